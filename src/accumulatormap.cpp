@@ -5,9 +5,11 @@
 
 #include "accumulatormap.h"
 #include "accumulators.h"
+#include "checkqueue.h"
 #include "main.h"
 #include "txdb.h"
 #include "libzerocoin/Denominations.h"
+#include "util.h"
 
 using namespace libzerocoin;
 using namespace std;
@@ -74,6 +76,78 @@ bool AccumulatorMap::Accumulate(const PublicCoin& pubCoin, bool fSkipValidation)
     return true;
 }
 
+/** The coins of one denomination of a batch, accumulated on the accumulator threads */
+class CAccumulateCheck
+{
+private:
+    Accumulator* accumulator;
+    std::vector<const PublicCoin*> vCoins;
+    bool fSkipValidation;
+
+public:
+    CAccumulateCheck() : accumulator(nullptr), fSkipValidation(false) {}
+    CAccumulateCheck(Accumulator* accumulatorIn, std::vector<const PublicCoin*>& vCoinsIn, bool fSkipValidationIn) : accumulator(accumulatorIn), fSkipValidation(fSkipValidationIn)
+    {
+        vCoins.swap(vCoinsIn);
+    }
+
+    bool operator()()
+    {
+        try {
+            for (const PublicCoin* pubCoin : vCoins) {
+                if (fSkipValidation)
+                    accumulator->increment(pubCoin->getValue());
+                else
+                    accumulator->accumulate(*pubCoin);
+            }
+        } catch (const std::exception& e) {
+            return error("%s : failed to accumulate denomination %d - %s", __func__, accumulator->getDenomination(), e.what());
+        }
+        return true;
+    }
+
+    void swap(CAccumulateCheck& check)
+    {
+        std::swap(accumulator, check.accumulator);
+        vCoins.swap(check.vCoins);
+        std::swap(fSkipValidation, check.fSkipValidation);
+    }
+};
+
+static CCheckQueue<CAccumulateCheck> accumulatequeue(1, MAX_ACCUMULATOR_THREADS);
+//! The queue is filled and waited for by one caller at a time
+static CCriticalSection cs_accumulatequeue;
+
+void ThreadAccumulate()
+{
+    RenameThread("kyd-accumulate");
+    accumulatequeue.Thread();
+}
+
+//Add a batch of zerocoins. The accumulators of the different denominations are independent of each
+//other, so the denominations present in the batch are accumulated concurrently on the accumulator threads.
+bool AccumulatorMap::Accumulate(const std::list<PublicCoin>& listPubcoins, bool fSkipValidation)
+{
+    std::map<CoinDenomination, std::vector<const PublicCoin*> > mapDenomCoins;
+    for (const PublicCoin& pubCoin : listPubcoins) {
+        CoinDenomination denom = pubCoin.getDenomination();
+        if (denom == CoinDenomination::ZQ_ERROR)
+            return false;
+        mapDenomCoins[denom].emplace_back(&pubCoin);
+    }
+
+    std::vector<CAccumulateCheck> vChecks;
+    vChecks.reserve(mapDenomCoins.size());
+    for (auto& it : mapDenomCoins)
+        vChecks.emplace_back(mapAccumulators.at(it.first).get(), it.second, fSkipValidation);
+
+    // Without accumulator threads the caller does all the work in Wait()
+    LOCK(cs_accumulatequeue);
+    CCheckQueueControl<CAccumulateCheck> control(&accumulatequeue);
+    control.Add(vChecks);
+    return control.Wait();
+}
+
 //Get the value of a specific accumulator
 CBigNum AccumulatorMap::GetValue(CoinDenomination denom)
 {
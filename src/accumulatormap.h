@@ -10,6 +10,11 @@
 #include "libzerocoin/Coin.h"
 #include "accumulatorcheckpoints.h"
 
+#include <list>
+
+//! Threads accumulating checkpoint batches besides the caller, one per remaining denomination
+static const int MAX_ACCUMULATOR_THREADS = 7;
+
 //A map with an accumulator for each denomination
 class AccumulatorMap
 {
@@ -21,9 +26,13 @@ public:
     bool Load(uint256 nCheckpoint);
     void Load(const AccumulatorCheckpoints::Checkpoint& checkpoint);
     bool Accumulate(const libzerocoin::PublicCoin& pubCoin, bool fSkipValidation = false);
+    bool Accumulate(const std::list<libzerocoin::PublicCoin>& listPubcoins, bool fSkipValidation = false);
     CBigNum GetValue(libzerocoin::CoinDenomination denom);
     uint256 GetCheckpoint();
     void Reset();
     void Reset(libzerocoin::ZerocoinParams* params2);
 };
+
+//Run the accumulator thread pool used by AccumulatorMap::Accumulate on batches
+void ThreadAccumulate();
 #endif //KYD_ACCUMULATORMAP_H
@@ -230,7 +230,7 @@ bool InitializeAccumulators(const int nHeight, int& nHeightCheckpoint, Accumulat
 }
 
 //Get checkpoint value for a specific block height
-bool CalculateAccumulatorCheckpoint(int nHeight, uint256& nCheckpoint, AccumulatorMap& mapAccumulators)
+bool CalculateAccumulatorCheckpoint(int nHeight, uint256& nCheckpoint, AccumulatorMap& mapAccumulators, const std::map<int, CBlockPubcoins>* pmapPubcoins)
 {
     if (nHeight < Params().Zerocoin_Block_V2_Start()) {
         nCheckpoint = 0;
@@ -254,6 +254,7 @@ bool CalculateAccumulatorCheckpoint(int nHeight, uint256& nCheckpoint, Accumulat
 
     //Accumulate all coins over the last ten blocks that havent been accumulated (height - 20 through height - 11)
     int nTotalMintsFound = 0;
+    std::list<PublicCoin> listPubcoinsWindow;
     CBlockIndex *pindex = chainActive[nHeightCheckpoint - 20];
 
     while (pindex->nHeight < nHeight - 10) {
@@ -267,26 +268,31 @@ bool CalculateAccumulatorCheckpoint(int nHeight, uint256& nCheckpoint, Accumulat
             continue;
         }
 
-        //grab mints from this block
-        CBlock block;
-        if(!ReadBlockFromDisk(block, pindex))
-            return error("%s: failed to read block from disk", __func__);
-
+        //grab mints from this block, unless the caller already extracted them
         std::list<PublicCoin> listPubcoins;
-        if (!BlockToPubcoinList(block, listPubcoins, fFilterInvalid))
-            return error("%s: failed to get zerocoin mintlist from block %d", __func__, pindex->nHeight);
+        auto it = pmapPubcoins ? pmapPubcoins->find(pindex->nHeight) : std::map<int, CBlockPubcoins>::const_iterator();
+        if (pmapPubcoins && it != pmapPubcoins->end() && it->second.fFilterInvalid == fFilterInvalid) {
+            listPubcoins = it->second.listPubcoins;
+        } else {
+            std::shared_ptr<const CBlock> pblock;
+            if(!ReadBlockFromDisk(pblock, pindex))
+                return error("%s: failed to read block from disk", __func__);
+
+            if (!BlockToPubcoinList(*pblock, listPubcoins, fFilterInvalid))
+                return error("%s: failed to get zerocoin mintlist from block %d", __func__, pindex->nHeight);
+        }
 
         nTotalMintsFound += listPubcoins.size();
         LogPrint("zero", "%s found %d mints\n", __func__, listPubcoins.size());
 
-        //add the pubcoins to accumulator
-        for (const PublicCoin& pubcoin : listPubcoins) {
-            if(!mapAccumulators.Accumulate(pubcoin, true))
-                return error("%s: failed to add pubcoin to accumulator at height %d", __func__, pindex->nHeight);
-        }
+        listPubcoinsWindow.splice(listPubcoinsWindow.end(), listPubcoins);
         pindex = chainActive.Next(pindex);
     }
 
+    //add the pubcoins of the whole window to the accumulators, one thread per denomination
+    if (!mapAccumulators.Accumulate(listPubcoinsWindow, true))
+        return error("%s: failed to add pubcoins to accumulator for checkpoint %d", __func__, nHeight);
+
     // if there were no new mints found, the accumulator checkpoint will be the same as the last checkpoint
     if (nTotalMintsFound == 0)
         nCheckpoint = chainActive[nHeight - 1]->nAccumulatorCheckpoint;
@@ -364,12 +370,12 @@ int AddBlockMintsToAccumulator(const libzerocoin::PublicCoin& coin, const int nH
     int nMintsAdded = 0;
     if (pindex->MintedDenomination(coin.getDenomination())) {
         //grab mints from this block
-        CBlock block;
-        if(!ReadBlockFromDisk(block, pindex))
+        std::shared_ptr<const CBlock> pblock;
+        if(!ReadBlockFromDisk(pblock, pindex))
             return error("%s: failed to read block from disk while adding pubcoins to witness", __func__);
 
         list<PublicCoin> listPubcoins;
-        if(!BlockToPubcoinList(block, listPubcoins, true))
+        if(!BlockToPubcoinList(*pblock, listPubcoins, true))
             return error("%s: failed to get zerocoin mintlist from block %n\n", __func__, pindex->nHeight);
 
         //add the mints to the witness
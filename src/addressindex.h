@@ -0,0 +1,327 @@
+// Copyright (c) 2016 BitPay, Inc.
+// Copyright (c) 2018-2019 The KYD developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef KYD_ADDRESSINDEX_H
+#define KYD_ADDRESSINDEX_H
+
+#include "amount.h"
+#include "crypto/common.h"
+#include "script/script.h"
+#include "serialize.h"
+#include "uint256.h"
+
+//! -addressindex default
+static const bool DEFAULT_ADDRESSINDEX = false;
+//! -spentindex default
+static const bool DEFAULT_SPENTINDEX = false;
+//! -timestampindex default
+static const bool DEFAULT_TIMESTAMPINDEX = false;
+
+enum AddressIndexType {
+    ADDRESS_INDEX_NONE = 0,
+    ADDRESS_INDEX_PUBKEYHASH = 1,
+    ADDRESS_INDEX_SCRIPTHASH = 2,
+};
+
+/**
+ * Integers inside index keys are stored big endian so that LevelDB keeps the
+ * entries of one address (or one timestamp range) ordered by height.
+ */
+template <typename Stream>
+inline void SerializeKeyBE32(Stream& s, uint32_t n)
+{
+    unsigned char buf[4];
+    WriteBE32(buf, n);
+    s.write((char*)buf, sizeof(buf));
+}
+
+template <typename Stream>
+inline uint32_t UnserializeKeyBE32(Stream& s)
+{
+    unsigned char buf[4];
+    s.read((char*)buf, sizeof(buf));
+    return ReadBE32(buf);
+}
+
+template <typename Stream>
+inline unsigned char UnserializeKeyByte(Stream& s)
+{
+    unsigned char ch;
+    s.read((char*)&ch, 1);
+    return ch;
+}
+
+/** One credit (spending = false) or debit (spending = true) of an address */
+struct CAddressIndexKey {
+    unsigned int type;
+    uint160 hashBytes;
+    int blockHeight;
+    unsigned int txindex;
+    uint256 txhash;
+    unsigned int index;
+    bool spending;
+
+    CAddressIndexKey() { SetNull(); }
+
+    CAddressIndexKey(unsigned int addressType, const uint160& addressHash, int height, unsigned int blockindex,
+        const uint256& txid, unsigned int indexValue, bool isSpending)
+        : type(addressType), hashBytes(addressHash), blockHeight(height), txindex(blockindex),
+          txhash(txid), index(indexValue), spending(isSpending) {}
+
+    void SetNull()
+    {
+        type = ADDRESS_INDEX_NONE;
+        hashBytes.SetNull();
+        blockHeight = 0;
+        txindex = 0;
+        txhash.SetNull();
+        index = 0;
+        spending = false;
+    }
+
+    unsigned int GetSerializeSize(int nType, int nVersion) const { return 66; }
+
+    template <typename Stream>
+    void Serialize(Stream& s, int nType, int nVersion) const
+    {
+        ::Serialize(s, (unsigned char)type, nType, nVersion);
+        hashBytes.Serialize(s, nType, nVersion);
+        SerializeKeyBE32(s, blockHeight);
+        SerializeKeyBE32(s, txindex);
+        txhash.Serialize(s, nType, nVersion);
+        SerializeKeyBE32(s, index);
+        ::Serialize(s, (unsigned char)spending, nType, nVersion);
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s, int nType, int nVersion)
+    {
+        type = UnserializeKeyByte(s);
+        hashBytes.Unserialize(s, nType, nVersion);
+        blockHeight = UnserializeKeyBE32(s);
+        txindex = UnserializeKeyBE32(s);
+        txhash.Unserialize(s, nType, nVersion);
+        index = UnserializeKeyBE32(s);
+        spending = UnserializeKeyByte(s) != 0;
+    }
+};
+
+/** Prefix of CAddressIndexKey and CAddressUnspentKey used to seek to the first entry of an address */
+struct CAddressIndexIteratorKey {
+    unsigned int type;
+    uint160 hashBytes;
+
+    CAddressIndexIteratorKey(unsigned int addressType, const uint160& addressHash) : type(addressType), hashBytes(addressHash) {}
+
+    unsigned int GetSerializeSize(int nType, int nVersion) const { return 21; }
+
+    template <typename Stream>
+    void Serialize(Stream& s, int nType, int nVersion) const
+    {
+        ::Serialize(s, (unsigned char)type, nType, nVersion);
+        hashBytes.Serialize(s, nType, nVersion);
+    }
+};
+
+/** Prefix of CAddressIndexKey used to seek to the first entry of an address at or above a height */
+struct CAddressIndexIteratorHeightKey {
+    unsigned int type;
+    uint160 hashBytes;
+    int blockHeight;
+
+    CAddressIndexIteratorHeightKey(unsigned int addressType, const uint160& addressHash, int height)
+        : type(addressType), hashBytes(addressHash), blockHeight(height) {}
+
+    unsigned int GetSerializeSize(int nType, int nVersion) const { return 25; }
+
+    template <typename Stream>
+    void Serialize(Stream& s, int nType, int nVersion) const
+    {
+        ::Serialize(s, (unsigned char)type, nType, nVersion);
+        hashBytes.Serialize(s, nType, nVersion);
+        SerializeKeyBE32(s, blockHeight);
+    }
+};
+
+/** An unspent output paying to an address */
+struct CAddressUnspentKey {
+    unsigned int type;
+    uint160 hashBytes;
+    uint256 txhash;
+    unsigned int index;
+
+    CAddressUnspentKey() { SetNull(); }
+
+    CAddressUnspentKey(unsigned int addressType, const uint160& addressHash, const uint256& txid, unsigned int indexValue)
+        : type(addressType), hashBytes(addressHash), txhash(txid), index(indexValue) {}
+
+    void SetNull()
+    {
+        type = ADDRESS_INDEX_NONE;
+        hashBytes.SetNull();
+        txhash.SetNull();
+        index = 0;
+    }
+
+    unsigned int GetSerializeSize(int nType, int nVersion) const { return 57; }
+
+    template <typename Stream>
+    void Serialize(Stream& s, int nType, int nVersion) const
+    {
+        ::Serialize(s, (unsigned char)type, nType, nVersion);
+        hashBytes.Serialize(s, nType, nVersion);
+        txhash.Serialize(s, nType, nVersion);
+        SerializeKeyBE32(s, index);
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s, int nType, int nVersion)
+    {
+        type = UnserializeKeyByte(s);
+        hashBytes.Unserialize(s, nType, nVersion);
+        txhash.Unserialize(s, nType, nVersion);
+        index = UnserializeKeyBE32(s);
+    }
+};
+
+struct CAddressUnspentValue {
+    CAmount satoshis;
+    CScript script;
+    int blockHeight;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion)
+    {
+        READWRITE(satoshis);
+        READWRITE(script);
+        READWRITE(blockHeight);
+    }
+
+    CAddressUnspentValue() { SetNull(); }
+
+    CAddressUnspentValue(CAmount sats, const CScript& scriptPubKey, int height)
+        : satoshis(sats), script(scriptPubKey), blockHeight(height) {}
+
+    void SetNull()
+    {
+        satoshis = -1;
+        script.clear();
+        blockHeight = 0;
+    }
+
+    //! A null value in an update batch erases the key
+    bool IsNull() const { return satoshis == -1; }
+};
+
+/** An output that has been spent */
+struct CSpentIndexKey {
+    uint256 txid;
+    unsigned int outputIndex;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion)
+    {
+        READWRITE(txid);
+        READWRITE(outputIndex);
+    }
+
+    CSpentIndexKey() { SetNull(); }
+
+    CSpentIndexKey(const uint256& t, unsigned int i) : txid(t), outputIndex(i) {}
+
+    void SetNull()
+    {
+        txid.SetNull();
+        outputIndex = 0;
+    }
+};
+
+/** The input spending an output, along with what the output was worth */
+struct CSpentIndexValue {
+    uint256 txid;
+    unsigned int inputIndex;
+    int blockHeight;
+    CAmount satoshis;
+    int addressType;
+    uint160 addressHash;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion)
+    {
+        READWRITE(txid);
+        READWRITE(inputIndex);
+        READWRITE(blockHeight);
+        READWRITE(satoshis);
+        READWRITE(addressType);
+        READWRITE(addressHash);
+    }
+
+    CSpentIndexValue() { SetNull(); }
+
+    CSpentIndexValue(const uint256& t, unsigned int i, int h, CAmount s, int type, const uint160& a)
+        : txid(t), inputIndex(i), blockHeight(h), satoshis(s), addressType(type), addressHash(a) {}
+
+    void SetNull()
+    {
+        txid.SetNull();
+        inputIndex = 0;
+        blockHeight = 0;
+        satoshis = 0;
+        addressType = ADDRESS_INDEX_NONE;
+        addressHash.SetNull();
+    }
+
+    //! A null value in an update batch erases the key
+    bool IsNull() const { return txid.IsNull(); }
+};
+
+/** A block by its timestamp */
+struct CTimestampIndexKey {
+    unsigned int timestamp;
+    uint256 blockHash;
+
+    CTimestampIndexKey() : timestamp(0) {}
+
+    CTimestampIndexKey(unsigned int time, const uint256& hash) : timestamp(time), blockHash(hash) {}
+
+    unsigned int GetSerializeSize(int nType, int nVersion) const { return 36; }
+
+    template <typename Stream>
+    void Serialize(Stream& s, int nType, int nVersion) const
+    {
+        SerializeKeyBE32(s, timestamp);
+        blockHash.Serialize(s, nType, nVersion);
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s, int nType, int nVersion)
+    {
+        timestamp = UnserializeKeyBE32(s);
+        blockHash.Unserialize(s, nType, nVersion);
+    }
+};
+
+/** Prefix of CTimestampIndexKey used to seek to the first block at or after a time */
+struct CTimestampIndexIteratorKey {
+    unsigned int timestamp;
+
+    CTimestampIndexIteratorKey(unsigned int time) : timestamp(time) {}
+
+    unsigned int GetSerializeSize(int nType, int nVersion) const { return 4; }
+
+    template <typename Stream>
+    void Serialize(Stream& s, int nType, int nVersion) const
+    {
+        SerializeKeyBE32(s, timestamp);
+    }
+};
+
+#endif // KYD_ADDRESSINDEX_H
@@ -0,0 +1,147 @@
+// Copyright (c) 2015-2016 The Bitcoin Core developers
+// Copyright (c) 2018-2019 The KYD developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "tinyformat.h"
+
+#include <algorithm>
+#include <iostream>
+#include <regex>
+
+#include <univalue.h>
+
+namespace
+{
+double Seconds(benchmark::clock::duration d)
+{
+    return std::chrono::duration_cast<std::chrono::duration<double> >(d).count();
+}
+} // namespace
+
+benchmark::State::State(const std::string& nameIn, double dTargetSecondsIn) : phase(PHASE_START), dTargetSeconds(dTargetSecondsIn),
+                                                                              nBatch(0), nLeft(0), nWarmupIterations(0), dMeasuredSeconds(0),
+                                                                              name(nameIn), nIterations(0)
+{
+}
+
+bool benchmark::State::UpdateTimer()
+{
+    clock::time_point now = clock::now();
+    double dMeasureBudget = dTargetSeconds * (1.0 - WARMUP_FRACTION);
+
+    switch (phase) {
+    case PHASE_START:
+        timeStart = now;
+        nBatch = 1;
+        phase = PHASE_WARMUP;
+        break;
+    case PHASE_WARMUP: {
+        nWarmupIterations += nBatch;
+        double dWarmup = Seconds(now - timeStart);
+        if (dWarmup < dTargetSeconds * WARMUP_FRACTION) {
+            nBatch *= 2;
+            break;
+        }
+        double dPerIteration = dWarmup / nWarmupIterations;
+        nBatch = std::max<uint64_t>(1, dMeasureBudget / TARGET_SAMPLES / std::max(dPerIteration, 1e-12));
+        phase = PHASE_MEASURE;
+        break;
+    }
+    case PHASE_MEASURE: {
+        double dBatch = Seconds(now - timeBatch);
+        vSamples.push_back(dBatch / nBatch);
+        nIterations += nBatch;
+        dMeasuredSeconds += dBatch;
+        if ((int)vSamples.size() >= TARGET_SAMPLES || dMeasuredSeconds >= dMeasureBudget) {
+            phase = PHASE_DONE;
+            return false;
+        }
+        break;
+    }
+    case PHASE_DONE:
+        return false;
+    }
+
+    nLeft = nBatch - 1;
+    timeBatch = clock::now();
+    return true;
+}
+
+benchmark::BenchRunner::BenchmarkMap& benchmark::BenchRunner::benchmarks()
+{
+    static std::map<std::string, BenchFunction> benchmarks_map;
+    return benchmarks_map;
+}
+
+benchmark::BenchRunner::BenchRunner(std::string name, benchmark::BenchFunction func)
+{
+    benchmarks().insert(std::make_pair(name, func));
+}
+
+void benchmark::BenchRunner::ListAll()
+{
+    for (const auto& p : benchmarks())
+        std::cout << p.first << std::endl;
+}
+
+void benchmark::BenchRunner::RunAll(const std::string& strFilter, double dTargetSeconds, std::vector<BenchResult>& vResults)
+{
+    std::regex reFilter(strFilter);
+    for (const auto& p : benchmarks()) {
+        if (!std::regex_search(p.first, reFilter))
+            continue;
+
+        State state(p.first, dTargetSeconds);
+        p.second(state);
+        if (state.vSamples.empty()) {
+            std::cerr << p.first << ": skipped" << std::endl;
+            continue;
+        }
+
+        std::vector<double> vSorted = state.vSamples;
+        std::sort(vSorted.begin(), vSorted.end());
+        double dTotal = 0;
+        for (double dSample : vSorted)
+            dTotal += dSample;
+
+        BenchResult result;
+        result.name = p.first;
+        result.nIterations = state.nIterations;
+        result.nSamples = vSorted.size();
+        result.dMin = vSorted.front() * 1e9;
+        result.dMedian = vSorted[vSorted.size() / 2] * 1e9;
+        result.dMean = dTotal / vSorted.size() * 1e9;
+        result.dMax = vSorted.back() * 1e9;
+        vResults.push_back(result);
+    }
+}
+
+std::string benchmark::FormatText(const std::vector<BenchResult>& vResults)
+{
+    std::string strOut = "#Benchmark,iterations,samples,min(ns),median(ns),mean(ns),max(ns)\n";
+    for (const BenchResult& result : vResults) {
+        strOut += strprintf("%s,%u,%u,%.1f,%.1f,%.1f,%.1f\n", result.name, result.nIterations, result.nSamples,
+            result.dMin, result.dMedian, result.dMean, result.dMax);
+    }
+    return strOut;
+}
+
+std::string benchmark::FormatJSON(const std::vector<BenchResult>& vResults)
+{
+    UniValue results(UniValue::VARR);
+    for (const BenchResult& result : vResults) {
+        UniValue obj(UniValue::VOBJ);
+        obj.push_back(Pair("name", result.name));
+        obj.push_back(Pair("iterations", result.nIterations));
+        obj.push_back(Pair("samples", (uint64_t)result.nSamples));
+        obj.push_back(Pair("min_ns", result.dMin));
+        obj.push_back(Pair("median_ns", result.dMedian));
+        obj.push_back(Pair("mean_ns", result.dMean));
+        obj.push_back(Pair("max_ns", result.dMax));
+        results.push_back(obj);
+    }
+    return results.write(2) + "\n";
+}
@@ -0,0 +1,135 @@
+// Copyright (c) 2015-2016 The Bitcoin Core developers
+// Copyright (c) 2018-2019 The KYD developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef KYD_BENCH_BENCH_H
+#define KYD_BENCH_BENCH_H
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <boost/preprocessor/cat.hpp>
+#include <boost/preprocessor/stringize.hpp>
+
+// Simple micro-benchmarking framework; API mostly matches a subset of the Google Benchmark
+// framework (see https://github.com/google/benchmark)
+// Why not use the Google Benchmark framework? Because adding Yet Another Dependency
+// (that uses cmake as its build system and has lots of features we don't need) isn't
+// worth it.
+
+/*
+ * Usage:
+
+static void CODE_TO_TIME(benchmark::State& state)
+{
+    ... do any setup needed...
+    while (state.KeepRunning()) {
+       ... do stuff you want to time...
+    }
+    ... do any cleanup needed...
+}
+
+BENCHMARK(CODE_TO_TIME);
+
+ */
+
+namespace benchmark
+{
+typedef std::chrono::steady_clock clock;
+
+//! Fraction of the time budget of a benchmark spent warming up before anything is recorded
+static const double WARMUP_FRACTION = 0.1;
+//! Number of samples the measured part of a benchmark is split into
+static const int TARGET_SAMPLES = 20;
+
+/**
+ * Drives the loop of one benchmark. Iterations run in batches so that reading the clock
+ * does not dominate short operations: the warmup phase doubles the batch until the warmup
+ * budget is used up, the per-iteration cost measured there sizes the batches of the
+ * measured phase, and each measured batch becomes one sample.
+ */
+class State
+{
+private:
+    enum Phase {
+        PHASE_START,
+        PHASE_WARMUP,
+        PHASE_MEASURE,
+        PHASE_DONE
+    };
+
+    Phase phase;
+    double dTargetSeconds;
+    uint64_t nBatch;
+    uint64_t nLeft;
+    uint64_t nWarmupIterations;
+    clock::time_point timeStart;
+    clock::time_point timeBatch;
+    double dMeasuredSeconds;
+
+    bool UpdateTimer();
+
+public:
+    std::string name;
+    //! Seconds per iteration of every measured batch
+    std::vector<double> vSamples;
+    uint64_t nIterations;
+
+    State(const std::string& nameIn, double dTargetSecondsIn);
+
+    bool KeepRunning()
+    {
+        if (nLeft > 0) {
+            --nLeft;
+            return true;
+        }
+        return UpdateTimer();
+    }
+};
+
+typedef std::function<void(State&)> BenchFunction;
+
+/** Result of a benchmark run, in nanoseconds per iteration */
+struct BenchResult {
+    std::string name;
+    uint64_t nIterations;
+    size_t nSamples;
+    double dMin;
+    double dMedian;
+    double dMean;
+    double dMax;
+};
+
+class BenchRunner
+{
+    typedef std::map<std::string, BenchFunction> BenchmarkMap;
+    static BenchmarkMap& benchmarks();
+
+public:
+    BenchRunner(std::string name, BenchFunction func);
+
+    static void ListAll();
+    /**
+     * Run the benchmarks whose name matches strFilter (a regular expression) for about
+     * dTargetSeconds each. Benchmarks that return without entering their loop, because their
+     * fixture could not be set up, are reported as skipped and left out of the results.
+     */
+    static void RunAll(const std::string& strFilter, double dTargetSeconds, std::vector<BenchResult>& vResults);
+};
+
+/** Print results as a table */
+std::string FormatText(const std::vector<BenchResult>& vResults);
+/** Print results as a JSON array so that runs can be compared by scripts */
+std::string FormatJSON(const std::vector<BenchResult>& vResults);
+}
+
+// BENCHMARK(foo) expands to:  benchmark::BenchRunner bench_11foo("foo", foo);
+#define BENCHMARK(n) \
+    benchmark::BenchRunner BOOST_PP_CAT(bench_, BOOST_PP_CAT(__LINE__, n))(BOOST_PP_STRINGIZE(n), n);
+
+#endif // KYD_BENCH_BENCH_H
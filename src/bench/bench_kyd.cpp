@@ -0,0 +1,80 @@
+// Copyright (c) 2015-2016 The Bitcoin Core developers
+// Copyright (c) 2018-2019 The KYD developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "fixture.h"
+
+#include "chainparams.h"
+#include "crypto/sha256.h"
+#include "key.h"
+#include "util.h"
+
+#include <fstream>
+#include <iostream>
+
+//! -time default (seconds per benchmark)
+static const double DEFAULT_BENCH_TIME = 1.0;
+
+static void PrintUsage()
+{
+    std::cout << "Usage: bench_kyd [options]\n\n"
+              << "Options:\n"
+              << "  -?                  This help message\n"
+              << "  -list               List the available benchmarks and exit\n"
+              << "  -filter=<regex>     Only run benchmarks whose name matches <regex> (default: .*)\n"
+              << "  -time=<seconds>     Time budget of every benchmark, including warmup (default: " << DEFAULT_BENCH_TIME << ")\n"
+              << "  -format=<fmt>       Output format, 'text' or 'json' (default: text)\n"
+              << "  -output=<file>      Write the results to <file> instead of stdout\n";
+}
+
+int main(int argc, char** argv)
+{
+    ParseParameters(argc, argv);
+    if (mapArgs.count("-?") || mapArgs.count("-h") || mapArgs.count("-help")) {
+        PrintUsage();
+        return 0;
+    }
+    if (mapArgs.count("-list")) {
+        benchmark::BenchRunner::ListAll();
+        return 0;
+    }
+
+    std::string strFormat = GetArg("-format", "text");
+    if (strFormat != "text" && strFormat != "json") {
+        std::cerr << "Error: unknown -format " << strFormat << std::endl;
+        return 1;
+    }
+    double dTime = atof(GetArg("-time", strprintf("%f", DEFAULT_BENCH_TIME)).c_str());
+    if (dTime <= 0) {
+        std::cerr << "Error: -time must be positive" << std::endl;
+        return 1;
+    }
+
+    SetupEnvironment();
+    fPrintToDebugLog = false; // don't want to write to debug.log file
+    SHA256AutoDetect();
+    ECC_Start();
+    ECCVerifyHandle globalVerifyHandle;
+    SelectParams(CBaseChainParams::REGTEST);
+
+    std::vector<benchmark::BenchResult> vResults;
+    benchmark::BenchRunner::RunAll(GetArg("-filter", ".*"), dTime, vResults);
+    benchmark::ChainFixture::Destroy();
+
+    ECC_Stop();
+
+    std::string strOut = strFormat == "json" ? benchmark::FormatJSON(vResults) : benchmark::FormatText(vResults);
+    if (mapArgs.count("-output")) {
+        std::ofstream file(GetArg("-output", "").c_str());
+        if (!file) {
+            std::cerr << "Error: cannot write to " << GetArg("-output", "") << std::endl;
+            return 1;
+        }
+        file << strOut;
+    } else {
+        std::cout << strOut;
+    }
+    return 0;
+}
@@ -0,0 +1,84 @@
+// Copyright (c) 2016 The Bitcoin Core developers
+// Copyright (c) 2018-2019 The KYD developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "fixture.h"
+
+#include "hash.h"
+#include "main.h"
+#include "streams.h"
+#include "version.h"
+
+/* Transactions in the synthetic block, next to its coinbase */
+static const int BLOCK_TXS = 1000;
+
+static void DeserializeBlock(benchmark::State& state)
+{
+    benchmark::ChainFixture* pchain = benchmark::ChainFixture::Get();
+    if (!pchain)
+        return;
+
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    stream << pchain->CreateBlock(BLOCK_TXS);
+    size_t nBlockSize = stream.size();
+    // Reading a CDataStream to its end releases the buffer, keep one byte behind the block
+    stream.write("\0", 1);
+
+    while (state.KeepRunning()) {
+        CBlock block;
+        stream >> block;
+        stream.Rewind(nBlockSize);
+    }
+}
+
+static void SerializeBlock(benchmark::State& state)
+{
+    benchmark::ChainFixture* pchain = benchmark::ChainFixture::Get();
+    if (!pchain)
+        return;
+
+    CBlock block = pchain->CreateBlock(BLOCK_TXS);
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    stream.reserve(::GetSerializeSize(block, SER_NETWORK, PROTOCOL_VERSION));
+
+    while (state.KeepRunning()) {
+        stream << block;
+        stream.clear();
+    }
+}
+
+static void CheckBlockFull(benchmark::State& state)
+{
+    benchmark::ChainFixture* pchain = benchmark::ChainFixture::Get();
+    if (!pchain)
+        return;
+
+    CBlock block = pchain->CreateBlock(BLOCK_TXS);
+    CValidationState validationState;
+    if (!CheckBlock(block, validationState))
+        return;
+
+    while (state.KeepRunning()) {
+        CValidationState validationState;
+        CheckBlock(block, validationState);
+    }
+}
+
+static void MerkleRoot(benchmark::State& state)
+{
+    std::vector<uint256> vLeaves(BLOCK_TXS + 1);
+    for (size_t i = 0; i < vLeaves.size(); i++)
+        vLeaves[i] = Hash(BEGIN(i), END(i));
+
+    while (state.KeepRunning()) {
+        bool mutated;
+        vLeaves[0] = ComputeMerkleRoot(vLeaves, &mutated);
+    }
+}
+
+BENCHMARK(DeserializeBlock);
+BENCHMARK(SerializeBlock);
+BENCHMARK(CheckBlockFull);
+BENCHMARK(MerkleRoot);
@@ -0,0 +1,67 @@
+// Copyright (c) 2016 The Bitcoin Core developers
+// Copyright (c) 2018-2019 The KYD developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "coins.h"
+#include "random.h"
+#include "script/script.h"
+
+#include <vector>
+
+/* Coins held by the base view */
+static const int BASE_COINS = 10000;
+/* Coins fetched or updated per iteration */
+static const int COINS_PER_ITERATION = 100;
+
+static void FillBase(CCoinsViewCache& base, std::vector<uint256>& vTxids)
+{
+    for (int i = 0; i < BASE_COINS; i++) {
+        uint256 txid = GetRandHash();
+        CCoinsModifier coins = base.ModifyCoins(txid);
+        coins->nVersion = 1;
+        coins->nHeight = i;
+        coins->vout.assign(2, CTxOut(COIN, CScript() << OP_DUP << OP_HASH160 << ToByteVector(txid) << OP_EQUALVERIFY << OP_CHECKSIG));
+        vTxids.push_back(txid);
+    }
+}
+
+// Fetch coins from a parent cache into a fresh child cache, as block validation does
+static void CoinsCacheFetch(benchmark::State& state)
+{
+    CCoinsView dummy;
+    CCoinsViewCache base(&dummy);
+    std::vector<uint256> vTxids;
+    FillBase(base, vTxids);
+
+    size_t nNext = 0;
+    while (state.KeepRunning()) {
+        CCoinsViewCache cache(&base);
+        for (int i = 0; i < COINS_PER_ITERATION; i++)
+            cache.AccessCoins(vTxids[nNext++ % vTxids.size()]);
+    }
+}
+
+// Update coins in a child cache and flush them back into the parent
+static void CoinsCacheFlush(benchmark::State& state)
+{
+    CCoinsView dummy;
+    CCoinsViewCache base(&dummy);
+    std::vector<uint256> vTxids;
+    FillBase(base, vTxids);
+
+    size_t nNext = 0;
+    while (state.KeepRunning()) {
+        CCoinsViewCache cache(&base);
+        for (int i = 0; i < COINS_PER_ITERATION; i++) {
+            CCoinsModifier coins = cache.ModifyCoins(vTxids[nNext++ % vTxids.size()]);
+            coins->vout[1].nValue++;
+        }
+        cache.Flush();
+    }
+}
+
+BENCHMARK(CoinsCacheFetch);
+BENCHMARK(CoinsCacheFlush);
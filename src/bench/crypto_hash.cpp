@@ -0,0 +1,64 @@
+// Copyright (c) 2016 The Bitcoin Core developers
+// Copyright (c) 2018-2019 The KYD developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "crypto/sha256.h"
+#include "hash.h"
+#include "uint256.h"
+
+#include <vector>
+
+/* Number of bytes to hash per iteration */
+static const uint64_t BUFFER_SIZE = 1000 * 1000;
+/* Size of a serialized block header */
+static const uint64_t HEADER_SIZE = 80;
+
+static void HashQuarkHeader(benchmark::State& state)
+{
+    std::vector<unsigned char> in(HEADER_SIZE, 0);
+    while (state.KeepRunning()) {
+        uint256 hash = HashQuark(in.begin(), in.end());
+        in[0] = hash.begin()[0];
+    }
+}
+
+static void Hash9Header(benchmark::State& state)
+{
+    std::vector<unsigned char> in(HEADER_SIZE, 0);
+    while (state.KeepRunning()) {
+        uint256 hash = Hash9(in.begin(), in.end());
+        in[0] = hash.begin()[0];
+    }
+}
+
+static void SHA256D64_1(benchmark::State& state)
+{
+    uint256 hash;
+    while (state.KeepRunning())
+        hash = Hash(hash.begin(), hash.end(), hash.begin(), hash.end());
+}
+
+static void SHA256D64_1024(benchmark::State& state)
+{
+    std::vector<unsigned char> in(64 * 1024, 0);
+    while (state.KeepRunning())
+        SHA256D64(&in[0], &in[0], 1024);
+}
+
+static void SHA256D1MB(benchmark::State& state)
+{
+    std::vector<unsigned char> in(BUFFER_SIZE, 0);
+    while (state.KeepRunning()) {
+        uint256 hash = Hash(in.begin(), in.end());
+        in[0] = hash.begin()[0];
+    }
+}
+
+BENCHMARK(HashQuarkHeader);
+BENCHMARK(Hash9Header);
+BENCHMARK(SHA256D64_1);
+BENCHMARK(SHA256D64_1024);
+BENCHMARK(SHA256D1MB);
@@ -0,0 +1,166 @@
+// Copyright (c) 2018-2019 The KYD developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "fixture.h"
+
+#include "chainparams.h"
+#include "init.h"
+#include "main.h"
+#include "noui.h"
+#include "pow.h"
+#include "random.h"
+#include "script/interpreter.h"
+#include "script/standard.h"
+#include "timedata.h"
+#include "txdb.h"
+#include "util.h"
+#ifdef ENABLE_WALLET
+#include "db.h"
+#include "wallet.h"
+#endif
+
+#include <iostream>
+
+#include <boost/filesystem/operations.hpp>
+
+namespace
+{
+benchmark::ChainFixture* pfixture = NULL;
+bool fFixtureTried = false;
+} // namespace
+
+benchmark::ChainFixture::ChainFixture() : pcoinsdbview(NULL), fReady(false)
+{
+    SelectParams(CBaseChainParams::REGTEST);
+    noui_connect();
+#ifdef ENABLE_WALLET
+    bitdb.MakeMock();
+#endif
+    pathTemp = GetTempPath() / strprintf("bench_kyd_%lu_%i", (unsigned long)GetTime(), (int)(GetRand(100000)));
+    boost::filesystem::create_directories(pathTemp);
+    mapArgs["-datadir"] = pathTemp.string();
+    pblocktree = new CBlockTreeDB(1 << 20, true);
+    pcoinsdbview = new CCoinsViewDB(1 << 23, true);
+    pcoinsTip = new CCoinsViewCache(pcoinsdbview);
+    if (!InitBlockIndex())
+        return;
+#ifdef ENABLE_WALLET
+    bool fFirstRun;
+    pwalletMain = new CWallet("wallet.dat");
+    pwalletMain->LoadWallet(fFirstRun);
+#endif
+
+    key.MakeNewKey(true);
+    scriptPubKey = GetScriptForDestination(key.GetPubKey().GetID());
+    if (!MineBlocks(FIXTURE_CHAIN_HEIGHT))
+        return;
+    CreateSpends(FIXTURE_SPENDS);
+    fReady = true;
+}
+
+benchmark::ChainFixture::~ChainFixture()
+{
+    mempool.clear();
+#ifdef ENABLE_WALLET
+    delete pwalletMain;
+    pwalletMain = NULL;
+#endif
+    delete pcoinsTip;
+    pcoinsTip = NULL;
+    delete pcoinsdbview;
+    delete pblocktree;
+    pblocktree = NULL;
+#ifdef ENABLE_WALLET
+    bitdb.Flush(true);
+#endif
+    boost::filesystem::remove_all(pathTemp);
+}
+
+benchmark::ChainFixture* benchmark::ChainFixture::Get()
+{
+    if (!fFixtureTried) {
+        fFixtureTried = true;
+        pfixture = new ChainFixture();
+        if (!pfixture->fReady)
+            std::cerr << "Error: could not set up the benchmark chain" << std::endl;
+    }
+    return pfixture->fReady ? pfixture : NULL;
+}
+
+void benchmark::ChainFixture::Destroy()
+{
+    delete pfixture;
+    pfixture = NULL;
+}
+
+CBlock benchmark::ChainFixture::CreateBlock(int nTx) const
+{
+    LOCK(cs_main);
+    CBlockIndex* pindexPrev = chainActive.Tip();
+    int nHeight = pindexPrev->nHeight + 1;
+
+    CBlock block;
+    block.hashPrevBlock = pindexPrev->GetBlockHash();
+    block.nTime = std::max(pindexPrev->GetMedianTimePast() + 1, GetAdjustedTime());
+    block.nBits = GetNextWorkRequired(pindexPrev, &block);
+    block.nAccumulatorCheckpoint = pindexPrev->nAccumulatorCheckpoint;
+
+    CMutableTransaction txCoinbase;
+    txCoinbase.vin.resize(1);
+    txCoinbase.vin[0].prevout.SetNull();
+    txCoinbase.vin[0].scriptSig = CScript() << nHeight << OP_0;
+    txCoinbase.vout.resize(1);
+    txCoinbase.vout[0] = CTxOut(GetBlockValue(nHeight), scriptPubKey);
+    block.vtx.push_back(txCoinbase);
+    for (int i = 0; i < nTx && i < (int)vSpends.size(); i++)
+        block.vtx.push_back(vSpends[i]);
+
+    block.hashMerkleRoot = block.BuildMerkleTree();
+    while (!CheckProofOfWork(block.GetHash(), block.nBits))
+        ++block.nNonce;
+    return block;
+}
+
+bool benchmark::ChainFixture::MineBlocks(int nBlocks)
+{
+    for (int i = 0; i < nBlocks; i++) {
+        CBlock block = CreateBlock(0);
+        CValidationState state;
+        if (!ProcessNewBlock(state, NULL, &block) || chainActive.Tip()->GetBlockHash() != block.GetHash())
+            return false;
+    }
+    return true;
+}
+
+void benchmark::ChainFixture::CreateSpends(int nSpends)
+{
+    LOCK(cs_main);
+    const CAmount nValue = 10 * COIN;
+    const CAmount nFee = COIN / 1000;
+    CPubKey pubkey = key.GetPubKey();
+
+    for (int i = 0; i < nSpends; i++) {
+        uint256 txid = GetRandHash();
+        {
+            CCoinsModifier coins = pcoinsTip->ModifyCoins(txid);
+            coins->fCoinBase = false;
+            coins->fCoinStake = false;
+            coins->nVersion = 1;
+            coins->nHeight = 1;
+            coins->vout.assign(1, CTxOut(nValue, scriptPubKey));
+        }
+
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        tx.vin[0].prevout = COutPoint(txid, 0);
+        tx.vout.assign(1, CTxOut(nValue - nFee, scriptPubKey));
+
+        uint256 hash = SignatureHash(scriptPubKey, tx, 0, SIGHASH_ALL);
+        std::vector<unsigned char> vchSig;
+        key.Sign(hash, vchSig);
+        vchSig.push_back((unsigned char)SIGHASH_ALL);
+        tx.vin[0].scriptSig << vchSig << ToByteVector(pubkey);
+        vSpends.push_back(tx);
+    }
+}
@@ -0,0 +1,62 @@
+// Copyright (c) 2018-2019 The KYD developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef KYD_BENCH_FIXTURE_H
+#define KYD_BENCH_FIXTURE_H
+
+#include "key.h"
+#include "primitives/block.h"
+#include "primitives/transaction.h"
+#include "script/script.h"
+
+#include <boost/filesystem/path.hpp>
+
+#include <vector>
+
+class CCoinsViewDB;
+
+namespace benchmark
+{
+//! Blocks mined on top of the regtest genesis block by the chain fixture
+static const int FIXTURE_CHAIN_HEIGHT = 20;
+//! Signed transactions the chain fixture prepares, each spending its own funding coin
+static const int FIXTURE_SPENDS = 2000;
+
+/**
+ * Synthetic regtest chain state for the benchmarks that need one: a temporary data directory
+ * with a block tree and coins database, FIXTURE_CHAIN_HEIGHT mined blocks, and FIXTURE_SPENDS
+ * standard pay-to-pubkey-hash transactions whose inputs were planted in pcoinsTip.
+ * It is built on first use, because it takes a while, and torn down by Destroy().
+ */
+class ChainFixture
+{
+private:
+    CCoinsViewDB* pcoinsdbview;
+    boost::filesystem::path pathTemp;
+    bool fReady;
+
+    ChainFixture();
+    ~ChainFixture();
+
+    bool MineBlocks(int nBlocks);
+    void CreateSpends(int nSpends);
+
+public:
+    CKey key;
+    CScript scriptPubKey;
+    std::vector<CTransaction> vSpends;
+
+    /** Returns NULL if the chain could not be set up */
+    static ChainFixture* Get();
+    static void Destroy();
+
+    /**
+     * A block on top of the current tip holding a coinbase and the first nTx of vSpends,
+     * with a valid merkle root and proof of work.
+     */
+    CBlock CreateBlock(int nTx) const;
+};
+}
+
+#endif // KYD_BENCH_FIXTURE_H
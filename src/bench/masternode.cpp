@@ -0,0 +1,54 @@
+// Copyright (c) 2018-2019 The KYD developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "fixture.h"
+
+#include "masternode.h"
+#include "masternodeman.h"
+#include "random.h"
+
+/* Size of the synthetic masternode list */
+static const int MASTERNODES = 1000;
+
+static CMasternode MakeMasternode()
+{
+    CMasternode mn;
+    mn.vin = CTxIn(COutPoint(GetRandHash(), 0));
+    mn.protocolVersion = PROTOCOL_VERSION;
+    mn.sigTime = 0;
+    return mn;
+}
+
+static void MasternodeCalculateScore(benchmark::State& state)
+{
+    if (!benchmark::ChainFixture::Get())
+        return;
+
+    CMasternode mn = MakeMasternode();
+    while (state.KeepRunning())
+        mn.CalculateScore(1, benchmark::FIXTURE_CHAIN_HEIGHT);
+}
+
+static void MasternodeRank(benchmark::State& state)
+{
+    if (!benchmark::ChainFixture::Get())
+        return;
+
+    mnodeman.Clear();
+    CTxIn vinLast;
+    for (int i = 0; i < MASTERNODES; i++) {
+        CMasternode mn = MakeMasternode();
+        mnodeman.Add(mn);
+        vinLast = mn.vin;
+    }
+
+    while (state.KeepRunning())
+        mnodeman.GetMasternodeRank(vinLast, benchmark::FIXTURE_CHAIN_HEIGHT, 0, false);
+
+    mnodeman.Clear();
+}
+
+BENCHMARK(MasternodeCalculateScore);
+BENCHMARK(MasternodeRank);
@@ -0,0 +1,82 @@
+// Copyright (c) 2018-2019 The KYD developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "fixture.h"
+
+#include "init.h"
+#include "main.h"
+#include "txmempool.h"
+#ifdef ENABLE_WALLET
+#include "miner.h"
+#include "wallet.h"
+#endif
+
+#include <memory>
+
+/* Mempool transactions CreateNewBlock has to choose from */
+static const int TEMPLATE_TXS = 500;
+
+// Accepts every prepared spend once, then empties the mempool and starts over. Signatures
+// are only verified on the first pass, after that they come from the signature cache, as
+// they do for transactions relayed by several peers.
+static void MempoolAccept(benchmark::State& state)
+{
+    benchmark::ChainFixture* pchain = benchmark::ChainFixture::Get();
+    if (!pchain)
+        return;
+
+    LOCK(cs_main);
+    mempool.clear();
+    CValidationState validationState;
+    if (!AcceptToMemoryPool(mempool, validationState, pchain->vSpends[0], false, NULL))
+        return;
+    mempool.clear();
+
+    size_t nNext = 0;
+    while (state.KeepRunning()) {
+        if (nNext == pchain->vSpends.size()) {
+            mempool.clear();
+            nNext = 0;
+        }
+        CValidationState validationState;
+        AcceptToMemoryPool(mempool, validationState, pchain->vSpends[nNext++], false, NULL);
+    }
+    mempool.clear();
+}
+
+#ifdef ENABLE_WALLET
+static void CreateNewBlockPoW(benchmark::State& state)
+{
+    benchmark::ChainFixture* pchain = benchmark::ChainFixture::Get();
+    if (!pchain)
+        return;
+
+    {
+        LOCK(cs_main);
+        mempool.clear();
+        for (int i = 0; i < TEMPLATE_TXS; i++) {
+            CValidationState validationState;
+            AcceptToMemoryPool(mempool, validationState, pchain->vSpends[i], false, NULL);
+        }
+    }
+
+    std::unique_ptr<CBlockTemplate> pblocktemplate(CreateNewBlock(pchain->scriptPubKey, pwalletMain, false));
+    if (!pblocktemplate || pblocktemplate->block.vtx.size() != TEMPLATE_TXS + 1) {
+        LOCK(cs_main);
+        mempool.clear();
+        return;
+    }
+
+    while (state.KeepRunning())
+        pblocktemplate.reset(CreateNewBlock(pchain->scriptPubKey, pwalletMain, false));
+
+    LOCK(cs_main);
+    mempool.clear();
+}
+
+BENCHMARK(CreateNewBlockPoW);
+#endif
+
+BENCHMARK(MempoolAccept);
@@ -0,0 +1,98 @@
+// Copyright (c) 2018-2019 The KYD developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "fixture.h"
+
+#include "accumulators.h"
+#include "chainparams.h"
+#include "init.h"
+#include "libzerocoin/Accumulator.h"
+#include "libzerocoin/Coin.h"
+#include "libzerocoin/CoinSpend.h"
+#include "random.h"
+#ifdef ENABLE_WALLET
+#include "wallet.h"
+#include "zkydwallet.h"
+#endif
+
+#include <vector>
+
+using namespace libzerocoin;
+
+/* Coins minted up front and cycled through by the benchmarks */
+static const int MINTED_COINS = 5;
+
+static void MintCoins(std::vector<PublicCoin>& vCoins)
+{
+    for (int i = 0; i < MINTED_COINS; i++) {
+        PrivateCoin coin(Params().Zerocoin_Params(false), CoinDenomination::ZQ_ONE);
+        vCoins.push_back(coin.getPublicCoin());
+    }
+}
+
+static void AccumulatorAccumulate(benchmark::State& state)
+{
+    std::vector<PublicCoin> vCoins;
+    MintCoins(vCoins);
+
+    Accumulator accumulator(Params().Zerocoin_Params(false), CoinDenomination::ZQ_ONE);
+    size_t nNext = 0;
+    while (state.KeepRunning())
+        accumulator.accumulate(vCoins[nNext++ % vCoins.size()]);
+}
+
+static void CoinSpendVerify(benchmark::State& state)
+{
+    ZerocoinParams* params = Params().Zerocoin_Params(false);
+    std::vector<PublicCoin> vCoins;
+    MintCoins(vCoins);
+
+    PrivateCoin coin(params, CoinDenomination::ZQ_ONE);
+    Accumulator accumulator(params, CoinDenomination::ZQ_ONE);
+    AccumulatorWitness witness(params, accumulator, coin.getPublicCoin());
+    for (const PublicCoin& pubcoin : vCoins) {
+        accumulator += pubcoin;
+        witness += pubcoin;
+    }
+    accumulator += coin.getPublicCoin();
+
+    uint32_t nChecksum = GetChecksum(accumulator.getValue());
+    CoinSpend spend(params, params, coin, accumulator, nChecksum, witness, GetRandHash(), SpendType::SPEND);
+    if (!spend.Verify(accumulator))
+        return;
+
+    while (state.KeepRunning())
+        spend.Verify(accumulator);
+}
+
+#ifdef ENABLE_WALLET
+static void SeedToZKYD(benchmark::State& state)
+{
+    if (!benchmark::ChainFixture::Get())
+        return;
+
+    CzKYDWallet zwallet(pwalletMain->strWalletFile);
+    std::vector<uint512> vSeeds;
+    for (int i = 0; i < 64; i++) {
+        std::vector<unsigned char> vchSeed(64);
+        GetRandBytes(vchSeed.data(), vchSeed.size());
+        vSeeds.push_back(uint512(vchSeed));
+    }
+
+    size_t nNext = 0;
+    while (state.KeepRunning()) {
+        CBigNum bnValue;
+        CBigNum bnSerial;
+        CBigNum bnRandomness;
+        CKey key;
+        zwallet.SeedToZKYD(vSeeds[nNext++ % vSeeds.size()], bnValue, bnSerial, bnRandomness, key);
+    }
+}
+
+BENCHMARK(SeedToZKYD);
+#endif
+
+BENCHMARK(AccumulatorAccumulate);
+BENCHMARK(CoinSpendVerify);
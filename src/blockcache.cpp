@@ -0,0 +1,205 @@
+// Copyright (c) 2018-2019 The KYD developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockcache.h"
+
+#include "main.h"
+#include "streams.h"
+#include "util.h"
+
+#include <string.h>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+CBlockFileMapper blockFileMapper;
+CBlockCache blockCache;
+
+class CBlockFileMapper::CMappedFile
+{
+public:
+    const char* pData;
+    size_t nSize;
+
+    CMappedFile(const char* pDataIn, size_t nSizeIn) : pData(pDataIn), nSize(nSizeIn) {}
+
+    ~CMappedFile()
+    {
+#ifndef WIN32
+        munmap(const_cast<char*>(pData), nSize);
+#endif
+    }
+
+    static std::shared_ptr<CMappedFile> Open(const boost::filesystem::path& path)
+    {
+#ifndef WIN32
+        int fd = open(path.string().c_str(), O_RDONLY);
+        if (fd < 0)
+            return nullptr;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+            close(fd);
+            return nullptr;
+        }
+
+        void* pMap = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (pMap == MAP_FAILED)
+            return nullptr;
+
+        return std::make_shared<CMappedFile>(static_cast<const char*>(pMap), (size_t)st.st_size);
+#else
+        return nullptr;
+#endif
+    }
+};
+
+CBlockFileMapper::CBlockFileMapper() : nUseCounter(0)
+{
+}
+
+CBlockFileMapper::~CBlockFileMapper()
+{
+    Clear();
+}
+
+std::shared_ptr<CBlockFileMapper::CMappedFile> CBlockFileMapper::GetFile(const CDiskBlockPos& pos, const char* prefix, size_t nRequired)
+{
+    boost::unique_lock<boost::mutex> lock(cs_mapper);
+
+    std::pair<std::string, int> key(prefix, pos.nFile);
+    std::map<std::pair<std::string, int>, CMappedEntry>::iterator it = mapFiles.find(key);
+    if (it != mapFiles.end() && it->second.file->nSize >= nRequired) {
+        it->second.nLastUse = ++nUseCounter;
+        return it->second.file;
+    }
+
+    // Not mapped yet, or the file was appended to since it was mapped
+    std::shared_ptr<CMappedFile> file = CMappedFile::Open(GetBlockPosFilename(pos, prefix));
+    if (!file)
+        return nullptr;
+
+    if (it == mapFiles.end() && (int)mapFiles.size() >= MAX_MAPPED_BLOCK_FILES) {
+        std::map<std::pair<std::string, int>, CMappedEntry>::iterator itOldest = mapFiles.begin();
+        for (std::map<std::pair<std::string, int>, CMappedEntry>::iterator itFile = mapFiles.begin(); itFile != mapFiles.end(); ++itFile) {
+            if (itFile->second.nLastUse < itOldest->second.nLastUse)
+                itOldest = itFile;
+        }
+        // readers still holding the old mapping keep it alive until they are done
+        mapFiles.erase(itOldest);
+    }
+
+    CMappedEntry& entry = mapFiles[key];
+    entry.file = file;
+    entry.nLastUse = ++nUseCounter;
+    return file;
+}
+
+bool CBlockFileMapper::ReadRecord(const CDiskBlockPos& pos, const char* prefix, unsigned int nTrailer, CDataStream& ssRecord)
+{
+    if (pos.IsNull() || pos.nPos < sizeof(unsigned int))
+        return false;
+
+    std::shared_ptr<CMappedFile> file = GetFile(pos, prefix, pos.nPos);
+    if (!file)
+        return false;
+
+    // The payload size is stored right in front of the payload
+    unsigned int nSize;
+    memcpy(&nSize, file->pData + pos.nPos - sizeof(nSize), sizeof(nSize));
+    size_t nEnd = (size_t)pos.nPos + nSize + nTrailer;
+    if (nEnd > file->nSize) {
+        file = GetFile(pos, prefix, nEnd);
+        if (!file || nEnd > file->nSize)
+            return false;
+    }
+
+    ssRecord.write(file->pData + pos.nPos, nSize + nTrailer);
+    return true;
+}
+
+void CBlockFileMapper::Clear()
+{
+    boost::unique_lock<boost::mutex> lock(cs_mapper);
+    mapFiles.clear();
+}
+
+CBlockCache::CBlockCache() : nMaxSize(DEFAULT_BLOCK_CACHE_SIZE << 20), nSize(0), nHits(0), nMisses(0)
+{
+}
+
+void CBlockCache::Trim()
+{
+    while (nSize > nMaxSize && !listBlocks.empty()) {
+        std::map<PosKey, std::pair<LruList::iterator, size_t> >::iterator it = mapBlocks.find(listBlocks.back().first);
+        nSize -= it->second.second;
+        mapBlocks.erase(it);
+        listBlocks.pop_back();
+    }
+}
+
+void CBlockCache::SetMaxSize(size_t nMaxSizeIn)
+{
+    boost::unique_lock<boost::mutex> lock(cs_cache);
+    nMaxSize = nMaxSizeIn;
+    Trim();
+}
+
+bool CBlockCache::IsEnabled() const
+{
+    boost::unique_lock<boost::mutex> lock(cs_cache);
+    return nMaxSize > 0;
+}
+
+std::shared_ptr<const CBlock> CBlockCache::Get(const CDiskBlockPos& pos)
+{
+    boost::unique_lock<boost::mutex> lock(cs_cache);
+    std::map<PosKey, std::pair<LruList::iterator, size_t> >::iterator it = mapBlocks.find(PosKey(pos.nFile, pos.nPos));
+    if (it == mapBlocks.end()) {
+        nMisses++;
+        return nullptr;
+    }
+
+    nHits++;
+    listBlocks.splice(listBlocks.begin(), listBlocks, it->second.first);
+    return it->second.first->second;
+}
+
+void CBlockCache::Insert(const CDiskBlockPos& pos, const std::shared_ptr<const CBlock>& pblock, size_t nBlockSize)
+{
+    boost::unique_lock<boost::mutex> lock(cs_cache);
+    if (nBlockSize > nMaxSize)
+        return;
+
+    PosKey key(pos.nFile, pos.nPos);
+    if (mapBlocks.count(key))
+        return;
+
+    listBlocks.push_front(std::make_pair(key, pblock));
+    mapBlocks[key] = std::make_pair(listBlocks.begin(), nBlockSize);
+    nSize += nBlockSize;
+    Trim();
+}
+
+void CBlockCache::Clear()
+{
+    boost::unique_lock<boost::mutex> lock(cs_cache);
+    mapBlocks.clear();
+    listBlocks.clear();
+    nSize = 0;
+}
+
+void CBlockCache::GetStats(size_t& nEntriesOut, size_t& nSizeOut, uint64_t& nHitsOut, uint64_t& nMissesOut) const
+{
+    boost::unique_lock<boost::mutex> lock(cs_cache);
+    nEntriesOut = mapBlocks.size();
+    nSizeOut = nSize;
+    nHitsOut = nHits;
+    nMissesOut = nMisses;
+}
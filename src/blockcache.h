@@ -0,0 +1,96 @@
+// Copyright (c) 2018-2019 The KYD developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef KYD_BLOCKCACHE_H
+#define KYD_BLOCKCACHE_H
+
+#include "chain.h"
+#include "primitives/block.h"
+
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <boost/thread/mutex.hpp>
+
+class CDataStream;
+
+//! -blockcachesize default (MiB)
+static const int64_t DEFAULT_BLOCK_CACHE_SIZE = 32;
+//! Number of blk/rev files kept mapped at the same time
+static const int MAX_MAPPED_BLOCK_FILES = 64;
+
+/**
+ * Read-only memory maps of the blk?????.dat and rev?????.dat files. Records in those files are
+ * written as message start, payload size and payload, and a CDiskBlockPos points at the payload.
+ * Files that grew since they were mapped are mapped again on demand.
+ */
+class CBlockFileMapper
+{
+private:
+    class CMappedFile;
+
+    struct CMappedEntry {
+        std::shared_ptr<CMappedFile> file;
+        uint64_t nLastUse;
+    };
+
+    boost::mutex cs_mapper;
+    std::map<std::pair<std::string, int>, CMappedEntry> mapFiles;
+    uint64_t nUseCounter;
+
+    std::shared_ptr<CMappedFile> GetFile(const CDiskBlockPos& pos, const char* prefix, size_t nRequired);
+
+public:
+    CBlockFileMapper();
+    ~CBlockFileMapper();
+
+    /**
+     * Append the record stored at pos, followed by nTrailer extra bytes, to ssRecord.
+     * Returns false if the file could not be mapped or is too short, in which case the
+     * caller should fall back to reading through stdio.
+     */
+    bool ReadRecord(const CDiskBlockPos& pos, const char* prefix, unsigned int nTrailer, CDataStream& ssRecord);
+
+    void Clear();
+};
+
+/**
+ * LRU cache of deserialized blocks keyed by their position on disk. Block files are append
+ * only, so an entry never goes stale. Entries are accounted by their serialized size.
+ */
+class CBlockCache
+{
+private:
+    typedef std::pair<int, unsigned int> PosKey;
+    typedef std::list<std::pair<PosKey, std::shared_ptr<const CBlock> > > LruList;
+
+    mutable boost::mutex cs_cache;
+    LruList listBlocks;
+    std::map<PosKey, std::pair<LruList::iterator, size_t> > mapBlocks;
+    size_t nMaxSize;
+    size_t nSize;
+    uint64_t nHits;
+    uint64_t nMisses;
+
+    void Trim();
+
+public:
+    CBlockCache();
+
+    void SetMaxSize(size_t nMaxSizeIn);
+    //! Whether -blockcachesize allows caching blocks at all
+    bool IsEnabled() const;
+    std::shared_ptr<const CBlock> Get(const CDiskBlockPos& pos);
+    void Insert(const CDiskBlockPos& pos, const std::shared_ptr<const CBlock>& pblock, size_t nBlockSize);
+    void Clear();
+    void GetStats(size_t& nEntriesOut, size_t& nSizeOut, uint64_t& nHitsOut, uint64_t& nMissesOut) const;
+};
+
+extern CBlockFileMapper blockFileMapper;
+extern CBlockCache blockCache;
+
+#endif // KYD_BLOCKCACHE_H
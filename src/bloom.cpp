@@ -190,3 +190,43 @@ void CBloomFilter::UpdateEmptyFull()
     isFull = full;
     isEmpty = empty;
 }
+
+CHashFilter::CHashFilter(unsigned int nElementsIn, double nFPRate) : nElements(nElementsIn), nInserted(0)
+{
+    // Same sizing as CBloomFilter, without the protocol limits
+    uint64_t nBits = std::max((uint64_t)64, (uint64_t)(-1 / LN2SQUARED * std::max(nElementsIn, 1u) * log(nFPRate)));
+    vBits.assign((nBits + 63) / 64, 0);
+    nHashFuncs = std::max(1u, std::min((unsigned int)(vBits.size() * 64 / std::max(nElementsIn, 1u) * LN2), MAX_HASH_FUNCS));
+}
+
+void CHashFilter::insert(const uint256& hash)
+{
+    if (vBits.empty())
+        return;
+
+    // Double hashing over two words of the key gives the k positions
+    uint64_t nBits = vBits.size() * 64;
+    uint64_t h1 = hash.Get64(0);
+    uint64_t h2 = hash.Get64(1) | 1;
+    for (unsigned int i = 0; i < nHashFuncs; i++) {
+        uint64_t nIndex = (h1 + i * h2) % nBits;
+        vBits[nIndex >> 6] |= (uint64_t)1 << (nIndex & 63);
+    }
+    nInserted++;
+}
+
+bool CHashFilter::contains(const uint256& hash) const
+{
+    if (vBits.empty())
+        return true;
+
+    uint64_t nBits = vBits.size() * 64;
+    uint64_t h1 = hash.Get64(0);
+    uint64_t h2 = hash.Get64(1) | 1;
+    for (unsigned int i = 0; i < nHashFuncs; i++) {
+        uint64_t nIndex = (h1 + i * h2) % nBits;
+        if (!(vBits[nIndex >> 6] & ((uint64_t)1 << (nIndex & 63))))
+            return false;
+    }
+    return true;
+}
@@ -99,4 +99,31 @@ public:
     void UpdateEmptyFull();
 };
 
+/**
+ * Bloom filter over keys that already are uniformly distributed hashes, such as zerocoin
+ * serial and pubcoin hashes, used to answer most lookups of unknown keys without going to
+ * the database. Bit positions are taken straight from the key, so a lookup does no hashing.
+ * It is not bound by the protocol size limits of CBloomFilter and has no false negatives.
+ */
+class CHashFilter
+{
+private:
+    std::vector<uint64_t> vBits;
+    unsigned int nHashFuncs;
+    unsigned int nElements;
+    unsigned int nInserted;
+
+public:
+    //! Sized for nElements keys at the given fp rate
+    CHashFilter(unsigned int nElementsIn, double nFPRate);
+    CHashFilter() : nHashFuncs(0), nElements(0), nInserted(0) {}
+
+    void insert(const uint256& hash);
+    bool contains(const uint256& hash) const;
+
+    //! True once more keys were inserted than the filter was sized for
+    bool IsFull() const { return nInserted > nElements; }
+    unsigned int size() const { return nInserted; }
+};
+
 #endif // BITCOIN_BLOOM_H
@@ -15,6 +15,7 @@
 #include "util.h"
 #include "libzerocoin/Denominations.h"
 
+#include <stdexcept>
 #include <vector>
 
 #include <boost/foreach.hpp>
@@ -100,6 +101,91 @@ enum BlockStatus {
     BLOCK_FAILED_MASK = BLOCK_FAILED_VALID | BLOCK_FAILED_CHILD,
 };
 
+/**
+ * Per-denomination zerocoin supply of a block index entry. Every index entry carries one, so the
+ * eight counters are kept in a fixed array instead of a node-based map. The serialized form is
+ * identical to the std::map<CoinDenomination, int64_t> it replaces.
+ */
+class CZerocoinSupply
+{
+private:
+    int64_t anSupply[8];
+
+    static int GetSlot(libzerocoin::CoinDenomination denom)
+    {
+        switch (denom) {
+        case libzerocoin::ZQ_ONE: return 0;
+        case libzerocoin::ZQ_FIVE: return 1;
+        case libzerocoin::ZQ_TEN: return 2;
+        case libzerocoin::ZQ_FIFTY: return 3;
+        case libzerocoin::ZQ_ONE_HUNDRED: return 4;
+        case libzerocoin::ZQ_FIVE_HUNDRED: return 5;
+        case libzerocoin::ZQ_ONE_THOUSAND: return 6;
+        case libzerocoin::ZQ_FIVE_THOUSAND: return 7;
+        default: return -1;
+        }
+    }
+
+public:
+    CZerocoinSupply()
+    {
+        SetNull();
+    }
+
+    void SetNull()
+    {
+        for (int64_t& nSupply : anSupply)
+            nSupply = 0;
+    }
+
+    int64_t& at(libzerocoin::CoinDenomination denom)
+    {
+        int nSlot = GetSlot(denom);
+        if (nSlot < 0)
+            throw std::out_of_range("CZerocoinSupply::at() : invalid denomination");
+        return anSupply[nSlot];
+    }
+
+    const int64_t& at(libzerocoin::CoinDenomination denom) const
+    {
+        return const_cast<CZerocoinSupply*>(this)->at(denom);
+    }
+
+    unsigned int GetSerializeSize(int nType, int nVersion) const
+    {
+        unsigned int nSize = GetSizeOfCompactSize(libzerocoin::zerocoinDenomList.size());
+        for (auto& denom : libzerocoin::zerocoinDenomList)
+            nSize += ::GetSerializeSize(denom, nType, nVersion) + ::GetSerializeSize(at(denom), nType, nVersion);
+        return nSize;
+    }
+
+    template <typename Stream>
+    void Serialize(Stream& s, int nType, int nVersion) const
+    {
+        WriteCompactSize(s, libzerocoin::zerocoinDenomList.size());
+        for (auto& denom : libzerocoin::zerocoinDenomList) {
+            ::Serialize(s, denom, nType, nVersion);
+            ::Serialize(s, at(denom), nType, nVersion);
+        }
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s, int nType, int nVersion)
+    {
+        SetNull();
+        unsigned int nSize = ReadCompactSize(s);
+        for (unsigned int i = 0; i < nSize; i++) {
+            libzerocoin::CoinDenomination denom;
+            int64_t nSupply;
+            ::Unserialize(s, denom, nType, nVersion);
+            ::Unserialize(s, nSupply, nType, nVersion);
+            // unknown denominations were never written with a meaningful supply
+            if (GetSlot(denom) >= 0)
+                at(denom) = nSupply;
+        }
+    }
+};
+
 /** The block chain is a tree shaped structure starting with the
  * genesis block at the root, with each block potentially having multiple
  * candidates to be the next block. A blockindex may have multiple pprev pointing
@@ -179,7 +265,7 @@ public:
     uint32_t nSequenceId;
 
     //! zerocoin specific fields
-    std::map<libzerocoin::CoinDenomination, int64_t> mapZerocoinSupply;
+    CZerocoinSupply mapZerocoinSupply;
     std::vector<libzerocoin::CoinDenomination> vMintDenominationsInBlock;
 
     void SetNull()
@@ -212,9 +298,7 @@ public:
         nNonce = 0;
         nAccumulatorCheckpoint = 0;
         // Start supply of each denomination with 0s
-        for (auto& denom : libzerocoin::zerocoinDenomList) {
-            mapZerocoinSupply.insert(make_pair(denom, 0));
-        }
+        mapZerocoinSupply.SetNull();
         vMintDenominationsInBlock.clear();
     }
 
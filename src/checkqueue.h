@@ -5,7 +5,13 @@
 #ifndef BITCOIN_CHECKQUEUE_H
 #define BITCOIN_CHECKQUEUE_H
 
+#include "utiltime.h"
+
 #include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <stdint.h>
 #include <vector>
 
 #include <boost/foreach.hpp>
@@ -16,21 +22,56 @@
 template <typename T>
 class CCheckQueueControl;
 
-/** 
+/** Counters of a CCheckQueue, accumulated since it was created */
+struct CCheckQueueStats {
+    //! Number of worker threads (not counting the master)
+    unsigned int nWorkers;
+    //! Verifications performed
+    uint64_t nChecks;
+    //! Batches taken from a queue, including the stolen ones
+    uint64_t nBatches;
+    //! Batches taken from the queue of another worker
+    uint64_t nSteals;
+    //! Microseconds the worker threads slept for lack of work
+    int64_t nIdleMicros;
+    //! Microseconds the master spent in Wait() for the workers to finish
+    int64_t nWaitMicros;
+};
+
+/**
  * Queue for verifications that have to be performed.
   * The verifications are represented by a type T, which must provide an
-  * operator(), returning a bool.
+  * operator(), returning a bool, and a swap() with every type of check
+  * added to the queue. A T that wraps several kinds of checks lets one
+  * queue verify all of them.
   *
   * One thread (the master) is assumed to push batches of verifications
   * onto the queue, where they are processed by N-1 worker threads. When
   * the master is done adding work, it temporarily joins the worker pool
   * as an N'th worker, until all jobs are done.
+  *
+  * Every worker has its own queue, which the master fills in turn. A worker
+  * takes batches from the back of its own queue and, when that is empty,
+  * steals from the front of the others, as does the master in Wait(). The
+  * queues are plain deques under a mutex, locked only by their owner, the
+  * master once per slice it adds and the odd thief, so no lock is shared
+  * by all threads while there is work to do.
   */
 template <typename T>
 class CCheckQueue
 {
 private:
-    //! Mutex to protect the inner state
+    //! The checks of one worker
+    struct WorkerQueue {
+        boost::mutex mutex;
+        std::deque<T> checks;
+    };
+
+    //! The worker queues; with more workers than queues, workers share them
+    std::unique_ptr<WorkerQueue[]> queues;
+    const unsigned int nQueues;
+
+    //! Mutex for the sleeping threads, used with the condition variables only
     boost::mutex mutex;
 
     //! Worker threads block on this when out of work
@@ -39,122 +80,205 @@ private:
     //! Master thread blocks on this when out of work
     boost::condition_variable condMaster;
 
-    //! The queue of elements to be processed.
-    //! As the order of booleans doesn't matter, it is used as a LIFO (stack)
-    std::vector<T> queue;
+    //! The number of worker threads that started, not counting the master
+    std::atomic<unsigned int> nWorkers;
 
-    //! The number of workers (including the master) that are idle.
-    int nIdle;
+    //! The number of workers sleeping on condWorker
+    std::atomic<int> nSleeping;
 
-    //! The total number of workers (including the master).
-    int nTotal;
-
-    //! The temporary evaluation result.
-    bool fAllOk;
+    //! The number of checks in the worker queues
+    std::atomic<int> nQueued;
 
     /**
      * Number of verifications that haven't completed yet.
-     * This includes elements that are not anymore in queue, but still in
-     * worker's own batches.
+     * This includes elements that are not anymore in a queue, but still in
+     * a worker's own batch.
      */
-    unsigned int nTodo;
+    std::atomic<unsigned int> nTodo;
 
-    //! Whether we're shutting down.
-    bool fQuit;
+    //! The temporary evaluation result.
+    std::atomic<bool> fAllOk;
+
+    //! The queue the master adds to next; only used by the master
+    unsigned int nNextQueue;
 
     //! The maximum number of elements to be processed in one batch
     unsigned int nBatchSize;
 
-    /** Internal function that does bulk of the verification work. */
-    bool Loop(bool fMaster = false)
+    std::atomic<uint64_t> nChecks;
+    std::atomic<uint64_t> nBatches;
+    std::atomic<uint64_t> nSteals;
+    std::atomic<int64_t> nIdleMicros;
+    std::atomic<int64_t> nWaitMicros;
+
+    //! Number of queues that are in use
+    unsigned int ActiveQueues() const
     {
-        boost::condition_variable& cond = fMaster ? condMaster : condWorker;
-        std::vector<T> vChecks;
-        vChecks.reserve(nBatchSize);
-        unsigned int nNow = 0;
-        bool fOk = true;
-        do {
-            {
-                boost::unique_lock<boost::mutex> lock(mutex);
-                // first do the clean-up of the previous loop run (allowing us to do it in the same critsect)
-                if (nNow) {
-                    fAllOk &= fOk;
-                    nTodo -= nNow;
-                    if (nTodo == 0 && !fMaster)
-                        // We processed the last element; inform the master he can exit and return the result
-                        condMaster.notify_one();
-                } else {
-                    // first iteration
-                    nTotal++;
-                }
-                // logically, the do loop starts here
-                while (queue.empty()) {
-                    if ((fMaster || fQuit) && nTodo == 0) {
-                        nTotal--;
-                        bool fRet = fAllOk;
-                        // reset the status for new work later
-                        if (fMaster)
-                            fAllOk = true;
-                        // return the current status
-                        return fRet;
-                    }
-                    nIdle++;
-                    cond.wait(lock); // wait
-                    nIdle--;
-                }
-                // Decide how many work units to process now.
-                // * Do not try to do everything at once, but aim for increasingly smaller batches so
-                //   all workers finish approximately simultaneously.
-                // * Try to account for idle jobs which will instantly start helping.
-                // * Don't do batches smaller than 1 (duh), or larger than nBatchSize.
-                nNow = std::max(1U, std::min(nBatchSize, (unsigned int)queue.size() / (nTotal + nIdle + 1)));
-                vChecks.resize(nNow);
-                for (unsigned int i = 0; i < nNow; i++) {
-                    // We want the lock on the mutex to be as short as possible, so swap jobs from the global
-                    // queue to the local batch vector instead of copying.
-                    vChecks[i].swap(queue.back());
-                    queue.pop_back();
-                }
-                // Check whether we need to do work at all
-                fOk = fAllOk;
+        return std::min(nQueues, std::max(1U, nWorkers.load()));
+    }
+
+    /**
+     * Move a batch of checks from q to vChecks. The owner takes from the back
+     * and thieves from the front, so that they rarely want the same checks.
+     */
+    bool TakeBatch(WorkerQueue& q, std::vector<T>& vChecks, bool fSteal)
+    {
+        boost::unique_lock<boost::mutex> lock(q.mutex);
+        if (q.checks.empty())
+            return false;
+        // Decide how many work units to process now.
+        // * Take at most half of the queue, so that there is something left to
+        //   steal and all workers finish approximately simultaneously. The
+        //   batches get smaller as the queue drains.
+        // * Don't do batches smaller than 1 (duh), or larger than nBatchSize.
+        unsigned int nNow = std::max(1U, std::min(nBatchSize, (unsigned int)q.checks.size() / 2));
+        vChecks.resize(nNow);
+        for (unsigned int i = 0; i < nNow; i++) {
+            // Swap instead of copying, to keep the lock short
+            if (fSteal) {
+                vChecks[i].swap(q.checks.front());
+                q.checks.pop_front();
+            } else {
+                vChecks[i].swap(q.checks.back());
+                q.checks.pop_back();
             }
-            // execute work
-            BOOST_FOREACH (T& check, vChecks)
-                if (fOk)
-                    fOk = check();
-            vChecks.clear();
-        } while (true);
+        }
+        nQueued -= nNow;
+        nBatches++;
+        if (fSteal)
+            nSteals++;
+        return true;
+    }
+
+    /** Get a batch from queue nOwn, or steal one. The master passes nQueues as it has no queue. */
+    bool GetWork(unsigned int nOwn, std::vector<T>& vChecks)
+    {
+        if (nOwn < nQueues && TakeBatch(queues[nOwn], vChecks, false))
+            return true;
+        unsigned int nActive = ActiveQueues();
+        for (unsigned int i = 1; i <= nActive; i++) {
+            unsigned int nVictim = (nOwn + i) % nActive;
+            if (nVictim != nOwn && TakeBatch(queues[nVictim], vChecks, true))
+                return true;
+        }
+        return false;
+    }
+
+    /** Run the checks in vChecks and account for them. */
+    void Process(std::vector<T>& vChecks)
+    {
+        // Skip the work once a check failed
+        bool fOk = fAllOk;
+        BOOST_FOREACH (T& check, vChecks)
+            if (fOk)
+                fOk = check();
+        if (!fOk)
+            fAllOk = false;
+        unsigned int nNow = vChecks.size();
+        vChecks.clear();
+        nChecks += nNow;
+        if ((nTodo -= nNow) == 0) {
+            // We processed the last element; inform the master he can exit and return the result
+            boost::unique_lock<boost::mutex> lock(mutex);
+            condMaster.notify_one();
+        }
     }
 
 public:
-    //! Create a new check queue
-    CCheckQueue(unsigned int nBatchSizeIn) : nIdle(0), nTotal(0), fAllOk(true), nTodo(0), fQuit(false), nBatchSize(nBatchSizeIn) {}
+    //! Create a new check queue with room for nQueuesIn workers
+    CCheckQueue(unsigned int nBatchSizeIn, unsigned int nQueuesIn) : queues(new WorkerQueue[std::max(1U, nQueuesIn)]), nQueues(std::max(1U, nQueuesIn)),
+                                                                     nWorkers(0), nSleeping(0), nQueued(0), nTodo(0), fAllOk(true), nNextQueue(0), nBatchSize(nBatchSizeIn),
+                                                                     nChecks(0), nBatches(0), nSteals(0), nIdleMicros(0), nWaitMicros(0) {}
 
     //! Worker thread
     void Thread()
     {
-        Loop();
+        const unsigned int nOwn = nWorkers++ % nQueues;
+        std::vector<T> vChecks;
+        vChecks.reserve(nBatchSize);
+        while (true) {
+            if (GetWork(nOwn, vChecks)) {
+                Process(vChecks);
+                continue;
+            }
+            int64_t nIdleStart = GetTimeMicros();
+            {
+                boost::unique_lock<boost::mutex> lock(mutex);
+                // Add() checks nSleeping after publishing nQueued, and we check
+                // nQueued after publishing nSleeping, so one of us sees the other.
+                nSleeping++;
+                try {
+                    while (nQueued <= 0)
+                        condWorker.wait(lock); // wait
+                } catch (...) {
+                    nSleeping--;
+                    throw;
+                }
+                nSleeping--;
+            }
+            nIdleMicros += GetTimeMicros() - nIdleStart;
+        }
     }
 
     //! Wait until execution finishes, and return whether all evaluations where successful.
     bool Wait()
     {
-        return Loop(true);
+        std::vector<T> vChecks;
+        vChecks.reserve(nBatchSize);
+        while (nTodo > 0) {
+            if (GetWork(nQueues, vChecks)) {
+                Process(vChecks);
+                continue;
+            }
+            // What is left is being processed by the workers
+            int64_t nWaitStart = GetTimeMicros();
+            {
+                boost::unique_lock<boost::mutex> lock(mutex);
+                while (nTodo > 0 && nQueued <= 0)
+                    condMaster.wait(lock);
+            }
+            nWaitMicros += GetTimeMicros() - nWaitStart;
+        }
+        // reset the status for new work later
+        bool fRet = fAllOk;
+        fAllOk = true;
+        return fRet;
     }
 
     //! Add a batch of checks to the queue
-    void Add(std::vector<T>& vChecks)
+    template <typename C>
+    void Add(std::vector<C>& vChecks)
     {
-        boost::unique_lock<boost::mutex> lock(mutex);
-        BOOST_FOREACH (T& check, vChecks) {
-            queue.push_back(T());
-            check.swap(queue.back());
-        }
+        if (vChecks.empty())
+            return;
         nTodo += vChecks.size();
-        if (vChecks.size() == 1)
-            condWorker.notify_one();
-        else if (vChecks.size() > 1)
-            condWorker.notify_all();
+        nQueued += vChecks.size();
+
+        // Spread large batches over the workers, and give small ones (a
+        // transaction's inputs) to the workers in turn.
+        unsigned int nActive = ActiveQueues();
+        unsigned int nSlice = std::max((size_t)1, vChecks.size() / nActive);
+        size_t nPos = 0;
+        while (nPos < vChecks.size()) {
+            size_t nEnd = std::min(vChecks.size(), nPos + nSlice);
+            // Give the remainder to the last slice rather than making a slice of it
+            if (vChecks.size() - nEnd < nSlice)
+                nEnd = vChecks.size();
+            WorkerQueue& q = queues[nNextQueue++ % nActive];
+            boost::unique_lock<boost::mutex> lock(q.mutex);
+            for (; nPos < nEnd; nPos++) {
+                q.checks.push_back(T());
+                q.checks.back().swap(vChecks[nPos]);
+            }
+        }
+
+        if (nSleeping > 0) {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            if (vChecks.size() == 1)
+                condWorker.notify_one();
+            else
+                condWorker.notify_all();
+        }
     }
 
     ~CCheckQueue()
@@ -163,12 +287,21 @@ public:
 
     bool IsIdle()
     {
-        boost::unique_lock<boost::mutex> lock(mutex);
-        return (nTotal == nIdle && nTodo == 0 && fAllOk == true);
+        return (nTodo == 0 && nQueued == 0 && fAllOk == true);
+    }
+
+    void GetStats(CCheckQueueStats& stats) const
+    {
+        stats.nWorkers = nWorkers;
+        stats.nChecks = nChecks;
+        stats.nBatches = nBatches;
+        stats.nSteals = nSteals;
+        stats.nIdleMicros = nIdleMicros;
+        stats.nWaitMicros = nWaitMicros;
     }
 };
 
-/** 
+/**
  * RAII-style controller object for a CCheckQueue that guarantees the passed
  * queue is finished before continuing.
  */
@@ -198,7 +331,8 @@ public:
         return fRet;
     }
 
-    void Add(std::vector<T>& vChecks)
+    template <typename C>
+    void Add(std::vector<C>& vChecks)
     {
         if (pqueue != NULL)
             pqueue->Add(vChecks);
@@ -0,0 +1,111 @@
+// Copyright (c) 2018-2019 The KYD developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+// ECHO-512 of 64-byte messages using AES-NI, for the X11 chain.
+// Must be compiled with AES-NI and SSSE3 enabled; only call it after checking
+// that the CPU supports both (see crypto/x11.cpp).
+
+#if defined(ENABLE_AESNI)
+
+#include <stddef.h>
+#include <stdint.h>
+#include <immintrin.h>
+
+namespace echo_aesni
+{
+namespace
+{
+const int ROUNDS = 10;
+
+inline __m128i Mul2(__m128i x)
+{
+    __m128i carry = _mm_cmpgt_epi8(_mm_setzero_si128(), x);
+    return _mm_xor_si128(_mm_add_epi8(x, x), _mm_and_si128(carry, _mm_set1_epi8(0x1b)));
+}
+
+inline void MixColumn(__m128i& a, __m128i& b, __m128i& c, __m128i& d)
+{
+    __m128i ab = _mm_xor_si128(a, b);
+    __m128i bc = _mm_xor_si128(b, c);
+    __m128i cd = _mm_xor_si128(c, d);
+    __m128i abx = Mul2(ab);
+    __m128i bcx = Mul2(bc);
+    __m128i cdx = Mul2(cd);
+    __m128i a0 = a, c0 = c;
+    a = _mm_xor_si128(_mm_xor_si128(abx, bc), d);
+    b = _mm_xor_si128(_mm_xor_si128(bcx, a0), cd);
+    c = _mm_xor_si128(_mm_xor_si128(cdx, ab), d);
+    d = _mm_xor_si128(_mm_xor_si128(_mm_xor_si128(abx, bcx), _mm_xor_si128(cdx, ab)), c0);
+}
+
+void Hash64(unsigned char* out, const unsigned char* in)
+{
+    // Words 0-7 hold the chaining value, words 8-15 the single padded block:
+    // the message, the 0x80 padding byte, the output size (512) in the two
+    // bytes before the last word and the 512-bit message length as the last word.
+    const __m128i iv = _mm_set_epi32(0, 0, 0, 512);
+    __m128i w[16];
+    for (int i = 0; i < 8; i++)
+        w[i] = iv;
+    for (int i = 0; i < 4; i++)
+        w[8 + i] = _mm_loadu_si128((const __m128i*)(in + 16 * i));
+    w[12] = _mm_set_epi32(0, 0, 0, 0x80);
+    w[13] = _mm_setzero_si128();
+    w[14] = _mm_set_epi32(0x02000000, 0, 0, 0);
+    w[15] = _mm_set_epi32(0, 0, 0, 512);
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set_epi32(0, 0, 0, 1);
+    // The 128-bit counter starts at the message length and goes up by one per
+    // word; it cannot carry out of its low 32 bits here.
+    __m128i k = _mm_set_epi32(0, 0, 0, 512);
+    for (int r = 0; r < ROUNDS; r++) {
+        // BIG.SubWords
+        for (int i = 0; i < 16; i++) {
+            w[i] = _mm_aesenc_si128(_mm_aesenc_si128(w[i], k), zero);
+            k = _mm_add_epi32(k, one);
+        }
+
+        // BIG.ShiftRows
+        __m128i t = w[1];
+        w[1] = w[5];
+        w[5] = w[9];
+        w[9] = w[13];
+        w[13] = t;
+        t = w[2];
+        w[2] = w[10];
+        w[10] = t;
+        t = w[6];
+        w[6] = w[14];
+        w[14] = t;
+        t = w[15];
+        w[15] = w[11];
+        w[11] = w[7];
+        w[7] = w[3];
+        w[3] = t;
+
+        // BIG.MixColumns
+        MixColumn(w[0], w[1], w[2], w[3]);
+        MixColumn(w[4], w[5], w[6], w[7]);
+        MixColumn(w[8], w[9], w[10], w[11]);
+        MixColumn(w[12], w[13], w[14], w[15]);
+    }
+
+    // BIG.Final, only the half of the chaining value that makes the output
+    for (int i = 0; i < 4; i++) {
+        __m128i m = _mm_loadu_si128((const __m128i*)(in + 16 * i));
+        __m128i v = _mm_xor_si128(_mm_xor_si128(iv, m), _mm_xor_si128(w[i], w[i + 8]));
+        _mm_storeu_si128((__m128i*)(out + 16 * i), v);
+    }
+}
+} // namespace
+
+void Hash64(unsigned char* out, const unsigned char* in, size_t blocks)
+{
+    for (size_t n = 0; n < blocks; n++)
+        Hash64(out + 64 * n, in + 64 * n);
+}
+} // namespace echo_aesni
+
+#endif
@@ -0,0 +1,156 @@
+// Copyright (c) 2018-2019 The KYD developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+// Groestl-512 of 64-byte messages using AES-NI, for the X11 and Quark chains.
+// Must be compiled with AES-NI and SSSE3 enabled; only call it after checking
+// that the CPU supports both (see crypto/x11.cpp).
+
+#if defined(ENABLE_AESNI)
+
+#include <stddef.h>
+#include <stdint.h>
+#include <immintrin.h>
+
+namespace groestl_aesni
+{
+namespace
+{
+/**
+ * The state is kept one row per register: byte j of row i is the byte at
+ * column j, row i of the 8x16 Groestl-1024 state, that is byte 8*j+i of the
+ * serialized state.
+ *
+ * AESENCLAST with a zero key computes SubBytes(ShiftRows(x)). Shuffling the
+ * row with the inverse of the AES ShiftRows composed with the Groestl
+ * ShiftBytes rotation first leaves SubBytes(ShiftBytes(row)), so both steps
+ * cost one PSHUFB and one AESENCLAST per row. SHIFT_BASE is that shuffle for
+ * a rotation by zero; a rotation by s adds s to every index modulo 16.
+ */
+const uint8_t SHIFT_BASE[16] = {0, 13, 10, 7, 4, 1, 14, 11, 8, 5, 2, 15, 12, 9, 6, 3};
+const int SHIFT_P[8] = {0, 1, 2, 3, 4, 5, 6, 11};
+const int SHIFT_Q[8] = {1, 3, 5, 11, 0, 2, 4, 6};
+const int ROUNDS = 14;
+
+inline __m128i Mul2(__m128i x)
+{
+    __m128i carry = _mm_cmpgt_epi8(_mm_setzero_si128(), x);
+    return _mm_xor_si128(_mm_add_epi8(x, x), _mm_and_si128(carry, _mm_set1_epi8(0x1b)));
+}
+
+/** MixBytes on the eight rows, with the sharing of terms from the Groestl submission */
+inline void MixBytes(__m128i& a0, __m128i& a1, __m128i& a2, __m128i& a3, __m128i& a4, __m128i& a5, __m128i& a6, __m128i& a7)
+{
+    __m128i t0 = _mm_xor_si128(a0, a1), t1 = _mm_xor_si128(a1, a2), t2 = _mm_xor_si128(a2, a3), t3 = _mm_xor_si128(a3, a4);
+    __m128i t4 = _mm_xor_si128(a4, a5), t5 = _mm_xor_si128(a5, a6), t6 = _mm_xor_si128(a6, a7), t7 = _mm_xor_si128(a7, a0);
+    __m128i y0 = _mm_xor_si128(_mm_xor_si128(t0, t2), a6), y1 = _mm_xor_si128(_mm_xor_si128(t1, t3), a7);
+    __m128i y2 = _mm_xor_si128(_mm_xor_si128(t2, t4), a0), y3 = _mm_xor_si128(_mm_xor_si128(t3, t5), a1);
+    __m128i y4 = _mm_xor_si128(_mm_xor_si128(t4, t6), a2), y5 = _mm_xor_si128(_mm_xor_si128(t5, t7), a3);
+    __m128i y6 = _mm_xor_si128(_mm_xor_si128(t6, t0), a4), y7 = _mm_xor_si128(_mm_xor_si128(t7, t1), a5);
+    // x[i] = t[i] ^ t[i + 3]; b[i] = 2 * (2 * x[i + 3] ^ y[i + 7]) ^ y[i + 4]
+    a0 = _mm_xor_si128(Mul2(_mm_xor_si128(Mul2(_mm_xor_si128(t3, t6)), y7)), y4);
+    a1 = _mm_xor_si128(Mul2(_mm_xor_si128(Mul2(_mm_xor_si128(t4, t7)), y0)), y5);
+    a2 = _mm_xor_si128(Mul2(_mm_xor_si128(Mul2(_mm_xor_si128(t5, t0)), y1)), y6);
+    a3 = _mm_xor_si128(Mul2(_mm_xor_si128(Mul2(_mm_xor_si128(t6, t1)), y2)), y7);
+    a4 = _mm_xor_si128(Mul2(_mm_xor_si128(Mul2(_mm_xor_si128(t7, t2)), y3)), y0);
+    a5 = _mm_xor_si128(Mul2(_mm_xor_si128(Mul2(_mm_xor_si128(t0, t3)), y4)), y1);
+    a6 = _mm_xor_si128(Mul2(_mm_xor_si128(Mul2(_mm_xor_si128(t1, t4)), y5)), y2);
+    a7 = _mm_xor_si128(Mul2(_mm_xor_si128(Mul2(_mm_xor_si128(t2, t5)), y6)), y3);
+}
+
+inline void MixBytes(__m128i a[8])
+{
+    MixBytes(a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7]);
+}
+
+struct Masks {
+    __m128i p[8];
+    __m128i q[8];
+    __m128i pcol; //!< (j << 4) for column j, the P round constant without the round number
+    __m128i qcol; //!< 0xff ^ (j << 4), the Q round constant of row 7 without the round number
+
+    Masks()
+    {
+        __m128i base = _mm_loadu_si128((const __m128i*)SHIFT_BASE);
+        for (int i = 0; i < 8; i++) {
+            p[i] = _mm_and_si128(_mm_add_epi8(base, _mm_set1_epi8(SHIFT_P[i])), _mm_set1_epi8(15));
+            q[i] = _mm_and_si128(_mm_add_epi8(base, _mm_set1_epi8(SHIFT_Q[i])), _mm_set1_epi8(15));
+        }
+        pcol = _mm_set_epi8((char)0xf0, (char)0xe0, (char)0xd0, (char)0xc0, (char)0xb0, (char)0xa0, (char)0x90, (char)0x80,
+            0x70, 0x60, 0x50, 0x40, 0x30, 0x20, 0x10, 0x00);
+        qcol = _mm_xor_si128(pcol, _mm_set1_epi8((char)0xff));
+    }
+};
+
+void PermP(__m128i p[8], const Masks& m)
+{
+    const __m128i zero = _mm_setzero_si128();
+    for (int r = 0; r < ROUNDS; r++) {
+        p[0] = _mm_xor_si128(p[0], _mm_xor_si128(m.pcol, _mm_set1_epi8((char)r)));
+        for (int i = 0; i < 8; i++)
+            p[i] = _mm_aesenclast_si128(_mm_shuffle_epi8(p[i], m.p[i]), zero);
+        MixBytes(p);
+    }
+}
+
+void PermQ(__m128i q[8], const Masks& m)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi8((char)0xff);
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < 7; i++)
+            q[i] = _mm_xor_si128(q[i], ones);
+        q[7] = _mm_xor_si128(q[7], _mm_xor_si128(m.qcol, _mm_set1_epi8((char)r)));
+        for (int i = 0; i < 8; i++)
+            q[i] = _mm_aesenclast_si128(_mm_shuffle_epi8(q[i], m.q[i]), zero);
+        MixBytes(q);
+    }
+}
+
+void Hash64(unsigned char* out, const unsigned char* in, const Masks& m)
+{
+    // The padded block is the message in columns 0-7, the 0x80 padding byte in
+    // column 8 and a block count of one in the last byte. The IV is zero except
+    // for the output size (512, big endian) in the last two bytes.
+    alignas(16) unsigned char rows[8][16] = {};
+    for (int j = 0; j < 8; j++)
+        for (int i = 0; i < 8; i++)
+            rows[i][j] = in[8 * j + i];
+    rows[0][8] = 0x80;
+    rows[7][15] = 0x01;
+
+    __m128i h[8], p[8], q[8];
+    for (int i = 0; i < 8; i++) {
+        q[i] = _mm_load_si128((const __m128i*)rows[i]);
+        h[i] = _mm_setzero_si128();
+    }
+    h[6] = _mm_insert_epi16(h[6], 0x0200, 7);
+    for (int i = 0; i < 8; i++)
+        p[i] = _mm_xor_si128(q[i], h[i]);
+
+    PermP(p, m);
+    PermQ(q, m);
+    for (int i = 0; i < 8; i++) {
+        h[i] = _mm_xor_si128(h[i], _mm_xor_si128(p[i], q[i]));
+        p[i] = h[i];
+    }
+
+    // Output transformation, truncated to the last eight columns
+    PermP(p, m);
+    for (int i = 0; i < 8; i++)
+        _mm_store_si128((__m128i*)rows[i], _mm_xor_si128(p[i], h[i]));
+    for (int j = 0; j < 8; j++)
+        for (int i = 0; i < 8; i++)
+            out[8 * j + i] = rows[i][8 + j];
+}
+} // namespace
+
+void Hash64(unsigned char* out, const unsigned char* in, size_t blocks)
+{
+    Masks m;
+    for (size_t n = 0; n < blocks; n++)
+        Hash64(out + 64 * n, in + 64 * n, m);
+}
+} // namespace groestl_aesni
+
+#endif
@@ -0,0 +1,92 @@
+// Copyright (c) 2018-2019 The KYD developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+// SHA-256 transform using the SHA extensions (SHA-NI).
+// Must be compiled with SHA and SSE4.1 enabled; only call it after checking
+// that the CPU supports both (see crypto/sha256.cpp).
+
+#if defined(ENABLE_SHANI)
+
+#include <stddef.h>
+#include <stdint.h>
+#include <immintrin.h>
+
+namespace sha256_shani
+{
+namespace
+{
+// The round constants, four per quad round
+const uint32_t K[64] __attribute__((aligned(16))) = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+/** Four rounds on the ABEF/CDGH state with message words w */
+inline void QuadRound(__m128i& abef, __m128i& cdgh, __m128i w, int i)
+{
+    __m128i kw = _mm_add_epi32(w, _mm_load_si128((const __m128i*)&K[4 * i]));
+    cdgh = _mm_sha256rnds2_epu32(cdgh, abef, kw);
+    abef = _mm_sha256rnds2_epu32(abef, cdgh, _mm_shuffle_epi32(kw, 0x0e));
+}
+
+/** The next four message words from the previous sixteen, in four registers w0 (oldest) to w3 */
+inline __m128i Schedule(__m128i w0, __m128i w1, __m128i w2, __m128i w3)
+{
+    __m128i x = _mm_add_epi32(_mm_sha256msg1_epu32(w0, w1), _mm_alignr_epi8(w3, w2, 4));
+    return _mm_sha256msg2_epu32(x, w3);
+}
+} // namespace
+
+void Transform(uint32_t* s, const unsigned char* chunk, size_t blocks)
+{
+    const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    // The SHA instructions want the state as ABEF and CDGH
+    __m128i dcba = _mm_loadu_si128((const __m128i*)&s[0]);
+    __m128i hgfe = _mm_loadu_si128((const __m128i*)&s[4]);
+    __m128i cdab = _mm_shuffle_epi32(dcba, 0xb1);
+    __m128i efgh = _mm_shuffle_epi32(hgfe, 0x1b);
+    __m128i abef = _mm_alignr_epi8(cdab, efgh, 8);
+    __m128i cdgh = _mm_blend_epi16(efgh, cdab, 0xf0);
+
+    while (blocks--) {
+        const __m128i abef_save = abef, cdgh_save = cdgh;
+        __m128i w0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(chunk + 0)), mask);
+        __m128i w1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(chunk + 16)), mask);
+        __m128i w2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(chunk + 32)), mask);
+        __m128i w3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(chunk + 48)), mask);
+
+        QuadRound(abef, cdgh, w0, 0);
+        QuadRound(abef, cdgh, w1, 1);
+        QuadRound(abef, cdgh, w2, 2);
+        QuadRound(abef, cdgh, w3, 3);
+        for (int i = 4; i < 16; i += 4) {
+            w0 = Schedule(w0, w1, w2, w3);
+            QuadRound(abef, cdgh, w0, i);
+            w1 = Schedule(w1, w2, w3, w0);
+            QuadRound(abef, cdgh, w1, i + 1);
+            w2 = Schedule(w2, w3, w0, w1);
+            QuadRound(abef, cdgh, w2, i + 2);
+            w3 = Schedule(w3, w0, w1, w2);
+            QuadRound(abef, cdgh, w3, i + 3);
+        }
+
+        abef = _mm_add_epi32(abef, abef_save);
+        cdgh = _mm_add_epi32(cdgh, cdgh_save);
+        chunk += 64;
+    }
+
+    __m128i feba = _mm_shuffle_epi32(abef, 0x1b);
+    __m128i dchg = _mm_shuffle_epi32(cdgh, 0xb1);
+    _mm_storeu_si128((__m128i*)&s[0], _mm_blend_epi16(feba, dchg, 0xf0));
+    _mm_storeu_si128((__m128i*)&s[4], _mm_alignr_epi8(dchg, feba, 8));
+}
+} // namespace sha256_shani
+
+#endif
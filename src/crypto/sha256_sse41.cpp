@@ -0,0 +1,176 @@
+// Copyright (c) 2018-2019 The KYD developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+// Double SHA-256 of four 64-byte messages at once, one per 32-bit lane of an
+// SSE register. Must be compiled with SSE4.1 enabled; only call it after
+// checking that the CPU supports it (see crypto/sha256.cpp).
+
+#if defined(ENABLE_SSE41)
+
+#include <stdint.h>
+#include <immintrin.h>
+
+#include "crypto/common.h"
+
+namespace sha256d64_sse41
+{
+namespace
+{
+typedef __m128i V;
+
+const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+const uint32_t IV[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+uint32_t inline sigma0(uint32_t x) { return (x >> 7 | x << 25) ^ (x >> 18 | x << 14) ^ (x >> 3); }
+uint32_t inline sigma1(uint32_t x) { return (x >> 17 | x << 15) ^ (x >> 19 | x << 13) ^ (x >> 10); }
+
+/**
+ * K + W for the block that follows a 64-byte message: all padding, so the
+ * same for every message and computed once. Built on first use rather than
+ * at startup, so that no code of this file runs before the CPU check.
+ */
+struct PaddingSchedule {
+    uint32_t kw[64];
+
+    PaddingSchedule()
+    {
+        uint32_t w[64] = {0x80000000};
+        w[15] = 512;
+        for (int i = 16; i < 64; i++)
+            w[i] = sigma1(w[i - 2]) + w[i - 7] + sigma0(w[i - 15]) + w[i - 16];
+        for (int i = 0; i < 64; i++)
+            kw[i] = K[i] + w[i];
+    }
+};
+const PaddingSchedule& Padding()
+{
+    static const PaddingSchedule padding;
+    return padding;
+}
+
+V inline Set(uint32_t x) { return _mm_set1_epi32(x); }
+V inline Add(V x, V y) { return _mm_add_epi32(x, y); }
+V inline Add(V x, V y, V z) { return Add(Add(x, y), z); }
+V inline Xor(V x, V y) { return _mm_xor_si128(x, y); }
+V inline Xor(V x, V y, V z) { return Xor(Xor(x, y), z); }
+V inline Or(V x, V y) { return _mm_or_si128(x, y); }
+V inline And(V x, V y) { return _mm_and_si128(x, y); }
+V inline Rot(V x, int n) { return Or(_mm_srli_epi32(x, n), _mm_slli_epi32(x, 32 - n)); }
+
+V inline Ch(V x, V y, V z) { return Xor(z, And(x, Xor(y, z))); }
+V inline Maj(V x, V y, V z) { return Or(And(x, y), And(z, Or(x, y))); }
+V inline Sigma0(V x) { return Xor(Rot(x, 2), Rot(x, 13), Rot(x, 22)); }
+V inline Sigma1(V x) { return Xor(Rot(x, 6), Rot(x, 11), Rot(x, 25)); }
+V inline sigma0(V x) { return Xor(Rot(x, 7), Rot(x, 18), _mm_srli_epi32(x, 3)); }
+V inline sigma1(V x) { return Xor(Rot(x, 17), Rot(x, 19), _mm_srli_epi32(x, 10)); }
+
+/** One round of SHA-256; kw is the round constant plus the message word. */
+void inline Round(V a, V b, V c, V& d, V e, V f, V g, V& h, V kw)
+{
+    V t1 = Add(h, Sigma1(e), Add(Ch(e, f, g), kw));
+    V t2 = Add(Sigma0(a), Maj(a, b, c));
+    d = Add(d, t1);
+    h = Add(t1, t2);
+}
+
+/** Extend the sixteen message words in w to the full schedule and add the round constants. */
+void inline Schedule(V w[64])
+{
+    for (int i = 16; i < 64; i++)
+        w[i] = Add(sigma1(w[i - 2]), w[i - 7], Add(sigma0(w[i - 15]), w[i - 16]));
+    for (int i = 0; i < 64; i++)
+        w[i] = Add(w[i], Set(K[i]));
+}
+
+/** The 64 rounds on s, with the K + W values kw[i] made by get(i). */
+template <typename F>
+void inline Compress(V s[8], F get)
+{
+    V a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+    for (int i = 0; i < 64; i += 8) {
+        Round(a, b, c, d, e, f, g, h, get(i));
+        Round(h, a, b, c, d, e, f, g, get(i + 1));
+        Round(g, h, a, b, c, d, e, f, get(i + 2));
+        Round(f, g, h, a, b, c, d, e, get(i + 3));
+        Round(e, f, g, h, a, b, c, d, get(i + 4));
+        Round(d, e, f, g, h, a, b, c, get(i + 5));
+        Round(c, d, e, f, g, h, a, b, get(i + 6));
+        Round(b, c, d, e, f, g, h, a, get(i + 7));
+    }
+    s[0] = Add(s[0], a);
+    s[1] = Add(s[1], b);
+    s[2] = Add(s[2], c);
+    s[3] = Add(s[3], d);
+    s[4] = Add(s[4], e);
+    s[5] = Add(s[5], f);
+    s[6] = Add(s[6], g);
+    s[7] = Add(s[7], h);
+}
+
+struct FromArray {
+    const V* kw;
+    V operator()(int i) const { return kw[i]; }
+};
+
+struct FromPadding {
+    const uint32_t* kw;
+    V operator()(int i) const { return Set(kw[i]); }
+};
+
+/** Big-endian word offset/4 of each of the four messages */
+V inline Read4(const unsigned char* in, int offset)
+{
+    return _mm_set_epi32(ReadBE32(in + 192 + offset), ReadBE32(in + 128 + offset), ReadBE32(in + 64 + offset), ReadBE32(in + offset));
+}
+
+void inline Write4(unsigned char* out, int offset, V v)
+{
+    WriteBE32(out + offset, _mm_extract_epi32(v, 0));
+    WriteBE32(out + 32 + offset, _mm_extract_epi32(v, 1));
+    WriteBE32(out + 64 + offset, _mm_extract_epi32(v, 2));
+    WriteBE32(out + 96 + offset, _mm_extract_epi32(v, 3));
+}
+} // namespace
+
+void Transform_4way(unsigned char* out, const unsigned char* in)
+{
+    V s[8], w[64];
+
+    // First hash: the message, then the padding block
+    for (int i = 0; i < 8; i++)
+        s[i] = Set(IV[i]);
+    for (int i = 0; i < 16; i++)
+        w[i] = Read4(in, 4 * i);
+    Schedule(w);
+    FromArray message = {w};
+    Compress(s, message);
+    FromPadding pad = {Padding().kw};
+    Compress(s, pad);
+
+    // Second hash: the 32-byte first hash, padded to one block
+    for (int i = 0; i < 8; i++) {
+        w[i] = s[i];
+        s[i] = Set(IV[i]);
+    }
+    w[8] = Set(0x80000000);
+    for (int i = 9; i < 15; i++)
+        w[i] = _mm_setzero_si128();
+    w[15] = Set(256);
+    Schedule(w);
+    Compress(s, message);
+
+    for (int i = 0; i < 8; i++)
+        Write4(out, 4 * i, s[i]);
+}
+} // namespace sha256d64_sse41
+
+#endif
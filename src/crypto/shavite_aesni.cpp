@@ -0,0 +1,100 @@
+// Copyright (c) 2018-2019 The KYD developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+// SHAvite-3-512 of 64-byte messages using AES-NI, for the X11 chain.
+// Must be compiled with AES-NI and SSSE3 enabled; only call it after checking
+// that the CPU supports both (see crypto/x11.cpp).
+
+#if defined(ENABLE_AESNI)
+
+#include <stddef.h>
+#include <stdint.h>
+#include <immintrin.h>
+
+namespace shavite_aesni
+{
+namespace
+{
+const int ROUNDS = 14;
+const int KEY_WORDS = 112;
+
+void Hash64(unsigned char* out, const unsigned char* in)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i rk[KEY_WORDS];
+
+    // The padded block: the message, the 0x80 padding byte, the 512-bit message
+    // length at byte 110 and the output size (512) in the last two bytes.
+    for (int i = 0; i < 4; i++)
+        rk[i] = _mm_loadu_si128((const __m128i*)(in + 16 * i));
+    rk[4] = _mm_set_epi32(0, 0, 0, 0x80);
+    rk[5] = zero;
+    rk[6] = _mm_set_epi32(0x02000000, 0, 0, 0);
+    rk[7] = _mm_set_epi32(0x02000000, 0, 0, 0);
+
+    // Key schedule: blocks of eight nonlinear words (an AES round of the word
+    // eight back, rotated by one 32-bit lane) alternate with blocks of eight
+    // linear ones. The bit counter (512, then zeros) is mixed into four words.
+    for (int w = 8; w < KEY_WORDS; w += 16) {
+        for (int i = w; i < w + 8; i++) {
+            __m128i x = _mm_aesenc_si128(_mm_shuffle_epi32(rk[i - 8], _MM_SHUFFLE(0, 3, 2, 1)), zero);
+            rk[i] = _mm_xor_si128(x, rk[i - 1]);
+            __m128i counter;
+            if (i == 8)
+                counter = _mm_set_epi32(~0, 0, 0, 512);
+            else if (i == 41)
+                counter = _mm_set_epi32(~512, 0, 0, 0);
+            else if (i == 79)
+                counter = _mm_set_epi32(~0, 512, 0, 0);
+            else if (i == 110)
+                counter = _mm_set_epi32(~0, 0, 512, 0);
+            else
+                continue;
+            rk[i] = _mm_xor_si128(rk[i], counter);
+        }
+        if (w + 8 == KEY_WORDS)
+            break;
+        for (int i = w + 8; i < w + 16; i++)
+            rk[i] = _mm_xor_si128(rk[i - 8], _mm_alignr_epi8(rk[i - 1], rk[i - 2], 4));
+    }
+
+    const __m128i iv[4] = {
+        _mm_set_epi32(0x40D55AEC, 0x128A077B, 0x79CA4727, 0x72FCCDD8),
+        _mm_set_epi32(0xDF07FBFC, 0xB29F5CD1, 0x430AE307, 0xD1901A06),
+        _mm_set_epi32(0xDD577E47, 0xBDE86578, 0x681AB538, 0x8E45D73D),
+        _mm_set_epi32(0x022A4B9A, 0xB9357178, 0x502D9FCD, 0xE275EADE)};
+    __m128i p[4];
+    for (int i = 0; i < 4; i++)
+        p[i] = iv[i];
+
+    for (int r = 0, u = 0; r < ROUNDS; r++, u += 8) {
+        // The two Feistel steps of a round are independent chains of AES rounds
+        __m128i x = _mm_aesenc_si128(_mm_xor_si128(p[1], rk[u]), zero);
+        __m128i y = _mm_aesenc_si128(_mm_xor_si128(p[3], rk[u + 4]), zero);
+        for (int j = 1; j < 4; j++) {
+            x = _mm_aesenc_si128(_mm_xor_si128(x, rk[u + j]), zero);
+            y = _mm_aesenc_si128(_mm_xor_si128(y, rk[u + 4 + j]), zero);
+        }
+        // Rotate the four words after the two Feistel steps
+        __m128i p0 = _mm_xor_si128(p[0], x);
+        __m128i p2 = _mm_xor_si128(p[2], y);
+        p[0] = p[3];
+        p[2] = p[1];
+        p[1] = p0;
+        p[3] = p2;
+    }
+
+    for (int i = 0; i < 4; i++)
+        _mm_storeu_si128((__m128i*)(out + 16 * i), _mm_xor_si128(iv[i], p[i]));
+}
+} // namespace
+
+void Hash64(unsigned char* out, const unsigned char* in, size_t blocks)
+{
+    for (size_t n = 0; n < blocks; n++)
+        Hash64(out + 64 * n, in + 64 * n);
+}
+} // namespace shavite_aesni
+
+#endif
@@ -0,0 +1,172 @@
+// Copyright (c) 2018-2019 The KYD developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#if defined(HAVE_CONFIG_H)
+#include "config/kyd-config.h"
+#endif
+
+#include "crypto/x11.h"
+
+#include "crypto/sph_blake.h"
+#include "crypto/sph_bmw.h"
+#include "crypto/sph_cubehash.h"
+#include "crypto/sph_echo.h"
+#include "crypto/sph_groestl.h"
+#include "crypto/sph_jh.h"
+#include "crypto/sph_keccak.h"
+#include "crypto/sph_luffa.h"
+#include "crypto/sph_shavite.h"
+#include "crypto/sph_simd.h"
+#include "crypto/sph_skein.h"
+
+#include <string.h>
+
+#if defined(ENABLE_AESNI) && (defined(__x86_64__) || defined(__amd64__) || defined(__i386__))
+#define HAVE_X11_AESNI 1
+#include <cpuid.h>
+
+namespace groestl_aesni
+{
+void Hash64(unsigned char* out, const unsigned char* in, size_t blocks);
+}
+namespace echo_aesni
+{
+void Hash64(unsigned char* out, const unsigned char* in, size_t blocks);
+}
+namespace shavite_aesni
+{
+void Hash64(unsigned char* out, const unsigned char* in, size_t blocks);
+}
+#endif
+
+namespace
+{
+// One 512-bit sph function over len bytes. Only one context is on the stack at a time.
+#define SPH_HASH512(name)                                                    \
+    void name##512(unsigned char* out, const unsigned char* in, size_t len) \
+    {                                                                        \
+        sph_##name##512_context ctx;                                         \
+        sph_##name##512_init(&ctx);                                          \
+        sph_##name##512(&ctx, in, len);                                      \
+        sph_##name##512_close(&ctx, out);                                    \
+    }
+
+// The generic fallback of a function with an AES-NI implementation
+#define SPH_HASH512_64(name)                                                       \
+    SPH_HASH512(name)                                                              \
+    void name##512_64(unsigned char* out, const unsigned char* in, size_t blocks) \
+    {                                                                              \
+        for (size_t n = 0; n < blocks; n++)                                        \
+            name##512(out + 64 * n, in + 64 * n, 64);                              \
+    }
+
+SPH_HASH512(blake)
+SPH_HASH512(bmw)
+SPH_HASH512_64(groestl)
+SPH_HASH512(jh)
+SPH_HASH512(keccak)
+SPH_HASH512(skein)
+SPH_HASH512(luffa)
+SPH_HASH512(cubehash)
+SPH_HASH512_64(shavite)
+SPH_HASH512(simd)
+SPH_HASH512_64(echo)
+
+#undef SPH_HASH512_64
+#undef SPH_HASH512
+
+/** Hashes blocks consecutive 64-byte messages into as many 64-byte outputs */
+typedef void (*Hash64Function)(unsigned char* out, const unsigned char* in, size_t blocks);
+
+/** The chain functions that have faster implementations on some CPUs */
+struct X11Functions {
+    Hash64Function groestl;
+    Hash64Function shavite;
+    Hash64Function echo;
+    const char* name;
+};
+
+X11Functions Detect(bool fAllowAesni)
+{
+    X11Functions f;
+    f.groestl = groestl512_64;
+    f.shavite = shavite512_64;
+    f.echo = echo512_64;
+    f.name = "generic";
+#if defined(HAVE_X11_AESNI)
+    unsigned int eax, ebx, ecx, edx;
+    // AES-NI is bit 25 and SSSE3 bit 9 of ecx in leaf 1
+    if (fAllowAesni && __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & (1 << 25)) && (ecx & (1 << 9))) {
+        f.groestl = groestl_aesni::Hash64;
+        f.shavite = shavite_aesni::Hash64;
+        f.echo = echo_aesni::Hash64;
+        f.name = "aes-ni";
+    }
+#endif
+    return f;
+}
+
+X11Functions& Functions()
+{
+    static X11Functions functions = Detect(true);
+    return functions;
+}
+} // namespace
+
+void X11Hash(const unsigned char* data, size_t len, unsigned char hash[X11_OUTPUT_SIZE])
+{
+    const X11Functions& f = Functions();
+    unsigned char a[64], b[64];
+
+    blake512(a, data, len);
+    bmw512(b, a, 64);
+    f.groestl(a, b, 1);
+    jh512(b, a, 64);
+    keccak512(a, b, 64);
+    skein512(b, a, 64);
+    luffa512(a, b, 64);
+    cubehash512(b, a, 64);
+    f.shavite(a, b, 1);
+    simd512(b, a, 64);
+    f.echo(a, b, 1);
+    memcpy(hash, a, X11_OUTPUT_SIZE);
+}
+
+void QuarkHash(const unsigned char* data, size_t len, unsigned char hash[X11_OUTPUT_SIZE])
+{
+    const X11Functions& f = Functions();
+    unsigned char a[64], b[64];
+
+    // Each branch tests bit 3 of the little-endian 512-bit value, that is of its first byte
+    blake512(a, data, len);
+    bmw512(b, a, 64);
+    if (b[0] & 8)
+        f.groestl(a, b, 1);
+    else
+        skein512(a, b, 64);
+    f.groestl(b, a, 1);
+    jh512(a, b, 64);
+    if (a[0] & 8)
+        blake512(b, a, 64);
+    else
+        bmw512(b, a, 64);
+    keccak512(a, b, 64);
+    skein512(b, a, 64);
+    if (b[0] & 8)
+        keccak512(a, b, 64);
+    else
+        jh512(a, b, 64);
+    memcpy(hash, a, X11_OUTPUT_SIZE);
+}
+
+const char* X11Implementation()
+{
+    return Functions().name;
+}
+
+const char* X11SelectImplementation(bool fAllowAesni)
+{
+    Functions() = Detect(fAllowAesni);
+    return Functions().name;
+}
@@ -0,0 +1,32 @@
+// Copyright (c) 2018-2019 The KYD developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef KYD_CRYPTO_X11_H
+#define KYD_CRYPTO_X11_H
+
+#include <stddef.h>
+
+/** Both chains end in a 512-bit hash of which the first 256 bits are used */
+static const size_t X11_OUTPUT_SIZE = 32;
+
+/**
+ * X11 (Hash9): blake, bmw, groestl, jh, keccak, skein, luffa, cubehash, shavite, simd and echo,
+ * each 512 bits wide and each hashing the output of the previous one.
+ */
+void X11Hash(const unsigned char* data, size_t len, unsigned char hash[X11_OUTPUT_SIZE]);
+
+/** Quark: the blake, bmw, groestl, jh, keccak and skein chain with three data-dependent branches */
+void QuarkHash(const unsigned char* data, size_t len, unsigned char hash[X11_OUTPUT_SIZE]);
+
+/** Name of the groestl, echo and shavite implementation chosen for this CPU */
+const char* X11Implementation();
+
+/**
+ * Choose the implementation again, the generic one unless fAllowAesni and the CPU
+ * supports AES-NI, and return its name. Meant for tests: nothing may be hashing
+ * with X11Hash or QuarkHash at the same time.
+ */
+const char* X11SelectImplementation(bool fAllowAesni);
+
+#endif // KYD_CRYPTO_X11_H
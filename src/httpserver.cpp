@@ -60,6 +60,22 @@ private:
     HTTPRequestHandler func;
 };
 
+/** Task queued on the HTTP worker threads on behalf of a running request */
+class HTTPTaskItem : public HTTPClosure
+{
+public:
+    HTTPTaskItem(const std::function<void()>& task): task(task)
+    {
+    }
+    void operator()()
+    {
+        task();
+    }
+
+private:
+    std::function<void()> task;
+};
+
 /** Simple work queue for distributing work over multiple threads.
  * Work items are simply callable objects.
  */
@@ -185,6 +201,8 @@ struct evhttp* eventHTTP = 0;
 static std::vector<CSubNet> rpc_allow_subnets;
 //! Work queue for handling longer requests off the event loop thread
 static WorkQueue<HTTPClosure>* workQueue = 0;
+//! Number of worker threads serving workQueue
+static int nWorkerThreads = 0;
 //! Handlers for (sub)paths
 std::vector<HTTPPathHandler> pathHandlers;
 std::vector<evhttp_bound_socket *> boundSockets;
@@ -448,6 +466,7 @@ bool StartHTTPServer()
     LogPrint("http", "Starting HTTP server\n");
     int rpcThreads = std::max((long)GetArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1L);
     LogPrintf("HTTP: starting %d worker threads\n", rpcThreads);
+    nWorkerThreads = rpcThreads;
     std::packaged_task<bool(event_base*, evhttp*)> task(ThreadHTTP);
     threadResult = task.get_future();
     threadHTTP = std::thread(std::move(task), eventBase, eventHTTP);
@@ -596,12 +615,22 @@ void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
  * this cannot be done from worker threads.
  */
 void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
+{
+    WriteReply(nStatus, std::string(strReply));
+}
+
+void HTTPRequest::WriteReply(int nStatus, std::string&& strReply)
 {
     assert(!replySent && req);
     // Send event to main http thread to send reply message
     struct evbuffer* evb = evhttp_request_get_output_buffer(req);
     assert(evb);
-    evbuffer_add(evb, strReply.data(), strReply.size());
+    if (!strReply.empty()) {
+        // The buffer references the body, which is freed once libevent is done with it
+        std::string* pstrReply = new std::string(std::move(strReply));
+        evbuffer_add_reference(evb, pstrReply->data(), pstrReply->size(),
+            [](const void*, size_t, void* extra) { delete static_cast<std::string*>(extra); }, pstrReply);
+    }
     HTTPEvent* ev = new HTTPEvent(eventBase, true,
         std::bind(evhttp_send_reply, req, nStatus, (const char*)NULL, (struct evbuffer *)NULL));
     ev->trigger(0);
@@ -649,6 +678,22 @@ HTTPRequest::RequestMethod HTTPRequest::GetRequestMethod()
     }
 }
 
+bool HTTPEnqueueTask(const std::function<void()>& task)
+{
+    if (!workQueue)
+        return false;
+    std::unique_ptr<HTTPTaskItem> item(new HTTPTaskItem(task));
+    if (!workQueue->Enqueue(item.get()))
+        return false;
+    item.release(); /* queue took ownership */
+    return true;
+}
+
+int HTTPWorkerThreads()
+{
+    return nWorkerThreads;
+}
+
 void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler)
 {
     LogPrint("http", "Registering HTTP handler for %s (exactmatch %d)\n", prefix, exactMatch);
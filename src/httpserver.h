@@ -42,6 +42,14 @@ void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPR
 /** Unregister handler for prefix */
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
 
+/** Queue a task on the HTTP worker threads. Returns false if the work queue is full.
+ */
+bool HTTPEnqueueTask(const std::function<void()>& task);
+
+/** Number of HTTP worker threads
+ */
+int HTTPWorkerThreads();
+
 /** Return evhttp event base. This can be used by submodules to
  * queue timers or custom events.
  */
@@ -110,6 +118,12 @@ public:
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
     void WriteReply(int nStatus, const std::string& strReply = "");
+
+    /**
+     * Write HTTP reply, handing the body over to the output buffer without copying it.
+     * Use this for large replies.
+     */
+    void WriteReply(int nStatus, std::string&& strReply);
 };
 
 /** Event handler closure.
@@ -17,8 +17,11 @@
 #include "activemasternode.h"
 #include "addrman.h"
 #include "amount.h"
+#include "blockcache.h"
 #include "checkpoints.h"
 #include "compat/sanity.h"
+#include "crypto/sha256.h"
+#include "crypto/x11.h"
 #include "httpserver.h"
 #include "httprpc.h"
 #include "invalid.h"
@@ -26,6 +29,7 @@
 #include "main.h"
 #include "masternode-budget.h"
 #include "masternode-payments.h"
+#include "masternode-verify.h"
 #include "masternodeconfig.h"
 #include "masternodeman.h"
 #include "miner.h"
@@ -213,12 +217,14 @@ void PrepareShutdown()
     DumpMasternodes();
     DumpBudgets();
     DumpMasternodePayments();
+    mnSigVerifier.Stop();
     UnregisterNodeSignals(GetNodeSignals());
 
     // After everything has been shut down, but before things get flushed, stop the
     // CScheduler/checkqueue threadGroup
     threadGroup.interrupt_all();
     threadGroup.join_all();
+    StopValidationQueue();
 
     if (fFeeEstimatesInitialized) {
         boost::filesystem::path est_path = GetDataDir() / FEE_ESTIMATES_FILENAME;
@@ -367,8 +373,10 @@ std::string HelpMessage(HelpMessageMode mode)
     string strUsage = HelpMessageGroup(_("Options:"));
     strUsage += HelpMessageOpt("-?", _("This help message"));
     strUsage += HelpMessageOpt("-version", _("Print version and exit"));
+    strUsage += HelpMessageOpt("-addressindex", strprintf(_("Maintain a full address index, used by the getaddressbalance, getaddressutxos and getaddresstxids rpc calls (default: %u)"), DEFAULT_ADDRESSINDEX));
     strUsage += HelpMessageOpt("-alertnotify=<cmd>", _("Execute command when a relevant alert is received or we see a really long fork (%s in cmd is replaced by message)"));
     strUsage += HelpMessageOpt("-alerts", strprintf(_("Receive and display P2P network alerts (default: %u)"), DEFAULT_ALERTS));
+    strUsage += HelpMessageOpt("-blockcachesize=<n>", strprintf(_("Keep up to <n> megabytes of recently read blocks in memory (0 to disable, default: %d)"), DEFAULT_BLOCK_CACHE_SIZE));
     strUsage += HelpMessageOpt("-blocknotify=<cmd>", _("Execute command when the best block changes (%s in cmd is replaced by block hash)"));
     strUsage += HelpMessageOpt("-blocksizenotify=<cmd>", _("Execute command when the best block changes and its size is over (%s in cmd is replaced by block hash, %d with the block size)"));
     strUsage += HelpMessageOpt("-checkblocks=<n>", strprintf(_("How many blocks to check at startup (default: %u, 0 = all)"), 500));
@@ -380,6 +388,9 @@ std::string HelpMessage(HelpMessageMode mode)
     }
     strUsage += HelpMessageOpt("-datadir=<dir>", _("Specify data directory"));
     strUsage += HelpMessageOpt("-dbcache=<n>", strprintf(_("Set database cache size in megabytes (%d to %d, default: %d)"), nMinDbCache, nMaxDbCache, nDefaultDbCache));
+    strUsage += HelpMessageOpt("-dbmaxfilesize=<n>", strprintf(_("Target size of database table files in megabytes, larger files mean fewer compactions (default: %d)"), DEFAULT_DB_MAX_FILE_SIZE));
+    strUsage += HelpMessageOpt("-dbsharedcache", strprintf(_("Use one block cache for the chainstate, block index, zerocoin and spork databases (default: %u)"), DEFAULT_DB_SHARED_CACHE));
+    strUsage += HelpMessageOpt("-dbwritebuffer=<n>", strprintf(_("Size of each database write buffer in megabytes (0 = derive from -dbcache, default: %d)"), DEFAULT_DB_WRITE_BUFFER));
     strUsage += HelpMessageOpt("-loadblock=<file>", _("Imports blocks from external blk000??.dat file") + " " + _("on startup"));
     strUsage += HelpMessageOpt("-maxreorg=<n>", strprintf(_("Set the Maximum reorg depth (default: %u)"), Params(CBaseChainParams::MAIN).MaxReorganizationDepth()));
     strUsage += HelpMessageOpt("-maxorphantx=<n>", strprintf(_("Keep at most <n> unconnectable transactions in memory (default: %u)"), DEFAULT_MAX_ORPHAN_TRANSACTIONS));
@@ -391,9 +402,11 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-reindexaccumulators", _("Reindex the accumulator database") + " " + _("on startup"));
     strUsage += HelpMessageOpt("-reindexmoneysupply", _("Reindex the KYD and zKYD money supply statistics") + " " + _("on startup"));
     strUsage += HelpMessageOpt("-resync", _("Delete blockchain folders and resync from scratch") + " " + _("on startup"));
+    strUsage += HelpMessageOpt("-spentindex", strprintf(_("Maintain a full spent index, used by the getspentinfo rpc call (default: %u)"), DEFAULT_SPENTINDEX));
 #if !defined(WIN32)
     strUsage += HelpMessageOpt("-sysperms", _("Create new files with system default permissions, instead of umask 077 (only effective with disabled wallet functionality)"));
 #endif
+    strUsage += HelpMessageOpt("-timestampindex", strprintf(_("Maintain a timestamp index for block hashes, used by the getblockhashes rpc call (default: %u)"), DEFAULT_TIMESTAMPINDEX));
     strUsage += HelpMessageOpt("-txindex", strprintf(_("Maintain a full transaction index, used by the getrawtransaction rpc call (default: %u)"), 0));
     strUsage += HelpMessageOpt("-forcestart", _("Attempt to force blockchain corruption recovery") + " " + _("on startup"));
 
@@ -438,6 +451,7 @@ std::string HelpMessage(HelpMessageMode mode)
 
 #ifdef ENABLE_WALLET
     strUsage += HelpMessageGroup(_("Wallet options:"));
+    strUsage += HelpMessageOpt("-asyncwalletnotify", strprintf(_("Update the wallet with new blocks and transactions from the validation queue thread instead of while validating (default: %u)"), DEFAULT_ASYNC_WALLET_NOTIFY));
     strUsage += HelpMessageOpt("-backuppath=<dir|file>", _("Specify custom backup path to add a copy of any wallet backup. If set as dir, every backup generates a timestamped file. If set as file, will rewrite to that file every backup."));
     strUsage += HelpMessageOpt("-createwalletbackups=<n>", _("Number of automatic wallet backups (default: 10)"));
     strUsage += HelpMessageOpt("-custombackupthreshold=<n>", strprintf(_("Number of custom location backups to retain (default: %d)"), DEFAULT_CUSTOMBACKUPTHRESHOLD));
@@ -457,6 +471,7 @@ std::string HelpMessage(HelpMessageMode mode)
         FormatMoney(maxTxFee)));
     strUsage += HelpMessageOpt("-upgradewallet", _("Upgrade wallet to latest format") + " " + _("on startup"));
     strUsage += HelpMessageOpt("-wallet=<file>", _("Specify wallet file (within data directory)") + " " + strprintf(_("(default: %s)"), "wallet.dat"));
+    strUsage += HelpMessageOpt("-walletloadthreads=<n>", strprintf(_("Set the number of threads used to decode wallet records on startup (up to %d, 0 = auto, <0 = leave that many cores free, default: %d)"), MAX_WALLET_LOAD_THREADS, DEFAULT_WALLET_LOAD_THREADS));
     strUsage += HelpMessageOpt("-walletnotify=<cmd>", _("Execute command when a wallet transaction changes (%s in cmd is replaced by TxID)"));
     if (mode == HMM_BITCOIN_QT)
         strUsage += HelpMessageOpt("-windowtitle=<name>", _("Wallet window title"));
@@ -469,9 +484,13 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-zmqpubhashblock=<address>", _("Enable publish hash block in <address>"));
     strUsage += HelpMessageOpt("-zmqpubhashtx=<address>", _("Enable publish hash transaction in <address>"));
     strUsage += HelpMessageOpt("-zmqpubhashtxlock=<address>", _("Enable publish hash transaction (locked via SwiftX) in <address>"));
+    strUsage += HelpMessageOpt("-zmqpubmnwinner=<address>", _("Enable publish masternode payment winner votes in <address>"));
     strUsage += HelpMessageOpt("-zmqpubrawblock=<address>", _("Enable publish raw block in <address>"));
     strUsage += HelpMessageOpt("-zmqpubrawtx=<address>", _("Enable publish raw transaction in <address>"));
     strUsage += HelpMessageOpt("-zmqpubrawtxlock=<address>", _("Enable publish raw transaction (locked via SwiftX) in <address>"));
+    strUsage += HelpMessageOpt("-zmqpubsequence=<address>", _("Enable publish block connect/disconnect and mempool add/remove events in <address>"));
+    strUsage += HelpMessageOpt("-zmqpubzerocoinmint=<address>", _("Enable publish zerocoin mints of connected blocks in <address>"));
+    strUsage += HelpMessageOpt("-zmqpubzerocoinspend=<address>", _("Enable publish zerocoin spends of connected blocks in <address>"));
 #endif
 
     strUsage += HelpMessageGroup(_("Debugging/Testing options:"));
@@ -504,6 +523,7 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-help-debug", _("Show all debugging options (usage: --help -help-debug)"));
     strUsage += HelpMessageOpt("-logips", strprintf(_("Include IP addresses in debug output (default: %u)"), 0));
     strUsage += HelpMessageOpt("-logtimestamps", strprintf(_("Prepend debug output with timestamp (default: %u)"), 1));
+    strUsage += HelpMessageOpt("-lockstats", strprintf(_("Record wait and hold times of every lock site, see getlockstats (default: %u)"), DEFAULT_LOCKSTATS));
     if (GetBoolArg("-help-debug", false)) {
         strUsage += HelpMessageOpt("-limitfreerelay=<n>", strprintf(_("Continuously rate-limit free transactions to <n>*1000 bytes per minute (default:%u)"), 15));
         strUsage += HelpMessageOpt("-relaypriority", strprintf(_("Require high priority for relaying free or low-fee transactions (default:%u)"), 1));
@@ -541,6 +561,8 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-masternodeprivkey=<n>", _("Set the masternode private key"));
     strUsage += HelpMessageOpt("-masternodeaddr=<n>", strprintf(_("Set external address:port to get to this masternode (example: %s)"), "128.127.106.235:12244"));
     strUsage += HelpMessageOpt("-budgetvotemode=<mode>", _("Change automatic finalized budget voting behavior. mode=auto: Vote for only exact finalized budget match to my generated budget. (string, default: auto)"));
+    strUsage += HelpMessageOpt("-mnsigcachesize=<n>", strprintf(_("Limit size of the verified masternode message cache to <n> entries (default: %u)"), DEFAULT_MN_SIGCACHE_SIZE));
+    strUsage += HelpMessageOpt("-mnsigthreads=<n>", strprintf(_("Set the number of masternode message verification threads (0 to %d, default: %d)"), MAX_MN_SIG_THREADS, DEFAULT_MN_SIG_THREADS));
 
     strUsage += HelpMessageGroup(_("Zerocoin options:"));
 #ifdef ENABLE_WALLET
@@ -802,6 +824,7 @@ bool AppInit2()
     fPrintToConsole = GetBoolArg("-printtoconsole", false);
     fLogTimestamps = GetBoolArg("-logtimestamps", true);
     fLogIPs = GetBoolArg("-logips", false);
+    fLockStats = GetBoolArg("-lockstats", DEFAULT_LOCKSTATS);
 
     if (mapArgs.count("-bind") || mapArgs.count("-whitebind")) {
         // when specifying an explicit binding address, you want to listen on it
@@ -1003,6 +1026,9 @@ bool AppInit2()
 
     // ********************************************************* Step 4: application initialization: dir lock, daemonize, pidfile, debug log
 
+    // Pick the SHA-256 implementation before anything hashes
+    std::string strSHA256Implementation = SHA256AutoDetect();
+
     // Initialize elliptic curve code
     ECC_Start();
     globalVerifyHandle.reset(new ECCVerifyHandle());
@@ -1035,6 +1061,8 @@ bool AppInit2()
     LogPrintf("\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n");
     LogPrintf("KYD version %s (%s)\n", FormatFullVersion(), CLIENT_DATE);
     LogPrintf("Using OpenSSL version %s\n", SSLeay_version(SSLEAY_VERSION));
+    LogPrintf("Using %s X11 implementation\n", X11Implementation());
+    LogPrintf("Using %s SHA256 implementation\n", strSHA256Implementation);
 #ifdef ENABLE_WALLET
     LogPrintf("Using BerkeleyDB version %s\n", DbEnv::version(0, 0, 0));
 #endif
@@ -1050,6 +1078,9 @@ bool AppInit2()
     if (nScriptCheckThreads) {
         for (int i = 0; i < nScriptCheckThreads - 1; i++)
             threadGroup.create_thread(&ThreadScriptCheck);
+        // Accumulator checkpoints have at most one job per denomination
+        for (int i = 0; i < std::min(nScriptCheckThreads - 1, MAX_ACCUMULATOR_THREADS); i++)
+            threadGroup.create_thread(&ThreadAccumulate);
     }
 
     if (mapArgs.count("-sporkkey")) // spork priv key
@@ -1062,6 +1093,9 @@ bool AppInit2()
     CScheduler::Function serviceLoop = boost::bind(&CScheduler::serviceQueue, &scheduler);
     threadGroup.create_thread(boost::bind(&TraceThread<CScheduler::Function>, "scheduler", serviceLoop));
 
+    // Start the thread delivering notifications to asynchronous validation listeners
+    StartValidationQueue(threadGroup);
+
     /* Start the RPC server already.  It will be started in "warmup" mode
      * and not really process calls already (but it will signify connections
      * that the server is there and will be ready later).  Warmup mode will
@@ -1360,7 +1394,7 @@ bool AppInit2()
     pzmqNotificationInterface = CZMQNotificationInterface::CreateWithArguments(mapArgs);
 
     if (pzmqNotificationInterface) {
-        RegisterValidationInterface(pzmqNotificationInterface);
+        RegisterValidationInterface(pzmqNotificationInterface, true, "zmq");
     }
 #endif
 
@@ -1409,6 +1443,11 @@ bool AppInit2()
     size_t nCoinDBCache = nTotalCache / 2; // use half of the remaining cache for coindb cache
     nTotalCache -= nCoinDBCache;
     nCoinCacheSize = nTotalCache / 300; // coins in memory require around 300 bytes
+    // The LevelDB block caches, half of each database cache, can be pooled into one
+    size_t nSharedDBCache = GetBoolArg("-dbsharedcache", DEFAULT_DB_SHARED_CACHE) ? (nBlockTreeDBCache + nCoinDBCache) / 2 : 0;
+    SetupLevelDB(nSharedDBCache, std::max((int64_t)0, GetArg("-dbwritebuffer", DEFAULT_DB_WRITE_BUFFER)) << 20,
+        std::max((int64_t)1, GetArg("-dbmaxfilesize", DEFAULT_DB_MAX_FILE_SIZE)) << 20);
+    blockCache.SetMaxSize(std::max((int64_t)0, GetArg("-blockcachesize", DEFAULT_BLOCK_CACHE_SIZE)) << 20);
 
     bool fLoaded = false;
     while (!fLoaded) {
@@ -1469,12 +1508,27 @@ bool AppInit2()
                     break;
                 }
 
+                // Check for changed -addressindex, -spentindex and -timestampindex state
+                if (fAddressIndex != GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX)) {
+                    strLoadError = _("You need to rebuild the database using -reindex to change -addressindex");
+                    break;
+                }
+                if (fSpentIndex != GetBoolArg("-spentindex", DEFAULT_SPENTINDEX)) {
+                    strLoadError = _("You need to rebuild the database using -reindex to change -spentindex");
+                    break;
+                }
+                if (fTimestampIndex != GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX)) {
+                    strLoadError = _("You need to rebuild the database using -reindex to change -timestampindex");
+                    break;
+                }
+
                 // Populate list of invalid/fraudulent outpoints that are banned from the chain
                 invalid_out::LoadOutpoints();
                 invalid_out::LoadSerials();
 
-                // Drop all information from the zerocoinDB and repopulate
-                if (GetBoolArg("-reindexzerocoin", false)) {
+                // Drop all information from the zerocoinDB and repopulate, or finish a reindex that was interrupted
+                int nHeightZerocoinReindex;
+                if (GetBoolArg("-reindexzerocoin", false) || zerocoinDB->ReadInt("reindexheight", nHeightZerocoinReindex)) {
                     if (chainActive.Height() > Params().Zerocoin_StartHeight()) {
                         uiInterface.InitMessage(_("Reindexing zerocoin database..."));
                         std::string strError = ReindexZerocoinDB();
@@ -1485,13 +1539,29 @@ bool AppInit2()
                     }
                 }
 
+                // Most serial and pubcoin lookups are for unknown ones; filter those out before LevelDB
+                if (!zerocoinDB->LoadFilters()) {
+                    strLoadError = _("Error loading zerocoin database");
+                    break;
+                }
+
                 // Recalculate money supply for blocks that are impacted by accounting issue after zerocoin activation
                 if (GetBoolArg("-reindexmoneysupply", false)) {
-                    if (chainActive.Height() > Params().Zerocoin_StartHeight()) {
-                        RecalculateZKYDMinted();
-                        RecalculateZKYDSpent();
+                    // Resume from where an interrupted recalculation stopped
+                    int nHeightZerocoinDone = 0;
+                    int nHeightMoneyDone = 0;
+                    pblocktree->ReadInt("zkydsupplyheight", nHeightZerocoinDone);
+                    pblocktree->ReadInt("moneysupplyheight", nHeightMoneyDone);
+                    CSupplyRecalculation start = GetSupplyRecalculationStart(nHeightZerocoinDone, nHeightMoneyDone,
+                                                                             chainActive.Height(), Params().Zerocoin_StartHeight());
+                    if (start.nHeightZerocoin > Params().Zerocoin_StartHeight() || start.nHeightMoney > 1)
+                        LogPrintf("%s : resuming money supply recalculation at block %d\n", __func__, std::max(start.nHeightZerocoin, start.nHeightMoney));
+
+                    if (start.fZerocoin) {
+                        RecalculateZKYDMinted(start.nHeightZerocoin);
+                        RecalculateZKYDSpent(start.nHeightZerocoin);
                     }
-                    RecalculateKYDSupply(1);
+                    RecalculateKYDSupply(start.nHeightMoney);
                 }
 
                 // Force recalculation of accumulators.
@@ -1654,7 +1724,7 @@ bool AppInit2()
         zwalletMain = new CzKYDWallet(pwalletMain->strWalletFile);
         pwalletMain->setZWallet(zwalletMain);
 
-        RegisterValidationInterface(pwalletMain);
+        RegisterValidationInterface(pwalletMain, GetBoolArg("-asyncwalletnotify", DEFAULT_ASYNC_WALLET_NOTIFY), "wallet");
 
         CBlockIndex* pindexRescan = chainActive.Tip();
         if (GetBoolArg("-rescan", false))
@@ -1909,6 +1979,12 @@ bool AppInit2()
 
     threadGroup.create_thread(boost::bind(&ThreadCheckObfuScationPool));
 
+    if (!fLiteMode) {
+        int nMnSigThreads = GetArg("-mnsigthreads", DEFAULT_MN_SIG_THREADS);
+        nMnSigThreads = std::max(0, std::min(nMnSigThreads, MAX_MN_SIG_THREADS));
+        mnSigVerifier.Start(threadGroup, nMnSigThreads);
+    }
+
     // ********************************************************* Step 11: start node
 
     if (!CheckDiskSpace())
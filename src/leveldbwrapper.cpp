@@ -27,12 +27,29 @@ void HandleError(const leveldb::Status& status)
     throw leveldb_error("Unknown database error");
 }
 
-static leveldb::Options GetOptions(size_t nCacheSize)
+namespace
+{
+std::shared_ptr<leveldb::Cache> pSharedBlockCache;
+size_t nDBWriteBufferSize = DEFAULT_DB_WRITE_BUFFER << 20;
+size_t nDBMaxFileSize = DEFAULT_DB_MAX_FILE_SIZE << 20;
+} // anon namespace
+
+void SetupLevelDB(size_t nSharedCacheSize, size_t nWriteBufferSize, size_t nMaxFileSize)
+{
+    // Databases that are still open keep their reference to the previous cache
+    pSharedBlockCache.reset(nSharedCacheSize > 0 ? leveldb::NewLRUCache(nSharedCacheSize) : NULL);
+    nDBWriteBufferSize = nWriteBufferSize;
+    nDBMaxFileSize = nMaxFileSize;
+    LogPrintf("LevelDB: shared block cache %.1fMiB, write buffer %s, max file size %.1fMiB\n", nSharedCacheSize * (1.0 / 1024 / 1024),
+        nWriteBufferSize ? strprintf("%.1fMiB", nWriteBufferSize * (1.0 / 1024 / 1024)) : "auto", nMaxFileSize * (1.0 / 1024 / 1024));
+}
+
+static leveldb::Options GetOptions(size_t nCacheSize, int nBloomBits)
 {
     leveldb::Options options;
-    options.block_cache = leveldb::NewLRUCache(nCacheSize / 2);
-    options.write_buffer_size = nCacheSize / 4; // up to two write buffers may be held in memory simultaneously
-    options.filter_policy = leveldb::NewBloomFilterPolicy(10);
+    options.write_buffer_size = nDBWriteBufferSize ? nDBWriteBufferSize : nCacheSize / 4; // up to two write buffers may be held in memory simultaneously
+    options.max_file_size = nDBMaxFileSize;
+    options.filter_policy = leveldb::NewBloomFilterPolicy(nBloomBits);
     options.compression = leveldb::kNoCompression;
     options.max_open_files = 64;
     if (leveldb::kMajorVersion > 1 || (leveldb::kMajorVersion == 1 && leveldb::kMinorVersion >= 16)) {
@@ -43,15 +60,20 @@ static leveldb::Options GetOptions(size_t nCacheSize)
     return options;
 }
 
-CLevelDBWrapper::CLevelDBWrapper(const boost::filesystem::path& path, size_t nCacheSize, bool fMemory, bool fWipe)
+CLevelDBWrapper::CLevelDBWrapper(const boost::filesystem::path& path, size_t nCacheSize, bool fMemory, bool fWipe, int nBloomBits)
 {
     penv = NULL;
     readoptions.verify_checksums = true;
     iteroptions.verify_checksums = true;
     iteroptions.fill_cache = false;
     syncoptions.sync = true;
-    options = GetOptions(nCacheSize);
+    options = GetOptions(nCacheSize, nBloomBits);
     options.create_if_missing = true;
+    if (pSharedBlockCache && !fMemory)
+        pblockcache = pSharedBlockCache;
+    else
+        pblockcache.reset(leveldb::NewLRUCache(nCacheSize / 2));
+    options.block_cache = pblockcache.get();
     if (fMemory) {
         penv = leveldb::NewMemEnv(leveldb::Env::Default());
         options.env = penv;
@@ -74,8 +96,8 @@ CLevelDBWrapper::~CLevelDBWrapper()
     pdb = NULL;
     delete options.filter_policy;
     options.filter_policy = NULL;
-    delete options.block_cache;
     options.block_cache = NULL;
+    pblockcache.reset();
     delete penv;
     options.env = NULL;
 }
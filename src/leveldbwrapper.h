@@ -11,11 +11,32 @@
 #include "util.h"
 #include "version.h"
 
+#include <algorithm>
+#include <memory>
+#include <string.h>
+#include <vector>
+
 #include <boost/filesystem/path.hpp>
 
 #include <leveldb/db.h>
 #include <leveldb/write_batch.h>
 
+namespace leveldb
+{
+class Cache;
+}
+
+//! Bloom filter bits per key for a database
+static const int DEFAULT_DB_BLOOM_BITS = 10;
+//! Bloom filter bits per key for databases that mostly see lookups of missing keys
+static const int SPARSE_DB_BLOOM_BITS = 16;
+//! -dbsharedcache default
+static const bool DEFAULT_DB_SHARED_CACHE = true;
+//! -dbwritebuffer default (MiB, 0 = a quarter of each database's cache)
+static const int64_t DEFAULT_DB_WRITE_BUFFER = 0;
+//! -dbmaxfilesize default (MiB)
+static const int64_t DEFAULT_DB_MAX_FILE_SIZE = 2;
+
 class leveldb_error : public std::runtime_error
 {
 public:
@@ -24,6 +45,103 @@ public:
 
 void HandleError(const leveldb::Status& status);
 
+/**
+ * Settings applied to every database opened afterwards. With nSharedCacheSize > 0 all
+ * databases use one LRU block cache of that size instead of a cache each, so small
+ * databases don't hold on to memory the chainstate could use. nWriteBufferSize = 0 derives
+ * the write buffer from each database's own cache size.
+ */
+void SetupLevelDB(size_t nSharedCacheSize, size_t nWriteBufferSize, size_t nMaxFileSize);
+
+/**
+ * Serializes a database key into an inline buffer. Keys made of a prefix character and a
+ * hash fit without touching the heap; longer keys spill into a string.
+ */
+class CLevelDBKey
+{
+private:
+    static const size_t INLINE_SIZE = 64;
+
+    char vchInline[INLINE_SIZE];
+    std::string strOverflow;
+    size_t nSize;
+
+public:
+    template <typename K>
+    explicit CLevelDBKey(const K& key) : nSize(0)
+    {
+        *this << key;
+    }
+
+    int GetType() const { return SER_DISK; }
+    int GetVersion() const { return CLIENT_VERSION; }
+
+    CLevelDBKey& write(const char* pch, size_t nWrite)
+    {
+        if (strOverflow.empty() && nSize + nWrite <= INLINE_SIZE) {
+            memcpy(vchInline + nSize, pch, nWrite);
+        } else {
+            if (strOverflow.empty())
+                strOverflow.assign(vchInline, nSize);
+            strOverflow.append(pch, nWrite);
+        }
+        nSize += nWrite;
+        return (*this);
+    }
+
+    template <typename T>
+    CLevelDBKey& operator<<(const T& obj)
+    {
+        ::Serialize(*this, obj, SER_DISK, CLIENT_VERSION);
+        return (*this);
+    }
+
+    leveldb::Slice GetSlice() const
+    {
+        return strOverflow.empty() ? leveldb::Slice(vchInline, nSize) : leveldb::Slice(strOverflow);
+    }
+
+    std::string str() const
+    {
+        return GetSlice().ToString();
+    }
+};
+
+/**
+ * Deserializes a value in place from a buffer owned by LevelDB (an iterator's value) or by
+ * the caller, instead of copying it into a CDataStream first.
+ */
+class CLevelDBValueReader
+{
+private:
+    const char* pch;
+    const char* pend;
+
+public:
+    explicit CLevelDBValueReader(const leveldb::Slice& slValue) : pch(slValue.data()), pend(slValue.data() + slValue.size()) {}
+
+    int GetType() const { return SER_DISK; }
+    int GetVersion() const { return CLIENT_VERSION; }
+    size_t size() const { return pend - pch; }
+    bool empty() const { return pch == pend; }
+
+    CLevelDBValueReader& read(char* pchOut, size_t nRead)
+    {
+        if (nRead > size())
+            throw std::ios_base::failure("CLevelDBValueReader::read : end of data");
+        memcpy(pchOut, pch, nRead);
+        pch += nRead;
+        return (*this);
+    }
+
+    template <typename T>
+    CLevelDBValueReader& operator>>(T& obj)
+    {
+        ::Unserialize(*this, obj, SER_DISK, CLIENT_VERSION);
+        return (*this);
+    }
+};
+
 /** Batch of changes queued to be written to a CLevelDBWrapper */
 class CLevelDBBatch
 {
@@ -36,28 +154,21 @@ public:
     template <typename K, typename V>
     void Write(const K& key, const V& value)
     {
-        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
-        ssKey.reserve(ssKey.GetSerializeSize(key));
-        ssKey << key;
-        leveldb::Slice slKey(&ssKey[0], ssKey.size());
+        CLevelDBKey dbKey(key);
 
         CDataStream ssValue(SER_DISK, CLIENT_VERSION);
         ssValue.reserve(ssValue.GetSerializeSize(value));
         ssValue << value;
         leveldb::Slice slValue(&ssValue[0], ssValue.size());
 
-        batch.Put(slKey, slValue);
+        batch.Put(dbKey.GetSlice(), slValue);
     }
 
     template <typename K>
     void Erase(const K& key)
     {
-        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
-        ssKey.reserve(ssKey.GetSerializeSize(key));
-        ssKey << key;
-        leveldb::Slice slKey(&ssKey[0], ssKey.size());
-
-        batch.Delete(slKey);
+        CLevelDBKey dbKey(key);
+        batch.Delete(dbKey.GetSlice());
     }
 };
 
@@ -82,23 +193,23 @@ private:
     //! options used when sync writing to the database
     leveldb::WriteOptions syncoptions;
 
+    //! block cache of this database, possibly shared with other databases
+    std::shared_ptr<leveldb::Cache> pblockcache;
+
     //! the database itself
     leveldb::DB* pdb;
 
 public:
-    CLevelDBWrapper(const boost::filesystem::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false);
+    CLevelDBWrapper(const boost::filesystem::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false, int nBloomBits = DEFAULT_DB_BLOOM_BITS);
     ~CLevelDBWrapper();
 
     template <typename K, typename V>
     bool Read(const K& key, V& value) const
     {
-        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
-        ssKey.reserve(ssKey.GetSerializeSize(key));
-        ssKey << key;
-        leveldb::Slice slKey(&ssKey[0], ssKey.size());
+        CLevelDBKey dbKey(key);
 
         std::string strValue;
-        leveldb::Status status = pdb->Get(readoptions, slKey, &strValue);
+        leveldb::Status status = pdb->Get(readoptions, dbKey.GetSlice(), &strValue);
         if (!status.ok()) {
             if (status.IsNotFound())
                 return false;
@@ -106,14 +217,55 @@ public:
             HandleError(status);
         }
         try {
-            CDataStream ssValue(strValue.data(), strValue.data() + strValue.size(), SER_DISK, CLIENT_VERSION);
-            ssValue >> value;
+            CLevelDBValueReader(strValue) >> value;
         } catch (const std::exception&) {
             return false;
         }
         return true;
     }
 
+    /**
+     * Read a batch of keys with a single iterator. The keys are visited in database order,
+     * so neighbouring keys share table block reads and the values are deserialized directly
+     * from the iterator. vValues and vFound are filled in the order of vKeys. Returns false
+     * if a value that is present could not be deserialized.
+     */
+    template <typename K, typename V>
+    bool MultiRead(const std::vector<K>& vKeys, std::vector<V>& vValues, std::vector<bool>& vFound) const
+    {
+        std::vector<std::pair<std::string, size_t> > vSorted;
+        vSorted.reserve(vKeys.size());
+        for (size_t i = 0; i < vKeys.size(); i++)
+            vSorted.emplace_back(CLevelDBKey(vKeys[i]).str(), i);
+        std::sort(vSorted.begin(), vSorted.end());
+
+        vValues.assign(vKeys.size(), V());
+        vFound.assign(vKeys.size(), false);
+
+        bool fOk = true;
+        std::unique_ptr<leveldb::Iterator> pcursor(pdb->NewIterator(readoptions));
+        for (const std::pair<std::string, size_t>& key : vSorted) {
+            leveldb::Slice slKey(key.first);
+            if (!pcursor->Valid() || pcursor->key().compare(slKey) < 0)
+                pcursor->Seek(slKey);
+            if (!pcursor->Valid())
+                break;
+            if (pcursor->key() != slKey)
+                continue;
+
+            try {
+                CLevelDBValueReader(pcursor->value()) >> vValues[key.second];
+                vFound[key.second] = true;
+            } catch (const std::exception& e) {
+                LogPrintf("LevelDB deserialize failure: %s\n", e.what());
+                fOk = false;
+            }
+        }
+        HandleError(pcursor->status());
+
+        return fOk;
+    }
+
     template <typename K, typename V>
     bool Write(const K& key, const V& value, bool fSync = false)
     {
@@ -125,13 +277,10 @@ public:
     template <typename K>
     bool Exists(const K& key) const
     {
-        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
-        ssKey.reserve(ssKey.GetSerializeSize(key));
-        ssKey << key;
-        leveldb::Slice slKey(&ssKey[0], ssKey.size());
+        CLevelDBKey dbKey(key);
 
         std::string strValue;
-        leveldb::Status status = pdb->Get(readoptions, slKey, &strValue);
+        leveldb::Status status = pdb->Get(readoptions, dbKey.GetSlice(), &strValue);
         if (!status.ok()) {
             if (status.IsNotFound())
                 return false;
@@ -12,6 +12,7 @@
 #include "accumulatormap.h"
 #include "addrman.h"
 #include "alert.h"
+#include "blockcache.h"
 #include "blocksignature.h"
 #include "chainparams.h"
 #include "checkpoints.h"
@@ -34,13 +35,16 @@
 #include "util.h"
 #include "utilmoneystr.h"
 #include "validationinterface.h"
+#include "validationstats.h"
 #include "zkydchain.h"
 
 #include "primitives/zerocoin.h"
 #include "libzerocoin/Denominations.h"
 #include "invalid.h"
 
+#include <memory>
 #include <sstream>
+#include <type_traits>
 
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/filesystem.hpp>
@@ -62,6 +66,51 @@ using namespace libzerocoin;
 CCriticalSection cs_main;
 
 BlockMap mapBlockIndex;
+
+namespace
+{
+/**
+ * Block index entries are never freed individually and live until shutdown, so they are
+ * constructed in place inside large chunks rather than allocated one at a time. Callers
+ * hold cs_main.
+ */
+class CBlockIndexArena
+{
+private:
+    static const size_t CHUNK_SIZE = 4096;
+    typedef std::aligned_storage<sizeof(CBlockIndex), alignof(CBlockIndex)>::type Slot;
+
+    std::vector<std::unique_ptr<Slot[]> > vChunks;
+    size_t nUsed;
+
+public:
+    CBlockIndexArena() : nUsed(CHUNK_SIZE) {}
+
+    ~CBlockIndexArena()
+    {
+        for (size_t i = 0; i < vChunks.size(); i++) {
+            size_t nCount = (i + 1 == vChunks.size()) ? nUsed : CHUNK_SIZE;
+            for (size_t j = 0; j < nCount; j++)
+                reinterpret_cast<CBlockIndex*>(&vChunks[i][j])->~CBlockIndex();
+        }
+    }
+
+    template <typename... Args>
+    CBlockIndex* New(Args&&... args)
+    {
+        if (nUsed == CHUNK_SIZE) {
+            vChunks.emplace_back(new Slot[CHUNK_SIZE]);
+            nUsed = 0;
+        }
+        CBlockIndex* pindex = new (&vChunks.back()[nUsed]) CBlockIndex(std::forward<Args>(args)...);
+        nUsed++;
+        return pindex;
+    }
+};
+
+CBlockIndexArena blockIndexArena;
+} // anon namespace
+
 map<uint256, uint256> mapProofOfStake;
 set<pair<COutPoint, unsigned int> > setStakeSeen;
 map<unsigned int, unsigned int> mapHashedBlocks;
@@ -74,6 +123,9 @@ int nScriptCheckThreads = 0;
 bool fImporting = false;
 bool fReindex = false;
 bool fTxIndex = true;
+bool fAddressIndex = DEFAULT_ADDRESSINDEX;
+bool fSpentIndex = DEFAULT_SPENTINDEX;
+bool fTimestampIndex = DEFAULT_TIMESTAMPINDEX;
 bool fIsBareMultisigStd = true;
 bool fCheckBlockIndex = false;
 bool fVerifyingBlocks = false;
@@ -973,9 +1025,9 @@ bool ContextualCheckZerocoinMint(const CTransaction& tx, const PublicCoin& coin,
     return true;
 }
 
-bool ContextualCheckZerocoinSpend(const CTransaction& tx, const CoinSpend& spend, CBlockIndex* pindex, const uint256& hashBlock)
+bool ContextualCheckZerocoinSpend(const CTransaction& tx, const CoinSpend& spend, CBlockIndex* pindex, const uint256& hashBlock, std::vector<CBlockCheck>* pvChecks)
 {
-    if(!ContextualCheckZerocoinSpendNoSerialCheck(tx, spend, pindex, hashBlock)){
+    if(!ContextualCheckZerocoinSpendNoSerialCheck(tx, spend, pindex, hashBlock, pvChecks)){
         return false;
     }
 
@@ -988,12 +1040,23 @@ bool ContextualCheckZerocoinSpend(const CTransaction& tx, const CoinSpend& spend
     return true;
 }
 
-bool ContextualCheckZerocoinSpendNoSerialCheck(const CTransaction& tx, const CoinSpend& spend, CBlockIndex* pindex, const uint256& hashBlock)
+/** Check the signature of a V2 zKYD spend; also run by the script check threads */
+static bool CheckZerocoinSpendSignature(const CoinSpend& spend, const uint256& txid)
+{
+    if (!spend.HasValidSignature())
+        return error("%s: V2 zKYD spend does not have a valid signature, tx %s", __func__, txid.GetHex());
+    return true;
+}
+
+bool ContextualCheckZerocoinSpendNoSerialCheck(const CTransaction& tx, const CoinSpend& spend, CBlockIndex* pindex, const uint256& hashBlock, std::vector<CBlockCheck>* pvChecks)
 {
     //Check to see if the zKYD is properly signed
     if (pindex->nHeight >= Params().Zerocoin_Block_V2_Start()) {
-        if (!spend.HasValidSignature())
-            return error("%s: V2 zKYD spend does not have a valid signature", __func__);
+        if (pvChecks) {
+            // Verified by the script check threads, along with the block's scripts
+            pvChecks->push_back(CBlockCheck(boost::bind(&CheckZerocoinSpendSignature, spend, tx.GetHash())));
+        } else if (!CheckZerocoinSpendSignature(spend, tx.GetHash()))
+            return false;
 
         libzerocoin::SpendType expectedType = libzerocoin::SpendType::SPEND;
         if (tx.IsCoinStake())
@@ -1710,13 +1773,12 @@ bool GetTransaction(const uint256& hash, CTransaction& txOut, uint256& hashBlock
 {
     CBlockIndex* pindexSlow = NULL;
     {
-        LOCK(cs_main);
-        {
-            if (mempool.lookup(hash, txOut)) {
-                return true;
-            }
+        if (mempool.lookup(hash, txOut)) {
+            return true;
         }
 
+        // The transaction index and block files are read without cs_main, so concurrent
+        // RPC lookups don't serialize on it
         if (fTxIndex) {
             CDiskTxPos postx;
             if (pblocktree->ReadTxIndex(hash, postx)) {
@@ -1742,6 +1804,7 @@ bool GetTransaction(const uint256& hash, CTransaction& txOut, uint256& hashBlock
         }
 
         if (fAllowSlow) { // use coin database to locate block that contains transaction, and scan it
+            LOCK(cs_main);
             int nHeight = -1;
             {
                 CCoinsViewCache& view = *pcoinsTip;
@@ -1797,20 +1860,27 @@ bool WriteBlockToDisk(CBlock& block, CDiskBlockPos& pos)
     return true;
 }
 
-bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos)
+static bool ReadBlockFromDiskUncached(CBlock& block, const CDiskBlockPos& pos)
 {
-    block.SetNull();
-
-    // Open history file to read
-    CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull())
-        return error("ReadBlockFromDisk : OpenBlockFile failed");
+    // Read block, from the mapped block file if possible
+    CDataStream ssBlock(SER_DISK, CLIENT_VERSION);
+    if (blockFileMapper.ReadRecord(pos, "blk", 0, ssBlock)) {
+        try {
+            ssBlock >> block;
+        } catch (std::exception& e) {
+            return error("%s : Deserialize or I/O error - %s", __func__, e.what());
+        }
+    } else {
+        // Open history file to read
+        CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
+        if (filein.IsNull())
+            return error("ReadBlockFromDisk : OpenBlockFile failed");
 
-    // Read block
-    try {
-        filein >> block;
-    } catch (std::exception& e) {
-        return error("%s : Deserialize or I/O error - %s", __func__, e.what());
+        try {
+            filein >> block;
+        } catch (std::exception& e) {
+            return error("%s : Deserialize or I/O error - %s", __func__, e.what());
+        }
     }
 
     // Check the header
@@ -1818,7 +1888,26 @@ bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos)
         if (!CheckProofOfWork(block.GetHash(), block.nBits))
             return error("ReadBlockFromDisk : Errors in block header");
     }
+    return true;
+}
+
+bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos)
+{
+    block.SetNull();
 
+    if (!blockCache.IsEnabled())
+        return ReadBlockFromDiskUncached(block, pos);
+
+    // Recently read blocks were already deserialized and checked
+    std::shared_ptr<const CBlock> pblockCached = blockCache.Get(pos);
+    if (pblockCached) {
+        block = *pblockCached;
+        return true;
+    }
+
+    if (!ReadBlockFromDiskUncached(block, pos))
+        return false;
+    blockCache.Insert(pos, std::make_shared<const CBlock>(block), ::GetSerializeSize(block, SER_DISK, CLIENT_VERSION));
     return true;
 }
 
@@ -1833,6 +1922,36 @@ bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex)
     return true;
 }
 
+bool ReadBlockFromDisk(std::shared_ptr<const CBlock>& pblock, const CDiskBlockPos& pos)
+{
+    bool fCache = blockCache.IsEnabled();
+    if (fCache) {
+        pblock = blockCache.Get(pos);
+        if (pblock)
+            return true;
+    }
+
+    std::shared_ptr<CBlock> pblockNew = std::make_shared<CBlock>();
+    pblock.reset();
+    if (!ReadBlockFromDiskUncached(*pblockNew, pos))
+        return false;
+    if (fCache)
+        blockCache.Insert(pos, pblockNew, ::GetSerializeSize(*pblockNew, SER_DISK, CLIENT_VERSION));
+    pblock = pblockNew;
+    return true;
+}
+
+bool ReadBlockFromDisk(std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindex)
+{
+    if (!ReadBlockFromDisk(pblock, pindex->GetBlockPos()))
+        return false;
+    if (pblock->GetHash() != pindex->GetBlockHash()) {
+        LogPrintf("%s : block=%s index=%s\n", __func__, pblock->GetHash().ToString().c_str(), pindex->GetBlockHash().ToString().c_str());
+        return error("ReadBlockFromDisk(shared_ptr<const CBlock>&, CBlockIndex*) : GetHash() doesn't match index");
+    }
+    return true;
+}
+
 
 double ConvertBitsToDouble(unsigned int nBits)
 {
@@ -2254,6 +2373,66 @@ bool CheckInputs(const CTransaction& tx, CValidationState& state, const CCoinsVi
     return true;
 }
 
+bool GetAddressIndexHash(const CScript& script, int& nAddressType, uint160& addressHash)
+{
+    CTxDestination dest;
+    if (!ExtractDestination(script, dest))
+        return false;
+
+    if (const CKeyID* keyID = boost::get<CKeyID>(&dest)) {
+        nAddressType = ADDRESS_INDEX_PUBKEYHASH;
+        addressHash = *keyID;
+        return true;
+    }
+    if (const CScriptID* scriptID = boost::get<CScriptID>(&dest)) {
+        nAddressType = ADDRESS_INDEX_SCRIPTHASH;
+        addressHash = *scriptID;
+        return true;
+    }
+    return false;
+}
+
+bool GetAddressIndex(const uint160& addressHash, int nAddressType, std::vector<std::pair<CAddressIndexKey, CAmount> >& addressIndex, int nStart, int nEnd)
+{
+    if (!fAddressIndex)
+        return error("%s : address index not enabled", __func__);
+
+    if (!pblocktree->ReadAddressIndex(addressHash, nAddressType, addressIndex, nStart, nEnd))
+        return error("%s : unable to get txids for address", __func__);
+
+    return true;
+}
+
+bool GetAddressUnspent(const uint160& addressHash, int nAddressType, std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >& unspentOutputs)
+{
+    if (!fAddressIndex)
+        return error("%s : address index not enabled", __func__);
+
+    if (!pblocktree->ReadAddressUnspentIndex(addressHash, nAddressType, unspentOutputs))
+        return error("%s : unable to get txids for address", __func__);
+
+    return true;
+}
+
+bool GetSpentIndex(const CSpentIndexKey& key, CSpentIndexValue& value)
+{
+    if (!fSpentIndex)
+        return false;
+
+    return pblocktree->ReadSpentIndex(key, value);
+}
+
+bool GetTimestampIndex(unsigned int nHigh, unsigned int nLow, std::vector<uint256>& vHashes)
+{
+    if (!fTimestampIndex)
+        return error("%s : timestamp index not enabled", __func__);
+
+    if (!pblocktree->ReadTimestampIndex(nHigh, nLow, vHashes))
+        return error("%s : unable to get hashes for timestamps", __func__);
+
+    return true;
+}
+
 bool DisconnectBlock(CBlock& block, CValidationState& state, CBlockIndex* pindex, CCoinsViewCache& view, bool* pfClean)
 {
     if (pindex->GetBlockHash() != view.GetBestBlock())
@@ -2275,6 +2454,17 @@ bool DisconnectBlock(CBlock& block, CValidationState& state, CBlockIndex* pindex
     if (blockUndo.vtxundo.size() + 1 != block.vtx.size())
         return error("DisconnectBlock() : block and undo data inconsistent");
 
+    // the optional indexes are left alone while VerifyDB rolls blocks back and forth
+    bool fUpdateAddressIndex = fAddressIndex && !fVerifyingBlocks;
+    bool fUpdateSpentIndex = fSpentIndex && !fVerifyingBlocks;
+    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > addressUnspentIndex;
+    std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > spentIndex;
+    // the zerocoin height index stops covering this block before its entries are erased
+    int nHeightZerocoinIndex = fVerifyingBlocks ? -1 : pindex->nHeight;
+    if (nHeightZerocoinIndex >= 0 && !zerocoinDB->TruncateHeightIndex(nHeightZerocoinIndex))
+        return error("DisconnectBlock() : failed to lower the zerocoin height index");
+
     // undo transactions in reverse order
     for (int i = block.vtx.size() - 1; i >= 0; i--) {
         const CTransaction& tx = block.vtx[i];
@@ -2289,7 +2479,7 @@ bool DisconnectBlock(CBlock& block, CValidationState& state, CBlockIndex* pindex
                 for (const CTxIn& txin : tx.vin) {
                     if (txin.scriptSig.IsZerocoinSpend()) {
                         CoinSpend spend = TxInToZerocoinSpend(txin);
-                        if (!zerocoinDB->EraseCoinSpend(spend.getCoinSerialNumber()))
+                        if (!zerocoinDB->EraseCoinSpend(spend.getCoinSerialNumber(), nHeightZerocoinIndex))
                             return error("failed to erase spent zerocoin in block");
 
                         //if this was our spend, then mark it unspent now
@@ -2314,7 +2504,7 @@ bool DisconnectBlock(CBlock& block, CValidationState& state, CBlockIndex* pindex
                     if (!TxOutToPublicCoin(txout, pubCoin, state))
                         return error("DisconnectBlock(): TxOutToPublicCoin() failed");
 
-                    if(!zerocoinDB->EraseCoinMint(pubCoin.getValue()))
+                    if(!zerocoinDB->EraseCoinMint(pubCoin.getValue(), nHeightZerocoinIndex))
                         return error("DisconnectBlock(): Failed to erase coin mint");
                 }
             }
@@ -2344,6 +2534,19 @@ bool DisconnectBlock(CBlock& block, CValidationState& state, CBlockIndex* pindex
             outs->Clear();
         }
 
+        if (fUpdateAddressIndex) {
+            for (unsigned int k = tx.vout.size(); k-- > 0;) {
+                const CTxOut& out = tx.vout[k];
+                int nAddressType;
+                uint160 addressHash;
+                if (!GetAddressIndexHash(out.scriptPubKey, nAddressType, addressHash))
+                    continue;
+
+                addressIndex.push_back(make_pair(CAddressIndexKey(nAddressType, addressHash, pindex->nHeight, i, hash, k, false), out.nValue));
+                addressUnspentIndex.push_back(make_pair(CAddressUnspentKey(nAddressType, addressHash, hash, k), CAddressUnspentValue()));
+            }
+        }
+
         // restore inputs
         if (!tx.IsCoinBase() && !tx.IsZerocoinSpend()) { // not coinbases or zerocoinspend because they dont have traditional inputs
             const CTxUndo& txundo = blockUndo.vtxundo[i - 1];
@@ -2370,10 +2573,32 @@ bool DisconnectBlock(CBlock& block, CValidationState& state, CBlockIndex* pindex
                 if (coins->vout.size() < out.n + 1)
                     coins->vout.resize(out.n + 1);
                 coins->vout[out.n] = undo.txout;
+
+                if (fUpdateSpentIndex)
+                    spentIndex.push_back(make_pair(CSpentIndexKey(out.hash, out.n), CSpentIndexValue()));
+
+                int nAddressType;
+                uint160 addressHash;
+                if (fUpdateAddressIndex && GetAddressIndexHash(undo.txout.scriptPubKey, nAddressType, addressHash)) {
+                    addressIndex.push_back(make_pair(CAddressIndexKey(nAddressType, addressHash, pindex->nHeight, i, hash, j, true), undo.txout.nValue * -1));
+                    addressUnspentIndex.push_back(make_pair(CAddressUnspentKey(nAddressType, addressHash, out.hash, out.n),
+                                                            CAddressUnspentValue(undo.txout.nValue, undo.txout.scriptPubKey, coins->nHeight)));
+                }
             }
         }
     }
 
+    if (fUpdateAddressIndex) {
+        if (!pblocktree->EraseAddressIndex(addressIndex))
+            return state.Abort("Failed to delete address index");
+        if (!pblocktree->UpdateAddressUnspentIndex(addressUnspentIndex))
+            return state.Abort("Failed to write address unspent index");
+    }
+    if (fUpdateSpentIndex && !pblocktree->UpdateSpentIndex(spentIndex))
+        return state.Abort("Failed to write spent index");
+    if (fTimestampIndex && !fVerifyingBlocks && !pblocktree->EraseTimestampIndex(CTimestampIndexKey(pindex->nTime, pindex->GetBlockHash())))
+        return state.Abort("Failed to delete timestamp index");
+
     // move best block pointer to prevout block
     view.SetBestBlock(pindex->pprev->GetBlockHash());
 
@@ -2415,11 +2640,15 @@ void static FlushBlockFile(bool fFinalize = false)
         FileCommit(fileOld);
         fclose(fileOld);
     }
+
+    // Mappings of the truncated files would extend past their end
+    if (fFinalize)
+        blockFileMapper.Clear();
 }
 
 bool FindUndoPos(CValidationState& state, int nFile, CDiskBlockPos& pos, unsigned int nAddSize);
 
-static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
+static CCheckQueue<CBlockCheck> scriptcheckqueue(128, MAX_SCRIPTCHECK_THREADS);
 
 void ThreadScriptCheck()
 {
@@ -2427,45 +2656,176 @@ void ThreadScriptCheck()
     scriptcheckqueue.Thread();
 }
 
-void RecalculateZKYDMinted()
+void GetScriptCheckQueueStats(CCheckQueueStats& stats)
 {
-    CBlockIndex *pindex = chainActive[Params().Zerocoin_StartHeight()];
-    int nHeightEnd = chainActive.Height();
-    while (true) {
-        if (pindex->nHeight % 1000 == 0)
-            LogPrintf("%s : block %d...\n", __func__, pindex->nHeight);
+    scriptcheckqueue.GetStats(stats);
+}
 
-        //overwrite possibly wrong vMintsInBlock data
-        CBlock block;
-        assert(ReadBlockFromDisk(block, pindex));
+/** Number of blocks the readers of CBlockReadQueue may run ahead of the block being applied */
+static const unsigned int BLOCK_READ_AHEAD = 64;
+/** Number of block index records written per batch while recalculating the money supply */
+static const unsigned int SUPPLY_WRITE_BATCH_SIZE = 1000;
 
-        std::list<CZerocoinMint> listMints;
-        BlockToZerocoinMintList(block, listMints, true);
+/**
+ * Reads a sequence of blocks on a pool of threads. Each block is passed to
+ * fnPrepare on the reader thread that read it, so that expensive extraction
+ * (mints, spends, pubcoins) runs in parallel too, and the prepared results are
+ * then handed to fnApply in the original order on the calling thread.
+ */
+template <typename T>
+class CBlockReadQueue
+{
+public:
+    typedef boost::function<bool(const CBlock&, const CBlockIndex*, T&)> PrepareFunction;
+    typedef boost::function<bool(CBlockIndex*, T&)> ApplyFunction;
 
-        vector<libzerocoin::CoinDenomination> vDenomsBefore = pindex->vMintDenominationsInBlock;
-        pindex->vMintDenominationsInBlock.clear();
-        for (auto mint : listMints)
-            pindex->vMintDenominationsInBlock.emplace_back(mint.GetDenomination());
+private:
+    const std::vector<CBlockIndex*>& vIndex;
+    PrepareFunction fnPrepare;
+
+    boost::mutex mutex;
+    //! Readers wait on this for room in the read-ahead window
+    boost::condition_variable condReader;
+    //! The applying thread waits on this for the next result
+    boost::condition_variable condResult;
+    size_t nNextRead;
+    size_t nNextApply;
+    std::map<size_t, std::pair<bool, T> > mapResults;
+    bool fAbort;
+
+    void Read()
+    {
+        while (true) {
+            size_t nPos;
+            {
+                boost::unique_lock<boost::mutex> lock(mutex);
+                while (!fAbort && nNextRead < vIndex.size() && nNextRead >= nNextApply + BLOCK_READ_AHEAD)
+                    condReader.wait(lock);
+                if (fAbort || nNextRead >= vIndex.size())
+                    return;
+                nPos = nNextRead++;
+            }
 
-        if (pindex->nHeight < nHeightEnd)
-            pindex = chainActive.Next(pindex);
-        else
-            break;
+            std::pair<bool, T> result;
+            result.first = false;
+            try {
+                std::shared_ptr<const CBlock> pblock;
+                if (ReadBlockFromDisk(pblock, vIndex[nPos]))
+                    result.first = fnPrepare(*pblock, vIndex[nPos], result.second);
+                else
+                    error("%s : failed to read block %d", __func__, vIndex[nPos]->nHeight);
+            } catch (const std::exception& e) {
+                error("%s : block %d - %s", __func__, vIndex[nPos]->nHeight, e.what());
+            } catch (...) {
+                // Anything escaping a reader thread would terminate the process
+                error("%s : block %d - unknown exception", __func__, vIndex[nPos]->nHeight);
+            }
+
+            {
+                boost::unique_lock<boost::mutex> lock(mutex);
+                std::swap(mapResults[nPos], result);
+            }
+            condResult.notify_all();
+        }
     }
+
+    void StopReaders(boost::thread_group& readers)
+    {
+        {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            fAbort = true;
+        }
+        condReader.notify_all();
+        readers.join_all();
+    }
+
+public:
+    CBlockReadQueue(const std::vector<CBlockIndex*>& vIndexIn, PrepareFunction fnPrepareIn) : vIndex(vIndexIn), fnPrepare(fnPrepareIn), nNextRead(0), nNextApply(0), fAbort(false) {}
+
+    //! Returns false as soon as a block fails to be read or prepared, or fnApply fails
+    bool Run(ApplyFunction fnApply)
+    {
+        boost::thread_group readers;
+        int nReaders = std::max(2, nScriptCheckThreads);
+        for (int i = 0; i < nReaders; i++)
+            readers.create_thread(boost::bind(&CBlockReadQueue<T>::Read, this));
+
+        bool fSuccess = true;
+        try {
+            for (size_t nPos = 0; nPos < vIndex.size(); nPos++) {
+                std::pair<bool, T> result;
+                {
+                    boost::unique_lock<boost::mutex> lock(mutex);
+                    while (!mapResults.count(nPos))
+                        condResult.wait(lock);
+                    std::swap(mapResults[nPos], result);
+                    mapResults.erase(nPos);
+                    nNextApply = nPos + 1;
+                }
+                condReader.notify_all();
+
+                if (!result.first || !fnApply(vIndex[nPos], result.second)) {
+                    fSuccess = false;
+                    break;
+                }
+            }
+        } catch (...) {
+            // fnApply may throw (it writes to the databases); the readers use
+            // this queue, so they have to be stopped before it goes away
+            StopReaders(readers);
+            throw;
+        }
+
+        StopReaders(readers);
+        return fSuccess;
+    }
+};
+
+static std::vector<CBlockIndex*> GetActiveChainRange(int nHeightStart, int nHeightEnd)
+{
+    std::vector<CBlockIndex*> vIndex;
+    for (int nHeight = nHeightStart; nHeight <= nHeightEnd; nHeight++)
+        vIndex.emplace_back(chainActive[nHeight]);
+    return vIndex;
 }
 
-void RecalculateZKYDSpent()
+void RecalculateZKYDMinted(int nHeightStart)
 {
-    CBlockIndex* pindex = chainActive[Params().Zerocoin_StartHeight()];
-    while (true) {
+    const char* strFunc = __func__;
+    std::vector<CBlockIndex*> vIndex = GetActiveChainRange(nHeightStart, chainActive.Height());
+
+    //overwrite possibly wrong vMintsInBlock data
+    CBlockReadQueue<vector<libzerocoin::CoinDenomination> > queue(vIndex,
+        [](const CBlock& block, const CBlockIndex* pindex, vector<libzerocoin::CoinDenomination>& vDenoms) {
+            std::list<CZerocoinMint> listMints;
+            BlockToZerocoinMintList(block, listMints, true);
+            for (auto mint : listMints)
+                vDenoms.emplace_back(mint.GetDenomination());
+            return true;
+        });
+    bool fSuccess = queue.Run([strFunc](CBlockIndex* pindex, vector<libzerocoin::CoinDenomination>& vDenoms) {
         if (pindex->nHeight % 1000 == 0)
-            LogPrintf("%s : block %d...\n", __func__, pindex->nHeight);
+            LogPrintf("%s : block %d...\n", strFunc, pindex->nHeight);
+        pindex->vMintDenominationsInBlock.swap(vDenoms);
+        return true;
+    });
+    assert(fSuccess);
+}
 
-        //Rewrite zKYD supply
-        CBlock block;
-        assert(ReadBlockFromDisk(block, pindex));
+void RecalculateZKYDSpent(int nHeightStart)
+{
+    const char* strFunc = __func__;
+    std::vector<CBlockIndex*> vIndex = GetActiveChainRange(nHeightStart, chainActive.Height());
+    std::vector<CBlockIndex*> vWrite;
 
-        list<libzerocoin::CoinDenomination> listDenomsSpent = ZerocoinSpendListFromBlock(block, true);
+    CBlockReadQueue<list<libzerocoin::CoinDenomination> > queue(vIndex,
+        [](const CBlock& block, const CBlockIndex* pindex, list<libzerocoin::CoinDenomination>& listDenomsSpent) {
+            listDenomsSpent = ZerocoinSpendListFromBlock(block, true);
+            return true;
+        });
+    bool fSuccess = queue.Run([strFunc, &vWrite](CBlockIndex* pindex, list<libzerocoin::CoinDenomination>& listDenomsSpent) {
+        if (pindex->nHeight % 1000 == 0)
+            LogPrintf("%s : block %d...\n", strFunc, pindex->nHeight);
 
         //Reset the supply to previous block
         pindex->mapZerocoinSupply = pindex->pprev->mapZerocoinSupply;
@@ -2480,18 +2840,30 @@ void RecalculateZKYDSpent()
         for (auto denom : listDenomsSpent)
             pindex->mapZerocoinSupply.at(denom)--;
 
-        //Rewrite money supply
-        assert(pblocktree->WriteBlockIndex(CDiskBlockIndex(pindex)));
-
-        if (pindex->nHeight < chainActive.Height())
-            pindex = chainActive.Next(pindex);
-        else
-            break;
-    }
+        //Rewrite money supply, a batch at a time, and record how far we got so an interrupted run can resume
+        vWrite.emplace_back(pindex);
+        if (vWrite.size() >= SUPPLY_WRITE_BATCH_SIZE || pindex->nHeight == chainActive.Height()) {
+            assert(pblocktree->WriteBlockIndexBatch(vWrite));
+            assert(pblocktree->WriteInt("zkydsupplyheight", pindex->nHeight + 1));
+            vWrite.clear();
+        }
+        return true;
+    });
+    assert(fSuccess);
+    pblocktree->WriteInt("zkydsupplyheight", 0);
 }
 
+/** Money supply effects of a block that can be computed without looking up its inputs */
+struct CBlockSupplyDelta
+{
+    CAmount nValueIn;
+    CAmount nValueOut;
+    std::vector<COutPoint> vPrevouts;
+};
+
 bool RecalculateKYDSupply(int nHeightStart)
 {
+    const char* strFunc = __func__;
     if (nHeightStart > chainActive.Height())
         return false;
 
@@ -2500,68 +2872,100 @@ bool RecalculateKYDSupply(int nHeightStart)
     if (nHeightStart == Params().Zerocoin_StartHeight())
         nSupplyPrev = CAmount(5449796547496199);
 
-    while (true) {
-        if (pindex->nHeight % 1000 == 0)
-            LogPrintf("%s : block %d...\n", __func__, pindex->nHeight);
+    std::vector<CBlockIndex*> vIndex = GetActiveChainRange(nHeightStart, chainActive.Height());
+    std::vector<CBlockIndex*> vWrite;
 
-        CBlock block;
-        assert(ReadBlockFromDisk(block, pindex));
+    CBlockReadQueue<CBlockSupplyDelta> queue(vIndex,
+        [](const CBlock& block, const CBlockIndex* pindex, CBlockSupplyDelta& delta) {
+            delta.nValueIn = 0;
+            delta.nValueOut = 0;
+            for (const CTransaction& tx : block.vtx) {
+                for (unsigned int i = 0; i < tx.vin.size(); i++) {
+                    if (tx.IsCoinBase())
+                        break;
 
-        CAmount nValueIn = 0;
-        CAmount nValueOut = 0;
-        for (const CTransaction& tx : block.vtx) {
-            for (unsigned int i = 0; i < tx.vin.size(); i++) {
-                if (tx.IsCoinBase())
-                    break;
+                    if (tx.vin[i].scriptSig.IsZerocoinSpend()) {
+                        delta.nValueIn += tx.vin[i].nSequence * COIN;
+                        continue;
+                    }
 
-                if (tx.vin[i].scriptSig.IsZerocoinSpend()) {
-                    nValueIn += tx.vin[i].nSequence * COIN;
-                    continue;
+                    delta.vPrevouts.emplace_back(tx.vin[i].prevout);
                 }
 
-                COutPoint prevout = tx.vin[i].prevout;
-                CTransaction txPrev;
-                uint256 hashBlock;
-                assert(GetTransaction(prevout.hash, txPrev, hashBlock, true));
-                nValueIn += txPrev.vout[prevout.n].nValue;
-            }
-
-            for (unsigned int i = 0; i < tx.vout.size(); i++) {
-                if (i == 0 && tx.IsCoinStake())
-                    continue;
+                for (unsigned int i = 0; i < tx.vout.size(); i++) {
+                    if (i == 0 && tx.IsCoinStake())
+                        continue;
 
-                nValueOut += tx.vout[i].nValue;
+                    delta.nValueOut += tx.vout[i].nValue;
+                }
             }
+            return true;
+        });
+    bool fSuccess = queue.Run([strFunc, &nSupplyPrev, &vWrite](CBlockIndex* pindex, CBlockSupplyDelta& delta) {
+        if (pindex->nHeight % 1000 == 0)
+            LogPrintf("%s : block %d...\n", strFunc, pindex->nHeight);
+
+        // Looking up the inputs may need cs_main, so it is done here rather than on the readers
+        CAmount nValueIn = delta.nValueIn;
+        for (const COutPoint& prevout : delta.vPrevouts) {
+            CTransaction txPrev;
+            uint256 hashBlock;
+            assert(GetTransaction(prevout.hash, txPrev, hashBlock, true));
+            nValueIn += txPrev.vout[prevout.n].nValue;
         }
 
         // Rewrite money supply
-        pindex->nMoneySupply = nSupplyPrev + nValueOut - nValueIn;
+        pindex->nMoneySupply = nSupplyPrev + delta.nValueOut - nValueIn;
         nSupplyPrev = pindex->nMoneySupply;
 
         // Add fraudulent funds to the supply and remove any recovered funds.
         if (pindex->nHeight == Params().Zerocoin_Block_RecalculateAccumulators()) {
-            LogPrintf("%s : Original money supply=%s\n", __func__, FormatMoney(pindex->nMoneySupply));
+            LogPrintf("%s : Original money supply=%s\n", strFunc, FormatMoney(pindex->nMoneySupply));
 
             pindex->nMoneySupply += Params().InvalidAmountFiltered();
-            LogPrintf("%s : Adding filtered funds to supply + %s : supply=%s\n", __func__, FormatMoney(Params().InvalidAmountFiltered()), FormatMoney(pindex->nMoneySupply));
+            LogPrintf("%s : Adding filtered funds to supply + %s : supply=%s\n", strFunc, FormatMoney(Params().InvalidAmountFiltered()), FormatMoney(pindex->nMoneySupply));
 
             CAmount nLocked = GetInvalidUTXOValue();
             pindex->nMoneySupply -= nLocked;
-            LogPrintf("%s : Removing locked from supply - %s : supply=%s\n", __func__, FormatMoney(nLocked), FormatMoney(pindex->nMoneySupply));
+            LogPrintf("%s : Removing locked from supply - %s : supply=%s\n", strFunc, FormatMoney(nLocked), FormatMoney(pindex->nMoneySupply));
         }
 
-        assert(pblocktree->WriteBlockIndex(CDiskBlockIndex(pindex)));
-
-        if (pindex->nHeight < chainActive.Height())
-            pindex = chainActive.Next(pindex);
-        else
-            break;
-    }
+        vWrite.emplace_back(pindex);
+        if (vWrite.size() >= SUPPLY_WRITE_BATCH_SIZE || pindex->nHeight == chainActive.Height()) {
+            assert(pblocktree->WriteBlockIndexBatch(vWrite));
+            assert(pblocktree->WriteInt("moneysupplyheight", pindex->nHeight + 1));
+            vWrite.clear();
+        }
+        return true;
+    });
+    assert(fSuccess);
+    pblocktree->WriteInt("moneysupplyheight", 0);
     return true;
 }
 
+CSupplyRecalculation GetSupplyRecalculationStart(int nHeightZerocoinDone, int nHeightMoneyDone, int nHeightChain, int nHeightZerocoinStart)
+{
+    // RecalculateZKYDSpent and RecalculateKYDSupply record the next block to
+    // process after each batch, and 0 once they are finished. The zKYD pass
+    // runs first, so a recorded zKYD height means the KYD pass never started.
+    CSupplyRecalculation start;
+    start.fZerocoin = nHeightChain > nHeightZerocoinStart;
+    start.nHeightZerocoin = nHeightZerocoinStart;
+    start.nHeightMoney = 1;
+    if (nHeightZerocoinDone > nHeightZerocoinStart && nHeightZerocoinDone <= nHeightChain) {
+        start.nHeightZerocoin = nHeightZerocoinDone;
+    } else if (nHeightMoneyDone > 1 && nHeightMoneyDone <= nHeightChain && nHeightMoneyDone != nHeightZerocoinStart) {
+        // RecalculateKYDSupply uses a fixed supply when it starts at the zerocoin
+        // start height, so that block is redone from the beginning instead
+        start.fZerocoin = false;
+        start.nHeightMoney = nHeightMoneyDone;
+    }
+    return start;
+}
+
 bool ReindexAccumulators(list<uint256>& listMissingCheckpoints, string& strError)
 {
+    const char* strFunc = __func__;
     // KYD: recalculate Accumulator Checkpoints that failed to database properly
     if (!listMissingCheckpoints.empty()) {
         uiInterface.ShowProgress(_("Calculating missing accumulators..."), 0);
@@ -2570,40 +2974,81 @@ bool ReindexAccumulators(list<uint256>& listMissingCheckpoints, string& strError
         //search the chain to see when zerocoin started
         int nZerocoinStart = Params().Zerocoin_Block_V2_Start();
 
-        // find each checkpoint that is missing
+        // find each checkpoint that is missing, and the blocks that have to be read to calculate it
+        std::set<int> setCheckpointHeights;
+        std::set<int> setReadHeights;
+        std::set<uint256> setPlanned;
         CBlockIndex* pindex = chainActive[nZerocoinStart];
         while (pindex) {
+            // find checkpoints by iterating through the blockchain beginning with the first zerocoin block
+            if (pindex->nAccumulatorCheckpoint != pindex->pprev->nAccumulatorCheckpoint && !setPlanned.count(pindex->nAccumulatorCheckpoint)) {
+                if (find(listMissingCheckpoints.begin(), listMissingCheckpoints.end(), pindex->nAccumulatorCheckpoint) != listMissingCheckpoints.end()) {
+                    setPlanned.insert(pindex->nAccumulatorCheckpoint);
+                    setCheckpointHeights.insert(pindex->nHeight);
+                    for (int nHeight = std::max(0, pindex->nHeight - 20); nHeight <= pindex->nHeight; nHeight++)
+                        setReadHeights.insert(nHeight);
+                }
+            }
+            pindex = chainActive.Next(pindex);
+        }
+
+        std::vector<CBlockIndex*> vIndex;
+        for (int nHeight : setReadHeights)
+            vIndex.emplace_back(chainActive[nHeight]);
+
+        // Blocks are read and their pubcoins extracted in parallel ahead of the checkpoint
+        // calculations, which then only have to accumulate them in order
+        std::map<int, CBlockPubcoins> mapPubcoins;
+        int nRecalculateHeight = Params().Zerocoin_Block_RecalculateAccumulators();
+        CBlockReadQueue<CBlockPubcoins> queue(vIndex,
+            [nRecalculateHeight](const CBlock& block, const CBlockIndex* pindex, CBlockPubcoins& pubcoins) {
+                // the checkpoint that accumulates this block decides whether invalid outpoints are filtered
+                int nHeightCheckpoint = pindex->nHeight - pindex->nHeight % 10 + 20;
+                pubcoins.fFilterInvalid = nHeightCheckpoint >= nRecalculateHeight;
+                return BlockToPubcoinList(block, pubcoins.listPubcoins, pubcoins.fFilterInvalid);
+            });
+        bool fSuccess = queue.Run([&](CBlockIndex* pindex, CBlockPubcoins& pubcoins) {
             uiInterface.ShowProgress(_("Calculating missing accumulators..."), std::max(1, std::min(99, (int)((double)(pindex->nHeight - nZerocoinStart) / (double)(chainActive.Height() - nZerocoinStart) * 100))));
 
             if (ShutdownRequested())
                 return false;
 
-            // find checkpoints by iterating through the blockchain beginning with the first zerocoin block
-            if (pindex->nAccumulatorCheckpoint != pindex->pprev->nAccumulatorCheckpoint) {
-                if (find(listMissingCheckpoints.begin(), listMissingCheckpoints.end(), pindex->nAccumulatorCheckpoint) != listMissingCheckpoints.end()) {
-                    uint256 nCheckpointCalculated = 0;
-                    AccumulatorMap mapAccumulators(Params().Zerocoin_Params(false));
-                    if (!CalculateAccumulatorCheckpoint(pindex->nHeight, nCheckpointCalculated, mapAccumulators)) {
-                        // GetCheckpoint could have terminated due to a shutdown request. Check this here.
-                        if (ShutdownRequested())
-                            break;
-                        strError = _("Failed to calculate accumulator checkpoint");
-                        return error("%s: %s", __func__, strError);
-                    }
+            std::swap(mapPubcoins[pindex->nHeight], pubcoins);
+            if (!setCheckpointHeights.count(pindex->nHeight))
+                return true;
 
-                    //check that the calculated checkpoint is what is in the index.
-                    if (nCheckpointCalculated != pindex->nAccumulatorCheckpoint) {
-                        LogPrintf("%s : height=%d calculated_checkpoint=%s actual=%s\n", __func__, pindex->nHeight, nCheckpointCalculated.GetHex(), pindex->nAccumulatorCheckpoint.GetHex());
-                        strError = _("Calculated accumulator checkpoint is not what is recorded by block index");
-                        return error("%s: %s", __func__, strError);
-                    }
+            uint256 nCheckpointCalculated = 0;
+            AccumulatorMap mapAccumulators(Params().Zerocoin_Params(false));
+            if (!CalculateAccumulatorCheckpoint(pindex->nHeight, nCheckpointCalculated, mapAccumulators, &mapPubcoins)) {
+                // GetCheckpoint could have terminated due to a shutdown request. Check this here.
+                if (ShutdownRequested())
+                    return false;
+                strError = _("Failed to calculate accumulator checkpoint");
+                return error("%s: %s", strFunc, strError);
+            }
 
-                    DatabaseChecksums(mapAccumulators);
-                    auto it = find(listMissingCheckpoints.begin(), listMissingCheckpoints.end(), pindex->nAccumulatorCheckpoint);
-                    listMissingCheckpoints.erase(it);
-                }
+            //check that the calculated checkpoint is what is in the index.
+            if (nCheckpointCalculated != pindex->nAccumulatorCheckpoint) {
+                LogPrintf("%s : height=%d calculated_checkpoint=%s actual=%s\n", strFunc, pindex->nHeight, nCheckpointCalculated.GetHex(), pindex->nAccumulatorCheckpoint.GetHex());
+                strError = _("Calculated accumulator checkpoint is not what is recorded by block index");
+                return error("%s: %s", strFunc, strError);
             }
-            pindex = chainActive.Next(pindex);
+
+            DatabaseChecksums(mapAccumulators);
+            auto it = find(listMissingCheckpoints.begin(), listMissingCheckpoints.end(), pindex->nAccumulatorCheckpoint);
+            listMissingCheckpoints.erase(it);
+
+            // Blocks below this window are not accumulated by any later checkpoint
+            mapPubcoins.erase(mapPubcoins.begin(), mapPubcoins.lower_bound(pindex->nHeight - 20));
+            return true;
+        });
+
+        if (!fSuccess) {
+            if (ShutdownRequested())
+                return false;
+            if (strError.empty())
+                strError = _("Failed to calculate accumulator checkpoint");
+            return error("%s: %s", __func__, strError);
         }
         uiInterface.ShowProgress("", 100);
     }
@@ -2682,8 +3127,10 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
 {
     AssertLockHeld(cs_main);
     // Check it again in case a previous version let a bad block in
+    int64_t nMicrosCheckBlock = GetTimeMicros();
     if (!fAlreadyChecked && !CheckBlock(block, state, !fJustCheck, !fJustCheck))
         return false;
+    nMicrosCheckBlock = GetTimeMicros() - nMicrosCheckBlock;
 
     // verify that the view's current state corresponds to the previous block
     uint256 hashPrevBlock = pindex->pprev == NULL ? uint256(0) : pindex->pprev->GetBlockHash();
@@ -2738,7 +3185,8 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
         }
     }
 
-    CCheckQueueControl<CScriptCheck> control(fScriptChecks && nScriptCheckThreads ? &scriptcheckqueue : NULL);
+    bool fParallelChecks = fScriptChecks && nScriptCheckThreads;
+    CCheckQueueControl<CBlockCheck> control(fParallelChecks ? &scriptcheckqueue : NULL);
 
     int64_t nTimeStart = GetTimeMicros();
     CAmount nFees = 0;
@@ -2756,6 +3204,13 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
     unsigned int nMaxBlockSigOps = MAX_BLOCK_SIGOPS_CURRENT;
     vector<uint256> vSpendsInBlock;
     uint256 hashBlock = block.GetHash();
+    bool fUpdateAddressIndex = fAddressIndex && !fJustCheck && !fVerifyingBlocks;
+    bool fUpdateSpentIndex = fSpentIndex && !fJustCheck && !fVerifyingBlocks;
+    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > addressUnspentIndex;
+    std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > spentIndex;
+    int64_t nMicrosZerocoin = 0;
+    int64_t nMicrosScripts = 0;
     for (unsigned int i = 0; i < block.vtx.size(); i++) {
         const CTransaction& tx = block.vtx[i];
 
@@ -2770,6 +3225,7 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
         }
 
         if (tx.IsZerocoinSpend()) {
+            int64_t nTimeZerocoinStart = GetTimeMicros();
             int nHeightTx = 0;
             uint256 txid = tx.GetHash();
             vSpendsInBlock.emplace_back(txid);
@@ -2783,6 +3239,7 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
 
             //Check for double spending of serial #'s
             set<CBigNum> setSerials;
+            std::vector<CBlockCheck> vChecks;
             for (const CTxIn& txIn : tx.vin) {
                 if (!txIn.scriptSig.IsZerocoinSpend())
                     continue;
@@ -2791,9 +3248,10 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
 
                 //queue for db write after the 'justcheck' section has concluded
                 vSpends.emplace_back(make_pair(spend, tx.GetHash()));
-                if (!ContextualCheckZerocoinSpend(tx, spend, pindex, hashBlock))
+                if (!ContextualCheckZerocoinSpend(tx, spend, pindex, hashBlock, fParallelChecks ? &vChecks : NULL))
                     return state.DoS(100, error("%s: failed to add block %s with invalid zerocoinspend", __func__, tx.GetHash().GetHex()), REJECT_INVALID);
             }
+            control.Add(vChecks);
 
             // Check that zKYD mints are not already known
             if (tx.IsZerocoinMint()) {
@@ -2811,6 +3269,7 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
                     vMints.emplace_back(make_pair(coin, tx.GetHash()));
                 }
             }
+            nMicrosZerocoin += GetTimeMicros() - nTimeZerocoinStart;
         } else if (!tx.IsCoinBase()) {
             if (!view.HaveInputs(tx))
                 return state.DoS(100, error("ConnectBlock() : inputs missing/spent"),
@@ -2857,9 +3316,11 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
             if (fCLTVHasMajority)
                 flags |= SCRIPT_VERIFY_CHECKLOCKTIMEVERIFY;
 
+            int64_t nTimeScriptsStart = GetTimeMicros();
             if (!CheckInputs(tx, state, view, fScriptChecks, flags, false, nScriptCheckThreads ? &vChecks : NULL))
                 return false;
             control.Add(vChecks);
+            nMicrosScripts += GetTimeMicros() - nTimeScriptsStart;
         }
         nValueOut += tx.GetValueOut();
 
@@ -2869,14 +3330,53 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
         }
         UpdateCoins(tx, state, view, i == 0 ? undoDummy : blockundo.vtxundo.back(), pindex->nHeight);
 
+        if (fUpdateAddressIndex || fUpdateSpentIndex) {
+            const uint256 txhash = tx.GetHash();
+
+            // the undo data UpdateCoins just filled in holds the outputs being spent
+            if (i > 0 && !tx.IsZerocoinSpend()) {
+                const CTxUndo& txundo = blockundo.vtxundo.back();
+                for (unsigned int j = 0; j < tx.vin.size(); j++) {
+                    const COutPoint& prevout = tx.vin[j].prevout;
+                    const CTxOut& spent = txundo.vprevout[j].txout;
+                    int nAddressType = ADDRESS_INDEX_NONE;
+                    uint160 addressHash;
+                    bool fAddress = GetAddressIndexHash(spent.scriptPubKey, nAddressType, addressHash);
+
+                    if (fUpdateAddressIndex && fAddress) {
+                        addressIndex.push_back(make_pair(CAddressIndexKey(nAddressType, addressHash, pindex->nHeight, i, txhash, j, true), spent.nValue * -1));
+                        addressUnspentIndex.push_back(make_pair(CAddressUnspentKey(nAddressType, addressHash, prevout.hash, prevout.n), CAddressUnspentValue()));
+                    }
+
+                    if (fUpdateSpentIndex)
+                        spentIndex.push_back(make_pair(CSpentIndexKey(prevout.hash, prevout.n),
+                                                       CSpentIndexValue(txhash, j, pindex->nHeight, spent.nValue, nAddressType, addressHash)));
+                }
+            }
+
+            if (fUpdateAddressIndex) {
+                for (unsigned int k = 0; k < tx.vout.size(); k++) {
+                    const CTxOut& out = tx.vout[k];
+                    int nAddressType;
+                    uint160 addressHash;
+                    if (!GetAddressIndexHash(out.scriptPubKey, nAddressType, addressHash))
+                        continue;
+
+                    addressIndex.push_back(make_pair(CAddressIndexKey(nAddressType, addressHash, pindex->nHeight, i, txhash, k, false), out.nValue));
+                    addressUnspentIndex.push_back(make_pair(CAddressUnspentKey(nAddressType, addressHash, txhash, k), CAddressUnspentValue(out.nValue, out.scriptPubKey, pindex->nHeight)));
+                }
+            }
+        }
+
         vPos.push_back(std::make_pair(tx.GetHash(), pos));
         pos.nTxOffset += ::GetSerializeSize(tx, SER_DISK, CLIENT_VERSION);
     }
 
     //A one-time event where money supply counts were off and recalculated on a certain block.
+    int64_t nMicrosSupply = GetTimeMicros();
     if (pindex->nHeight == Params().Zerocoin_Block_RecalculateAccumulators() + 1) {
-        RecalculateZKYDMinted();
-        RecalculateZKYDSpent();
+        RecalculateZKYDMinted(Params().Zerocoin_StartHeight());
+        RecalculateZKYDSpent(Params().Zerocoin_StartHeight());
         RecalculateKYDSupply(Params().Zerocoin_StartHeight());
     }
 
@@ -2891,6 +3391,7 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
     CAmount nMoneySupplyPrev = pindex->pprev ? pindex->pprev->nMoneySupply : 0;
     pindex->nMoneySupply = nMoneySupplyPrev + nValueOut - nValueIn;
     pindex->nMint = pindex->nMoneySupply - nMoneySupplyPrev + nFees;
+    nMicrosSupply = GetTimeMicros() - nMicrosSupply;
 
 //    LogPrintf("XX69----------> ConnectBlock(): nValueOut: %s, nValueIn: %s, nFees: %s, nMint: %s zKydSpent: %s\n",
 //              FormatMoney(nValueOut), FormatMoney(nValueIn),
@@ -2913,14 +3414,18 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
     }
 
     // Ensure that accumulator checkpoints are valid and in the same state as this instance of the chain
+    int64_t nMicrosAccumulator = GetTimeMicros();
     AccumulatorMap mapAccumulators(Params().Zerocoin_Params(pindex->nHeight < Params().Zerocoin_Block_V2_Start()));
     if (!ValidateAccumulatorCheckpoint(block, pindex, mapAccumulators))
         return state.DoS(100, error("%s: Failed to validate accumulator checkpoint for block=%s height=%d", __func__,
                                     block.GetHash().GetHex(), pindex->nHeight), REJECT_INVALID, "bad-acc-checkpoint");
+    nMicrosAccumulator = GetTimeMicros() - nMicrosAccumulator;
 
+    int64_t nMicrosWait = GetTimeMicros();
     if (!control.Wait())
         return state.DoS(100, false);
     int64_t nTime2 = GetTimeMicros();
+    nMicrosScripts += nTime2 - nMicrosWait;
     nTimeVerify += nTime2 - nTimeStart;
     LogPrint("bench", "    - Verify %u txins: %.2fms (%.3fms/txin) [%.2fs]\n", nInputs - 1, 0.001 * (nTime2 - nTimeStart), nInputs <= 1 ? 0 : 0.001 * (nTime2 - nTimeStart) / (nInputs - 1), nTimeVerify * 0.000001);
 
@@ -2928,6 +3433,13 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
     if (fJustCheck)
         return true;
 
+    if (!fAlreadyChecked)
+        validationStats.Add(VALIDATION_STAGE_CHECK_BLOCK, nMicrosCheckBlock);
+    validationStats.Add(VALIDATION_STAGE_ZEROCOIN, nMicrosZerocoin);
+    validationStats.Add(VALIDATION_STAGE_SCRIPTS, nMicrosScripts);
+    validationStats.Add(VALIDATION_STAGE_SUPPLY, nMicrosSupply);
+    validationStats.Add(VALIDATION_STAGE_ACCUMULATOR, nMicrosAccumulator);
+
     // Write undo information to disk
     if (pindex->GetUndoPos().IsNull() || !pindex->IsValid(BLOCK_VALID_SCRIPTS)) {
         if (pindex->GetUndoPos().IsNull()) {
@@ -2988,11 +3500,25 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
         if (!pblocktree->WriteTxIndex(vPos))
             return state.Abort("Failed to write transaction index");
 
+    if (fUpdateAddressIndex) {
+        if (!pblocktree->WriteAddressIndex(addressIndex))
+            return state.Abort("Failed to write address index");
+        if (!pblocktree->UpdateAddressUnspentIndex(addressUnspentIndex))
+            return state.Abort("Failed to write address unspent index");
+    }
+
+    if (fUpdateSpentIndex && !pblocktree->UpdateSpentIndex(spentIndex))
+        return state.Abort("Failed to write spent index");
+
+    if (fTimestampIndex && !fVerifyingBlocks && !pblocktree->WriteTimestampIndex(CTimestampIndexKey(pindex->nTime, pindex->GetBlockHash())))
+        return state.Abort("Failed to write timestamp index");
+
     // add this block to the view's block chain
     view.SetBestBlock(pindex->GetBlockHash());
 
     int64_t nTime3 = GetTimeMicros();
     nTimeIndex += nTime3 - nTime2;
+    validationStats.Add(VALIDATION_STAGE_INDEX, nTime3 - nTime2);
     LogPrint("bench", "    - Index writing: %.2fms [%.2fs]\n", 0.001 * (nTime3 - nTime2), nTimeIndex * 0.000001);
 
     // Watch for changes to the previous coinbase transaction.
@@ -3150,6 +3676,7 @@ bool static DisconnectTip(CValidationState& state)
     // Write the chain state to disk, if necessary.
     if (!FlushStateToDisk(state, FLUSH_STATE_ALWAYS))
         return false;
+    GetMainSignals().BlockDisconnected(block, pindexDelete);
     // Resurrect mempool transactions from the disconnected block.
     BOOST_FOREACH (const CTransaction& tx, block.vtx) {
         // ignore validation errors in resurrected transactions
@@ -3202,10 +3729,14 @@ bool static ConnectTip(CValidationState& state, CBlockIndex* pindexNew, CBlock*
     nTimeReadFromDisk += nTime2 - nTime1;
     int64_t nTime3;
     LogPrint("bench", "  - Load block from disk: %.2fms [%.2fs]\n", (nTime2 - nTime1) * 0.001, nTimeReadFromDisk * 0.000001);
+    validationStats.BeginBlock(pindexNew->GetBlockHash(), pindexNew->nHeight, pblock->vtx.size());
+    validationStats.Add(VALIDATION_STAGE_READ_DISK, nTime2 - nTime1);
     {
         CInv inv(MSG_BLOCK, pindexNew->GetBlockHash());
         bool rv = ConnectBlock(*pblock, state, pindexNew, view, false, fAlreadyChecked);
+        int64_t nTimeChecked = GetTimeMicros();
         GetMainSignals().BlockChecked(*pblock, state);
+        validationStats.Add(VALIDATION_STAGE_SIGNALS, GetTimeMicros() - nTimeChecked);
         if (!rv) {
             if (state.IsInvalid())
                 InvalidBlockFound(pindexNew, state);
@@ -3214,6 +3745,7 @@ bool static ConnectTip(CValidationState& state, CBlockIndex* pindexNew, CBlock*
         mapBlockSource.erase(inv.hash);
         nTime3 = GetTimeMicros();
         nTimeConnectTotal += nTime3 - nTime2;
+        validationStats.Add(VALIDATION_STAGE_CONNECT, nTime3 - nTime2);
         LogPrint("bench", "  - Connect total: %.2fms [%.2fs]\n", (nTime3 - nTime2) * 0.001, nTimeConnectTotal * 0.000001);
         assert(view.Flush());
     }
@@ -3229,6 +3761,7 @@ bool static ConnectTip(CValidationState& state, CBlockIndex* pindexNew, CBlock*
         return false;
     int64_t nTime5 = GetTimeMicros();
     nTimeChainState += nTime5 - nTime4;
+    validationStats.Add(VALIDATION_STAGE_FLUSH, nTime5 - nTime3);
     LogPrint("bench", "  - Writing chainstate: %.2fms [%.2fs]\n", (nTime5 - nTime4) * 0.001, nTimeChainState * 0.000001);
 
     // Remove conflicting transactions from the mempool.
@@ -3237,6 +3770,8 @@ bool static ConnectTip(CValidationState& state, CBlockIndex* pindexNew, CBlock*
     mempool.check(pcoinsTip);
     // Update chainActive & related variables.
     UpdateTip(pindexNew);
+    int64_t nTimeSignals = GetTimeMicros();
+    GetMainSignals().BlockConnected(*pblock, pindexNew);
     // Tell wallet about transactions that went from mempool
     // to conflicted:
     BOOST_FOREACH (const CTransaction& tx, txConflicted) {
@@ -3250,6 +3785,9 @@ bool static ConnectTip(CValidationState& state, CBlockIndex* pindexNew, CBlock*
     int64_t nTime6 = GetTimeMicros();
     nTimePostConnect += nTime6 - nTime5;
     nTimeTotal += nTime6 - nTime1;
+    validationStats.Add(VALIDATION_STAGE_SIGNALS, nTime6 - nTimeSignals);
+    validationStats.Add(VALIDATION_STAGE_TOTAL, nTime6 - nTime1);
+    validationStats.CommitBlock();
     LogPrint("bench", "  - Connect postprocess: %.2fms [%.2fs]\n", (nTime6 - nTime5) * 0.001, nTimePostConnect * 0.000001);
     LogPrint("bench", "- Connect block: %.2fms [%.2fs]\n", (nTime6 - nTime1) * 0.001, nTimeTotal * 0.000001);
     return true;
@@ -3630,7 +4168,7 @@ CBlockIndex* AddToBlockIndex(const CBlock& block)
         return it->second;
 
     // Construct new block index object
-    CBlockIndex* pindexNew = new CBlockIndex(block);
+    CBlockIndex* pindexNew = blockIndexArena.New(block);
     assert(pindexNew);
     // We assign the sequence id to blocks only when the full data is available,
     // to avoid miners withholding blocks but broadcasting headers, to get a
@@ -4247,8 +4785,10 @@ bool AcceptBlock(CBlock& block, CValidationState& state, CBlockIndex** ppindex,
         uint256 hashProofOfStake = 0;
         unique_ptr<CStakeInput> stake;
 
+        int64_t nTimeStakeStart = GetTimeMicros();
         if (!CheckProofOfStake(block, hashProofOfStake, stake))
             return state.DoS(100, error("%s: proof of stake check failed", __func__));
+        validationStats.AddPending(block.GetHash(), VALIDATION_STAGE_CHECK_STAKE, GetTimeMicros() - nTimeStakeStart);
 
         if (!stake)
             return error("%s: null stake ptr", __func__);
@@ -4550,7 +5090,10 @@ bool ProcessNewBlock(CValidationState& state, CNode* pfrom, CBlock* pblock, CDis
 {
     // Preliminary checks
     int64_t nStartTime = GetTimeMillis();
+    int64_t nTimeCheckStart = GetTimeMicros();
     bool checked = CheckBlock(*pblock, state);
+    if (checked)
+        validationStats.AddPending(pblock->GetHash(), VALIDATION_STAGE_CHECK_BLOCK, GetTimeMicros() - nTimeCheckStart);
 
     int nMints = 0;
     int nSpends = 0;
@@ -4742,7 +5285,7 @@ CBlockIndex* InsertBlockIndex(uint256 hash)
         return (*mi).second;
 
     // Create new
-    CBlockIndex* pindexNew = new CBlockIndex();
+    CBlockIndex* pindexNew = blockIndexArena.New();
     if (!pindexNew)
         throw runtime_error("LoadBlockIndex() : new CBlockIndex failed");
     mi = mapBlockIndex.insert(make_pair(hash, pindexNew)).first;
@@ -4763,16 +5306,21 @@ bool static LoadBlockIndexDB(string& strError)
 
     boost::this_thread::interruption_point();
 
-    // Calculate nChainWork
-    vector<pair<int, CBlockIndex*> > vSortedByHeight;
-    vSortedByHeight.reserve(mapBlockIndex.size());
-    for (const std::pair<const uint256, CBlockIndex*>& item : mapBlockIndex) {
-        CBlockIndex* pindex = item.second;
-        vSortedByHeight.push_back(make_pair(pindex->nHeight, pindex));
-    }
-    sort(vSortedByHeight.begin(), vSortedByHeight.end());
-    BOOST_FOREACH (const PAIRTYPE(int, CBlockIndex*) & item, vSortedByHeight) {
-        CBlockIndex* pindex = item.second;
+    // Calculate nChainWork. Heights are dense, so the entries are ordered with a counting
+    // sort on height instead of a comparison sort.
+    int nMaxHeight = 0;
+    for (const std::pair<const uint256, CBlockIndex*>& item : mapBlockIndex)
+        nMaxHeight = std::max(nMaxHeight, item.second->nHeight);
+    vector<size_t> vHeightOffsets(nMaxHeight + 2, 0);
+    for (const std::pair<const uint256, CBlockIndex*>& item : mapBlockIndex)
+        vHeightOffsets[item.second->nHeight + 1]++;
+    for (int nHeight = 1; nHeight <= nMaxHeight + 1; nHeight++)
+        vHeightOffsets[nHeight] += vHeightOffsets[nHeight - 1];
+    vector<CBlockIndex*> vSortedByHeight(mapBlockIndex.size());
+    for (const std::pair<const uint256, CBlockIndex*>& item : mapBlockIndex)
+        vSortedByHeight[vHeightOffsets[item.second->nHeight]++] = item.second;
+
+    for (CBlockIndex* pindex : vSortedByHeight) {
         pindex->nChainWork = (pindex->pprev ? pindex->pprev->nChainWork : 0) + GetBlockProof(*pindex);
         if (pindex->nStatus & BLOCK_HAVE_DATA) {
             if (pindex->pprev) {
@@ -4843,6 +5391,14 @@ bool static LoadBlockIndexDB(string& strError)
     pblocktree->ReadFlag("txindex", fTxIndex);
     LogPrintf("LoadBlockIndexDB(): transaction index %s\n", fTxIndex ? "enabled" : "disabled");
 
+    // Check whether we have the optional address, spent and timestamp indexes
+    pblocktree->ReadFlag("addressindex", fAddressIndex);
+    LogPrintf("LoadBlockIndexDB(): address index %s\n", fAddressIndex ? "enabled" : "disabled");
+    pblocktree->ReadFlag("spentindex", fSpentIndex);
+    LogPrintf("LoadBlockIndexDB(): spent index %s\n", fSpentIndex ? "enabled" : "disabled");
+    pblocktree->ReadFlag("timestampindex", fTimestampIndex);
+    LogPrintf("LoadBlockIndexDB(): timestamp index %s\n", fTimestampIndex ? "enabled" : "disabled");
+
     // If this is written true before the next client init, then we know the shutdown process failed
     pblocktree->WriteFlag("shutdown", false);
 
@@ -4976,6 +5532,12 @@ bool InitBlockIndex()
     // Use the provided setting for -txindex in the new database
     fTxIndex = GetBoolArg("-txindex", true);
     pblocktree->WriteFlag("txindex", fTxIndex);
+    fAddressIndex = GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX);
+    pblocktree->WriteFlag("addressindex", fAddressIndex);
+    fSpentIndex = GetBoolArg("-spentindex", DEFAULT_SPENTINDEX);
+    pblocktree->WriteFlag("spentindex", fSpentIndex);
+    fTimestampIndex = GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX);
+    pblocktree->WriteFlag("timestampindex", fTimestampIndex);
     LogPrintf("Initializing databases...\n");
 
     // Only add the genesis block if not reindexing (in which case we reuse the one already on disk)
@@ -5409,9 +5971,10 @@ void static ProcessGetData(CNode* pfrom)
                 // Don't send not-validated blocks
                 if (send && (mi->second->nStatus & BLOCK_HAVE_DATA)) {
                     // Send block from disk
-                    CBlock block;
-                    if (!ReadBlockFromDisk(block, (*mi).second))
+                    std::shared_ptr<const CBlock> pblock;
+                    if (!ReadBlockFromDisk(pblock, (*mi).second))
                         assert(!"cannot load block from disk");
+                    const CBlock& block = *pblock;
                     if (inv.type == MSG_BLOCK)
                         pfrom->PushMessage("block", block);
                     else // MSG_FILTERED_BLOCK)
@@ -6830,18 +7393,28 @@ bool CBlockUndo::WriteToDisk(CDiskBlockPos& pos, const uint256& hashBlock)
 
 bool CBlockUndo::ReadFromDisk(const CDiskBlockPos& pos, const uint256& hashBlock)
 {
-    // Open history file to read
-    CAutoFile filein(OpenUndoFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull())
-        return error("CBlockUndo::ReadFromDisk : OpenBlockFile failed");
-
-    // Read block
+    // Read block, from the mapped undo file if possible. The checksum follows the undo data.
     uint256 hashChecksum;
-    try {
-        filein >> *this;
-        filein >> hashChecksum;
-    } catch (std::exception& e) {
-        return error("%s : Deserialize or I/O error - %s", __func__, e.what());
+    CDataStream ssUndo(SER_DISK, CLIENT_VERSION);
+    if (blockFileMapper.ReadRecord(pos, "rev", sizeof(hashChecksum), ssUndo)) {
+        try {
+            ssUndo >> *this;
+            ssUndo >> hashChecksum;
+        } catch (std::exception& e) {
+            return error("%s : Deserialize or I/O error - %s", __func__, e.what());
+        }
+    } else {
+        // Open history file to read
+        CAutoFile filein(OpenUndoFile(pos, true), SER_DISK, CLIENT_VERSION);
+        if (filein.IsNull())
+            return error("CBlockUndo::ReadFromDisk : OpenBlockFile failed");
+
+        try {
+            filein >> *this;
+            filein >> hashChecksum;
+        } catch (std::exception& e) {
+            return error("%s : Deserialize or I/O error - %s", __func__, e.what());
+        }
     }
 
     // Verify checksum
@@ -6866,10 +7439,7 @@ public:
     CMainCleanup() {}
     ~CMainCleanup()
     {
-        // block headers
-        BlockMap::iterator it1 = mapBlockIndex.begin();
-        for (; it1 != mapBlockIndex.end(); it1++)
-            delete (*it1).second;
+        // block headers, the entries themselves are released with blockIndexArena
         mapBlockIndex.clear();
 
         // orphan transactions
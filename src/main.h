@@ -13,6 +13,7 @@
 #include "config/kyd-config.h"
 #endif
 
+#include "addressindex.h"
 #include "amount.h"
 #include "chain.h"
 #include "chainparams.h"
@@ -42,6 +43,7 @@
 
 #include "libzerocoin/CoinSpend.h"
 
+#include <boost/function.hpp>
 #include <boost/unordered_map.hpp>
 
 class CBlockIndex;
@@ -50,11 +52,13 @@ class CZerocoinDB;
 class CSporkDB;
 class CBloomFilter;
 class CInv;
+class CBlockCheck;
 class CScriptCheck;
 class CValidationInterface;
 class CValidationState;
 
 struct CBlockTemplate;
+struct CCheckQueueStats;
 struct CNodeStateStats;
 
 /** Default for -blockmaxsize and -blockminsize, which control the range of sizes the mining code will create **/
@@ -86,7 +90,7 @@ static const unsigned int UNDOFILE_CHUNK_SIZE = 0x100000; // 1 MiB
 /** Coinbase transaction outputs can only be spent after this number of new blocks (network rule) */
 static const int COINBASE_MATURITY = 100;
 /** Maximum number of script-checking threads allowed */
-static const int MAX_SCRIPTCHECK_THREADS = 16;
+static const int MAX_SCRIPTCHECK_THREADS = 32;
 /** -par default (number of script-checking threads, 0 = auto) */
 static const int DEFAULT_SCRIPTCHECK_THREADS = 0;
 /** Number of blocks that can be requested at any given time from a single peer. */
@@ -145,6 +149,9 @@ extern bool fImporting;
 extern bool fReindex;
 extern int nScriptCheckThreads;
 extern bool fTxIndex;
+extern bool fAddressIndex;
+extern bool fSpentIndex;
+extern bool fTimestampIndex;
 extern bool fIsBareMultisigStd;
 extern bool fCheckBlockIndex;
 extern unsigned int nCoinCacheSize;
@@ -217,6 +224,8 @@ bool ProcessMessages(CNode* pfrom);
 bool SendMessages(CNode* pto, bool fSendTrickle);
 /** Run an instance of the script checking thread */
 void ThreadScriptCheck();
+/** Get the counters of the script check queue */
+void GetScriptCheckQueueStats(CCheckQueueStats& stats);
 
 /** Check whether we are doing an initial block download (synchronizing from disk or network) */
 bool IsInitialBlockDownload();
@@ -224,6 +233,13 @@ bool IsInitialBlockDownload();
 std::string GetWarnings(std::string strFor);
 /** Retrieve a transaction (from memory pool, or from disk, if possible) */
 bool GetTransaction(const uint256& hash, CTransaction& tx, uint256& hashBlock, bool fAllowSlow = false);
+/** Map a scriptPubKey to the type and hash it is kept under in the address index */
+bool GetAddressIndexHash(const CScript& script, int& nAddressType, uint160& addressHash);
+/** Query the optional -addressindex, -spentindex and -timestampindex databases */
+bool GetAddressIndex(const uint160& addressHash, int nAddressType, std::vector<std::pair<CAddressIndexKey, CAmount> >& addressIndex, int nStart = 0, int nEnd = 0);
+bool GetAddressUnspent(const uint160& addressHash, int nAddressType, std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >& unspentOutputs);
+bool GetSpentIndex(const CSpentIndexKey& key, CSpentIndexValue& value);
+bool GetTimestampIndex(unsigned int nHigh, unsigned int nLow, std::vector<uint256>& vHashes);
 /** Find the best known block, and make it the tip of the block chain */
 
 // ***TODO***
@@ -344,15 +360,25 @@ void UpdateCoins(const CTransaction& tx, CValidationState& state, CCoinsViewCach
 bool CheckTransaction(const CTransaction& tx, bool fZerocoinActive, bool fRejectBadUTXO, CValidationState& state);
 bool CheckZerocoinMint(const uint256& txHash, const CTxOut& txout, CValidationState& state, bool fCheckOnly = false);
 bool CheckZerocoinSpend(const CTransaction& tx, bool fVerifySignature, CValidationState& state);
-bool ContextualCheckZerocoinSpend(const CTransaction& tx, const libzerocoin::CoinSpend& spend, CBlockIndex* pindex, const uint256& hashBlock);
-bool ContextualCheckZerocoinSpendNoSerialCheck(const CTransaction& tx, const libzerocoin::CoinSpend& spend, CBlockIndex* pindex, const uint256& hashBlock);
+bool ContextualCheckZerocoinSpend(const CTransaction& tx, const libzerocoin::CoinSpend& spend, CBlockIndex* pindex, const uint256& hashBlock, std::vector<CBlockCheck>* pvChecks = NULL);
+bool ContextualCheckZerocoinSpendNoSerialCheck(const CTransaction& tx, const libzerocoin::CoinSpend& spend, CBlockIndex* pindex, const uint256& hashBlock, std::vector<CBlockCheck>* pvChecks = NULL);
 bool IsTransactionInChain(const uint256& txId, int& nHeightTx, CTransaction& tx);
 bool IsTransactionInChain(const uint256& txId, int& nHeightTx);
 bool IsBlockHashInChain(const uint256& hashBlock);
 bool ValidOutPoint(const COutPoint out, int nHeight);
-void RecalculateZKYDSpent();
-void RecalculateZKYDMinted();
+void RecalculateZKYDSpent(int nHeightStart);
+void RecalculateZKYDMinted(int nHeightStart);
 bool RecalculateKYDSupply(int nHeightStart);
+
+/** Where -reindexmoneysupply starts, given the progress recorded by an interrupted run */
+struct CSupplyRecalculation {
+    //! Whether the zKYD minted and spent pass has to run, and from which block
+    bool fZerocoin;
+    int nHeightZerocoin;
+    //! First block of the KYD supply pass
+    int nHeightMoney;
+};
+CSupplyRecalculation GetSupplyRecalculationStart(int nHeightZerocoinDone, int nHeightMoneyDone, int nHeightChain, int nHeightZerocoinStart);
 bool ReindexAccumulators(list<uint256>& listMissingCheckpoints, string& strError);
 
 
@@ -425,11 +451,47 @@ public:
     ScriptError GetScriptError() const { return error; }
 };
 
+/**
+ * A verification for the script check threads: either a script check or
+ * another self-contained check of a block, given as a function, like the
+ * signature of a zerocoin spend.
+ */
+class CBlockCheck
+{
+private:
+    CScriptCheck script;
+    boost::function<bool()> func;
+
+public:
+    CBlockCheck() {}
+    explicit CBlockCheck(const boost::function<bool()>& funcIn) : func(funcIn) {}
+
+    bool operator()()
+    {
+        return func.empty() ? script() : func();
+    }
+
+    void swap(CBlockCheck& check)
+    {
+        script.swap(check.script);
+        func.swap(check.func);
+    }
+
+    //! Take over a script check
+    void swap(CScriptCheck& check)
+    {
+        script.swap(check);
+    }
+};
+
 
 /** Functions for disk access for blocks */
 bool WriteBlockToDisk(CBlock& block, CDiskBlockPos& pos);
 bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos);
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex);
+/** Read a block without copying it out of the block cache */
+bool ReadBlockFromDisk(std::shared_ptr<const CBlock>& pblock, const CDiskBlockPos& pos);
+bool ReadBlockFromDisk(std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindex);
 
 
 /** Functions for validating blocks and updating the block tree */
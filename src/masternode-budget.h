@@ -77,6 +77,7 @@ public:
     bool Sign(CKey& keyMasternode, CPubKey& pubKeyMasternode);
     bool SignatureValid(bool fSignatureCheck);
     void Relay();
+    std::string GetStrMessage() const;
 
     std::string GetVoteString()
     {
@@ -129,6 +130,7 @@ public:
     bool Sign(CKey& keyMasternode, CPubKey& pubKeyMasternode);
     bool SignatureValid(bool fSignatureCheck);
     void Relay();
+    std::string GetStrMessage() const;
 
     uint256 GetHash()
     {
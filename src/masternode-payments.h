@@ -196,6 +196,7 @@ public:
     bool IsValid(CNode* pnode, std::string& strError);
     bool SignatureValid();
     void Relay();
+    std::string GetStrMessage() const;
 
     void AddPayee(CScript payeeIn)
     {
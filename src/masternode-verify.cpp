@@ -0,0 +1,145 @@
+// Copyright (c) 2018-2019 The KYD developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "masternode-verify.h"
+
+#include "masternode.h"
+#include "masternode-budget.h"
+#include "masternode-payments.h"
+#include "net.h"
+#include "obfuscation.h"
+#include "spork.h"
+#include "swifttx.h"
+#include "util.h"
+
+#include <boost/bind.hpp>
+
+CMasternodeSigVerifier mnSigVerifier;
+
+static bool IsSignedMasternodeMessage(const std::string& strCommand)
+{
+    return strCommand == "mnb" || strCommand == "mnp" || strCommand == "mnw" || strCommand == "mvote" ||
+           strCommand == "fbvote" || strCommand == "txlvote" || strCommand == "spork";
+}
+
+void CMasternodeSigVerifier::Verify(const std::string& strCommand, CDataStream& vRecv)
+{
+    CKeyID keyID;
+    std::string errorMessage;
+
+    if (strCommand == "mnb") {
+        CMasternodeBroadcast mnb;
+        vRecv >> mnb;
+        // same order as CMasternodeBroadcast::VerifySignature, the old format is only tried on a mismatch
+        if (!obfuScationSigner.RecoverMessageKey(mnb.sig, mnb.GetNewStrMessage(), keyID, errorMessage) ||
+            keyID != mnb.pubKeyCollateralAddress.GetID())
+            obfuScationSigner.RecoverMessageKey(mnb.sig, mnb.GetOldStrMessage(), keyID, errorMessage);
+        obfuScationSigner.RecoverMessageKey(mnb.lastPing.vchSig, mnb.lastPing.GetStrMessage(), keyID, errorMessage);
+    } else if (strCommand == "mnp") {
+        CMasternodePing mnp;
+        vRecv >> mnp;
+        obfuScationSigner.RecoverMessageKey(mnp.vchSig, mnp.GetStrMessage(), keyID, errorMessage);
+    } else if (strCommand == "mnw") {
+        CMasternodePaymentWinner winner;
+        vRecv >> winner;
+        obfuScationSigner.RecoverMessageKey(winner.vchSig, winner.GetStrMessage(), keyID, errorMessage);
+    } else if (strCommand == "mvote") {
+        CBudgetVote vote;
+        vRecv >> vote;
+        obfuScationSigner.RecoverMessageKey(vote.vchSig, vote.GetStrMessage(), keyID, errorMessage);
+    } else if (strCommand == "fbvote") {
+        CFinalizedBudgetVote vote;
+        vRecv >> vote;
+        obfuScationSigner.RecoverMessageKey(vote.vchSig, vote.GetStrMessage(), keyID, errorMessage);
+    } else if (strCommand == "txlvote") {
+        CConsensusVote ctx;
+        vRecv >> ctx;
+        obfuScationSigner.RecoverMessageKey(ctx.vchMasterNodeSignature, ctx.GetStrMessage(), keyID, errorMessage);
+    } else if (strCommand == "spork") {
+        CSporkMessage spork;
+        vRecv >> spork;
+        obfuScationSigner.RecoverMessageKey(spork.vchSig, spork.GetStrMessage(), keyID, errorMessage);
+    }
+}
+
+void CMasternodeSigVerifier::ThreadVerify()
+{
+    RenameThread("kyd-mnsigverify");
+
+    while (true) {
+        std::deque<CQueuedMessage> batch;
+        {
+            boost::unique_lock<boost::mutex> lock(cs_queue);
+            while (queue.empty())
+                condQueue.wait(lock);
+
+            size_t nBatch = std::min(queue.size(), MN_SIG_BATCH_SIZE);
+            for (size_t i = 0; i < nBatch; i++) {
+                CQueuedMessage& msg = queue.front();
+                nQueuedBytes -= msg.vRecv.size();
+                std::map<NodeId, size_t>::iterator mi = mapPeerBytes.find(msg.nodeid);
+                if ((mi->second -= msg.vRecv.size()) == 0)
+                    mapPeerBytes.erase(mi);
+                batch.push_back(std::move(msg));
+                queue.pop_front();
+            }
+        }
+
+        for (std::deque<CQueuedMessage>::iterator it = batch.begin(); it != batch.end(); ++it) {
+            try {
+                Verify(it->strCommand, it->vRecv);
+            } catch (const std::exception&) {
+                // malformed messages are reported by the message thread
+            }
+        }
+
+        boost::this_thread::interruption_point();
+    }
+}
+
+void CMasternodeSigVerifier::ReceivedMessage(NodeId nodeid, const CNetMessage& msg)
+{
+    std::string strCommand = msg.hdr.GetCommand();
+    if (!IsSignedMasternodeMessage(strCommand))
+        return;
+
+    // A peer that floods us only loses the head start for its own messages
+    size_t nSize = msg.vRecv.size();
+    boost::unique_lock<boost::mutex> lock(cs_queue);
+    if (queue.size() >= MAX_MN_SIG_QUEUE || nQueuedBytes + nSize > MAX_MN_SIG_QUEUE_BYTES)
+        return;
+    size_t& nPeerBytes = mapPeerBytes[nodeid];
+    if (nPeerBytes + nSize > MAX_MN_SIG_QUEUE_PEER_BYTES) {
+        if (nPeerBytes == 0)
+            mapPeerBytes.erase(nodeid);
+        return;
+    }
+
+    queue.push_back(CQueuedMessage(nodeid, strCommand, CDataStream(msg.vRecv.begin(), msg.vRecv.end(), SER_NETWORK, PROTOCOL_VERSION)));
+    nQueuedBytes += nSize;
+    nPeerBytes += nSize;
+    condQueue.notify_one();
+}
+
+void CMasternodeSigVerifier::Start(boost::thread_group& threadGroup, int nThreads)
+{
+    if (nThreads <= 0)
+        return;
+
+    LogPrintf("Using %d threads for masternode message verification\n", nThreads);
+    for (int i = 0; i < nThreads; i++)
+        threadGroup.create_thread(boost::bind(&CMasternodeSigVerifier::ThreadVerify, this));
+
+    connReceived = GetNodeSignals().ReceivedMessage.connect(boost::bind(&CMasternodeSigVerifier::ReceivedMessage, this, _1, _2));
+}
+
+void CMasternodeSigVerifier::Stop()
+{
+    connReceived.disconnect();
+
+    boost::unique_lock<boost::mutex> lock(cs_queue);
+    queue.clear();
+    nQueuedBytes = 0;
+    mapPeerBytes.clear();
+}
@@ -0,0 +1,76 @@
+// Copyright (c) 2018-2019 The KYD developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef MASTERNODE_VERIFY_H
+#define MASTERNODE_VERIFY_H
+
+#include "net.h"
+#include "streams.h"
+
+#include <deque>
+#include <map>
+#include <string>
+
+#include <boost/signals2/connection.hpp>
+#include <boost/thread.hpp>
+
+//! -mnsigthreads default
+static const int DEFAULT_MN_SIG_THREADS = 2;
+//! Maximum number of masternode signature verification threads
+static const int MAX_MN_SIG_THREADS = 8;
+//! Messages waiting for a worker, anything received beyond this is left to the message thread
+static const size_t MAX_MN_SIG_QUEUE = 10000;
+//! Payload bytes waiting for a worker, from all peers together
+static const size_t MAX_MN_SIG_QUEUE_BYTES = 16 * 1024 * 1024;
+//! Payload bytes waiting for a worker from a single peer
+static const size_t MAX_MN_SIG_QUEUE_PEER_BYTES = 1024 * 1024;
+//! Messages a worker takes off the queue at a time
+static const size_t MN_SIG_BATCH_SIZE = 64;
+
+/**
+ * Pool of threads that recover the signers of masternode network messages (mnb, mnp, mnw,
+ * budget votes, SwiftX consensus votes and sporks) as soon as they come off the wire, filling
+ * the verified message cache of CObfuScationSigner. Nothing is accepted or rejected here: the
+ * message thread still handles each message in order and checks the signer against the
+ * masternode list, it just finds the key recovery already done.
+ */
+class CMasternodeSigVerifier
+{
+private:
+    struct CQueuedMessage {
+        NodeId nodeid;
+        std::string strCommand;
+        CDataStream vRecv;
+
+        CQueuedMessage(NodeId nodeidIn, const std::string& strCommandIn, const CDataStream& vRecvIn) : nodeid(nodeidIn), strCommand(strCommandIn), vRecv(vRecvIn) {}
+    };
+
+    boost::mutex cs_queue;
+    boost::condition_variable condQueue;
+    std::deque<CQueuedMessage> queue;
+    //! Payload bytes in the queue, in total and per peer; a peer without queued messages has no entry
+    size_t nQueuedBytes;
+    std::map<NodeId, size_t> mapPeerBytes;
+    boost::signals2::connection connReceived;
+
+    void Verify(const std::string& strCommand, CDataStream& vRecv);
+    void ThreadVerify();
+
+public:
+    CMasternodeSigVerifier() : nQueuedBytes(0) {}
+
+    void Start(boost::thread_group& threadGroup, int nThreads);
+    void Stop();
+
+    /**
+     * Called from the socket handler thread for every complete message of a connected peer.
+     * Queues the signed masternode messages, unless that would take the queue or the
+     * peer's share of it over its limit.
+     */
+    void ReceivedMessage(NodeId nodeid, const CNetMessage& msg);
+};
+
+extern CMasternodeSigVerifier mnSigVerifier;
+
+#endif
@@ -64,6 +64,7 @@ public:
     bool Sign(CKey& keyMasternode, CPubKey& pubKeyMasternode);
     bool VerifySignature(CPubKey& pubKeyMasternode, int &nDos);
     void Relay();
+    std::string GetStrMessage() const;
 
     uint256 GetHash()
     {
@@ -737,6 +737,8 @@ bool CNode::ReceiveMsgBytes(const char* pch, unsigned int nBytes)
 
         if (msg.complete()) {
             msg.nTime = GetTimeMicros();
+            if (fSuccessfullyConnected)
+                GetNodeSignals().ReceivedMessage(GetId(), msg);
             messageHandlerCondition.notify_one();
         }
     }
@@ -86,6 +86,8 @@ void SocketSendData(CNode* pnode);
 
 typedef int NodeId;
 
+class CNetMessage;
+
 // Signals for message handling
 struct CNodeSignals {
     boost::signals2::signal<int()> GetHeight;
@@ -93,6 +95,8 @@ struct CNodeSignals {
     boost::signals2::signal<bool(CNode*, bool)> SendMessages;
     boost::signals2::signal<void(NodeId, const CNode*)> InitializeNode;
     boost::signals2::signal<void(NodeId)> FinalizeNode;
+    //! Sent from the socket handler thread for every complete message of a peer that finished the handshake
+    boost::signals2::signal<void(NodeId, const CNetMessage&)> ReceivedMessage;
 };
 
 
@@ -9,6 +9,7 @@
 #include "init.h"
 #include "main.h"
 #include "masternodeman.h"
+#include "random.h"
 #include "script/sign.h"
 #include "swifttx.h"
 #include "ui_interface.h"
@@ -16,6 +17,7 @@
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
+#include <boost/thread/shared_mutex.hpp>
 
 #include <algorithm>
 #include <boost/assign/list_of.hpp>
@@ -2162,22 +2164,83 @@ bool CObfuScationSigner::SignMessage(std::string strMessage, std::string& errorM
     return true;
 }
 
-bool CObfuScationSigner::VerifyMessage(CPubKey pubkey, vector<unsigned char>& vchSig, std::string strMessage, std::string& errorMessage)
+CVerifiedMessageCache::CVerifiedMessageCache(size_t nMaxSizeIn) : nMaxSize(nMaxSizeIn)
+{
+}
+
+bool CVerifiedMessageCache::Get(const uint256& entry, CKeyID& keyIDRet)
+{
+    boost::shared_lock<boost::shared_mutex> lock(cs_cache);
+
+    std::map<uint256, CKeyID>::const_iterator it = mapSigners.find(entry);
+    if (it == mapSigners.end())
+        return false;
+    keyIDRet = it->second;
+    return true;
+}
+
+void CVerifiedMessageCache::Set(const uint256& entry, const CKeyID& keyID)
+{
+    if (nMaxSize == 0) return;
+
+    boost::unique_lock<boost::shared_mutex> lock(cs_cache);
+
+    while (mapSigners.size() >= nMaxSize) {
+        // Evict a random entry, see CSignatureCache
+        std::map<uint256, CKeyID>::iterator it = mapSigners.lower_bound(GetRandHash());
+        if (it == mapSigners.end())
+            it = mapSigners.begin();
+        mapSigners.erase(it);
+    }
+
+    mapSigners.insert(std::make_pair(entry, keyID));
+}
+
+size_t CVerifiedMessageCache::size()
+{
+    boost::shared_lock<boost::shared_mutex> lock(cs_cache);
+    return mapSigners.size();
+}
+
+//! Created on first use, after -mnsigcachesize was parsed
+static CVerifiedMessageCache& GetVerifiedMessageCache()
+{
+    static CVerifiedMessageCache cache(std::max((int64_t)0, GetArg("-mnsigcachesize", DEFAULT_MN_SIGCACHE_SIZE)));
+    return cache;
+}
+
+bool CObfuScationSigner::RecoverMessageKey(const std::vector<unsigned char>& vchSig, const std::string& strMessage, CKeyID& keyIDRet, std::string& errorMessage)
 {
     CHashWriter ss(SER_GETHASH, 0);
     ss << strMessageMagic;
     ss << strMessage;
+    uint256 hashMessage = ss.GetHash();
 
-    CPubKey pubkey2;
-    if (!pubkey2.RecoverCompact(ss.GetHash(), vchSig)) {
+    uint256 entry = Hash(BEGIN(hashMessage), END(hashMessage), vchSig.begin(), vchSig.end());
+    if (GetVerifiedMessageCache().Get(entry, keyIDRet))
+        return true;
+
+    CPubKey pubkey;
+    if (!pubkey.RecoverCompact(hashMessage, vchSig)) {
         errorMessage = _("Error recovering public key.");
         return false;
     }
 
-    if (fDebug && pubkey2.GetID() != pubkey.GetID())
-        LogPrintf("CObfuScationSigner::VerifyMessage -- keys don't match: %s %s\n", pubkey2.GetID().ToString(), pubkey.GetID().ToString());
+    keyIDRet = pubkey.GetID();
+    GetVerifiedMessageCache().Set(entry, keyIDRet);
+    return true;
+}
+
+bool CObfuScationSigner::VerifyMessage(CPubKey pubkey, vector<unsigned char>& vchSig, std::string strMessage, std::string& errorMessage)
+{
+    CKeyID keyID;
+    if (!RecoverMessageKey(vchSig, strMessage, keyID, errorMessage))
+        return false;
+
+    if (fDebug && keyID != pubkey.GetID())
+        LogPrintf("CObfuScationSigner::VerifyMessage -- keys don't match: %s %s\n", keyID.ToString(), pubkey.GetID().ToString());
 
-    return (pubkey2.GetID() == pubkey.GetID());
+    return (keyID == pubkey.GetID());
 }
 
 bool CObfuscationQueue::Sign()
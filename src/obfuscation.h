@@ -14,6 +14,8 @@
 #include "obfuscation-relay.h"
 #include "sync.h"
 
+#include <boost/thread/shared_mutex.hpp>
+
 class CTxIn;
 class CObfuscationPool;
 class CObfuScationSigner;
@@ -243,6 +245,30 @@ public:
     int64_t sigTime;
 };
 
+//! -mnsigcachesize default
+static const unsigned int DEFAULT_MN_SIGCACHE_SIZE = 50000;
+
+/**
+ * Cache of recovered masternode message signers, keyed by the hash of (message hash, signature).
+ * The same mnb, mnp, vote or spork is usually relayed to us by many peers, and the verification
+ * workers fill this cache before the message thread gets to the message.
+ */
+class CVerifiedMessageCache
+{
+private:
+    std::map<uint256, CKeyID> mapSigners;
+    boost::shared_mutex cs_cache;
+    //! Maximum number of entries, 0 disables the cache
+    const size_t nMaxSize;
+
+public:
+    explicit CVerifiedMessageCache(size_t nMaxSizeIn);
+
+    bool Get(const uint256& entry, CKeyID& keyIDRet);
+    void Set(const uint256& entry, const CKeyID& keyID);
+    size_t size();
+};
+
 /** Helper object for signing and checking signatures
  */
 class CObfuScationSigner
@@ -256,6 +282,8 @@ public:
     bool SetKey(std::string strSecret, std::string& errorMessage, CKey& key, CPubKey& pubkey);
     /// Sign the message, returns true if successful
     bool SignMessage(std::string strMessage, std::string& errorMessage, std::vector<unsigned char>& vchSig, CKey key);
+    /// Recover the key id that signed the message, consulting the verified message cache first
+    bool RecoverMessageKey(const std::vector<unsigned char>& vchSig, const std::string& strMessage, CKeyID& keyIDRet, std::string& errorMessage);
     /// Verify the message, returns true if succcessful
     bool VerifyMessage(CPubKey pubkey, std::vector<unsigned char>& vchSig, std::string strMessage, std::string& errorMessage);
 };
@@ -7,6 +7,7 @@
 
 #include "primitives/block.h"
 
+#include "crypto/sha256.h"
 #include "hash.h"
 #include "script/standard.h"
 #include "script/sign.h"
@@ -22,7 +23,26 @@ uint256 CBlockHeader::GetHash() const
     return Hash(BEGIN(nVersion), END(nAccumulatorCheckpoint));
 }
 
-uint256 CBlock::BuildMerkleTree(bool* fMutated) const
+/**
+ * Replace the first nSize hashes of vHashes by the (nSize + 1) / 2 hashes of the
+ * level above them and return that number. An odd last hash is paired with itself.
+ */
+static size_t HashMerkleLevel(std::vector<uint256>& vHashes, size_t nSize)
+{
+    if (nSize & 1) {
+        if (vHashes.size() == nSize)
+            vHashes.push_back(vHashes[nSize - 1]);
+        else
+            vHashes[nSize] = vHashes[nSize - 1];
+        nSize++;
+    }
+    // The pairs are adjacent 64-byte blobs, and each output only overwrites
+    // hashes that have already been read.
+    SHA256D64(vHashes[0].begin(), vHashes[0].begin(), nSize / 2);
+    return nSize / 2;
+}
+
+uint256 ComputeMerkleRoot(std::vector<uint256> vHashes, bool* fMutated)
 {
     /* WARNING! If you're reading this because you're learning about crypto
        and/or designing a new system that will use merkle trees, keep in mind
@@ -59,44 +79,52 @@ uint256 CBlock::BuildMerkleTree(bool* fMutated) const
        known ways of changing the transactions without affecting the merkle
        root.
     */
-    vMerkleTree.clear();
-    vMerkleTree.reserve(vtx.size() * 2 + 16); // Safe upper bound for the number of total nodes.
-    for (std::vector<CTransaction>::const_iterator it(vtx.begin()); it != vtx.end(); ++it)
-        vMerkleTree.push_back(it->GetHash());
-    int j = 0;
     bool mutated = false;
-    for (int nSize = vtx.size(); nSize > 1; nSize = (nSize + 1) / 2)
-    {
-        for (int i = 0; i < nSize; i += 2)
-        {
-            int i2 = std::min(i+1, nSize-1);
-            if (i2 == i + 1 && i2 + 1 == nSize && vMerkleTree[j+i] == vMerkleTree[j+i2]) {
-                // Two identical hashes at the end of the list at a particular level.
-                mutated = true;
-            }
-            vMerkleTree.push_back(Hash(BEGIN(vMerkleTree[j+i]),  END(vMerkleTree[j+i]),
-                                       BEGIN(vMerkleTree[j+i2]), END(vMerkleTree[j+i2])));
+    size_t nSize = vHashes.size();
+    while (nSize > 1) {
+        if (nSize % 2 == 0 && vHashes[nSize - 2] == vHashes[nSize - 1]) {
+            // Two identical hashes at the end of the list at a particular level.
+            mutated = true;
         }
-        j += nSize;
+        nSize = HashMerkleLevel(vHashes, nSize);
     }
     if (fMutated) {
         *fMutated = mutated;
     }
-    return (vMerkleTree.empty() ? uint256() : vMerkleTree.back());
+    return (vHashes.empty() ? uint256() : vHashes[0]);
+}
+
+uint256 CBlock::BuildMerkleTree(bool* fMutated) const
+{
+    // The transaction hashes are cached by CTransaction, so comparing them is
+    // far cheaper than hashing the tree again. CheckBlock runs several times on
+    // the same block and the miner rebuilds after every coinbase change.
+    std::vector<uint256> vLeaves;
+    vLeaves.reserve(vtx.size());
+    for (std::vector<CTransaction>::const_iterator it(vtx.begin()); it != vtx.end(); ++it)
+        vLeaves.push_back(it->GetHash());
+    if (vLeaves != vMerkleLeaves) {
+        hashMerkleRootCached = ComputeMerkleRoot(vLeaves, &fMerkleMutatedCached);
+        vMerkleLeaves.swap(vLeaves);
+    }
+    if (fMutated) {
+        *fMutated = fMerkleMutatedCached;
+    }
+    return hashMerkleRootCached;
 }
 
 std::vector<uint256> CBlock::GetMerkleBranch(int nIndex) const
 {
-    if (vMerkleTree.empty())
-        BuildMerkleTree();
+    std::vector<uint256> vHashes;
+    vHashes.reserve(vtx.size() + 1);
+    for (std::vector<CTransaction>::const_iterator it(vtx.begin()); it != vtx.end(); ++it)
+        vHashes.push_back(it->GetHash());
     std::vector<uint256> vMerkleBranch;
-    int j = 0;
-    for (int nSize = vtx.size(); nSize > 1; nSize = (nSize + 1) / 2)
+    for (size_t nSize = vHashes.size(); nSize > 1; nSize = HashMerkleLevel(vHashes, nSize))
     {
-        int i = std::min(nIndex^1, nSize-1);
-        vMerkleBranch.push_back(vMerkleTree[j+i]);
+        int i = std::min(nIndex^1, (int)nSize-1);
+        vMerkleBranch.push_back(vHashes[i]);
         nIndex >>= 1;
-        j += nSize;
     }
     return vMerkleBranch;
 }
@@ -130,10 +158,6 @@ std::string CBlock::ToString() const
     {
         s << "  " << vtx[i].ToString() << "\n";
     }
-    s << "  vMerkleTree: ";
-    for (unsigned int i = 0; i < vMerkleTree.size(); i++)
-        s << " " << vMerkleTree[i].ToString();
-    s << "\n";
     return s.str();
 }
 
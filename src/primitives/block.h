@@ -95,7 +95,10 @@ public:
 
     // memory only
     mutable CScript payee;
-    mutable std::vector<uint256> vMerkleTree;
+    // the transaction hashes the merkle root was last computed from, and the result
+    mutable std::vector<uint256> vMerkleLeaves;
+    mutable uint256 hashMerkleRootCached;
+    mutable bool fMerkleMutatedCached;
 
     CBlock()
     {
@@ -122,7 +125,9 @@ public:
     {
         CBlockHeader::SetNull();
         vtx.clear();
-        vMerkleTree.clear();
+        vMerkleLeaves.clear();
+        hashMerkleRootCached.SetNull();
+        fMerkleMutatedCached = false;
         payee = CScript();
         vchBlockSig.clear();
     }
@@ -158,10 +163,11 @@ public:
         return IsProofOfStake()? std::make_pair(vtx[1].vin[0].prevout, nTime) : std::make_pair(COutPoint(), (unsigned int)0);
     }
 
-    // Build the in-memory merkle tree for this block and return the merkle root.
-    // If non-NULL, *mutated is set to whether mutation was detected in the merkle
-    // tree (a duplication of transactions in the block leading to an identical
-    // merkle root).
+    // Return the merkle root of this block's transactions. The root is cached
+    // with the transaction hashes it was computed from and only recomputed when
+    // those change. If non-NULL, *mutated is set to whether mutation was detected
+    // in the merkle tree (a duplication of transactions in the block leading to
+    // an identical merkle root).
     uint256 BuildMerkleTree(bool* mutated = NULL) const;
 
     std::vector<uint256> GetMerkleBranch(int nIndex) const;
@@ -171,6 +177,14 @@ public:
 };
 
 
+/**
+ * Merkle root of the given leaf hashes, without keeping the inner levels. Each
+ * level is hashed in one batch with SHA256D64. If non-NULL, *mutated is set as
+ * for CBlock::BuildMerkleTree.
+ */
+uint256 ComputeMerkleRoot(std::vector<uint256> vHashes, bool* mutated = NULL);
+
+
 /** Describes a place in the block chain to another node such that if the
  * other node doesn't have the same branch, it can find a recent common trunk.
  * The further back it is, the further before the fork it may be.
@@ -35,7 +35,7 @@ ClientModel::ClientModel(OptionsModel* optionsModel, QObject* parent) : QObject(
                                                                         optionsModel(optionsModel),
                                                                         peerTableModel(0),
                                                                         banTableModel(0),
-                                                                        cachedNumBlocks(0),
+                                                                        cachedNumBlocks(0), fNumBlocksChanged(true), fInitialSync(true),
                                                                         cachedMasternodeCountString(""),
                                                                         cachedReindexing(0), cachedImporting(0),
                                                                         numBlocksAtStartup(-1), pollTimer(0)
@@ -121,15 +121,24 @@ double ClientModel::getVerificationProgress() const
 
 void ClientModel::updateTimer()
 {
-    // Get required lock upfront. This avoids the GUI from getting stuck on
-    // periodical polls if the core is holding the locks for a longer time -
-    // for example, during a wallet rescan.
-    TRY_LOCK(cs_main, lockMain);
-    if (!lockMain)
-        return;
     // Some quantities (such as number of blocks) change so fast that we don't want to be notified for each change.
     // Periodically check and update with a timer.
-    int newNumBlocks = getNumBlocks();
+    // Once synced, the block height is only read after a new tip was announced,
+    // so that the timer does not compete with the staker for cs_main while
+    // nothing happens. No tips are announced during the initial download and
+    // reindexing, so the height is read on every tick until that is over.
+    int newNumBlocks = cachedNumBlocks;
+    if (fNumBlocksChanged || fInitialSync) {
+        // Get required lock upfront. This avoids the GUI from getting stuck on
+        // periodical polls if the core is holding the locks for a longer time -
+        // for example, during a wallet rescan.
+        TRY_LOCK(cs_main, lockMain);
+        if (lockMain) {
+            newNumBlocks = getNumBlocks();
+            fInitialSync = IsInitialBlockDownload();
+            fNumBlocksChanged = false;
+        }
+    }
 
     static int prevAttempt = -1;
     static int prevAssets = -1;
@@ -254,6 +263,11 @@ void ClientModel::updateBanlist()
     banTableModel->refresh();
 }
 
+void ClientModel::updateNumBlocks()
+{
+    fNumBlocksChanged = true;
+}
+
 // Handlers for core signals
 static void ShowProgress(ClientModel* clientmodel, const std::string& title, int nProgress)
 {
@@ -278,6 +292,11 @@ static void NotifyAlertChanged(ClientModel* clientmodel, const uint256& hash, Ch
         Q_ARG(int, status));
 }
 
+static void NotifyBlockTip(ClientModel* clientmodel, const uint256& hashNewTip)
+{
+    QMetaObject::invokeMethod(clientmodel, "updateNumBlocks", Qt::QueuedConnection);
+}
+
 static void BannedListChanged(ClientModel *clientmodel)
 {
     qDebug() << QString("%1: Requesting update for peer banlist").arg(__func__);
@@ -291,6 +310,7 @@ void ClientModel::subscribeToCoreSignals()
     uiInterface.NotifyNumConnectionsChanged.connect(boost::bind(NotifyNumConnectionsChanged, this, _1));
     uiInterface.NotifyAlertChanged.connect(boost::bind(NotifyAlertChanged, this, _1, _2));
     uiInterface.BannedListChanged.connect(boost::bind(BannedListChanged, this));
+    uiInterface.NotifyBlockTip.connect(boost::bind(NotifyBlockTip, this, _1));
 }
 
 void ClientModel::unsubscribeFromCoreSignals()
@@ -300,6 +320,7 @@ void ClientModel::unsubscribeFromCoreSignals()
     uiInterface.NotifyNumConnectionsChanged.disconnect(boost::bind(NotifyNumConnectionsChanged, this, _1));
     uiInterface.NotifyAlertChanged.disconnect(boost::bind(NotifyAlertChanged, this, _1, _2));
     uiInterface.BannedListChanged.disconnect(boost::bind(BannedListChanged, this));
+    uiInterface.NotifyBlockTip.disconnect(boost::bind(NotifyBlockTip, this, _1));
 }
 
 bool ClientModel::getTorInfo(std::string& ip_port) const
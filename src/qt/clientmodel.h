@@ -84,6 +84,9 @@ private:
     BanTableModel *banTableModel;
 
     int cachedNumBlocks;
+    bool fNumBlocksChanged;
+    //! Still in the initial block download or reindexing, when no tips are announced
+    bool fInitialSync;
     QString cachedMasternodeCountString;
     bool cachedReindexing;
     bool cachedImporting;
@@ -112,6 +115,7 @@ signals:
 public slots:
     void updateTimer();
     void updateMnTimer();
+    void updateNumBlocks();
     void updateNumConnections(int numConnections);
     void updateAlert(const QString& hash, int status);
     void updateBanlist();
@@ -10,6 +10,8 @@
 
 /* Milliseconds between model updates */
 static const int MODEL_UPDATE_DELAY = 1000;
+/* Milliseconds to collect block and wallet notifications before updating the balance */
+static const int BALANCE_UPDATE_DELAY = 250;
 
 /* AskPassphraseDialog -- Maximum passphrase length */
 static const int MAX_PASSPHRASE_SIZE = 1024;
@@ -40,6 +42,8 @@ static const bool DEFAULT_SPLASHSCREEN = true;
 #define COLOR_ORPHAN QColor(211, 211, 211)
 /* Transaction list -- TX status decoration - stake (BlueViolet #8A2BE2) */
 #define COLOR_STAKE QColor(138,43,226)
+/* Transaction list -- wallet transactions added to the model per batch while loading */
+static const int TRANSACTION_LOAD_BATCH_SIZE = 500;
 /* Tooltips longer than this (in characters) are converted into rich text,
    so that they can be word-wrapped.
  */
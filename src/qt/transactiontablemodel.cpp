@@ -26,6 +26,7 @@
 #include <QDebug>
 #include <QIcon>
 #include <QList>
+#include <QTimer>
 
 // Amount column is right-aligned it contains numbers
 static int column_alignments[] = {
@@ -58,7 +59,8 @@ class TransactionTablePriv
 {
 public:
     TransactionTablePriv(CWallet* wallet, TransactionTableModel* parent) : wallet(wallet),
-                                                                           parent(parent)
+                                                                           parent(parent),
+                                                                           nLoadPos(0)
     {
     }
 
@@ -71,19 +73,97 @@ public:
      */
     QList<TransactionRecord> cachedWallet;
 
+    /* Hashes of the wallet transactions that still have to be decomposed
+     * into cachedWallet, in ascending order, and the next one to load.
+     */
+    std::vector<uint256> vLoadQueue;
+    size_t nLoadPos;
+
     /* Query entire wallet anew from core.
+     * Only the transaction hashes are read here; the records are added to
+     * the model a batch at a time by loadBatch, so that a large wallet
+     * neither blocks the GUI nor holds cs_main for the whole decomposition.
      */
     void refreshWallet()
     {
         qDebug() << "TransactionTablePriv::refreshWallet";
         cachedWallet.clear();
+        vLoadQueue.clear();
+        nLoadPos = 0;
         {
-            LOCK2(cs_main, wallet->cs_wallet);
-            for (std::map<uint256, CWalletTx>::iterator it = wallet->mapWallet.begin(); it != wallet->mapWallet.end(); ++it) {
-                if (TransactionRecord::showTransaction(it->second))
-                    cachedWallet.append(TransactionRecord::decomposeTransaction(wallet, it->second));
+            LOCK(wallet->cs_wallet);
+            vLoadQueue.reserve(wallet->mapWallet.size());
+            for (std::map<uint256, CWalletTx>::iterator it = wallet->mapWallet.begin(); it != wallet->mapWallet.end(); ++it)
+                vLoadQueue.push_back(it->first);
+        }
+    }
+
+    bool isLoading() const
+    {
+        return nLoadPos < vLoadQueue.size();
+    }
+
+    /* Insert records, which all sort at position idx, into the model. */
+    void insertRecords(int idx, QList<TransactionRecord>& records)
+    {
+        if (records.isEmpty())
+            return;
+        parent->beginInsertRows(QModelIndex(), idx, idx + records.size() - 1);
+        foreach (const TransactionRecord& rec, records) {
+            cachedWallet.insert(idx, rec);
+            idx += 1;
+        }
+        parent->endInsertRows();
+        records.clear();
+    }
+
+    /* Decompose the next TRANSACTION_LOAD_BATCH_SIZE queued transactions
+     * into the model. Returns the number of transactions processed, or -1
+     * if the core is holding the locks and the batch should be retried.
+     */
+    int loadBatch()
+    {
+        TRY_LOCK(cs_main, lockMain);
+        if (!lockMain)
+            return -1;
+        TRY_LOCK(wallet->cs_wallet, lockWallet);
+        if (!lockWallet)
+            return -1;
+
+        // Consecutive transactions with no record of the model between them
+        // are inserted together, which keeps the proxy models from
+        // re-sorting after every single row.
+        QList<TransactionRecord> toInsert;
+        int insertIdx = 0;
+        size_t nStart = nLoadPos;
+        size_t nEnd = std::min(vLoadQueue.size(), nLoadPos + (size_t)TRANSACTION_LOAD_BATCH_SIZE);
+        for (; nLoadPos < nEnd; ++nLoadPos) {
+            const uint256& hash = vLoadQueue[nLoadPos];
+            std::map<uint256, CWalletTx>::iterator mi = wallet->mapWallet.find(hash);
+            if (mi == wallet->mapWallet.end() || !TransactionRecord::showTransaction(mi->second))
+                continue;
+
+            // updateWallet may already have added it while we were loading
+            QList<TransactionRecord>::iterator lower = qLowerBound(
+                cachedWallet.begin(), cachedWallet.end(), hash, TxLessThan());
+            if (lower != cachedWallet.end() && lower->hash == hash)
+                continue;
+            int idx = (lower - cachedWallet.begin());
+            if (!toInsert.isEmpty() && idx != insertIdx) {
+                insertRecords(insertIdx, toInsert);
+                idx = (qLowerBound(cachedWallet.begin(), cachedWallet.end(), hash, TxLessThan()) - cachedWallet.begin());
             }
+            if (toInsert.isEmpty())
+                insertIdx = idx;
+            toInsert.append(TransactionRecord::decomposeTransaction(wallet, mi->second));
+        }
+        insertRecords(insertIdx, toInsert);
+
+        if (!isLoading()) {
+            std::vector<uint256>().swap(vLoadQueue);
+            nLoadPos = 0;
         }
+        return nEnd - nStart;
     }
 
     /* Update our model of the wallet incrementally, to synchronize our model of the wallet
@@ -155,8 +235,15 @@ public:
             parent->endRemoveRows();
             break;
         case CT_UPDATED:
-            // Miscellaneous updates -- nothing to do, status update will take care of this, and is only computed for
-            // visible transactions.
+            // Miscellaneous updates -- the status update will take care of this, and is only computed for
+            // visible transactions. Mark the status stale and tell the views, as updateConfirmations skips
+            // confirmed rows.
+            if (inModel) {
+                for (int idx = lowerIndex; idx < upperIndex; idx++)
+                    cachedWallet[idx].status.cur_num_blocks = -1;
+                emit parent->dataChanged(parent->index(lowerIndex, TransactionTableModel::Status), parent->index(upperIndex - 1, TransactionTableModel::Status));
+                emit parent->dataChanged(parent->index(lowerIndex, TransactionTableModel::ToAddress), parent->index(upperIndex - 1, TransactionTableModel::ToAddress));
+            }
             break;
         }
     }
@@ -166,6 +253,35 @@ public:
         return cachedWallet.size();
     }
 
+    /* Whether a new block can change how the record is shown. Once a
+     * transaction has all recommended confirmations only its confirmation
+     * count still changes, and that is refreshed by index() when a view
+     * asks for the row.
+     */
+    static bool statusSettled(const TransactionRecord& rec)
+    {
+        return rec.status.cur_num_blocks >= 0 &&
+               rec.status.status == TransactionStatus::Confirmed &&
+               rec.status.depth >= TransactionRecord::RecommendedNumConfirmations;
+    }
+
+    /* Invalidate column of every record whose status is not settled, one
+     * dataChanged per contiguous range of rows.
+     */
+    void invalidateUnsettled(int column)
+    {
+        int first = -1;
+        for (int idx = 0; idx <= cachedWallet.size(); idx++) {
+            bool settled = (idx == cachedWallet.size() || statusSettled(cachedWallet.at(idx)));
+            if (!settled && first < 0) {
+                first = idx;
+            } else if (settled && first >= 0) {
+                emit parent->dataChanged(parent->index(first, column), parent->index(idx - 1, column));
+                first = -1;
+            }
+        }
+    }
+
     TransactionRecord* index(int idx)
     {
         if (idx >= 0 && idx < cachedWallet.size()) {
@@ -219,6 +335,9 @@ TransactionTableModel::TransactionTableModel(CWallet* wallet, WalletModel* paren
     connect(walletModel->getOptionsModel(), SIGNAL(displayUnitChanged(int)), this, SLOT(updateDisplayUnit()));
 
     subscribeToCoreSignals();
+
+    // Load the first batch right away, so that small wallets show up complete
+    loadNextBatch();
 }
 
 TransactionTableModel::~TransactionTableModel()
@@ -242,14 +361,25 @@ void TransactionTableModel::updateTransaction(const QString& hash, int status, b
     priv->updateWallet(updated, status, showTransaction);
 }
 
+void TransactionTableModel::loadNextBatch()
+{
+    int nLoaded = priv->loadBatch();
+    if (priv->isLoading()) {
+        // Let the event loop run between batches; back off if the core holds the locks
+        QTimer::singleShot(nLoaded < 0 ? MODEL_UPDATE_DELAY / 10 : 0, this, SLOT(loadNextBatch()));
+    }
+}
+
 void TransactionTableModel::updateConfirmations()
 {
-    // Blocks came in since last poll.
+    // Blocks came in since last update.
     // Invalidate status (number of confirmations) and (possibly) description
-    //  for all rows. Qt is smart enough to only actually request the data for the
-    //  visible rows.
-    emit dataChanged(index(0, Status), index(priv->size() - 1, Status));
-    emit dataChanged(index(0, ToAddress), index(priv->size() - 1, ToAddress));
+    //  for the rows that are not yet fully confirmed. The filter proxy reads the
+    //  status of every row it is told about, so invalidating all rows would
+    //  recompute the status of the whole wallet on each block. The settled rows
+    //  are brought up to date lazily when a view requests them.
+    priv->invalidateUnsettled(Status);
+    priv->invalidateUnsettled(ToAddress);
 }
 
 int TransactionTableModel::rowCount(const QModelIndex& parent) const
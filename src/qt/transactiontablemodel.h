@@ -106,6 +106,10 @@ public slots:
     /* Needed to update fProcessingQueuedTransactions through a QueuedConnection */
     void setProcessingQueuedTransactions(bool value) { fProcessingQueuedTransactions = value; }
 
+private slots:
+    /* Add the next batch of wallet transactions to the model while it is loading */
+    void loadNextBatch();
+
     friend class TransactionTablePriv;
 };
 
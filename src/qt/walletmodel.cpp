@@ -45,12 +45,16 @@ WalletModel::WalletModel(CWallet* wallet, OptionsModel* optionsModel, QObject* p
     transactionTableModel = new TransactionTableModel(wallet, this);
     recentRequestsTableModel = new RecentRequestsTableModel(wallet, this);
 
-    // This timer will be fired repeatedly to update the balance
+    // This timer is started by block and wallet notifications to update the balance,
+    // and restarts itself while the initial block download runs.
+    // It is single-shot, so that a burst of notifications results in one update.
     pollTimer = new QTimer(this);
+    pollTimer->setSingleShot(true);
     connect(pollTimer, SIGNAL(timeout()), this, SLOT(pollBalanceChanged()));
-    pollTimer->start(MODEL_UPDATE_DELAY);
+    connect(optionsModel, SIGNAL(zeromintPercentageChanged(int)), this, SLOT(scheduleBalanceCheck()));
 
     subscribeToCoreSignals();
+    scheduleBalanceCheck();
 }
 
 WalletModel::~WalletModel()
@@ -133,17 +137,27 @@ void WalletModel::updateStatus()
         emit encryptionStatusChanged(newEncryptionStatus);
 }
 
+void WalletModel::scheduleBalanceCheck()
+{
+    if (!pollTimer->isActive())
+        pollTimer->start(BALANCE_UPDATE_DELAY);
+}
+
 void WalletModel::pollBalanceChanged()
 {
     // Get required locks upfront. This avoids the GUI from getting stuck on
-    // periodical polls if the core is holding the locks for a longer time -
-    // for example, during a wallet rescan.
+    // balance updates if the core is holding the locks for a longer time -
+    // for example, during a wallet rescan. In that case try again later.
     TRY_LOCK(cs_main, lockMain);
-    if (!lockMain)
+    if (!lockMain) {
+        pollTimer->start(MODEL_UPDATE_DELAY);
         return;
+    }
     TRY_LOCK(wallet->cs_wallet, lockWallet);
-    if (!lockWallet)
+    if (!lockWallet) {
+        pollTimer->start(MODEL_UPDATE_DELAY);
         return;
+    }
 
     if (fForceCheckBalanceChanged || chainActive.Height() != cachedNumBlocks || nZeromintPercentage != cachedZeromintPercentage || cachedTxLocks != nCompleteTXLocks) {
         fForceCheckBalanceChanged = false;
@@ -160,6 +174,11 @@ void WalletModel::pollBalanceChanged()
         // Address in receive tab may have been used
         emit notifyReceiveAddressChanged();
     }
+
+    // No tips are announced during the initial download and reindexing, so
+    // keep checking for new blocks until that is over
+    if (IsInitialBlockDownload())
+        pollTimer->start(MODEL_UPDATE_DELAY);
 }
 
 void WalletModel::emitBalanceChanged()
@@ -214,6 +233,7 @@ void WalletModel::updateTransaction()
 {
     // Balance and number of transactions might have changed
     fForceCheckBalanceChanged = true;
+    scheduleBalanceCheck();
 }
 
 void WalletModel::updateAddressBook(const QString& address, const QString& label, bool isMine, const QString& purpose, int status)
@@ -545,6 +565,11 @@ static void NotifyTransactionChanged(WalletModel* walletmodel, CWallet* wallet,
                               Q_ARG(int, status)*/);
 }
 
+static void NotifyBlockTip(WalletModel* walletmodel, const uint256& hashNewTip)
+{
+    QMetaObject::invokeMethod(walletmodel, "scheduleBalanceCheck", Qt::QueuedConnection);
+}
+
 static void ShowProgress(WalletModel* walletmodel, const std::string& title, int nProgress)
 {
     // emits signal "showProgress"
@@ -619,6 +644,7 @@ void WalletModel::subscribeToCoreSignals()
     wallet->NotifyZerocoinChanged.connect(boost::bind(NotifyZerocoinChanged, this, _1, _2, _3, _4));
     wallet->NotifyzKYDReset.connect(boost::bind(NotifyzKYDReset, this));
     wallet->NotifyWalletBacked.connect(boost::bind(NotifyWalletBacked, this, _1, _2));
+    uiInterface.NotifyBlockTip.connect(boost::bind(NotifyBlockTip, this, _1));
 }
 
 void WalletModel::unsubscribeFromCoreSignals()
@@ -633,6 +659,7 @@ void WalletModel::unsubscribeFromCoreSignals()
     wallet->NotifyZerocoinChanged.disconnect(boost::bind(NotifyZerocoinChanged, this, _1, _2, _3, _4));
     wallet->NotifyzKYDReset.disconnect(boost::bind(NotifyzKYDReset, this));
     wallet->NotifyWalletBacked.disconnect(boost::bind(NotifyWalletBacked, this, _1, _2));
+    uiInterface.NotifyBlockTip.disconnect(boost::bind(NotifyBlockTip, this, _1));
 }
 
 // WalletModel::UnlockContext implementation
@@ -301,6 +301,8 @@ public slots:
     void updateWatchOnlyFlag(bool fHaveWatchonly);
     /* MultiSig added */
     void updateMultiSigFlag(bool fHaveMultiSig);
+    /* A block or wallet transaction came in - check the balance shortly */
+    void scheduleBalanceCheck();
     /* Current, immature or unconfirmed balance might have changed - emit 'balanceChanged' if so */
     void pollBalanceChanged();
     /* Update address book labels in the database */
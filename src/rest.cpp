@@ -25,6 +25,7 @@
 using namespace std;
 
 static const size_t MAX_GETUTXOS_OUTPOINTS = 15; //allow a max of 15 outpoints to be queried at once
+static const size_t MAX_REST_ADDRESSES = 15; //allow a max of 15 addresses to be queried at once
 
 enum RetFormat {
     RF_UNDEF,
@@ -163,14 +164,14 @@ static bool rest_headers(HTTPRequest* req,
     case RF_BINARY: {
         string binaryHeader = ssHeader.str();
         req->WriteHeader("Content-Type", "application/octet-stream");
-        req->WriteReply(HTTP_OK, binaryHeader);
+        req->WriteReply(HTTP_OK, std::move(binaryHeader));
         return true;
     }
 
     case RF_HEX: {
         string strHex = HexStr(ssHeader.begin(), ssHeader.end()) + "\n";
         req->WriteHeader("Content-Type", "text/plain");
-        req->WriteReply(HTTP_OK, strHex);
+        req->WriteReply(HTTP_OK, std::move(strHex));
         return true;
     }
     case RF_JSON: {
@@ -180,7 +181,7 @@ static bool rest_headers(HTTPRequest* req,
         }
         string strJSON = jsonHeaders.write() + "\n";
         req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
+        req->WriteReply(HTTP_OK, std::move(strJSON));
         return true;
     }
     default: {
@@ -216,11 +217,12 @@ static bool rest_block(HTTPRequest* req,
         pblockindex = mapBlockIndex[hash];
         if (!(pblockindex->nStatus & BLOCK_HAVE_DATA) && pblockindex->nTx > 0)
             return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not available (pruned data)");
-
-        if (!ReadBlockFromDisk(block, pblockindex))
-            return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
     }
 
+    // Block files are append only, so the block can be read without holding cs_main
+    if (!ReadBlockFromDisk(block, pblockindex))
+        return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+
     CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
     ssBlock << block;
 
@@ -228,14 +230,14 @@ static bool rest_block(HTTPRequest* req,
     case RF_BINARY: {
         string binaryBlock = ssBlock.str();
         req->WriteHeader("Content-Type", "application/octet-stream");
-        req->WriteReply(HTTP_OK, binaryBlock);
+        req->WriteReply(HTTP_OK, std::move(binaryBlock));
         return true;
     }
 
     case RF_HEX: {
         string strHex = HexStr(ssBlock.begin(), ssBlock.end()) + "\n";
         req->WriteHeader("Content-Type", "text/plain");
-        req->WriteReply(HTTP_OK, strHex);
+        req->WriteReply(HTTP_OK, std::move(strHex));
         return true;
     }
 
@@ -243,7 +245,7 @@ static bool rest_block(HTTPRequest* req,
         UniValue objBlock = blockToJSON(block, pblockindex, showTxDetails);
         string strJSON = objBlock.write() + "\n";
         req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
+        req->WriteReply(HTTP_OK, std::move(strJSON));
         return true;
     }
 
@@ -279,7 +281,7 @@ static bool rest_chaininfo(HTTPRequest* req, const std::string& strURIPart)
         UniValue chainInfoObject = getblockchaininfo(rpcParams, false);
         string strJSON = chainInfoObject.write() + "\n";
         req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
+        req->WriteReply(HTTP_OK, std::move(strJSON));
         return true;
     }
     default: {
@@ -304,7 +306,7 @@ static bool rest_mempool_info(HTTPRequest* req, const std::string& strURIPart)
 
         string strJSON = mempoolInfoObject.write() + "\n";
         req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
+        req->WriteReply(HTTP_OK, std::move(strJSON));
         return true;
     }
     default: {
@@ -329,7 +331,7 @@ static bool rest_mempool_contents(HTTPRequest* req, const std::string& strURIPar
 
         string strJSON = mempoolObject.write() + "\n";
         req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
+        req->WriteReply(HTTP_OK, std::move(strJSON));
         return true;
     }
     default: {
@@ -365,14 +367,14 @@ static bool rest_tx(HTTPRequest* req, const std::string& strURIPart)
     case RF_BINARY: {
         string binaryTx = ssTx.str();
         req->WriteHeader("Content-Type", "application/octet-stream");
-        req->WriteReply(HTTP_OK, binaryTx);
+        req->WriteReply(HTTP_OK, std::move(binaryTx));
         return true;
     }
 
     case RF_HEX: {
         string strHex = HexStr(ssTx.begin(), ssTx.end()) + "\n";
         req->WriteHeader("Content-Type", "text/plain");
-        req->WriteReply(HTTP_OK, strHex);
+        req->WriteReply(HTTP_OK, std::move(strHex));
         return true;
     }
 
@@ -381,7 +383,7 @@ static bool rest_tx(HTTPRequest* req, const std::string& strURIPart)
         TxToJSON(tx, hashBlock, objTx);
         string strJSON = objTx.write() + "\n";
         req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
+        req->WriteReply(HTTP_OK, std::move(strJSON));
         return true;
     }
 
@@ -537,7 +539,7 @@ static bool rest_getutxos(HTTPRequest* req, const std::string& strURIPart)
         string ssGetUTXOResponseString = ssGetUTXOResponse.str();
 
         req->WriteHeader("Content-Type", "application/octet-stream");
-        req->WriteReply(HTTP_OK, ssGetUTXOResponseString);
+        req->WriteReply(HTTP_OK, std::move(ssGetUTXOResponseString));
         return true;
     }
 
@@ -547,7 +549,7 @@ static bool rest_getutxos(HTTPRequest* req, const std::string& strURIPart)
         string strHex = HexStr(ssGetUTXOResponse.begin(), ssGetUTXOResponse.end()) + "\n";
 
         req->WriteHeader("Content-Type", "text/plain");
-        req->WriteReply(HTTP_OK, strHex);
+        req->WriteReply(HTTP_OK, std::move(strHex));
         return true;
     }
 
@@ -578,7 +580,7 @@ static bool rest_getutxos(HTTPRequest* req, const std::string& strURIPart)
         // return json string
         string strJSON = objGetUTXOResponse.write() + "\n";
         req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
+        req->WriteReply(HTTP_OK, std::move(strJSON));
         return true;
     }
     default: {
@@ -590,6 +592,109 @@ static bool rest_getutxos(HTTPRequest* req, const std::string& strURIPart)
     return true; // continue to process further HTTP reqs on this cxn
 }
 
+static bool rest_address(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    vector<string> params;
+    const RetFormat rf = ParseDataFormat(params, strURIPart);
+
+    // /rest/address/<balance|utxos|txids>/<address>[-<address>...].json
+    vector<string> uriParts;
+    boost::split(uriParts, params[0], boost::is_any_of("/"));
+    if (uriParts.size() != 2 || uriParts[1].empty())
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid URI format. Expected /rest/address/<balance|utxos|txids>/<address>[-<address>...].json");
+
+    UniValue (*method)(const UniValue&, bool);
+    if (uriParts[0] == "balance")
+        method = getaddressbalance;
+    else if (uriParts[0] == "utxos")
+        method = getaddressutxos;
+    else if (uriParts[0] == "txids")
+        method = getaddresstxids;
+    else
+        return RESTERR(req, HTTP_NOT_FOUND, "Unknown address query: " + uriParts[0]);
+
+    vector<string> vAddresses;
+    boost::split(vAddresses, uriParts[1], boost::is_any_of("-"));
+    if (vAddresses.size() > MAX_REST_ADDRESSES)
+        return RESTERR(req, HTTP_BAD_REQUEST, strprintf("Error: max addresses exceeded (max: %d, tried: %d)", MAX_REST_ADDRESSES, vAddresses.size()));
+
+    switch (rf) {
+    case RF_JSON: {
+        UniValue addressArray(UniValue::VARR);
+        for (const string& strAddress : vAddresses)
+            addressArray.push_back(strAddress);
+        UniValue addressObject(UniValue::VOBJ);
+        addressObject.push_back(Pair("addresses", addressArray));
+        UniValue rpcParams(UniValue::VARR);
+        rpcParams.push_back(addressObject);
+
+        UniValue result;
+        try {
+            result = method(rpcParams, false);
+        } catch (const UniValue& objError) {
+            return RESTERR(req, HTTP_BAD_REQUEST, find_value(objError, "message").get_str());
+        }
+
+        string strJSON = result.write() + "\n";
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, std::move(strJSON));
+        return true;
+    }
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: json)");
+    }
+    }
+
+    // not reached
+    return true; // continue to process further HTTP reqs on this cxn
+}
+
+static bool rest_spentinfo(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    vector<string> params;
+    const RetFormat rf = ParseDataFormat(params, strURIPart);
+
+    // /rest/spentinfo/<txid>-<n>.json
+    vector<string> txOutput;
+    boost::split(txOutput, params[0], boost::is_any_of("-"));
+    uint256 txid;
+    int32_t nOutput;
+    if (txOutput.size() != 2 || !ParseHashStr(txOutput[0], txid) || !ParseInt32(txOutput[1], &nOutput) || nOutput < 0)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid URI format. Expected /rest/spentinfo/<txid>-<n>.json");
+
+    switch (rf) {
+    case RF_JSON: {
+        UniValue outputObject(UniValue::VOBJ);
+        outputObject.push_back(Pair("txid", txid.GetHex()));
+        outputObject.push_back(Pair("index", nOutput));
+        UniValue rpcParams(UniValue::VARR);
+        rpcParams.push_back(outputObject);
+
+        UniValue result;
+        try {
+            result = getspentinfo(rpcParams, false);
+        } catch (const UniValue& objError) {
+            return RESTERR(req, HTTP_NOT_FOUND, find_value(objError, "message").get_str());
+        }
+
+        string strJSON = result.write() + "\n";
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, std::move(strJSON));
+        return true;
+    }
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: json)");
+    }
+    }
+
+    // not reached
+    return true; // continue to process further HTTP reqs on this cxn
+}
+
 static const struct {
     const char* prefix;
     bool (*handler)(HTTPRequest* req, const std::string& strReq);
@@ -602,6 +707,8 @@ static const struct {
       {"/rest/mempool/contents", rest_mempool_contents},
       {"/rest/headers/", rest_headers},
       {"/rest/getutxos", rest_getutxos},
+      {"/rest/address/", rest_address},
+      {"/rest/spentinfo/", rest_spentinfo},
 };
 
 bool StartREST()
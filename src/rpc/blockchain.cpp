@@ -7,7 +7,9 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "base58.h"
+#include "blockcache.h"
 #include "checkpoints.h"
+#include "checkqueue.h"
 #include "clientversion.h"
 #include "main.h"
 #include "rpc/server.h"
@@ -15,9 +17,12 @@
 #include "txdb.h"
 #include "util.h"
 #include "utilmoneystr.h"
+#include "validationinterface.h"
+#include "validationstats.h"
 #include "accumulatormap.h"
 #include "accumulators.h"
 
+#include <algorithm>
 #include <stdint.h>
 #include <univalue.h>
 
@@ -84,12 +89,43 @@ UniValue blockheaderToJSON(const CBlockIndex* blockindex)
 
 UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails = false)
 {
+    // Snapshot what comes from the block index under cs_main, connecting and disconnecting
+    // blocks writes these fields. The transactions are formatted without it.
+    int confirmations = -1;
+    int64_t nMedianTime;
+    double dDifficulty;
+    uint256 hashChainWork, hashPrev, hashNext, hashProof;
+    CAmount nMoneySupply, nZerocoinSupply;
+    CZerocoinSupply mapZerocoinSupply;
+    std::string strFlags;
+    int nEntropyBit;
+    uint64_t nStakeModifier;
+    unsigned int nStakeModifierChecksum;
+    {
+        LOCK(cs_main);
+        // Only report confirmations if the block is on the main chain
+        if (chainActive.Contains(blockindex))
+            confirmations = chainActive.Height() - blockindex->nHeight + 1;
+        CBlockIndex* pnext = chainActive.Next(blockindex);
+        if (pnext)
+            hashNext = pnext->GetBlockHash();
+        if (blockindex->pprev)
+            hashPrev = blockindex->pprev->GetBlockHash();
+        nMedianTime = blockindex->GetMedianTimePast();
+        dDifficulty = GetDifficulty(blockindex);
+        hashChainWork = blockindex->nChainWork;
+        nMoneySupply = blockindex->nMoneySupply;
+        strFlags = strprintf("%s%s", blockindex->IsProofOfStake()? "proof-of-stake" : "proof-of-work", blockindex->GeneratedStakeModifier()? " stake-modifier": "");
+        hashProof = blockindex->IsProofOfStake()? blockindex->hashProofOfStake : blockindex->GetBlockHash();
+        nEntropyBit = blockindex->GetStakeEntropyBit();
+        nStakeModifier = blockindex->nStakeModifier;
+        nStakeModifierChecksum = blockindex->nStakeModifierChecksum;
+        mapZerocoinSupply = blockindex->mapZerocoinSupply;
+        nZerocoinSupply = blockindex->GetZerocoinSupply();
+    }
+
     UniValue result(UniValue::VOBJ);
     result.push_back(Pair("hash", block.GetHash().GetHex()));
-    int confirmations = -1;
-    // Only report confirmations if the block is on the main chain
-    if (chainActive.Contains(blockindex))
-        confirmations = chainActive.Height() - blockindex->nHeight + 1;
     result.push_back(Pair("confirmations", confirmations));
     result.push_back(Pair("size", (int)::GetSerializeSize(block, SER_NETWORK, PROTOCOL_VERSION)));
     result.push_back(Pair("height", blockindex->nHeight));
@@ -107,31 +143,30 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool tx
     }
     result.push_back(Pair("tx", txs));
     result.push_back(Pair("time", block.GetBlockTime()));
-    result.push_back(Pair("mediantime", (int64_t)blockindex->GetMedianTimePast()));
+    result.push_back(Pair("mediantime", nMedianTime));
     result.push_back(Pair("nonce", (uint64_t)block.nNonce));
     result.push_back(Pair("bits", strprintf("%08x", block.nBits)));
-    result.push_back(Pair("difficulty", GetDifficulty(blockindex)));
-    result.push_back(Pair("chainwork", blockindex->nChainWork.GetHex()));
+    result.push_back(Pair("difficulty", dDifficulty));
+    result.push_back(Pair("chainwork", hashChainWork.GetHex()));
 
-    if (blockindex->pprev)
-        result.push_back(Pair("previousblockhash", blockindex->pprev->GetBlockHash().GetHex()));
-    CBlockIndex* pnext = chainActive.Next(blockindex);
-    if (pnext)
-        result.push_back(Pair("nextblockhash", pnext->GetBlockHash().GetHex()));
+    if (hashPrev != 0)
+        result.push_back(Pair("previousblockhash", hashPrev.GetHex()));
+    if (hashNext != 0)
+        result.push_back(Pair("nextblockhash", hashNext.GetHex()));
 
-    result.push_back(Pair("moneysupply",ValueFromAmount(blockindex->nMoneySupply)));
+    result.push_back(Pair("moneysupply",ValueFromAmount(nMoneySupply)));
 
-    result.push_back(Pair("flags", strprintf("%s%s", blockindex->IsProofOfStake()? "proof-of-stake" : "proof-of-work", blockindex->GeneratedStakeModifier()? " stake-modifier": "")));
-    result.push_back(Pair("proofhash", blockindex->IsProofOfStake()? blockindex->hashProofOfStake.GetHex() : blockindex->GetBlockHash().GetHex()));
-    result.push_back(Pair("entropybit", (int)blockindex->GetStakeEntropyBit()));
-    result.push_back(Pair("modifier", strprintf("%s", blockindex->nStakeModifier)));
-    result.push_back(Pair("modifierchecksum", strprintf("%08x", blockindex->nStakeModifierChecksum)));
+    result.push_back(Pair("flags", strFlags));
+    result.push_back(Pair("proofhash", hashProof.GetHex()));
+    result.push_back(Pair("entropybit", nEntropyBit));
+    result.push_back(Pair("modifier", strprintf("%s", nStakeModifier)));
+    result.push_back(Pair("modifierchecksum", strprintf("%08x", nStakeModifierChecksum)));
 
     UniValue zkydObj(UniValue::VOBJ);
     for (auto denom : libzerocoin::zerocoinDenomList) {
-        zkydObj.push_back(Pair(to_string(denom), ValueFromAmount(blockindex->mapZerocoinSupply.at(denom) * (denom*COIN))));
+        zkydObj.push_back(Pair(to_string(denom), ValueFromAmount(mapZerocoinSupply.at(denom) * (denom*COIN))));
     }
-    zkydObj.push_back(Pair("total", ValueFromAmount(blockindex->GetZerocoinSupply())));
+    zkydObj.push_back(Pair("total", ValueFromAmount(nZerocoinSupply)));
     result.push_back(Pair("zKYDsupply", zkydObj));
 
     return result;
@@ -192,24 +227,53 @@ UniValue getdifficulty(const UniValue& params, bool fHelp)
 UniValue mempoolToJSON(bool fVerbose = false)
 {
     if (fVerbose) {
-        LOCK(mempool.cs);
+        struct CEntryInfo {
+            uint256 hash;
+            unsigned int nSize;
+            CAmount nFee;
+            int64_t nTime;
+            unsigned int nHeight;
+            double dStartingPriority;
+            double dCurrentPriority;
+            vector<uint256> vDepends;
+        };
+
+        // Copy what is needed under the locks and format the (possibly large) result after
+        // releasing them
+        vector<CEntryInfo> vEntries;
+        {
+            LOCK2(cs_main, mempool.cs);
+            vEntries.reserve(mempool.mapTx.size());
+            BOOST_FOREACH (const PAIRTYPE(uint256, CTxMemPoolEntry) & entry, mempool.mapTx) {
+                const CTxMemPoolEntry& e = entry.second;
+                vEntries.push_back(CEntryInfo());
+                CEntryInfo& info = vEntries.back();
+                info.hash = entry.first;
+                info.nSize = e.GetTxSize();
+                info.nFee = e.GetFee();
+                info.nTime = e.GetTime();
+                info.nHeight = e.GetHeight();
+                info.dStartingPriority = e.GetPriority(e.GetHeight());
+                info.dCurrentPriority = e.GetPriority(chainActive.Height());
+                BOOST_FOREACH (const CTxIn& txin, e.GetTx().vin) {
+                    if (mempool.exists(txin.prevout.hash))
+                        info.vDepends.push_back(txin.prevout.hash);
+                }
+            }
+        }
+
         UniValue o(UniValue::VOBJ);
-        BOOST_FOREACH (const PAIRTYPE(uint256, CTxMemPoolEntry) & entry, mempool.mapTx) {
-            const uint256& hash = entry.first;
-            const CTxMemPoolEntry& e = entry.second;
+        for (const CEntryInfo& e : vEntries) {
             UniValue info(UniValue::VOBJ);
-            info.push_back(Pair("size", (int)e.GetTxSize()));
-            info.push_back(Pair("fee", ValueFromAmount(e.GetFee())));
-            info.push_back(Pair("time", e.GetTime()));
-            info.push_back(Pair("height", (int)e.GetHeight()));
-            info.push_back(Pair("startingpriority", e.GetPriority(e.GetHeight())));
-            info.push_back(Pair("currentpriority", e.GetPriority(chainActive.Height())));
-            const CTransaction& tx = e.GetTx();
+            info.push_back(Pair("size", (int)e.nSize));
+            info.push_back(Pair("fee", ValueFromAmount(e.nFee)));
+            info.push_back(Pair("time", e.nTime));
+            info.push_back(Pair("height", (int)e.nHeight));
+            info.push_back(Pair("startingpriority", e.dStartingPriority));
+            info.push_back(Pair("currentpriority", e.dCurrentPriority));
             set<string> setDepends;
-            BOOST_FOREACH (const CTxIn& txin, tx.vin) {
-                if (mempool.exists(txin.prevout.hash))
-                    setDepends.insert(txin.prevout.hash.ToString());
-            }
+            for (const uint256& hashDepend : e.vDepends)
+                setDepends.insert(hashDepend.ToString());
 
             UniValue depends(UniValue::VARR);
             BOOST_FOREACH(const string& dep, setDepends) {
@@ -217,7 +281,7 @@ UniValue mempoolToJSON(bool fVerbose = false)
             }
 
             info.push_back(Pair("depends", depends));
-            o.push_back(Pair(hash.ToString(), info));
+            o.push_back(Pair(e.hash.ToString(), info));
         }
         return o;
     } else {
@@ -266,8 +330,6 @@ UniValue getrawmempool(const UniValue& params, bool fHelp)
             "\nExamples\n" +
             HelpExampleCli("getrawmempool", "true") + HelpExampleRpc("getrawmempool", "true"));
 
-    LOCK(cs_main);
-
     bool fVerbose = false;
     if (params.size() > 0)
         fVerbose = params[0].get_bool();
@@ -301,19 +363,53 @@ UniValue getblockhash(const UniValue& params, bool fHelp)
     return pblockindex->GetBlockHash().GetHex();
 }
 
+UniValue getblockhashes(const UniValue& params, bool fHelp)
+{
+    if (fHelp || params.size() != 2)
+        throw runtime_error(
+            "getblockhashes high low\n"
+            "\nReturns the hashes of the blocks with a timestamp in [low, high) (requires -timestampindex).\n"
+
+            "\nArguments:\n"
+            "1. high         (numeric, required) The newer block timestamp, exclusive\n"
+            "2. low          (numeric, required) The older block timestamp\n"
+
+            "\nResult:\n"
+            "[\n"
+            "  \"hash\"       (string) The block hash\n"
+            "  ,...\n"
+            "]\n"
+
+            "\nExamples:\n" +
+            HelpExampleCli("getblockhashes", "1231614698 1231024505") + HelpExampleRpc("getblockhashes", "1231614698, 1231024505"));
+
+    unsigned int nHigh = params[0].get_int();
+    unsigned int nLow = params[1].get_int();
+
+    std::vector<uint256> vHashes;
+    if (!GetTimestampIndex(nHigh, nLow, vHashes))
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for block hashes");
+
+    UniValue result(UniValue::VARR);
+    for (const uint256& hash : vHashes)
+        result.push_back(hash.GetHex());
+    return result;
+}
+
 UniValue getblock(const UniValue& params, bool fHelp)
 {
     if (fHelp || params.size() < 1 || params.size() > 2)
         throw runtime_error(
-            "getblock \"hash\" ( verbose )\n"
-            "\nIf verbose is false, returns a string that is serialized, hex-encoded data for block 'hash'.\n"
-            "If verbose is true, returns an Object with information about block <hash>.\n"
+            "getblock \"hash\" ( verbosity )\n"
+            "\nIf verbosity is 0 (or false), returns a string that is serialized, hex-encoded data for block 'hash'.\n"
+            "If verbosity is 1 (or true), returns an Object with information about block <hash>.\n"
+            "If verbosity is 2, returns an Object with information about block <hash> and information about each transaction.\n"
 
             "\nArguments:\n"
             "1. \"hash\"          (string, required) The block hash\n"
-            "2. verbose           (boolean, optional, default=true) true for a json object, false for the hex encoded data\n"
+            "2. verbosity         (numeric or boolean, optional, default=1) 0 for hex encoded data, 1 for a json object, and 2 for json object with transaction data\n"
 
-            "\nResult (for verbose = true):\n"
+            "\nResult (for verbosity = 1):\n"
             "{\n"
             "  \"hash\" : \"hash\",     (string) the block hash (same as provided)\n"
             "  \"confirmations\" : n,   (numeric) The number of confirmations, or -1 if the block is not on the main chain\n"
@@ -347,39 +443,55 @@ UniValue getblock(const UniValue& params, bool fHelp)
             "  }\n"
             "}\n"
 
-            "\nResult (for verbose=false):\n"
+            "\nResult (for verbosity = 2):\n"
+            "{\n"
+            "  ...,                 Same output as verbosity = 1\n"
+            "  \"tx\" : [               (array of Objects) The transactions in the format of the getrawtransaction RPC\n"
+            "         ,...\n"
+            "  ],\n"
+            "  ...                  Same output as verbosity = 1\n"
+            "}\n"
+
+            "\nResult (for verbosity = 0):\n"
             "\"data\"             (string) A string that is serialized, hex-encoded data for block 'hash'.\n"
 
             "\nExamples:\n" +
             HelpExampleCli("getblock", "\"00000000000fd08c2fb661d2fcb0d49abb3a91e5f27082ce64feed3b4dede2e2\"") +
             HelpExampleRpc("getblock", "\"00000000000fd08c2fb661d2fcb0d49abb3a91e5f27082ce64feed3b4dede2e2\""));
 
-    LOCK(cs_main);
-
     std::string strHash = params[0].get_str();
     uint256 hash(strHash);
 
-    bool fVerbose = true;
-    if (params.size() > 1)
-        fVerbose = params[1].get_bool();
+    int nVerbosity = 1;
+    if (params.size() > 1) {
+        if (params[1].isNum())
+            nVerbosity = params[1].get_int();
+        else
+            nVerbosity = params[1].get_bool() ? 1 : 0;
+    }
 
-    if (mapBlockIndex.count(hash) == 0)
-        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
+    CBlockIndex* pblockindex = NULL;
+    {
+        LOCK(cs_main);
+        BlockMap::iterator mi = mapBlockIndex.find(hash);
+        if (mi == mapBlockIndex.end())
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
+        pblockindex = mi->second;
+    }
 
+    // Reading and formatting the block doesn't need cs_main, block files are append only
     CBlock block;
-    CBlockIndex* pblockindex = mapBlockIndex[hash];
-
     if (!ReadBlockFromDisk(block, pblockindex))
         throw JSONRPCError(RPC_INTERNAL_ERROR, "Can't read block from disk");
 
-    if (!fVerbose) {
+    if (nVerbosity <= 0) {
         CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
         ssBlock << block;
         std::string strHex = HexStr(ssBlock.begin(), ssBlock.end());
         return strHex;
     }
 
-    return blockToJSON(block, pblockindex);
+    return blockToJSON(block, pblockindex, nVerbosity >= 2);
 }
 
 UniValue getblockheader(const UniValue& params, bool fHelp)
@@ -641,7 +753,13 @@ UniValue getblockchaininfo(const UniValue& params, bool fHelp)
             "        },\n"
             "        \"reject\": { ... }      (object) progress toward rejecting pre-softfork blocks (same fields as \"enforce\")\n"
             "     }, ...\n"
-            "  ]\n"
+            "  ],\n"
+            "  \"blockcache\": {           (object) cache of recently read blocks\n"
+            "     \"entries\": xx,          (numeric) number of cached blocks\n"
+            "     \"bytes\": xx,            (numeric) serialized size of the cached blocks\n"
+            "     \"hits\": xx,             (numeric) block reads served from the cache\n"
+            "     \"misses\": xx            (numeric) block reads that went to disk\n"
+            "  }\n"
             "}\n"
 
             "\nExamples:\n" +
@@ -661,6 +779,16 @@ UniValue getblockchaininfo(const UniValue& params, bool fHelp)
     UniValue softforks(UniValue::VARR);
     softforks.push_back(SoftForkDesc("bip65", 5, tip));
     obj.push_back(Pair("softforks",             softforks));
+
+    size_t nCacheEntries, nCacheSize;
+    uint64_t nCacheHits, nCacheMisses;
+    blockCache.GetStats(nCacheEntries, nCacheSize, nCacheHits, nCacheMisses);
+    UniValue cache(UniValue::VOBJ);
+    cache.push_back(Pair("entries", (uint64_t)nCacheEntries));
+    cache.push_back(Pair("bytes", (uint64_t)nCacheSize));
+    cache.push_back(Pair("hits", nCacheHits));
+    cache.push_back(Pair("misses", nCacheMisses));
+    obj.push_back(Pair("blockcache", cache));
     return obj;
 }
 
@@ -880,6 +1008,176 @@ UniValue getmempoolinfo(const UniValue& params, bool fHelp)
     return mempoolInfoToJSON();
 }
 
+UniValue getvalidationqueueinfo(const UniValue& params, bool fHelp)
+{
+    if (fHelp || params.size() != 0)
+        throw runtime_error(
+            "getvalidationqueueinfo\n"
+            "\nReturns the notifications waiting for the asynchronous validation listeners and how long each listener took to handle them.\n"
+
+            "\nResult:\n"
+            "{\n"
+            "  \"queued\": xxxxx             (numeric) Notifications not delivered yet\n"
+            "  \"listeners\": [              (array) One entry per asynchronous listener\n"
+            "    {\n"
+            "      \"name\": \"name\",          (string) The listener\n"
+            "      \"calls\": xxxxx          (numeric) Notifications delivered\n"
+            "      \"avg_us\": xxxxx         (numeric) Average callback time in microseconds\n"
+            "      \"max_us\": xxxxx         (numeric) Longest callback time in microseconds\n"
+            "      \"histogram\": {          (object) Number of callbacks by duration\n"
+            "        \"<100us\": xxxxx,\n"
+            "        ...\n"
+            "        \">=1s\": xxxxx\n"
+            "      }\n"
+            "    }\n"
+            "    ,...\n"
+            "  ]\n"
+            "}\n"
+
+            "\nExamples:\n" +
+            HelpExampleCli("getvalidationqueueinfo", "") + HelpExampleRpc("getvalidationqueueinfo", ""));
+
+    static const char* const pszBuckets[VALIDATION_LATENCY_BUCKETS] = {"<100us", "<1ms", "<10ms", "<100ms", "<1s", ">=1s"};
+
+    size_t nQueued;
+    std::vector<CValidationListenerStats> vStats;
+    GetValidationQueueStats(nQueued, vStats);
+
+    UniValue ret(UniValue::VOBJ);
+    ret.push_back(Pair("queued", (uint64_t)nQueued));
+
+    UniValue listeners(UniValue::VARR);
+    for (const CValidationListenerStats& stats : vStats) {
+        UniValue listener(UniValue::VOBJ);
+        listener.push_back(Pair("name", stats.strName));
+        listener.push_back(Pair("calls", stats.nCalls));
+        listener.push_back(Pair("avg_us", stats.nCalls ? stats.nTotalMicros / (int64_t)stats.nCalls : 0));
+        listener.push_back(Pair("max_us", stats.nMaxMicros));
+        UniValue histogram(UniValue::VOBJ);
+        for (int i = 0; i < VALIDATION_LATENCY_BUCKETS; i++)
+            histogram.push_back(Pair(pszBuckets[i], stats.vLatency[i]));
+        listener.push_back(Pair("histogram", histogram));
+        listeners.push_back(listener);
+    }
+    ret.push_back(Pair("listeners", listeners));
+
+    return ret;
+}
+
+UniValue getvalidationstats(const UniValue& params, bool fHelp)
+{
+    if (fHelp || params.size() > 2)
+        throw runtime_error(
+            "getvalidationstats ( nblocks verbose )\n"
+            "\nReturns how long the last blocks connected to the tip spent in each stage of validation.\n"
+
+            "\nArguments:\n"
+            "1. nblocks     (numeric, optional, default=100) Number of recent blocks to summarize, at most " + std::to_string(VALIDATION_STATS_BLOCKS) + "\n"
+            "2. verbose     (boolean, optional, default=false) Also list the timings of every block\n"
+
+            "\nResult:\n"
+            "{\n"
+            "  \"blocks\": xxxxx              (numeric) Number of blocks summarized\n"
+            "  \"stages\": {                 (object) One entry per stage, times in microseconds\n"
+            "    \"read_disk\": {\n"
+            "      \"avg\": xxxxx,            (numeric) Average time\n"
+            "      \"p50\": xxxxx,            (numeric) Median time\n"
+            "      \"p90\": xxxxx,            (numeric) 90th percentile\n"
+            "      \"p99\": xxxxx,            (numeric) 99th percentile\n"
+            "      \"max\": xxxxx             (numeric) Longest time\n"
+            "    },\n"
+            "    \"check_block\", \"check_stake\", \"zerocoin\", \"scripts\", \"accumulator_checkpoint\", \"supply\",\n"
+            "    \"connect_block\", \"undo_and_index\", \"flush\", \"signals\", \"total\": { ... }\n"
+            "  },\n"
+            "  \"checkqueue\": {             (object) Script check queue counters since startup\n"
+            "    \"workers\": n,              (numeric) Number of script check threads, not counting the validating thread\n"
+            "    \"checks\": n,               (numeric) Verifications performed\n"
+            "    \"batches\": n,              (numeric) Batches of verifications taken from the queues\n"
+            "    \"steals\": n,               (numeric) Batches taken from the queue of another thread\n"
+            "    \"idle_us\": n,              (numeric) Microseconds the script check threads slept without work\n"
+            "    \"wait_us\": n               (numeric) Microseconds block validation waited for the script check threads\n"
+            "  },\n"
+            "  \"recent\": [                 (array) Only with verbose, newest block first\n"
+            "    {\n"
+            "      \"hash\": \"hash\",          (string) The block hash\n"
+            "      \"height\": n,             (numeric) The block height\n"
+            "      \"tx\": n,                 (numeric) Number of transactions in the block\n"
+            "      \"time\": ttt,             (numeric) When the block was connected, in seconds since epoch\n"
+            "      \"read_disk\": xxxxx,      (numeric) Microseconds spent in each stage\n"
+            "      ...\n"
+            "    }\n"
+            "    ,...\n"
+            "  ]\n"
+            "}\n"
+
+            "\nExamples:\n" +
+            HelpExampleCli("getvalidationstats", "") + HelpExampleCli("getvalidationstats", "10 true") +
+            HelpExampleRpc("getvalidationstats", "10, true"));
+
+    int nBlocks = 100;
+    if (params.size() > 0) {
+        nBlocks = params[0].get_int();
+        if (nBlocks < 1)
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "nblocks must be positive");
+    }
+    bool fVerbose = params.size() > 1 ? params[1].get_bool() : false;
+
+    std::vector<CBlockValidationTimes> vRecent;
+    validationStats.GetRecent(nBlocks, vRecent);
+
+    UniValue ret(UniValue::VOBJ);
+    ret.push_back(Pair("blocks", (uint64_t)vRecent.size()));
+
+    UniValue stages(UniValue::VOBJ);
+    for (int nStage = 0; nStage < VALIDATION_STAGE_COUNT; nStage++) {
+        std::vector<int64_t> vSorted;
+        vSorted.reserve(vRecent.size());
+        int64_t nTotal = 0;
+        for (const CBlockValidationTimes& times : vRecent) {
+            vSorted.push_back(times.vMicros[nStage]);
+            nTotal += times.vMicros[nStage];
+        }
+        std::sort(vSorted.begin(), vSorted.end());
+
+        UniValue stage(UniValue::VOBJ);
+        stage.push_back(Pair("avg", vSorted.empty() ? 0 : nTotal / (int64_t)vSorted.size()));
+        stage.push_back(Pair("p50", ValidationStagePercentile(vSorted, 50)));
+        stage.push_back(Pair("p90", ValidationStagePercentile(vSorted, 90)));
+        stage.push_back(Pair("p99", ValidationStagePercentile(vSorted, 99)));
+        stage.push_back(Pair("max", vSorted.empty() ? 0 : vSorted.back()));
+        stages.push_back(Pair(GetValidationStageName(nStage), stage));
+    }
+    ret.push_back(Pair("stages", stages));
+
+    CCheckQueueStats queueStats;
+    GetScriptCheckQueueStats(queueStats);
+    UniValue checkqueue(UniValue::VOBJ);
+    checkqueue.push_back(Pair("workers", (uint64_t)queueStats.nWorkers));
+    checkqueue.push_back(Pair("checks", queueStats.nChecks));
+    checkqueue.push_back(Pair("batches", queueStats.nBatches));
+    checkqueue.push_back(Pair("steals", queueStats.nSteals));
+    checkqueue.push_back(Pair("idle_us", queueStats.nIdleMicros));
+    checkqueue.push_back(Pair("wait_us", queueStats.nWaitMicros));
+    ret.push_back(Pair("checkqueue", checkqueue));
+
+    if (fVerbose) {
+        UniValue recent(UniValue::VARR);
+        for (const CBlockValidationTimes& times : vRecent) {
+            UniValue block(UniValue::VOBJ);
+            block.push_back(Pair("hash", times.hashBlock.GetHex()));
+            block.push_back(Pair("height", times.nHeight));
+            block.push_back(Pair("tx", (uint64_t)times.nTx));
+            block.push_back(Pair("time", times.nTimeConnected));
+            for (int nStage = 0; nStage < VALIDATION_STAGE_COUNT; nStage++)
+                block.push_back(Pair(GetValidationStageName(nStage), times.vMicros[nStage]));
+            recent.push_back(block);
+        }
+        ret.push_back(Pair("recent", recent));
+    }
+
+    return ret;
+}
+
 UniValue invalidateblock(const UniValue& params, bool fHelp)
 {
     if (fHelp || params.size() != 1)
@@ -989,6 +1287,60 @@ UniValue findserial(const UniValue& params, bool fHelp)
     return ret;
 }
 
+UniValue listzerocoinspends(const UniValue& params, bool fHelp)
+{
+    if (fHelp || params.size() < 1 || params.size() > 2)
+        throw runtime_error(
+            "listzerocoinspends startheight ( endheight )\n"
+            "\nLists the zerocoin spends recorded in a range of blocks, in height order.\n"
+            "Uses the height index that -reindexzerocoin builds, which ends at the chain tip of that reindex,\n"
+            "or below the lowest block disconnected since.\n"
+
+            "\nArguments:\n"
+            "1. startheight   (numeric, required) the first block height to include.\n"
+            "2. endheight     (numeric, optional, default=startheight) the last block height to include.\n"
+
+            "\nResult:\n"
+            "[\n"
+            "  {\n"
+            "    \"height\": n,           (numeric) The height of the block containing the spend\n"
+            "    \"serialhash\": \"xxx\",  (string) The hash of the spent serial\n"
+            "    \"txid\": \"xxx\"         (string) The transaction that contains the spend\n"
+            "  }\n"
+            "  ,...\n"
+            "]\n"
+
+            "\nExamples:\n" +
+            HelpExampleCli("listzerocoinspends", "100000 101000") + HelpExampleRpc("listzerocoinspends", "100000, 101000"));
+
+    int nHeightStart = params[0].get_int();
+    int nHeightEnd = params.size() > 1 ? params[1].get_int() : nHeightStart;
+    if (nHeightStart < 0 || nHeightEnd < nHeightStart)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid height range");
+
+    int nHeightIndexed;
+    if (!zerocoinDB->ReadInt("heightindex", nHeightIndexed))
+        throw JSONRPCError(RPC_DATABASE_ERROR, "Zerocoin height index not built, restart with -reindexzerocoin");
+    // Connecting blocks doesn't add to the height index and disconnecting lowers its end, so
+    // later blocks would silently come back empty
+    if (nHeightEnd > nHeightIndexed)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Zerocoin height index only covers blocks up to %d, restart with -reindexzerocoin to extend it", nHeightIndexed));
+
+    std::vector<CZerocoinIndexEntry> vSpends;
+    if (!zerocoinDB->ReadCoinsInRange('s', nHeightStart, nHeightEnd, vSpends))
+        throw JSONRPCError(RPC_DATABASE_ERROR, "Failed to read the zerocoin database");
+
+    UniValue ret(UniValue::VARR);
+    for (const CZerocoinIndexEntry& entry : vSpends) {
+        UniValue obj(UniValue::VOBJ);
+        obj.push_back(Pair("height", entry.nHeight));
+        obj.push_back(Pair("serialhash", entry.hash.GetHex()));
+        obj.push_back(Pair("txid", entry.txid.GetHex()));
+        ret.push_back(obj);
+    }
+    return ret;
+}
+
 UniValue getaccumulatorvalues(const UniValue& params, bool fHelp)
 {
     if (fHelp || params.size() != 1)
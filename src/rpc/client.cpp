@@ -76,6 +76,8 @@ static const CRPCConvertParam vRPCConvertParams[] =
         {"listunspent", 3},
         {"getblock", 1},
         {"getblockheader", 1},
+        {"getvalidationstats", 0},
+        {"getvalidationstats", 1},
         {"gettransaction", 1},
         {"getrawtransaction", 1},
         {"createrawtransaction", 0},
@@ -144,14 +146,28 @@ static const CRPCConvertParam vRPCConvertParams[] =
         {"searchdzkyd", 1},
         {"searchdzkyd", 2},
         {"getaccumulatorvalues", 0},
+        {"listzerocoinspends", 0},
+        {"listzerocoinspends", 1},
         {"enableautomintaddress", 0},
-        {"getfeeinfo", 0}
+        {"getfeeinfo", 0},
+        {"getspentinfo", 0},
+        {"getblockhashes", 0},
+        {"getblockhashes", 1}
+    };
+
+/** Parameters that are either a JSON object or a plain string, such as a single address */
+static const CRPCConvertParam vRPCConvertObjectParams[] =
+    {
+        {"getaddressbalance", 0},
+        {"getaddressutxos", 0},
+        {"getaddresstxids", 0}
     };
 
 class CRPCConvertTable
 {
 private:
     std::set<std::pair<std::string, int> > members;
+    std::set<std::pair<std::string, int> > membersObject;
 
 public:
     CRPCConvertTable();
@@ -160,6 +176,11 @@ public:
     {
         return (members.count(std::make_pair(method, idx)) > 0);
     }
+
+    bool convertObject(const std::string& method, int idx)
+    {
+        return (membersObject.count(std::make_pair(method, idx)) > 0);
+    }
 };
 
 CRPCConvertTable::CRPCConvertTable()
@@ -171,6 +192,9 @@ CRPCConvertTable::CRPCConvertTable()
         members.insert(std::make_pair(vRPCConvertParams[i].methodName,
             vRPCConvertParams[i].paramIdx));
     }
+
+    for (const CRPCConvertParam& param : vRPCConvertObjectParams)
+        membersObject.insert(std::make_pair(param.methodName, param.paramIdx));
 }
 
 static CRPCConvertTable rpcCvtTable;
@@ -195,7 +219,8 @@ UniValue RPCConvertValues(const std::string &strMethod, const std::vector<std::s
     for (unsigned int idx = 0; idx < strParams.size(); idx++) {
         const std::string& strVal = strParams[idx];
 
-        if (!rpcCvtTable.convert(strMethod, idx)) {
+        bool fObject = !strVal.empty() && (strVal[0] == '{' || strVal[0] == '[');
+        if (!rpcCvtTable.convert(strMethod, idx) && !(fObject && rpcCvtTable.convertObject(strMethod, idx))) {
             // insert string value directly
             params.push_back(strVal);
         } else {
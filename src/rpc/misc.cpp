@@ -15,6 +15,7 @@
 #include "netbase.h"
 #include "rpc/server.h"
 #include "spork.h"
+#include "sync.h"
 #include "timedata.h"
 #include "util.h"
 #ifdef ENABLE_WALLET
@@ -22,6 +23,9 @@
 #include "walletdb.h"
 #endif
 
+#include <algorithm>
+#include <map>
+#include <set>
 #include <stdint.h>
 
 #include <boost/assign/list_of.hpp>
@@ -330,6 +334,156 @@ UniValue spork(const UniValue& params, bool fHelp)
         HelpExampleCli("spork", "show") + HelpExampleRpc("spork", "show"));
 }
 
+static void LockStatsToJSON(UniValue& obj, uint64_t nLocks, uint64_t nContended, int64_t nWaitMicros, int64_t nMaxWaitMicros,
+    int64_t nHoldMicros, int64_t nMaxHoldMicros, const uint64_t* vWait, const uint64_t* vHold)
+{
+    obj.push_back(Pair("locks", nLocks));
+    obj.push_back(Pair("contended", nContended));
+    obj.push_back(Pair("wait_us", nWaitMicros));
+    obj.push_back(Pair("max_wait_us", nMaxWaitMicros));
+    obj.push_back(Pair("hold_us", nHoldMicros));
+    obj.push_back(Pair("max_hold_us", nMaxHoldMicros));
+    UniValue wait(UniValue::VARR);
+    UniValue hold(UniValue::VARR);
+    for (int i = 0; i < LOCK_STATS_BUCKETS; i++) {
+        wait.push_back(vWait[i]);
+        hold.push_back(vHold[i]);
+    }
+    obj.push_back(Pair("wait_histogram", wait));
+    obj.push_back(Pair("hold_histogram", hold));
+}
+
+UniValue getlockstats(const UniValue& params, bool fHelp)
+{
+    std::string strMode = "show";
+    if (params.size() >= 1)
+        strMode = params[0].get_str();
+
+    if (fHelp || params.size() > 2 || (strMode != "show" && strMode != "enable" && strMode != "disable" && strMode != "reset")) {
+        throw runtime_error(
+            "getlockstats ( \"mode\" \"name\" )\n"
+            "\nReturns how long LOCK statements waited for and held each critical section, per lock and per source location.\n"
+            "Statistics are only recorded while enabled, either with -lockstats or with the 'enable' mode.\n"
+
+            "\nArguments:\n"
+            "1. \"mode\"    (string, optional, default=show) 'show', 'enable', 'disable' or 'reset'\n"
+            "2. \"name\"    (string, optional) In 'show' mode, only return the lock with this name (e.g. cs_main)\n"
+
+            "\nResult ('show' mode):\n"
+            "{\n"
+            "  \"enabled\": true|false,        (boolean) Whether statistics are being recorded\n"
+            "  \"buckets\": [ n, ... ],        (array) Upper bound in microseconds of each histogram bucket, the last one is unbounded\n"
+            "  \"locks\": [                    (array) Locks, most waited for first\n"
+            "    {\n"
+            "      \"name\": \"xxxx\",          (string) The lock expression passed to LOCK\n"
+            "      \"locks\": n,               (numeric) Number of times it was taken\n"
+            "      \"contended\": n,           (numeric) Number of times it was held by another thread\n"
+            "      \"wait_us\": n,             (numeric) Total time spent waiting for it\n"
+            "      \"max_wait_us\": n,         (numeric) Longest single wait\n"
+            "      \"hold_us\": n,             (numeric) Total time it was held\n"
+            "      \"max_hold_us\": n,         (numeric) Longest single hold\n"
+            "      \"wait_histogram\": [ n, ... ], (array) Number of waits per bucket\n"
+            "      \"hold_histogram\": [ n, ... ], (array) Number of holds per bucket\n"
+            "      \"sites\": [                (array) The same fields for every file:line that took the lock, most waited for first\n"
+            "        {\n"
+            "          \"site\": \"file:line\",\n"
+            "          ...\n"
+            "        }\n"
+            "      ]\n"
+            "    }\n"
+            "    ,...\n"
+            "  ]\n"
+            "}\n"
+
+            "\nResult (other modes):\n"
+            "\"status\"     (string) 'success'\n"
+
+            "\nExamples:\n" +
+            HelpExampleCli("getlockstats", "") + HelpExampleCli("getlockstats", "\"show\" \"cs_main\"") +
+            HelpExampleCli("getlockstats", "\"enable\"") + HelpExampleRpc("getlockstats", "\"show\", \"cs_main\""));
+    }
+
+    if (strMode == "enable" || strMode == "disable") {
+        fLockStats = (strMode == "enable");
+        return "success";
+    }
+
+    if (strMode == "reset") {
+        ResetLockStats();
+        return "success";
+    }
+
+    std::string strName;
+    if (params.size() > 1)
+        strName = params[1].get_str();
+
+    std::vector<CLockSiteStats> vSites;
+    GetLockStats(vSites);
+
+    // Sum up the sites of each lock
+    std::map<std::string, CLockSiteStats> mapLocks;
+    std::map<std::string, std::vector<const CLockSiteStats*> > mapLockSites;
+    for (const CLockSiteStats& site : vSites) {
+        if (!strName.empty() && site.strName != strName)
+            continue;
+        std::map<std::string, CLockSiteStats>::iterator it = mapLocks.find(site.strName);
+        if (it == mapLocks.end()) {
+            mapLocks.insert(std::make_pair(site.strName, site));
+        } else {
+            CLockSiteStats& total = it->second;
+            total.nLocks += site.nLocks;
+            total.nContended += site.nContended;
+            total.nWaitMicros += site.nWaitMicros;
+            total.nMaxWaitMicros = std::max(total.nMaxWaitMicros, site.nMaxWaitMicros);
+            total.nHoldMicros += site.nHoldMicros;
+            total.nMaxHoldMicros = std::max(total.nMaxHoldMicros, site.nMaxHoldMicros);
+            for (int i = 0; i < LOCK_STATS_BUCKETS; i++) {
+                total.vWait[i] += site.vWait[i];
+                total.vHold[i] += site.vHold[i];
+            }
+        }
+        mapLockSites[site.strName].push_back(&site);
+    }
+
+    std::vector<const CLockSiteStats*> vLocks;
+    for (const auto& lock : mapLocks)
+        vLocks.push_back(&lock.second);
+    auto byWait = [](const CLockSiteStats* a, const CLockSiteStats* b) { return a->nWaitMicros > b->nWaitMicros; };
+    std::sort(vLocks.begin(), vLocks.end(), byWait);
+
+    UniValue locks(UniValue::VARR);
+    for (const CLockSiteStats* pLock : vLocks) {
+        UniValue lock(UniValue::VOBJ);
+        lock.push_back(Pair("name", pLock->strName));
+        LockStatsToJSON(lock, pLock->nLocks, pLock->nContended, pLock->nWaitMicros, pLock->nMaxWaitMicros,
+            pLock->nHoldMicros, pLock->nMaxHoldMicros, pLock->vWait, pLock->vHold);
+
+        std::vector<const CLockSiteStats*>& vLockSites = mapLockSites[pLock->strName];
+        std::sort(vLockSites.begin(), vLockSites.end(), byWait);
+        UniValue sites(UniValue::VARR);
+        for (const CLockSiteStats* pSite : vLockSites) {
+            UniValue site(UniValue::VOBJ);
+            site.push_back(Pair("site", strprintf("%s:%d", pSite->strFile, pSite->nLine)));
+            LockStatsToJSON(site, pSite->nLocks, pSite->nContended, pSite->nWaitMicros, pSite->nMaxWaitMicros,
+                pSite->nHoldMicros, pSite->nMaxHoldMicros, pSite->vWait, pSite->vHold);
+            sites.push_back(site);
+        }
+        lock.push_back(Pair("sites", sites));
+        locks.push_back(lock);
+    }
+
+    UniValue buckets(UniValue::VARR);
+    int64_t nLimit = 1;
+    for (int i = 0; i < LOCK_STATS_BUCKETS - 1; i++, nLimit *= 10)
+        buckets.push_back(nLimit);
+
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("enabled", fLockStats.load()));
+    obj.push_back(Pair("buckets", buckets));
+    obj.push_back(Pair("locks", locks));
+    return obj;
+}
+
 UniValue validateaddress(const UniValue& params, bool fHelp)
 {
     if (fHelp || params.size() != 1)
@@ -566,6 +720,261 @@ UniValue setmocktime(const UniValue& params, bool fHelp)
     return NullUniValue;
 }
 
+static bool AddressToIndexKey(const CBitcoinAddress& address, uint160& addressHash, int& nAddressType)
+{
+    CTxDestination dest = address.Get();
+    if (const CKeyID* keyID = boost::get<CKeyID>(&dest)) {
+        addressHash = *keyID;
+        nAddressType = ADDRESS_INDEX_PUBKEYHASH;
+        return true;
+    }
+    if (const CScriptID* scriptID = boost::get<CScriptID>(&dest)) {
+        addressHash = *scriptID;
+        nAddressType = ADDRESS_INDEX_SCRIPTHASH;
+        return true;
+    }
+    return false;
+}
+
+static std::string IndexKeyToAddress(const uint160& addressHash, int nAddressType)
+{
+    if (nAddressType == ADDRESS_INDEX_PUBKEYHASH)
+        return CBitcoinAddress(CKeyID(addressHash)).ToString();
+    if (nAddressType == ADDRESS_INDEX_SCRIPTHASH)
+        return CBitcoinAddress(CScriptID(addressHash)).ToString();
+    return "";
+}
+
+/** Accepts either a single address or an object of the form {"addresses": ["address", ...]} */
+static void ParseIndexAddresses(const UniValue& param, std::vector<std::pair<uint160, int> >& vAddresses)
+{
+    std::vector<std::string> vStrAddresses;
+    if (param.isStr()) {
+        vStrAddresses.push_back(param.get_str());
+    } else if (param.isObject()) {
+        const UniValue& addressValues = find_value(param.get_obj(), "addresses");
+        if (!addressValues.isArray())
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Addresses is expected to be an array");
+        for (unsigned int i = 0; i < addressValues.size(); i++)
+            vStrAddresses.push_back(addressValues[i].get_str());
+    } else {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
+    }
+
+    for (const std::string& strAddress : vStrAddresses) {
+        uint160 addressHash;
+        int nAddressType;
+        if (!AddressToIndexKey(CBitcoinAddress(strAddress), addressHash, nAddressType))
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address: " + strAddress);
+        vAddresses.push_back(std::make_pair(addressHash, nAddressType));
+    }
+}
+
+UniValue getaddressbalance(const UniValue& params, bool fHelp)
+{
+    if (fHelp || params.size() != 1)
+        throw runtime_error(
+            "getaddressbalance \"address\"|{\"addresses\": [\"address\",...]}\n"
+            "\nReturns the balance of one or more addresses (requires -addressindex).\n"
+
+            "\nArguments:\n"
+            "1. \"address\"        (string or object, required) A kyd address, or an object with an array of addresses\n"
+            "     {\n"
+            "       \"addresses\": [\"address\",...]\n"
+            "     }\n"
+
+            "\nResult:\n"
+            "{\n"
+            "  \"balance\": n,     (numeric) The current balance in satoshis\n"
+            "  \"received\": n,    (numeric) The total number of satoshis received (including change)\n"
+            "}\n"
+
+            "\nExamples:\n" +
+            HelpExampleCli("getaddressbalance", "\"YRxBRQgepgrvRwgxhSK7Pm7K6mnWuhu8vU\"") +
+            HelpExampleCli("getaddressbalance", "'{\"addresses\": [\"YRxBRQgepgrvRwgxhSK7Pm7K6mnWuhu8vU\"]}'") +
+            HelpExampleRpc("getaddressbalance", "{\"addresses\": [\"YRxBRQgepgrvRwgxhSK7Pm7K6mnWuhu8vU\"]}"));
+
+    std::vector<std::pair<uint160, int> > vAddresses;
+    ParseIndexAddresses(params[0], vAddresses);
+
+    CAmount nBalance = 0;
+    CAmount nReceived = 0;
+    for (const std::pair<uint160, int>& address : vAddresses) {
+        std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+        if (!GetAddressIndex(address.first, address.second, addressIndex))
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+
+        for (const std::pair<CAddressIndexKey, CAmount>& entry : addressIndex) {
+            if (entry.second > 0)
+                nReceived += entry.second;
+            nBalance += entry.second;
+        }
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.push_back(Pair("balance", nBalance));
+    result.push_back(Pair("received", nReceived));
+    return result;
+}
+
+UniValue getaddressutxos(const UniValue& params, bool fHelp)
+{
+    if (fHelp || params.size() != 1)
+        throw runtime_error(
+            "getaddressutxos \"address\"|{\"addresses\": [\"address\",...]}\n"
+            "\nReturns all unspent outputs of one or more addresses (requires -addressindex).\n"
+
+            "\nArguments:\n"
+            "1. \"address\"        (string or object, required) A kyd address, or an object with an array of addresses\n"
+            "     {\n"
+            "       \"addresses\": [\"address\",...]\n"
+            "     }\n"
+
+            "\nResult:\n"
+            "[\n"
+            "  {\n"
+            "    \"address\": \"address\",  (string) The address\n"
+            "    \"txid\": \"hash\",        (string) The output txid\n"
+            "    \"outputIndex\": n,      (numeric) The output index\n"
+            "    \"script\": \"hex\",       (string) The script hex encoded\n"
+            "    \"satoshis\": n,         (numeric) The number of satoshis of the output\n"
+            "    \"height\": n,           (numeric) The block height\n"
+            "  }\n"
+            "  ,...\n"
+            "]\n"
+
+            "\nExamples:\n" +
+            HelpExampleCli("getaddressutxos", "\"YRxBRQgepgrvRwgxhSK7Pm7K6mnWuhu8vU\"") +
+            HelpExampleCli("getaddressutxos", "'{\"addresses\": [\"YRxBRQgepgrvRwgxhSK7Pm7K6mnWuhu8vU\"]}'") +
+            HelpExampleRpc("getaddressutxos", "{\"addresses\": [\"YRxBRQgepgrvRwgxhSK7Pm7K6mnWuhu8vU\"]}"));
+
+    std::vector<std::pair<uint160, int> > vAddresses;
+    ParseIndexAddresses(params[0], vAddresses);
+
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > unspentOutputs;
+    for (const std::pair<uint160, int>& address : vAddresses) {
+        if (!GetAddressUnspent(address.first, address.second, unspentOutputs))
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+    }
+
+    std::stable_sort(unspentOutputs.begin(), unspentOutputs.end(),
+        [](const std::pair<CAddressUnspentKey, CAddressUnspentValue>& a, const std::pair<CAddressUnspentKey, CAddressUnspentValue>& b) {
+            return a.second.blockHeight < b.second.blockHeight;
+        });
+
+    UniValue result(UniValue::VARR);
+    for (const std::pair<CAddressUnspentKey, CAddressUnspentValue>& output : unspentOutputs) {
+        UniValue entry(UniValue::VOBJ);
+        entry.push_back(Pair("address", IndexKeyToAddress(output.first.hashBytes, output.first.type)));
+        entry.push_back(Pair("txid", output.first.txhash.GetHex()));
+        entry.push_back(Pair("outputIndex", (int)output.first.index));
+        entry.push_back(Pair("script", HexStr(output.second.script.begin(), output.second.script.end())));
+        entry.push_back(Pair("satoshis", output.second.satoshis));
+        entry.push_back(Pair("height", output.second.blockHeight));
+        result.push_back(entry);
+    }
+    return result;
+}
+
+UniValue getaddresstxids(const UniValue& params, bool fHelp)
+{
+    if (fHelp || params.size() != 1)
+        throw runtime_error(
+            "getaddresstxids \"address\"|{\"addresses\": [\"address\",...], \"start\": n, \"end\": n}\n"
+            "\nReturns the txids of one or more addresses, ordered by height (requires -addressindex).\n"
+
+            "\nArguments:\n"
+            "1. \"address\"        (string or object, required) A kyd address, or an object with an array of addresses\n"
+            "     {\n"
+            "       \"addresses\": [\"address\",...]\n"
+            "       \"start\": n   (numeric, optional) The first block height to include\n"
+            "       \"end\": n     (numeric, optional) The last block height to include\n"
+            "     }\n"
+
+            "\nResult:\n"
+            "[\n"
+            "  \"transactionid\"  (string) The transaction id\n"
+            "  ,...\n"
+            "]\n"
+
+            "\nExamples:\n" +
+            HelpExampleCli("getaddresstxids", "\"YRxBRQgepgrvRwgxhSK7Pm7K6mnWuhu8vU\"") +
+            HelpExampleCli("getaddresstxids", "'{\"addresses\": [\"YRxBRQgepgrvRwgxhSK7Pm7K6mnWuhu8vU\"]}'") +
+            HelpExampleRpc("getaddresstxids", "{\"addresses\": [\"YRxBRQgepgrvRwgxhSK7Pm7K6mnWuhu8vU\"]}"));
+
+    std::vector<std::pair<uint160, int> > vAddresses;
+    ParseIndexAddresses(params[0], vAddresses);
+
+    int nStart = 0;
+    int nEnd = 0;
+    if (params[0].isObject()) {
+        const UniValue& startValue = find_value(params[0].get_obj(), "start");
+        const UniValue& endValue = find_value(params[0].get_obj(), "end");
+        if (startValue.isNum() && endValue.isNum()) {
+            nStart = startValue.get_int();
+            nEnd = endValue.get_int();
+            if (nStart <= 0 || nEnd < nStart)
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid start and end heights");
+        }
+    }
+
+    std::set<std::pair<int, uint256> > setTxids;
+    for (const std::pair<uint160, int>& address : vAddresses) {
+        std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+        if (!GetAddressIndex(address.first, address.second, addressIndex, nStart, nEnd))
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+
+        for (const std::pair<CAddressIndexKey, CAmount>& entry : addressIndex)
+            setTxids.insert(std::make_pair(entry.first.blockHeight, entry.first.txhash));
+    }
+
+    UniValue result(UniValue::VARR);
+    for (const std::pair<int, uint256>& txid : setTxids)
+        result.push_back(txid.second.GetHex());
+    return result;
+}
+
+UniValue getspentinfo(const UniValue& params, bool fHelp)
+{
+    if (fHelp || params.size() != 1 || !params[0].isObject())
+        throw runtime_error(
+            "getspentinfo {\"txid\": \"hash\", \"index\": n}\n"
+            "\nReturns the txid and input index where an output is spent (requires -spentindex).\n"
+
+            "\nArguments:\n"
+            "1. {\n"
+            "     \"txid\": \"hash\",  (string, required) The hex string of the txid\n"
+            "     \"index\": n       (numeric, required) The output index\n"
+            "   }\n"
+
+            "\nResult:\n"
+            "{\n"
+            "  \"txid\": \"hash\",     (string) The transaction id of the spending transaction\n"
+            "  \"index\": n,         (numeric) The spending input index\n"
+            "  \"height\": n,        (numeric) The height of the block the output was spent in\n"
+            "}\n"
+
+            "\nExamples:\n" +
+            HelpExampleCli("getspentinfo", "'{\"txid\": \"0437cd7f8525ceed2324359c2d0ba26006d92d856a9c20fa0241106ee5a597c9\", \"index\": 0}'") +
+            HelpExampleRpc("getspentinfo", "{\"txid\": \"0437cd7f8525ceed2324359c2d0ba26006d92d856a9c20fa0241106ee5a597c9\", \"index\": 0}"));
+
+    const UniValue& txidValue = find_value(params[0].get_obj(), "txid");
+    const UniValue& indexValue = find_value(params[0].get_obj(), "index");
+    if (!txidValue.isStr() || !indexValue.isNum())
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid txid or index");
+
+    CSpentIndexKey key(ParseHashV(txidValue, "txid"), indexValue.get_int());
+    CSpentIndexValue value;
+    if (!GetSpentIndex(key, value))
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unable to get spent info");
+
+    UniValue result(UniValue::VOBJ);
+    result.push_back(Pair("txid", value.txid.GetHex()));
+    result.push_back(Pair("index", (int)value.inputIndex));
+    result.push_back(Pair("height", value.blockHeight));
+    return result;
+}
+
 #ifdef ENABLE_WALLET
 UniValue getstakingstatus(const UniValue& params, bool fHelp)
 {
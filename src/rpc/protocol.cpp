@@ -53,8 +53,13 @@ UniValue JSONRPCReplyObj(const UniValue& result, const UniValue& error, const Un
 
 string JSONRPCReply(const UniValue& result, const UniValue& error, const UniValue& id)
 {
-    UniValue reply = JSONRPCReplyObj(result, error, id);
-    return reply.write() + "\n";
+    // Same output as JSONRPCReplyObj(result, error, id).write(), without copying a
+    // potentially large result into the reply object first
+    string strReply = "{\"result\":";
+    strReply += error.isNull() ? result.write() : NullUniValue.write();
+    strReply += ",\"error\":" + error.write();
+    strReply += ",\"id\":" + id.write() + "}\n";
+    return strReply;
 }
 
 UniValue JSONRPCError(int code, const string& message)
@@ -16,6 +16,10 @@
 #include "ui_interface.h"
 #include "util.h"
 #include "utilstrencodings.h"
+#include "validationinterface.h"
+#ifdef ENABLE_WALLET
+#include "wallet.h"
+#endif
 
 #include <boost/bind.hpp>
 #include <boost/filesystem.hpp>
@@ -27,6 +31,10 @@
 #include <boost/thread.hpp>
 #include <boost/algorithm/string/case_conv.hpp> // for to_upper()
 
+#include <atomic>
+#include <memory>
+#include <set>
+
 #include <univalue.h>
 
 using namespace RPCServer;
@@ -284,6 +292,7 @@ static const CRPCCommand vRPCCommands[] =
         //  --------------------- ------------------------  -----------------------  ---------- ---------- ---------
         /* Overall control/query calls */
         {"control", "getinfo", &getinfo, true, false, false}, /* uses wallet if enabled */
+        {"control", "getlockstats", &getlockstats, true, true, false},
         {"control", "help", &help, true, true, false},
         {"control", "stop", &stop, true, true, false},
 
@@ -308,6 +317,7 @@ static const CRPCCommand vRPCCommands[] =
         {"blockchain", "getblockcount", &getblockcount, true, false, false},
         {"blockchain", "getblock", &getblock, true, false, false},
         {"blockchain", "getblockhash", &getblockhash, true, false, false},
+        {"blockchain", "getblockhashes", &getblockhashes, true, false, false},
         {"blockchain", "getblockheader", &getblockheader, false, false, false},
         {"blockchain", "getchaintips", &getchaintips, true, false, false},
         {"blockchain", "getdifficulty", &getdifficulty, true, false, false},
@@ -316,7 +326,10 @@ static const CRPCCommand vRPCCommands[] =
         {"blockchain", "getrawmempool", &getrawmempool, true, false, false},
         {"blockchain", "gettxout", &gettxout, true, false, false},
         {"blockchain", "gettxoutsetinfo", &gettxoutsetinfo, true, false, false},
+        {"blockchain", "getvalidationqueueinfo", &getvalidationqueueinfo, true, true, false},
+        {"blockchain", "getvalidationstats", &getvalidationstats, true, true, false},
         {"blockchain", "invalidateblock", &invalidateblock, true, true, false},
+        {"blockchain", "listzerocoinspends", &listzerocoinspends, true, false, false},
         {"blockchain", "reconsiderblock", &reconsiderblock, true, true, false},
         {"blockchain", "verifychain", &verifychain, true, false, false},
 
@@ -343,6 +356,12 @@ static const CRPCCommand vRPCCommands[] =
         {"rawtransactions", "sendrawtransaction", &sendrawtransaction, false, false, false},
         {"rawtransactions", "signrawtransaction", &signrawtransaction, false, false, false}, /* uses wallet if enabled */
 
+        /* Address index */
+        {"addressindex", "getaddressbalance", &getaddressbalance, true, false, false},
+        {"addressindex", "getaddresstxids", &getaddresstxids, true, false, false},
+        {"addressindex", "getaddressutxos", &getaddressutxos, true, false, false},
+        {"addressindex", "getspentinfo", &getspentinfo, true, false, false},
+
         /* Utility functions */
         {"util", "createmultisig", &createmultisig, true, true, false},
         {"util", "validateaddress", &validateaddress, true, false, false}, /* uses wallet if enabled */
@@ -580,13 +599,113 @@ static UniValue JSONRPCExecOne(const UniValue& req)
     return rpc_result;
 }
 
-std::string JSONRPCExecBatch(const UniValue& vReq)
+/**
+ * Methods that only read chain state. A batch made up of these alone may run its elements
+ * concurrently, since no element can observe the effect of another.
+ */
+static const std::set<std::string> setParallelBatchMethods = {
+    "decoderawtransaction", "decodescript", "getaddressbalance", "getaddresstxids", "getaddressutxos",
+    "getbestblockhash", "getblock", "getblockcount", "getblockhash", "getblockhashes", "getblockheader",
+    "getdifficulty", "getrawtransaction", "getspentinfo", "gettxout", "listzerocoinspends", "validateaddress",
+    "verifymessage",
+};
+
+static bool IsParallelBatch(const UniValue& vReq)
 {
-    UniValue ret(UniValue::VARR);
-    for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++)
-        ret.push_back(JSONRPCExecOne(vReq[reqIdx]));
+    for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++) {
+        const UniValue& req = vReq[reqIdx];
+        if (!req.isObject())
+            return false;
+        const UniValue& valMethod = find_value(req, "method");
+        if (!valMethod.isStr() || !setParallelBatchMethods.count(valMethod.get_str()))
+            return false;
+    }
+    return true;
+}
 
-    return ret.write() + "\n";
+/** Progress of a batch whose elements are executed by several threads */
+struct CRPCBatchState {
+    typedef std::function<bool(const std::function<void()>&)> EnqueueFunction;
+
+    const UniValue* pvReq;
+    const unsigned int nSize;
+    std::vector<UniValue> vReplies;
+    std::atomic<unsigned int> nNext;
+    //! Helpers that may still be queued; each helper queues the next one while work is left
+    std::atomic<int> nHelpersLeft;
+    const EnqueueFunction fnEnqueue;
+    boost::mutex cs;
+    boost::condition_variable cond;
+    unsigned int nDone;
+    unsigned int nWorking;
+
+    CRPCBatchState(const UniValue* pvReqIn, const EnqueueFunction& fnEnqueueIn, int nHelpers) : pvReq(pvReqIn), nSize(pvReqIn->size()), vReplies(nSize), nNext(0),
+                                                                                                 nHelpersLeft(nHelpers), fnEnqueue(fnEnqueueIn), nDone(0), nWorking(0) {}
+
+    //! Queue another helper if enough of the batch is left to be worth one. Helpers are
+    //! queued one after the other, so a finished batch leaves at most one in the work queue.
+    static void QueueHelper(const std::shared_ptr<CRPCBatchState>& state)
+    {
+        if (state->nNext + 1 >= state->nSize || state->nHelpersLeft-- <= 0)
+            return;
+        state->fnEnqueue([state]() {
+            QueueHelper(state);
+            state->Work();
+        });
+    }
+
+    //! Execute elements until none are left to claim. pvReq and vReplies are only touched
+    //! for claimed elements, and the thread owning the batch waits for those and for every
+    //! thread inside Work() before taking the replies.
+    void Work()
+    {
+        {
+            boost::unique_lock<boost::mutex> lock(cs);
+            nWorking++;
+        }
+        for (unsigned int reqIdx = nNext++; reqIdx < nSize; reqIdx = nNext++) {
+            UniValue reply = JSONRPCExecOne((*pvReq)[reqIdx]);
+            boost::unique_lock<boost::mutex> lock(cs);
+            vReplies[reqIdx] = std::move(reply);
+            nDone++;
+        }
+        boost::unique_lock<boost::mutex> lock(cs);
+        if (--nWorking == 0 && nDone == nSize)
+            cond.notify_all();
+    }
+
+    //! Wait for the helpers and hand out the replies
+    void TakeReplies(std::vector<UniValue>& vRepliesOut)
+    {
+        boost::unique_lock<boost::mutex> lock(cs);
+        while (nDone < nSize || nWorking > 0)
+            cond.wait(lock);
+        vRepliesOut.swap(vReplies);
+    }
+};
+
+std::string JSONRPCExecBatch(const UniValue& vReq, const std::function<bool(const std::function<void()>&)>& fnEnqueue, int nHelpers)
+{
+    std::vector<UniValue> vReplies;
+    if (fnEnqueue && nHelpers > 0 && vReq.size() > 1 && IsParallelBatch(vReq)) {
+        // Helpers may only start after the batch is done, so they share ownership of the state
+        std::shared_ptr<CRPCBatchState> state = std::make_shared<CRPCBatchState>(&vReq, fnEnqueue, std::min(nHelpers, (int)vReq.size() - 1));
+        CRPCBatchState::QueueHelper(state);
+        state->Work();
+        state->TakeReplies(vReplies);
+    } else {
+        vReplies.reserve(vReq.size());
+        for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++)
+            vReplies.push_back(JSONRPCExecOne(vReq[reqIdx]));
+    }
+
+    std::string strReply = "[";
+    for (unsigned int reqIdx = 0; reqIdx < vReplies.size(); reqIdx++) {
+        if (reqIdx > 0)
+            strReply += ",";
+        strReply += vReplies[reqIdx].write();
+    }
+    return strReply + "]\n";
 }
 
 UniValue CRPCTable::execute(const std::string &strMethod, const UniValue &params) const
@@ -598,6 +717,12 @@ UniValue CRPCTable::execute(const std::string &strMethod, const UniValue &params
 
     g_rpcSignals.PreCommand(*pcmd);
 
+#ifdef ENABLE_WALLET
+    // Wallet calls must see every block and transaction validated before they were made
+    if (pcmd->reqWallet && pwalletMain)
+        SyncWithValidationQueue(pwalletMain);
+#endif
+
     try {
         // Execute
         return pcmd->actor(params, false);
@@ -88,6 +88,11 @@ public:
         return n;
     }
 
+    std::string GetStrMessage() const
+    {
+        return std::to_string(nSporkID) + std::to_string(nValue) + std::to_string(nTimeSigned);
+    }
+
     ADD_SERIALIZE_METHODS;
 
     template <typename Stream, typename Operation>
@@ -76,6 +76,7 @@ public:
     std::vector<unsigned char> vchMasterNodeSignature;
 
     uint256 GetHash() const;
+    std::string GetStrMessage() const;
 
     bool SignatureValid();
     bool Sign();
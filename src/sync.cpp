@@ -6,6 +6,8 @@
 
 #include "sync.h"
 
+#include <algorithm>
+#include <map>
 #include <memory>
 #include <set>
 
@@ -14,6 +16,112 @@
 
 #include <stdio.h>
 
+std::atomic<bool> fLockStats(DEFAULT_LOCKSTATS);
+
+namespace
+{
+/**
+ * Lock statistics are kept per (name, file, line) of the LOCK statement. The strings are the
+ * literals expanded by the LOCK macros, so comparing their addresses is enough. Sites are spread
+ * over several independently locked shards so that the bookkeeping itself does not become the
+ * next point of contention.
+ */
+struct CLockSiteKey {
+    const char* pszName;
+    const char* pszFile;
+    int nLine;
+
+    bool operator<(const CLockSiteKey& other) const
+    {
+        if (nLine != other.nLine) return nLine < other.nLine;
+        if (pszFile != other.pszFile) return pszFile < other.pszFile;
+        return pszName < other.pszName;
+    }
+};
+
+struct CLockSiteCounters {
+    uint64_t nLocks;
+    uint64_t nContended;
+    int64_t nWaitMicros;
+    int64_t nMaxWaitMicros;
+    int64_t nHoldMicros;
+    int64_t nMaxHoldMicros;
+    uint64_t vWait[LOCK_STATS_BUCKETS];
+    uint64_t vHold[LOCK_STATS_BUCKETS];
+};
+
+static const int LOCK_STATS_SHARDS = 64;
+
+struct CLockStatsShard {
+    std::mutex mutex;
+    std::map<CLockSiteKey, CLockSiteCounters> mapSites;
+};
+
+CLockStatsShard lockStatsShards[LOCK_STATS_SHARDS];
+
+int LockStatsBucket(int64_t nMicros)
+{
+    int nBucket = 0;
+    for (int64_t nLimit = 1; nBucket < LOCK_STATS_BUCKETS - 1 && nMicros >= nLimit; nLimit *= 10)
+        nBucket++;
+    return nBucket;
+}
+} // namespace
+
+void RecordLockStats(const char* pszName, const char* pszFile, int nLine, bool fContended, int64_t nWaitMicros, int64_t nHoldMicros)
+{
+    CLockSiteKey key = {pszName, pszFile, nLine};
+    CLockStatsShard& shard = lockStatsShards[(((uintptr_t)pszFile >> 4) ^ (unsigned int)nLine) % LOCK_STATS_SHARDS];
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    std::map<CLockSiteKey, CLockSiteCounters>::iterator it = shard.mapSites.find(key);
+    if (it == shard.mapSites.end()) {
+        CLockSiteCounters counters = {};
+        it = shard.mapSites.insert(std::make_pair(key, counters)).first;
+    }
+    CLockSiteCounters& counters = it->second;
+    counters.nLocks++;
+    if (fContended)
+        counters.nContended++;
+    counters.nWaitMicros += nWaitMicros;
+    counters.nMaxWaitMicros = std::max(counters.nMaxWaitMicros, nWaitMicros);
+    counters.nHoldMicros += nHoldMicros;
+    counters.nMaxHoldMicros = std::max(counters.nMaxHoldMicros, nHoldMicros);
+    counters.vWait[LockStatsBucket(nWaitMicros)]++;
+    counters.vHold[LockStatsBucket(nHoldMicros)]++;
+}
+
+void GetLockStats(std::vector<CLockSiteStats>& vStats)
+{
+    vStats.clear();
+    for (int i = 0; i < LOCK_STATS_SHARDS; i++) {
+        std::lock_guard<std::mutex> lock(lockStatsShards[i].mutex);
+        for (const auto& site : lockStatsShards[i].mapSites) {
+            CLockSiteStats stats;
+            stats.strName = site.first.pszName;
+            stats.strFile = site.first.pszFile;
+            stats.nLine = site.first.nLine;
+            stats.nLocks = site.second.nLocks;
+            stats.nContended = site.second.nContended;
+            stats.nWaitMicros = site.second.nWaitMicros;
+            stats.nMaxWaitMicros = site.second.nMaxWaitMicros;
+            stats.nHoldMicros = site.second.nHoldMicros;
+            stats.nMaxHoldMicros = site.second.nMaxHoldMicros;
+            std::copy(site.second.vWait, site.second.vWait + LOCK_STATS_BUCKETS, stats.vWait);
+            std::copy(site.second.vHold, site.second.vHold + LOCK_STATS_BUCKETS, stats.vHold);
+            vStats.push_back(stats);
+        }
+    }
+}
+
+void ResetLockStats()
+{
+    for (int i = 0; i < LOCK_STATS_SHARDS; i++) {
+        std::lock_guard<std::mutex> lock(lockStatsShards[i].mutex);
+        lockStatsShards[i].mapSites.clear();
+    }
+}
+
 #ifdef DEBUG_LOCKCONTENTION
 #if !defined(HAVE_THREAD_LOCAL)
 static_assert(false, "thread_local is not supported");
@@ -10,9 +10,14 @@
 
 #include "threadsafety.h"
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <stdint.h>
+#include <string>
 #include <thread>
 #include <mutex>
+#include <vector>
 
 
 /////////////////////////////////////////////////
@@ -111,15 +116,62 @@ typedef std::unique_lock<std::mutex> WaitableLock;
 void PrintLockContention(const char* pszName, const char* pszFile, int nLine);
 #endif
 
+//! -lockstats default
+static const bool DEFAULT_LOCKSTATS = false;
+//! Bucket n of the lock wait and hold histograms counts times under 10^n microseconds, the last one the rest
+static const int LOCK_STATS_BUCKETS = 8;
+
+/** Wait and hold times of the LOCK/TRY_LOCK statements at one source location */
+struct CLockSiteStats {
+    std::string strName;
+    std::string strFile;
+    int nLine;
+    uint64_t nLocks;
+    uint64_t nContended;
+    int64_t nWaitMicros;
+    int64_t nMaxWaitMicros;
+    int64_t nHoldMicros;
+    int64_t nMaxHoldMicros;
+    uint64_t vWait[LOCK_STATS_BUCKETS];
+    uint64_t vHold[LOCK_STATS_BUCKETS];
+};
+
+/** Whether CCriticalBlock records lock statistics. Can be switched at any time. */
+extern std::atomic<bool> fLockStats;
+
+void RecordLockStats(const char* pszName, const char* pszFile, int nLine, bool fContended, int64_t nWaitMicros, int64_t nHoldMicros);
+void GetLockStats(std::vector<CLockSiteStats>& vStats);
+void ResetLockStats();
+
 /** Wrapper around std::unique_lock<CCriticalSection> */
 class SCOPED_LOCKABLE CCriticalBlock
 {
 private:
     std::unique_lock<CCriticalSection> lock;
 
+    // Only set while fLockStats was on when the lock was taken
+    const char* pszStatsName;
+    const char* pszStatsFile;
+    int nStatsLine;
+    bool fStatsContended;
+    int64_t nStatsWaitMicros;
+    std::chrono::steady_clock::time_point timeAcquired;
+
     void Enter(const char* pszName, const char* pszFile, int nLine)
     {
         EnterCritical(pszName, pszFile, nLine, (void*)(lock.mutex()));
+        if (fLockStats.load(std::memory_order_relaxed)) {
+            std::chrono::steady_clock::time_point timeStart = std::chrono::steady_clock::now();
+            fStatsContended = !lock.try_lock();
+            if (fStatsContended)
+                lock.lock();
+            timeAcquired = std::chrono::steady_clock::now();
+            nStatsWaitMicros = std::chrono::duration_cast<std::chrono::microseconds>(timeAcquired - timeStart).count();
+            pszStatsName = pszName;
+            pszStatsFile = pszFile;
+            nStatsLine = nLine;
+            return;
+        }
 #ifdef DEBUG_LOCKCONTENTION
         if (!lock.try_lock()) {
             PrintLockContention(pszName, pszFile, nLine);
@@ -136,11 +188,17 @@ private:
         lock.try_lock();
         if (!lock.owns_lock())
             LeaveCritical();
+        else if (fLockStats.load(std::memory_order_relaxed)) {
+            timeAcquired = std::chrono::steady_clock::now();
+            pszStatsName = pszName;
+            pszStatsFile = pszFile;
+            nStatsLine = nLine;
+        }
         return lock.owns_lock();
     }
 
 public:
-    CCriticalBlock(CCriticalSection& mutexIn, const char* pszName, const char* pszFile, int nLine, bool fTry = false) EXCLUSIVE_LOCK_FUNCTION(mutexIn) : lock(mutexIn, std::defer_lock)
+    CCriticalBlock(CCriticalSection& mutexIn, const char* pszName, const char* pszFile, int nLine, bool fTry = false) EXCLUSIVE_LOCK_FUNCTION(mutexIn) : lock(mutexIn, std::defer_lock), pszStatsName(nullptr), fStatsContended(false), nStatsWaitMicros(0)
     {
         if (fTry)
             TryEnter(pszName, pszFile, nLine);
@@ -148,7 +206,7 @@ public:
             Enter(pszName, pszFile, nLine);
     }
 
-    CCriticalBlock(CCriticalSection* pmutexIn, const char* pszName, const char* pszFile, int nLine, bool fTry = false) EXCLUSIVE_LOCK_FUNCTION(pmutexIn)
+    CCriticalBlock(CCriticalSection* pmutexIn, const char* pszName, const char* pszFile, int nLine, bool fTry = false) EXCLUSIVE_LOCK_FUNCTION(pmutexIn) : pszStatsName(nullptr), fStatsContended(false), nStatsWaitMicros(0)
     {
         if (!pmutexIn) return;
 
@@ -161,8 +219,19 @@ public:
 
     ~CCriticalBlock() UNLOCK_FUNCTION()
     {
-        if (lock.owns_lock())
+        if (!lock.owns_lock())
+            return;
+        if (!pszStatsName) {
             LeaveCritical();
+            return;
+        }
+        // Release the lock before recording, so the bookkeeping isn't counted
+        // as hold time and doesn't delay the next owner
+        std::chrono::steady_clock::time_point timeReleased = std::chrono::steady_clock::now();
+        lock.unlock();
+        LeaveCritical();
+        int64_t nHoldMicros = std::chrono::duration_cast<std::chrono::microseconds>(timeReleased - timeAcquired).count();
+        RecordLockStats(pszStatsName, pszStatsFile, nStatsLine, fStatsContended, nStatsWaitMicros, nHoldMicros);
     }
 
     operator bool()
@@ -0,0 +1,99 @@
+// Copyright (c) 2018-2019 The KYD developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockcache.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(blockcache_tests)
+
+static std::shared_ptr<const CBlock> MakeBlock(unsigned int nNonce)
+{
+    std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
+    pblock->nNonce = nNonce;
+    return pblock;
+}
+
+static void CheckStats(const CBlockCache& cache, size_t nEntries, size_t nSize, uint64_t nHits, uint64_t nMisses)
+{
+    size_t nEntriesOut, nSizeOut;
+    uint64_t nHitsOut, nMissesOut;
+    cache.GetStats(nEntriesOut, nSizeOut, nHitsOut, nMissesOut);
+    BOOST_CHECK_EQUAL(nEntriesOut, nEntries);
+    BOOST_CHECK_EQUAL(nSizeOut, nSize);
+    BOOST_CHECK_EQUAL(nHitsOut, nHits);
+    BOOST_CHECK_EQUAL(nMissesOut, nMisses);
+}
+
+BOOST_AUTO_TEST_CASE(blockcache_hits)
+{
+    CBlockCache cache;
+    cache.SetMaxSize(1000);
+    BOOST_CHECK(cache.IsEnabled());
+
+    CDiskBlockPos pos(1, 100);
+    BOOST_CHECK(!cache.Get(pos));
+    std::shared_ptr<const CBlock> pblock = MakeBlock(1);
+    cache.Insert(pos, pblock, 100);
+
+    // A hit hands out the cached block itself, not a copy
+    BOOST_CHECK(cache.Get(pos) == pblock);
+    BOOST_CHECK(!cache.Get(CDiskBlockPos(1, 101)));
+    BOOST_CHECK(!cache.Get(CDiskBlockPos(2, 100)));
+    CheckStats(cache, 1, 100, 1, 3);
+
+    // Inserting the same position again keeps the first entry
+    cache.Insert(pos, MakeBlock(2), 100);
+    BOOST_CHECK(cache.Get(pos) == pblock);
+    CheckStats(cache, 1, 100, 2, 3);
+
+    cache.Clear();
+    BOOST_CHECK(!cache.Get(pos));
+    CheckStats(cache, 0, 0, 2, 4);
+}
+
+BOOST_AUTO_TEST_CASE(blockcache_eviction)
+{
+    CBlockCache cache;
+    cache.SetMaxSize(300);
+
+    cache.Insert(CDiskBlockPos(0, 1), MakeBlock(1), 100);
+    cache.Insert(CDiskBlockPos(0, 2), MakeBlock(2), 100);
+    cache.Insert(CDiskBlockPos(0, 3), MakeBlock(3), 100);
+    CheckStats(cache, 3, 300, 0, 0);
+
+    // Using block 1 makes block 2 the least recently used
+    BOOST_CHECK(cache.Get(CDiskBlockPos(0, 1)));
+    cache.Insert(CDiskBlockPos(0, 4), MakeBlock(4), 100);
+    BOOST_CHECK(!cache.Get(CDiskBlockPos(0, 2)));
+    BOOST_CHECK(cache.Get(CDiskBlockPos(0, 1)));
+    BOOST_CHECK(cache.Get(CDiskBlockPos(0, 3)));
+    BOOST_CHECK(cache.Get(CDiskBlockPos(0, 4)));
+
+    // A large block evicts as many entries as needed
+    cache.Insert(CDiskBlockPos(0, 5), MakeBlock(5), 250);
+    BOOST_CHECK(cache.Get(CDiskBlockPos(0, 5)));
+    BOOST_CHECK(!cache.Get(CDiskBlockPos(0, 1)));
+    BOOST_CHECK(!cache.Get(CDiskBlockPos(0, 3)));
+    BOOST_CHECK(!cache.Get(CDiskBlockPos(0, 4)));
+
+    // A block larger than the whole cache is not cached and evicts nothing
+    cache.Insert(CDiskBlockPos(0, 6), MakeBlock(6), 301);
+    BOOST_CHECK(!cache.Get(CDiskBlockPos(0, 6)));
+    BOOST_CHECK(cache.Get(CDiskBlockPos(0, 5)));
+
+    // Shrinking the cache evicts, and a size of 0 disables it
+    cache.SetMaxSize(200);
+    BOOST_CHECK(!cache.Get(CDiskBlockPos(0, 5)));
+    cache.SetMaxSize(0);
+    BOOST_CHECK(!cache.IsEnabled());
+    cache.Insert(CDiskBlockPos(0, 7), MakeBlock(7), 1);
+    size_t nEntries, nSize;
+    uint64_t nHits, nMisses;
+    cache.GetStats(nEntries, nSize, nHits, nMisses);
+    BOOST_CHECK_EQUAL(nEntries, 0U);
+    BOOST_CHECK_EQUAL(nSize, 0U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,176 @@
+// Copyright (c) 2018-2019 The KYD developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "checkqueue.h"
+#include "coins.h"
+#include "main.h"
+#include "random.h"
+#include "script/interpreter.h"
+
+#include <atomic>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(checkqueue_tests)
+
+/** Counts its calls and returns fOk */
+struct CountingCheck {
+    static std::atomic<int> nCalls;
+    bool fOk;
+
+    CountingCheck(bool fOkIn = true) : fOk(fOkIn) {}
+
+    bool operator()()
+    {
+        nCalls++;
+        return fOk;
+    }
+
+    void swap(CountingCheck& check)
+    {
+        std::swap(fOk, check.fOk);
+    }
+};
+
+std::atomic<int> CountingCheck::nCalls(0);
+
+static bool ReturnBool(std::atomic<int>* pnCalls, bool fRet)
+{
+    (*pnCalls)++;
+    return fRet;
+}
+
+/** A queue with nWorkers worker threads, stopped when it goes out of scope */
+template <typename T>
+struct CheckQueueWorkers {
+    CCheckQueue<T> queue;
+    boost::thread_group threads;
+
+    CheckQueueWorkers(unsigned int nBatchSize, unsigned int nWorkers) : queue(nBatchSize, nWorkers)
+    {
+        for (unsigned int i = 0; i < nWorkers; i++)
+            threads.create_thread(boost::bind(&CCheckQueue<T>::Thread, &queue));
+    }
+
+    ~CheckQueueWorkers()
+    {
+        threads.interrupt_all();
+        threads.join_all();
+    }
+};
+
+/** Add nTotal checks to queue, in batches of random sizes up to nMaxBatch, the nFail'th one failing */
+static void AddChecks(CCheckQueueControl<CountingCheck>& control, int nTotal, int nMaxBatch, int nFail = -1)
+{
+    int nAdded = 0;
+    while (nAdded < nTotal) {
+        int nBatch = std::min(nTotal - nAdded, (int)(insecure_rand() % (nMaxBatch + 1)));
+        std::vector<CountingCheck> vChecks;
+        for (int i = 0; i < nBatch; i++, nAdded++)
+            vChecks.push_back(CountingCheck(nAdded != nFail));
+        control.Add(vChecks);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(checkqueue_all_checked)
+{
+    static const unsigned int nWorkerCounts[] = {0, 1, 2, 3, 7};
+    static const int nTotals[] = {0, 1, 2, 10, 127, 128, 129, 1000, 3001};
+    static const int nMaxBatches[] = {1, 16, 200, 5000};
+
+    for (unsigned int w = 0; w < sizeof(nWorkerCounts) / sizeof(nWorkerCounts[0]); w++) {
+        CheckQueueWorkers<CountingCheck> workers(128, nWorkerCounts[w]);
+        for (unsigned int t = 0; t < sizeof(nTotals) / sizeof(nTotals[0]); t++) {
+            for (unsigned int b = 0; b < sizeof(nMaxBatches) / sizeof(nMaxBatches[0]); b++) {
+                CountingCheck::nCalls = 0;
+                CCheckQueueControl<CountingCheck> control(&workers.queue);
+                AddChecks(control, nTotals[t], nMaxBatches[b]);
+                BOOST_CHECK(control.Wait());
+                BOOST_CHECK_EQUAL(CountingCheck::nCalls.load(), nTotals[t]);
+                BOOST_CHECK(workers.queue.IsIdle());
+            }
+        }
+        CCheckQueueStats stats;
+        workers.queue.GetStats(stats);
+        BOOST_CHECK(stats.nWorkers <= nWorkerCounts[w]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(checkqueue_failure)
+{
+    static const unsigned int nWorkerCounts[] = {0, 1, 3};
+
+    for (unsigned int w = 0; w < sizeof(nWorkerCounts) / sizeof(nWorkerCounts[0]); w++) {
+        CheckQueueWorkers<CountingCheck> workers(16, nWorkerCounts[w]);
+        for (int nFail = 0; nFail < 1000; nFail += 37) {
+            // A failing check anywhere fails the round
+            {
+                CCheckQueueControl<CountingCheck> control(&workers.queue);
+                AddChecks(control, 1000, 100, nFail);
+                BOOST_CHECK(!control.Wait());
+                BOOST_CHECK(workers.queue.IsIdle());
+            }
+            // and doesn't affect the next one
+            {
+                CountingCheck::nCalls = 0;
+                CCheckQueueControl<CountingCheck> control(&workers.queue);
+                AddChecks(control, 500, 100);
+                BOOST_CHECK(control.Wait());
+                BOOST_CHECK_EQUAL(CountingCheck::nCalls.load(), 500);
+                BOOST_CHECK(workers.queue.IsIdle());
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(checkqueue_blockcheck)
+{
+    // One output any input can spend and one none can
+    CMutableTransaction txFrom;
+    txFrom.vout.resize(2);
+    txFrom.vout[0].scriptPubKey = CScript() << OP_TRUE;
+    txFrom.vout[1].scriptPubKey = CScript() << OP_FALSE;
+    CCoins coins(txFrom, 1);
+
+    CMutableTransaction mtxTo;
+    mtxTo.vin.resize(2);
+    mtxTo.vin[0].prevout = COutPoint(txFrom.GetHash(), 0);
+    mtxTo.vin[1].prevout = COutPoint(txFrom.GetHash(), 1);
+    CTransaction txTo(mtxTo);
+
+    std::atomic<int> nCalls(0);
+    for (int nFail = 0; nFail < 3; nFail++) {
+        CheckQueueWorkers<CBlockCheck> workers(128, 2);
+        CCheckQueueControl<CBlockCheck> control(&workers.queue);
+        nCalls = 0;
+
+        // Script checks are taken over by a CBlockCheck as they are added
+        std::vector<CScriptCheck> vScriptChecks;
+        for (int i = 0; i < 50; i++)
+            vScriptChecks.push_back(CScriptCheck(coins, txTo, nFail == 1 && i == 25 ? 1 : 0, SCRIPT_VERIFY_NONE, false));
+        control.Add(vScriptChecks);
+
+        std::vector<CBlockCheck> vChecks;
+        for (int i = 0; i < 50; i++) {
+            if (i % 2) {
+                vChecks.push_back(CBlockCheck(boost::bind(&ReturnBool, &nCalls, !(nFail == 2 && i == 25))));
+            } else {
+                CScriptCheck check(coins, txTo, 0, SCRIPT_VERIFY_NONE, false);
+                vChecks.push_back(CBlockCheck());
+                vChecks.back().swap(check);
+            }
+        }
+        control.Add(vChecks);
+
+        BOOST_CHECK_EQUAL(control.Wait(), nFail == 0);
+        BOOST_CHECK(workers.queue.IsIdle());
+        if (nFail == 0)
+            BOOST_CHECK_EQUAL(nCalls.load(), 25);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
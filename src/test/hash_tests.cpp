@@ -5,6 +5,19 @@
 #include "hash.h"
 #include "utilstrencodings.h"
 
+#include "crypto/sph_blake.h"
+#include "crypto/sph_bmw.h"
+#include "crypto/sph_cubehash.h"
+#include "crypto/sph_echo.h"
+#include "crypto/sph_groestl.h"
+#include "crypto/sph_jh.h"
+#include "crypto/sph_keccak.h"
+#include "crypto/sph_luffa.h"
+#include "crypto/sph_shavite.h"
+#include "crypto/sph_simd.h"
+#include "crypto/sph_skein.h"
+
+#include <string>
 #include <vector>
 
 #include <boost/test/unit_test.hpp>
@@ -13,6 +26,78 @@ using namespace std;
 
 BOOST_AUTO_TEST_SUITE(hash_tests)
 
+// The X11 and Quark chains straight on the sph functions, as hash.h computed them
+// before crypto/x11.cpp picked an implementation per CPU
+#define REF_HASH512(name)                                                            \
+    static void Ref_##name(unsigned char* out, const unsigned char* in, size_t len) \
+    {                                                                                \
+        sph_##name##512_context ctx;                                                 \
+        sph_##name##512_init(&ctx);                                                  \
+        sph_##name##512(&ctx, in, len);                                              \
+        sph_##name##512_close(&ctx, out);                                            \
+    }
+
+REF_HASH512(blake)
+REF_HASH512(bmw)
+REF_HASH512(groestl)
+REF_HASH512(jh)
+REF_HASH512(keccak)
+REF_HASH512(skein)
+REF_HASH512(luffa)
+REF_HASH512(cubehash)
+REF_HASH512(shavite)
+REF_HASH512(simd)
+REF_HASH512(echo)
+
+#undef REF_HASH512
+
+static uint256 RefX11(const vector<unsigned char>& vch)
+{
+    static const unsigned char pblank[1] = {};
+    unsigned char a[64], b[64];
+    Ref_blake(a, vch.empty() ? pblank : &vch[0], vch.size());
+    Ref_bmw(b, a, 64);
+    Ref_groestl(a, b, 64);
+    Ref_jh(b, a, 64);
+    Ref_keccak(a, b, 64);
+    Ref_skein(b, a, 64);
+    Ref_luffa(a, b, 64);
+    Ref_cubehash(b, a, 64);
+    Ref_shavite(a, b, 64);
+    Ref_simd(b, a, 64);
+    Ref_echo(a, b, 64);
+    uint256 hash;
+    memcpy(hash.begin(), a, 32);
+    return hash;
+}
+
+static uint256 RefQuark(const vector<unsigned char>& vch)
+{
+    static const unsigned char pblank[1] = {};
+    unsigned char a[64], b[64];
+    Ref_blake(a, vch.empty() ? pblank : &vch[0], vch.size());
+    Ref_bmw(b, a, 64);
+    if (b[0] & 8)
+        Ref_groestl(a, b, 64);
+    else
+        Ref_skein(a, b, 64);
+    Ref_groestl(b, a, 64);
+    Ref_jh(a, b, 64);
+    if (a[0] & 8)
+        Ref_blake(b, a, 64);
+    else
+        Ref_bmw(b, a, 64);
+    Ref_keccak(a, b, 64);
+    Ref_skein(b, a, 64);
+    if (b[0] & 8)
+        Ref_keccak(a, b, 64);
+    else
+        Ref_jh(a, b, 64);
+    uint256 hash;
+    memcpy(hash.begin(), a, 32);
+    return hash;
+}
+
 BOOST_AUTO_TEST_CASE(murmurhash3)
 {
 
@@ -46,4 +131,40 @@ BOOST_AUTO_TEST_CASE(murmurhash3)
 #undef T
 }
 
+BOOST_AUTO_TEST_CASE(x11_quark_reference)
+{
+    // Both the generic and, where the CPU has it, the AES-NI implementation
+    for (int nAesni = 0; nAesni <= 1; nAesni++) {
+        BOOST_TEST_MESSAGE(std::string("X11 implementation: ") + X11SelectImplementation(nAesni));
+        vector<unsigned char> vch;
+        for (unsigned int nLen = 0; nLen <= 200; nLen++) {
+            BOOST_CHECK(Hash9(vch.begin(), vch.end()) == RefX11(vch));
+            BOOST_CHECK(HashQuark(vch.begin(), vch.end()) == RefQuark(vch));
+            vch.push_back((unsigned char)(nLen * 97 + 13));
+        }
+    }
+    X11SelectImplementation(true);
+}
+
+BOOST_AUTO_TEST_CASE(x11_quark_testvectors)
+{
+    // The mainnet genesis block header
+    const vector<unsigned char> vchGenesis = ParseHex("0100000000000000000000000000000000000000000000000000000000000000000000"
+                                                      "00166ee06ca607adf709c3bf7db1c5e87d943b739438812e17315dd50a31d3a86706c20c5cffff0f1ebb618200");
+    const std::string strFox = "The quick brown fox jumps over the lazy dog";
+    const vector<unsigned char> vchFox(strFox.begin(), strFox.end());
+    const vector<unsigned char> vchEmpty;
+
+    for (int nAesni = 0; nAesni <= 1; nAesni++) {
+        X11SelectImplementation(nAesni);
+        BOOST_CHECK_EQUAL(Hash9(vchEmpty.begin(), vchEmpty.end()).GetHex(), "41163a9bd78c0184185c194ee479b58108788cf9f82872ef7b54f3d9c5968fe7");
+        BOOST_CHECK_EQUAL(Hash9(vchGenesis.begin(), vchGenesis.end()).GetHex(), "00000a063178bcfbd2c7c7dc62702ec982b10d470032916eb4436a5865100d9b");
+        BOOST_CHECK_EQUAL(Hash9(vchFox.begin(), vchFox.end()).GetHex(), "589205105559f765eb54f844b1a551caa32ed7e1b983328959e770f03a6d2ee6");
+        BOOST_CHECK_EQUAL(HashQuark(vchEmpty.begin(), vchEmpty.end()).GetHex(), "9c7d513ab01c44694f7bc7c6a7e269a3eced7b2be24d8663835bf35a3bf10008");
+        BOOST_CHECK_EQUAL(HashQuark(vchGenesis.begin(), vchGenesis.end()).GetHex(), "c05cc2c351cfd04992dca6ee4ab660a8aa319d7cb985856bde1e6ac3bc3dc23e");
+        BOOST_CHECK_EQUAL(HashQuark(vchFox.begin(), vchFox.end()).GetHex(), "a51361c415e83def5c7c39e9ebc72913edb970a52403c91c04e2c9e96fceec70");
+    }
+    X11SelectImplementation(true);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,174 @@
+// Copyright (c) 2018-2019 The KYD developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "sync.h"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(lockstats_tests)
+
+static const char* pszSiteName = "site";
+
+/** Stats of the sites in this file, keyed by line, so locks taken elsewhere in the test binary don't interfere */
+static std::vector<CLockSiteStats> GetFileLockStats()
+{
+    std::vector<CLockSiteStats> vAll, vFile;
+    GetLockStats(vAll);
+    for (const CLockSiteStats& stats : vAll) {
+        if (stats.strFile == __FILE__)
+            vFile.push_back(stats);
+    }
+    return vFile;
+}
+
+static uint64_t BucketSum(const uint64_t* vBuckets)
+{
+    uint64_t nSum = 0;
+    for (int i = 0; i < LOCK_STATS_BUCKETS; i++)
+        nSum += vBuckets[i];
+    return nSum;
+}
+
+static std::atomic<int> nLockLine(0);
+static std::atomic<int> nTryLockLine(0);
+
+static void LockMany(CCriticalSection* pcs, int* pnShared, int nCount)
+{
+    for (int i = 0; i < nCount; i++) {
+        nLockLine = __LINE__ + 1;
+        LOCK(*pcs);
+        (*pnShared)++;
+    }
+    nTryLockLine = __LINE__ + 1;
+    TRY_LOCK(*pcs, lockTry);
+}
+
+BOOST_AUTO_TEST_CASE(lockstats_locks)
+{
+    fLockStats = true;
+    ResetLockStats();
+
+    // Every LOCK of every thread ends up in the same site
+    CCriticalSection cs;
+    int nShared = 0;
+    boost::thread_group threads;
+    for (int i = 0; i < 4; i++)
+        threads.create_thread(boost::bind(&LockMany, &cs, &nShared, 1000));
+    threads.join_all();
+    BOOST_CHECK_EQUAL(nShared, 4000);
+
+    std::vector<CLockSiteStats> vStats = GetFileLockStats();
+    int nSites = 0;
+    for (const CLockSiteStats& stats : vStats) {
+        if (stats.nLine == nLockLine) {
+            nSites++;
+            BOOST_CHECK_EQUAL(stats.strName, "*pcs");
+            BOOST_CHECK_EQUAL(stats.nLocks, 4000U);
+            BOOST_CHECK(stats.nContended <= stats.nLocks);
+            BOOST_CHECK_EQUAL(BucketSum(stats.vWait), stats.nLocks);
+            BOOST_CHECK_EQUAL(BucketSum(stats.vHold), stats.nLocks);
+            BOOST_CHECK(stats.nMaxWaitMicros <= stats.nWaitMicros);
+            BOOST_CHECK(stats.nMaxHoldMicros <= stats.nHoldMicros);
+        } else if (stats.nLine == nTryLockLine) {
+            // A TRY_LOCK never waits; it is only counted when it got the lock
+            nSites++;
+            BOOST_CHECK(stats.nLocks <= 4U);
+            BOOST_CHECK_EQUAL(stats.nContended, 0U);
+            BOOST_CHECK_EQUAL(stats.nWaitMicros, 0);
+        }
+    }
+    BOOST_CHECK(nSites >= 1 && nSites <= 2);
+
+    fLockStats = DEFAULT_LOCKSTATS;
+    ResetLockStats();
+}
+
+BOOST_AUTO_TEST_CASE(lockstats_disabled)
+{
+    fLockStats = false;
+    ResetLockStats();
+
+    CCriticalSection cs;
+    int nShared = 0;
+    LockMany(&cs, &nShared, 10);
+    BOOST_CHECK(GetFileLockStats().empty());
+
+    // Switching on takes effect with the next lock
+    fLockStats = true;
+    LockMany(&cs, &nShared, 10);
+    std::vector<CLockSiteStats> vStats = GetFileLockStats();
+    BOOST_CHECK_EQUAL(vStats.size(), 2U);
+
+    // A lock taken while off is not recorded when released while on
+    fLockStats = false;
+    {
+        LOCK(cs);
+        fLockStats = true;
+    }
+    BOOST_CHECK(GetFileLockStats().size() == vStats.size());
+
+    fLockStats = DEFAULT_LOCKSTATS;
+    ResetLockStats();
+}
+
+BOOST_AUTO_TEST_CASE(lockstats_shards)
+{
+    ResetLockStats();
+
+    // Many sites of one file spread over the shards and are all accumulated separately
+    for (int nLine = 1; nLine <= 500; nLine++) {
+        for (int i = 0; i < nLine % 7 + 1; i++)
+            RecordLockStats(pszSiteName, __FILE__, nLine, i % 2 == 0, nLine, 2 * nLine);
+    }
+
+    std::vector<CLockSiteStats> vStats = GetFileLockStats();
+    BOOST_CHECK_EQUAL(vStats.size(), 500U);
+    std::vector<bool> vSeen(501, false);
+    for (const CLockSiteStats& stats : vStats) {
+        BOOST_REQUIRE(stats.nLine >= 1 && stats.nLine <= 500);
+        BOOST_CHECK(!vSeen[stats.nLine]);
+        vSeen[stats.nLine] = true;
+
+        uint64_t nCount = stats.nLine % 7 + 1;
+        BOOST_CHECK_EQUAL(stats.strName, pszSiteName);
+        BOOST_CHECK_EQUAL(stats.nLocks, nCount);
+        BOOST_CHECK_EQUAL(stats.nContended, (nCount + 1) / 2);
+        BOOST_CHECK_EQUAL(stats.nWaitMicros, (int64_t)nCount * stats.nLine);
+        BOOST_CHECK_EQUAL(stats.nMaxWaitMicros, stats.nLine);
+        BOOST_CHECK_EQUAL(stats.nHoldMicros, (int64_t)nCount * 2 * stats.nLine);
+        BOOST_CHECK_EQUAL(stats.nMaxHoldMicros, 2 * stats.nLine);
+    }
+
+    ResetLockStats();
+    BOOST_CHECK(GetFileLockStats().empty());
+}
+
+BOOST_AUTO_TEST_CASE(lockstats_buckets)
+{
+    ResetLockStats();
+
+    // Bucket n counts times under 10^n microseconds, the last one everything else
+    static const int64_t nTimes[] = {0, 1, 9, 10, 99, 100, 999999, 1000000, 9999999, 10000000, 1000000000};
+    static const int nBuckets[] = {0, 1, 1, 2, 2, 3, 6, 7, 7, 7, 7};
+    for (unsigned int i = 0; i < sizeof(nTimes) / sizeof(nTimes[0]); i++) {
+        ResetLockStats();
+        RecordLockStats(pszSiteName, __FILE__, 1, false, nTimes[i], nTimes[i]);
+        std::vector<CLockSiteStats> vStats = GetFileLockStats();
+        BOOST_REQUIRE_EQUAL(vStats.size(), 1U);
+        for (int nBucket = 0; nBucket < LOCK_STATS_BUCKETS; nBucket++) {
+            BOOST_CHECK_EQUAL(vStats[0].vWait[nBucket], nBucket == nBuckets[i] ? 1U : 0U);
+            BOOST_CHECK_EQUAL(vStats[0].vHold[nBucket], nBucket == nBuckets[i] ? 1U : 0U);
+        }
+    }
+
+    ResetLockStats();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -49,4 +49,45 @@ BOOST_AUTO_TEST_CASE(subsidy_limit_test)
     BOOST_CHECK(nSum == 4109975100000000ULL);
 }
 
+BOOST_AUTO_TEST_CASE(supply_recalculation_start)
+{
+    const int nStart = 100;
+    const int nChain = 5000;
+
+    // Nothing recorded: both passes from the beginning
+    CSupplyRecalculation start = GetSupplyRecalculationStart(0, 0, nChain, nStart);
+    BOOST_CHECK(start.fZerocoin);
+    BOOST_CHECK_EQUAL(start.nHeightZerocoin, nStart);
+    BOOST_CHECK_EQUAL(start.nHeightMoney, 1);
+
+    // Chain not past the zerocoin start: no zKYD pass
+    start = GetSupplyRecalculationStart(0, 0, nStart, nStart);
+    BOOST_CHECK(!start.fZerocoin);
+    BOOST_CHECK_EQUAL(start.nHeightMoney, 1);
+
+    // Interrupted zKYD pass: resume it, then redo the whole KYD pass
+    start = GetSupplyRecalculationStart(2000, 3000, nChain, nStart);
+    BOOST_CHECK(start.fZerocoin);
+    BOOST_CHECK_EQUAL(start.nHeightZerocoin, 2000);
+    BOOST_CHECK_EQUAL(start.nHeightMoney, 1);
+
+    // Interrupted KYD pass: the zKYD pass is done
+    start = GetSupplyRecalculationStart(0, 3000, nChain, nStart);
+    BOOST_CHECK(!start.fZerocoin);
+    BOOST_CHECK_EQUAL(start.nHeightMoney, 3000);
+
+    // Heights that can't be resumed from start over
+    start = GetSupplyRecalculationStart(nChain + 1, 0, nChain, nStart);
+    BOOST_CHECK(start.fZerocoin);
+    BOOST_CHECK_EQUAL(start.nHeightZerocoin, nStart);
+    start = GetSupplyRecalculationStart(nStart, 0, nChain, nStart);
+    BOOST_CHECK_EQUAL(start.nHeightZerocoin, nStart);
+    start = GetSupplyRecalculationStart(0, nChain + 1, nChain, nStart);
+    BOOST_CHECK(start.fZerocoin);
+    BOOST_CHECK_EQUAL(start.nHeightMoney, 1);
+    start = GetSupplyRecalculationStart(0, nStart, nChain, nStart);
+    BOOST_CHECK(start.fZerocoin);
+    BOOST_CHECK_EQUAL(start.nHeightMoney, 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,79 @@
+// Copyright (c) 2018-2019 The KYD developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "obfuscation.h"
+#include "key.h"
+#include "random.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(obfuscation_tests)
+
+BOOST_AUTO_TEST_CASE(verified_message_cache)
+{
+    CVerifiedMessageCache cache(10);
+    CKeyID keyID(uint160(ParseHex("0102030405060708090a0b0c0d0e0f1011121314")));
+    CKeyID keyIDRet;
+
+    uint256 entry = GetRandHash();
+    BOOST_CHECK(!cache.Get(entry, keyIDRet));
+    cache.Set(entry, keyID);
+    BOOST_CHECK(cache.Get(entry, keyIDRet));
+    BOOST_CHECK(keyIDRet == keyID);
+
+    // The cache never grows past its size, evicting entries to make room
+    std::vector<uint256> vEntries;
+    for (int i = 0; i < 100; i++) {
+        vEntries.push_back(GetRandHash());
+        cache.Set(vEntries.back(), keyID);
+        BOOST_CHECK(cache.size() <= 10);
+    }
+    BOOST_CHECK_EQUAL(cache.size(), 10U);
+    BOOST_CHECK(cache.Get(vEntries.back(), keyIDRet));
+    int nFound = 0;
+    for (const uint256& hash : vEntries)
+        nFound += cache.Get(hash, keyIDRet);
+    BOOST_CHECK_EQUAL(nFound, 10);
+
+    // A size of 0 disables it
+    CVerifiedMessageCache cacheDisabled(0);
+    cacheDisabled.Set(entry, keyID);
+    BOOST_CHECK(!cacheDisabled.Get(entry, keyIDRet));
+    BOOST_CHECK_EQUAL(cacheDisabled.size(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(verify_message_signatures)
+{
+    CObfuScationSigner signer;
+    CKey key, keyOther;
+    key.MakeNewKey(true);
+    keyOther.MakeNewKey(true);
+    std::string strMessage = "masternode message " + GetRandHash().ToString();
+    std::string strError;
+
+    std::vector<unsigned char> vchSig;
+    BOOST_CHECK(signer.SignMessage(strMessage, strError, vchSig, key));
+
+    // Verifying twice gives the same answer, the second time from the cache
+    for (int i = 0; i < 2; i++) {
+        BOOST_CHECK(signer.VerifyMessage(key.GetPubKey(), vchSig, strMessage, strError));
+        BOOST_CHECK(!signer.VerifyMessage(keyOther.GetPubKey(), vchSig, strMessage, strError));
+        BOOST_CHECK(!signer.VerifyMessage(key.GetPubKey(), vchSig, strMessage + "x", strError));
+    }
+
+    // A signature that doesn't recover a key is rejected, cached or not
+    std::vector<unsigned char> vchBad(65, 0);
+    for (int i = 0; i < 2; i++) {
+        CKeyID keyIDRet;
+        BOOST_CHECK(!signer.RecoverMessageKey(vchBad, strMessage, keyIDRet, strError));
+        BOOST_CHECK(!signer.VerifyMessage(key.GetPubKey(), vchBad, strMessage, strError));
+    }
+
+    // A tampered signature doesn't verify for the signer
+    std::vector<unsigned char> vchTampered(vchSig);
+    vchTampered[10] ^= 1;
+    BOOST_CHECK(!signer.VerifyMessage(key.GetPubKey(), vchTampered, strMessage, strError));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
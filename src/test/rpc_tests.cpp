@@ -7,11 +7,16 @@
 #include "rpc/server.h"
 #include "rpc/client.h"
 
+#include "addressindex.h"
 #include "base58.h"
+#include "main.h"
+#include "txdb.h"
 #include "netbase.h"
 #include "util.h"
 
 #include <boost/algorithm/string.hpp>
+#include <boost/assign/list_of.hpp>
+#include <boost/thread.hpp>
 #include <boost/test/unit_test.hpp>
 
 #include <univalue.h>
@@ -183,6 +188,103 @@ BOOST_AUTO_TEST_CASE(json_parse_errors)
     BOOST_CHECK_THROW(ParseNonRFCJSONValue("3J98t1WpEZ73CNmQviecrnyiWrnqRhWNL"), std::runtime_error);
 }
 
+BOOST_AUTO_TEST_CASE(rpc_parallel_batch)
+{
+    UniValue vReq(UniValue::VARR);
+    for (int i = 0; i < 8; i++) {
+        UniValue req(UniValue::VOBJ);
+        req.push_back(Pair("method", i % 2 ? "getblockcount" : "validateaddress"));
+        UniValue params(UniValue::VARR);
+        if (i % 2 == 0)
+            params.push_back(strprintf("notanaddress%d", i));
+        req.push_back(Pair("params", params));
+        req.push_back(Pair("id", i));
+        vReq.push_back(req);
+    }
+    std::string strSerial = JSONRPCExecBatch(vReq);
+    BOOST_CHECK_EQUAL(strSerial.substr(0, 1), "[");
+
+    // Helpers running on other threads
+    boost::thread_group threads;
+    int nQueued = 0;
+    std::string strThreads = JSONRPCExecBatch(vReq, [&](const std::function<void()>& fn) {
+        nQueued++;
+        threads.create_thread(fn);
+        return true;
+    }, 3);
+    threads.join_all();
+    BOOST_CHECK_EQUAL(strThreads, strSerial);
+    BOOST_CHECK(nQueued <= 3);
+
+    // Helpers that only start after the batch is done find nothing left and queue no others
+    std::vector<std::function<void()> > vLate;
+    std::string strLate = JSONRPCExecBatch(vReq, [&](const std::function<void()>& fn) {
+        vLate.push_back(fn);
+        return true;
+    }, 7);
+    BOOST_CHECK_EQUAL(strLate, strSerial);
+    BOOST_CHECK_EQUAL(vLate.size(), 1U);
+    for (unsigned int i = 0; i < vLate.size(); i++)
+        vLate[i]();
+    BOOST_CHECK_EQUAL(vLate.size(), 1U);
+
+    // A full work queue leaves the batch to the calling thread
+    std::string strRefused = JSONRPCExecBatch(vReq, [](const std::function<void()>& fn) { return false; }, 3);
+    BOOST_CHECK_EQUAL(strRefused, strSerial);
+}
+
+BOOST_AUTO_TEST_CASE(rpc_addressindex)
+{
+    CKeyID keyID(uint160(ParseHex("0102030405060708090a0b0c0d0e0f1011121314")));
+    std::string strAddress = CBitcoinAddress(keyID).ToString();
+    std::string strObject = "{\"addresses\":[\"" + strAddress + "\"]}";
+
+    // A single address is passed on as a string, an object is parsed
+    UniValue params = RPCConvertValues("getaddressbalance", boost::assign::list_of(strAddress));
+    BOOST_CHECK(params[0].isStr());
+    params = RPCConvertValues("getaddresstxids", boost::assign::list_of(strObject));
+    BOOST_CHECK(params[0].isObject());
+    BOOST_CHECK_THROW(RPCConvertValues("getaddressutxos", boost::assign::list_of("{\"addresses\":")), runtime_error);
+
+    BOOST_CHECK_THROW(CallRPC("getaddressbalance " + strAddress), runtime_error);
+    fAddressIndex = true;
+
+    uint256 txid1 = uint256S("0xaa"), txid2 = uint256S("0xbb");
+    std::vector<std::pair<CAddressIndexKey, CAmount> > vIndex;
+    vIndex.push_back(std::make_pair(CAddressIndexKey(ADDRESS_INDEX_PUBKEYHASH, keyID, 10, 1, txid1, 0, false), 50 * COIN));
+    vIndex.push_back(std::make_pair(CAddressIndexKey(ADDRESS_INDEX_PUBKEYHASH, keyID, 20, 1, txid2, 0, true), -20 * COIN));
+    BOOST_CHECK(pblocktree->WriteAddressIndex(vIndex));
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > vUnspent;
+    vUnspent.push_back(std::make_pair(CAddressUnspentKey(ADDRESS_INDEX_PUBKEYHASH, keyID, txid2, 1), CAddressUnspentValue(30 * COIN, GetScriptForDestination(keyID), 20)));
+    BOOST_CHECK(pblocktree->UpdateAddressUnspentIndex(vUnspent));
+
+    UniValue r;
+    BOOST_CHECK_NO_THROW(r = CallRPC("getaddressbalance " + strAddress));
+    BOOST_CHECK_EQUAL(find_value(r.get_obj(), "balance").get_int64(), 30 * COIN);
+    BOOST_CHECK_EQUAL(find_value(r.get_obj(), "received").get_int64(), 50 * COIN);
+    BOOST_CHECK_NO_THROW(r = CallRPC("getaddressbalance " + strObject));
+    BOOST_CHECK_EQUAL(find_value(r.get_obj(), "balance").get_int64(), 30 * COIN);
+
+    BOOST_CHECK_NO_THROW(r = CallRPC("getaddresstxids " + strAddress));
+    BOOST_CHECK_EQUAL(r.size(), 2U);
+    BOOST_CHECK_EQUAL(r[0].get_str(), txid1.GetHex());
+    BOOST_CHECK_EQUAL(r[1].get_str(), txid2.GetHex());
+    BOOST_CHECK_NO_THROW(r = CallRPC("getaddresstxids {\"addresses\":[\"" + strAddress + "\"],\"start\":15,\"end\":25}"));
+    BOOST_CHECK_EQUAL(r.size(), 1U);
+    BOOST_CHECK_THROW(CallRPC("getaddresstxids {\"addresses\":[\"" + strAddress + "\"],\"start\":25,\"end\":15}"), runtime_error);
+
+    BOOST_CHECK_NO_THROW(r = CallRPC("getaddressutxos " + strAddress));
+    BOOST_CHECK_EQUAL(r.size(), 1U);
+    BOOST_CHECK_EQUAL(find_value(r[0].get_obj(), "address").get_str(), strAddress);
+    BOOST_CHECK_EQUAL(find_value(r[0].get_obj(), "txid").get_str(), txid2.GetHex());
+    BOOST_CHECK_EQUAL(find_value(r[0].get_obj(), "satoshis").get_int64(), 30 * COIN);
+
+    BOOST_CHECK_THROW(CallRPC("getaddressbalance notanaddress"), runtime_error);
+    BOOST_CHECK_THROW(CallRPC("getaddressutxos {\"addresses\":\"" + strAddress + "\"}"), runtime_error);
+
+    fAddressIndex = false;
+}
+
 BOOST_AUTO_TEST_CASE(rpc_ban)
 {
     BOOST_CHECK_NO_THROW(CallRPC(string("clearbanned")));
@@ -2,6 +2,8 @@
 // Distributed under the MIT/X11 software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include "chain.h"
+#include "clientversion.h"
 #include "serialize.h"
 #include "streams.h"
 
@@ -161,4 +163,93 @@ BOOST_AUTO_TEST_CASE(insert_delete)
     BOOST_CHECK_EQUAL(ss.size(), 0);
 }
 
+BOOST_AUTO_TEST_CASE(zerocoin_supply)
+{
+    // CZerocoinSupply is written exactly like the map it replaced
+    std::map<libzerocoin::CoinDenomination, int64_t> mapSupply;
+    CZerocoinSupply supply;
+    int64_t n = 1;
+    for (auto& denom : libzerocoin::zerocoinDenomList) {
+        mapSupply[denom] = n;
+        supply.at(denom) = n;
+        n *= 7;
+    }
+    CDataStream ssMap(SER_DISK, CLIENT_VERSION), ssSupply(SER_DISK, CLIENT_VERSION);
+    ssMap << mapSupply;
+    ssSupply << supply;
+    BOOST_CHECK(ssMap.str() == ssSupply.str());
+    BOOST_CHECK_EQUAL(ssSupply.size(), ::GetSerializeSize(supply, SER_DISK, CLIENT_VERSION));
+
+    CZerocoinSupply supply2;
+    ssMap >> supply2;
+    for (auto& denom : libzerocoin::zerocoinDenomList)
+        BOOST_CHECK_EQUAL(supply2.at(denom), supply.at(denom));
+    BOOST_CHECK_THROW(supply2.at(libzerocoin::ZQ_ERROR), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(diskblockindex_roundtrip)
+{
+    uint256 hashBlock = uint256S("0x1234");
+    CBlockIndex index;
+    index.phashBlock = &hashBlock;
+    index.nHeight = 123456;
+    index.nStatus = BLOCK_VALID_SCRIPTS | BLOCK_HAVE_DATA | BLOCK_HAVE_UNDO;
+    index.nTx = 17;
+    index.nFile = 3;
+    index.nDataPos = 4096;
+    index.nUndoPos = 512;
+    index.nMint = 5 * COIN;
+    index.nMoneySupply = 1000000 * COIN;
+    index.nStakeModifier = 0x0123456789abcdefULL;
+    index.SetProofOfStake();
+    index.prevoutStake = COutPoint(uint256S("0xabcd"), 2);
+    index.nStakeTime = 1550000000;
+    index.nVersion = 4;
+    index.hashMerkleRoot = uint256S("0x5678");
+    index.nTime = 1550000001;
+    index.nBits = 0x1d00ffff;
+    index.nNonce = 42;
+    index.nAccumulatorCheckpoint = uint256S("0x9abc");
+    int64_t n = 3;
+    for (auto& denom : libzerocoin::zerocoinDenomList)
+        index.mapZerocoinSupply.at(denom) = n++;
+    index.vMintDenominationsInBlock = {libzerocoin::ZQ_ONE, libzerocoin::ZQ_FIFTY, libzerocoin::ZQ_ONE};
+
+    CDiskBlockIndex diskindex(&index);
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << diskindex;
+    std::string strSerialized = ss.str();
+
+    CDiskBlockIndex diskindex2;
+    ss >> diskindex2;
+    BOOST_CHECK(ss.empty());
+    BOOST_CHECK_EQUAL(diskindex2.nHeight, index.nHeight);
+    BOOST_CHECK_EQUAL(diskindex2.nStatus, index.nStatus);
+    BOOST_CHECK_EQUAL(diskindex2.nTx, index.nTx);
+    BOOST_CHECK_EQUAL(diskindex2.nFile, index.nFile);
+    BOOST_CHECK_EQUAL(diskindex2.nDataPos, index.nDataPos);
+    BOOST_CHECK_EQUAL(diskindex2.nUndoPos, index.nUndoPos);
+    BOOST_CHECK_EQUAL(diskindex2.nMint, index.nMint);
+    BOOST_CHECK_EQUAL(diskindex2.nMoneySupply, index.nMoneySupply);
+    BOOST_CHECK_EQUAL(diskindex2.nFlags, index.nFlags);
+    BOOST_CHECK_EQUAL(diskindex2.nStakeModifier, index.nStakeModifier);
+    BOOST_CHECK(diskindex2.prevoutStake == index.prevoutStake);
+    BOOST_CHECK_EQUAL(diskindex2.nStakeTime, index.nStakeTime);
+    BOOST_CHECK_EQUAL(diskindex2.nVersion, index.nVersion);
+    BOOST_CHECK(diskindex2.hashPrev == uint256());
+    BOOST_CHECK(diskindex2.hashMerkleRoot == index.hashMerkleRoot);
+    BOOST_CHECK_EQUAL(diskindex2.nTime, index.nTime);
+    BOOST_CHECK_EQUAL(diskindex2.nBits, index.nBits);
+    BOOST_CHECK_EQUAL(diskindex2.nNonce, index.nNonce);
+    BOOST_CHECK(diskindex2.nAccumulatorCheckpoint == index.nAccumulatorCheckpoint);
+    for (auto& denom : libzerocoin::zerocoinDenomList)
+        BOOST_CHECK_EQUAL(diskindex2.mapZerocoinSupply.at(denom), index.mapZerocoinSupply.at(denom));
+    BOOST_CHECK(diskindex2.vMintDenominationsInBlock == index.vMintDenominationsInBlock);
+
+    // Writing it back gives the same bytes
+    CDataStream ss2(SER_DISK, CLIENT_VERSION);
+    ss2 << diskindex2;
+    BOOST_CHECK(ss2.str() == strSerialized);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -6,6 +6,7 @@
 
 #define BOOST_TEST_MODULE Kyd Test Suite
 
+#include "crypto/sha256.h"
 #include "main.h"
 #include "random.h"
 #include "txdb.h"
@@ -33,6 +34,7 @@ struct TestingSetup {
     ECCVerifyHandle globalVerifyHandle;
 
     TestingSetup() {
+        SHA256AutoDetect();
         ECC_Start();
         SetupEnvironment();
         fPrintToDebugLog = false; // don't want to write to debug.log file
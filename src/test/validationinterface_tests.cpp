@@ -0,0 +1,182 @@
+// Copyright (c) 2018-2019 The KYD developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "validationinterface.h"
+
+#include "main.h"
+#include "primitives/block.h"
+#include "utiltime.h"
+
+#include <atomic>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(validationinterface_tests)
+
+namespace {
+
+class CCountingListener : public CValidationInterface
+{
+public:
+    boost::mutex cs;
+    std::vector<uint256> vChecked;
+    std::vector<uint256> vConnected;
+    int nTransactions;
+    boost::thread::id idLast;
+
+    CCountingListener() : nTransactions(0) {}
+
+protected:
+    void BlockChecked(const CBlock& block, const CValidationState&)
+    {
+        boost::unique_lock<boost::mutex> lock(cs);
+        vChecked.push_back(block.GetHash());
+        idLast = boost::this_thread::get_id();
+    }
+
+    void BlockConnected(const CBlock& block, const CBlockIndex*)
+    {
+        boost::unique_lock<boost::mutex> lock(cs);
+        vConnected.push_back(block.GetHash());
+        idLast = boost::this_thread::get_id();
+    }
+
+    void SyncTransaction(const CTransaction&, const CBlock*)
+    {
+        boost::unique_lock<boost::mutex> lock(cs);
+        nTransactions++;
+        idLast = boost::this_thread::get_id();
+    }
+};
+
+CBlock MakeBlock(unsigned int nNonce)
+{
+    CBlock block;
+    block.nNonce = nNonce;
+    block.vtx.resize(2);
+    return block;
+}
+
+/** Counts BlockChecked notifications, each one waiting until cs_gate can be taken */
+class CGatedListener : public CValidationInterface
+{
+public:
+    boost::mutex cs_gate;
+    std::atomic<int> nChecked;
+
+    CGatedListener() : nChecked(0) {}
+
+protected:
+    void BlockChecked(const CBlock&, const CValidationState&)
+    {
+        boost::unique_lock<boost::mutex> lock(cs_gate);
+        nChecked++;
+    }
+};
+
+void RaiseBlockChecked(int nCount, std::atomic<int>* pnRaised)
+{
+    CBlock block = MakeBlock(0);
+    CValidationState state;
+    for (int i = 0; i < nCount; i++) {
+        GetMainSignals().BlockChecked(block, state);
+        (*pnRaised)++;
+    }
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(validation_queue)
+{
+    CCountingListener listenerAsync, listenerSync;
+    RegisterValidationInterface(&listenerAsync, true, "async");
+    RegisterValidationInterface(&listenerSync);
+
+    boost::thread_group threads;
+    StartValidationQueue(threads);
+
+    CValidationState state;
+    std::vector<uint256> vHashes;
+    for (unsigned int i = 0; i < 20; i++) {
+        // The block is a temporary that is gone before the notification is delivered
+        {
+            CBlock block = MakeBlock(i);
+            vHashes.push_back(block.GetHash());
+            GetMainSignals().BlockChecked(block, state);
+            for (const CTransaction& tx : block.vtx)
+                GetMainSignals().SyncTransaction(tx, &block);
+            GetMainSignals().BlockConnected(block, NULL);
+        }
+    }
+
+    // Synchronous listeners are up to date without waiting
+    SyncWithValidationQueue(&listenerSync);
+    BOOST_CHECK(listenerSync.vChecked == vHashes);
+    BOOST_CHECK(listenerSync.idLast == boost::this_thread::get_id());
+
+    // Asynchronous ones once the queue caught up, in order, on the queue thread
+    SyncWithValidationQueue(&listenerAsync);
+    {
+        boost::unique_lock<boost::mutex> lock(listenerAsync.cs);
+        BOOST_CHECK(listenerAsync.vChecked == vHashes);
+        BOOST_CHECK(listenerAsync.vConnected == vHashes);
+        BOOST_CHECK_EQUAL(listenerAsync.nTransactions, 40);
+        BOOST_CHECK(listenerAsync.idLast != boost::this_thread::get_id());
+    }
+
+    // An interrupted queue thread doesn't leave Sync() waiting, and later
+    // notifications are delivered on the calling thread
+    threads.interrupt_all();
+    threads.join_all();
+    CBlock block = MakeBlock(100);
+    GetMainSignals().BlockChecked(block, state);
+    SyncWithValidationQueue(&listenerAsync);
+    {
+        boost::unique_lock<boost::mutex> lock(listenerAsync.cs);
+        BOOST_CHECK_EQUAL(listenerAsync.vChecked.size(), 21U);
+        BOOST_CHECK(listenerAsync.vChecked.back() == block.GetHash());
+        BOOST_CHECK(listenerAsync.idLast == boost::this_thread::get_id());
+    }
+
+    StopValidationQueue();
+    UnregisterValidationInterface(&listenerAsync);
+    UnregisterValidationInterface(&listenerSync);
+
+    // An unregistered listener is not waited for
+    SyncWithValidationQueue(&listenerAsync);
+}
+
+BOOST_AUTO_TEST_CASE(validation_queue_full)
+{
+    CGatedListener listener;
+    RegisterValidationInterface(&listener, true, "gated");
+
+    boost::thread_group threads;
+    StartValidationQueue(threads);
+
+    // While the listener is stuck on its first notification the queue fills up and the producer waits
+    const int nCount = (int)MAX_VALIDATION_QUEUE + 2;
+    std::atomic<int> nRaised(0);
+    boost::unique_lock<boost::mutex> lockGate(listener.cs_gate);
+    boost::thread producer(boost::bind(&RaiseBlockChecked, nCount, &nRaised));
+    for (int i = 0; i < 1000 && nRaised.load() <= (int)MAX_VALIDATION_QUEUE; i++)
+        MilliSleep(10);
+    BOOST_CHECK(!producer.timed_join(boost::posix_time::milliseconds(100)));
+    BOOST_CHECK_EQUAL(nRaised.load(), (int)MAX_VALIDATION_QUEUE + 1);
+
+    // and carries on once the listener does
+    lockGate.unlock();
+    producer.join();
+    SyncWithValidationQueue(&listener);
+    BOOST_CHECK_EQUAL(listener.nChecked.load(), nCount);
+
+    threads.interrupt_all();
+    threads.join_all();
+    StopValidationQueue();
+    UnregisterValidationInterface(&listener);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
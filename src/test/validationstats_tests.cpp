@@ -0,0 +1,140 @@
+// Copyright (c) 2018-2019 The KYD developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "validationstats.h"
+
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(validationstats_tests)
+
+static uint256 BlockHash(int nHeight)
+{
+    return uint256(nHeight + 1);
+}
+
+/** Connect the block at nHeight, nMicros spent connecting it */
+static void ConnectBlock(CValidationStats& stats, int nHeight, int64_t nMicros)
+{
+    stats.BeginBlock(BlockHash(nHeight), nHeight, 1);
+    stats.Add(VALIDATION_STAGE_CONNECT, nMicros);
+    stats.Add(VALIDATION_STAGE_CONNECT, nMicros);
+    stats.CommitBlock();
+}
+
+BOOST_AUTO_TEST_CASE(validationstats_ring)
+{
+    CValidationStats stats;
+    std::vector<CBlockValidationTimes> vRecent;
+    stats.GetRecent(10, vRecent);
+    BOOST_CHECK(vRecent.empty());
+
+    // Before the ring buffer is full
+    for (int nHeight = 0; nHeight < 10; nHeight++)
+        ConnectBlock(stats, nHeight, nHeight);
+    stats.GetRecent(20, vRecent);
+    BOOST_REQUIRE_EQUAL(vRecent.size(), 10U);
+    for (int i = 0; i < 10; i++) {
+        BOOST_CHECK_EQUAL(vRecent[i].nHeight, 9 - i);
+        BOOST_CHECK(vRecent[i].hashBlock == BlockHash(9 - i));
+        BOOST_CHECK_EQUAL(vRecent[i].vMicros[VALIDATION_STAGE_CONNECT], 2 * (9 - i));
+    }
+
+    // Once it wrapped around only the newest VALIDATION_STATS_BLOCKS are left, newest first
+    const int nBlocks = VALIDATION_STATS_BLOCKS * 2 + 10;
+    for (int nHeight = 10; nHeight < nBlocks; nHeight++)
+        ConnectBlock(stats, nHeight, nHeight);
+    stats.GetRecent(VALIDATION_STATS_BLOCKS + 100, vRecent);
+    BOOST_REQUIRE_EQUAL(vRecent.size(), VALIDATION_STATS_BLOCKS);
+    for (size_t i = 0; i < vRecent.size(); i++)
+        BOOST_CHECK_EQUAL(vRecent[i].nHeight, nBlocks - 1 - (int)i);
+
+    stats.GetRecent(3, vRecent);
+    BOOST_REQUIRE_EQUAL(vRecent.size(), 3U);
+    BOOST_CHECK_EQUAL(vRecent[0].nHeight, nBlocks - 1);
+    BOOST_CHECK_EQUAL(vRecent[2].nHeight, nBlocks - 3);
+
+    // Times added outside a block and a commit without a block are ignored
+    stats.Add(VALIDATION_STAGE_CONNECT, 1000);
+    stats.CommitBlock();
+    stats.GetRecent(1, vRecent);
+    BOOST_REQUIRE_EQUAL(vRecent.size(), 1U);
+    BOOST_CHECK_EQUAL(vRecent[0].nHeight, nBlocks - 1);
+    BOOST_CHECK_EQUAL(vRecent[0].vMicros[VALIDATION_STAGE_CONNECT], 2 * (nBlocks - 1));
+}
+
+BOOST_AUTO_TEST_CASE(validationstats_pending)
+{
+    CValidationStats stats;
+    std::vector<CBlockValidationTimes> vRecent;
+
+    // Stages recorded before the block is connected are merged into its record
+    stats.AddPending(BlockHash(0), VALIDATION_STAGE_CHECK_BLOCK, 5);
+    stats.AddPending(BlockHash(0), VALIDATION_STAGE_CHECK_BLOCK, 7);
+    stats.AddPending(BlockHash(0), VALIDATION_STAGE_CHECK_STAKE, 3);
+    stats.BeginBlock(BlockHash(0), 0, 1);
+    stats.Add(VALIDATION_STAGE_CHECK_BLOCK, 1);
+    stats.CommitBlock();
+    stats.GetRecent(1, vRecent);
+    BOOST_REQUIRE_EQUAL(vRecent.size(), 1U);
+    BOOST_CHECK_EQUAL(vRecent[0].vMicros[VALIDATION_STAGE_CHECK_BLOCK], 13);
+    BOOST_CHECK_EQUAL(vRecent[0].vMicros[VALIDATION_STAGE_CHECK_STAKE], 3);
+
+    // and only once
+    ConnectBlock(stats, 0, 0);
+    stats.GetRecent(1, vRecent);
+    BOOST_CHECK_EQUAL(vRecent[0].vMicros[VALIDATION_STAGE_CHECK_BLOCK], 0);
+
+    // At most VALIDATION_STATS_PENDING blocks that are not connected yet are kept
+    const int nPending = VALIDATION_STATS_PENDING + 50;
+    for (int nHeight = 1; nHeight <= nPending; nHeight++)
+        stats.AddPending(BlockHash(nHeight), VALIDATION_STAGE_CHECK_BLOCK, 1);
+    for (int nHeight = 1; nHeight <= nPending; nHeight++)
+        ConnectBlock(stats, nHeight, 0);
+    stats.GetRecent(nPending, vRecent);
+    BOOST_REQUIRE_EQUAL(vRecent.size(), (size_t)nPending);
+    size_t nMerged = 0;
+    for (const CBlockValidationTimes& times : vRecent)
+        nMerged += times.vMicros[VALIDATION_STAGE_CHECK_BLOCK];
+    BOOST_CHECK_EQUAL(nMerged, VALIDATION_STATS_PENDING);
+}
+
+BOOST_AUTO_TEST_CASE(validationstats_percentile)
+{
+    std::vector<int64_t> vSorted;
+    BOOST_CHECK_EQUAL(ValidationStagePercentile(vSorted, 50), 0);
+
+    vSorted.push_back(42);
+    BOOST_CHECK_EQUAL(ValidationStagePercentile(vSorted, 0), 42);
+    BOOST_CHECK_EQUAL(ValidationStagePercentile(vSorted, 50), 42);
+    BOOST_CHECK_EQUAL(ValidationStagePercentile(vSorted, 99), 42);
+
+    // 1..100: the n'th percentile is n
+    vSorted.clear();
+    for (int i = 1; i <= 100; i++)
+        vSorted.push_back(i);
+    BOOST_CHECK_EQUAL(ValidationStagePercentile(vSorted, 0), 1);
+    BOOST_CHECK_EQUAL(ValidationStagePercentile(vSorted, 1), 1);
+    BOOST_CHECK_EQUAL(ValidationStagePercentile(vSorted, 50), 50);
+    BOOST_CHECK_EQUAL(ValidationStagePercentile(vSorted, 90), 90);
+    BOOST_CHECK_EQUAL(ValidationStagePercentile(vSorted, 99), 99);
+    BOOST_CHECK_EQUAL(ValidationStagePercentile(vSorted, 100), 100);
+
+    // 1..10: a percentile falling between two values takes the higher one
+    vSorted.resize(10);
+    BOOST_CHECK_EQUAL(ValidationStagePercentile(vSorted, 50), 5);
+    BOOST_CHECK_EQUAL(ValidationStagePercentile(vSorted, 51), 6);
+    BOOST_CHECK_EQUAL(ValidationStagePercentile(vSorted, 90), 9);
+    BOOST_CHECK_EQUAL(ValidationStagePercentile(vSorted, 99), 10);
+
+    // A full ring buffer
+    vSorted.clear();
+    for (size_t i = 0; i < VALIDATION_STATS_BLOCKS; i++)
+        vSorted.push_back(i);
+    BOOST_CHECK_EQUAL(ValidationStagePercentile(vSorted, 50), 499);
+    BOOST_CHECK_EQUAL(ValidationStagePercentile(vSorted, 99), 989);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,170 @@
+// Copyright (c) 2018-2019 The KYD developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "chainparams.h"
+#include "txdb.h"
+#include "primitives/zerocoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(zerocoindb_tests)
+
+BOOST_AUTO_TEST_CASE(zerocoindb_read_mints)
+{
+    CZerocoinDB db(1 << 20, true, true);
+    std::vector<uint256> vHashPubcoin;
+    for (int i = 0; i < 20; i++) {
+        uint256 hash = uint256S(strprintf("%064x", i * 7 + 1));
+        vHashPubcoin.push_back(hash);
+        // every other pubcoin is in the database
+        if (i % 2 == 0)
+            BOOST_CHECK(db.Write(std::make_pair('m', hash), uint256S(strprintf("%064x", 1000 + i))));
+    }
+
+    std::map<uint256, uint256> mapHashTx;
+    BOOST_CHECK(db.ReadCoinMints(vHashPubcoin, mapHashTx));
+    BOOST_CHECK_EQUAL(mapHashTx.size(), 10U);
+    for (int i = 0; i < 20; i++) {
+        auto it = mapHashTx.find(vHashPubcoin[i]);
+        BOOST_CHECK_EQUAL(it != mapHashTx.end(), i % 2 == 0);
+        if (it != mapHashTx.end())
+            BOOST_CHECK(it->second == uint256S(strprintf("%064x", 1000 + i)));
+        uint256 hashTx;
+        BOOST_CHECK_EQUAL(db.ReadCoinMint(vHashPubcoin[i], hashTx), i % 2 == 0);
+    }
+
+    // A value that can't be deserialized is an error, not a missing mint
+    BOOST_CHECK(db.Write(std::make_pair('m', vHashPubcoin[4]), (unsigned char)1));
+    mapHashTx.clear();
+    BOOST_CHECK(!db.ReadCoinMints(vHashPubcoin, mapHashTx));
+
+    std::vector<std::pair<char, uint256> > vKeys;
+    vKeys.emplace_back('m', vHashPubcoin[2]);
+    vKeys.emplace_back('m', vHashPubcoin[4]);
+    std::vector<uint256> vValues;
+    std::vector<bool> vFound;
+    BOOST_CHECK(!db.MultiRead(vKeys, vValues, vFound));
+    BOOST_CHECK(vFound[0]);
+    BOOST_CHECK(!vFound[1]);
+}
+
+static std::vector<std::pair<libzerocoin::PublicCoin, uint256> > MakeMints(int nFirst, int nCount)
+{
+    std::vector<std::pair<libzerocoin::PublicCoin, uint256> > vMints;
+    for (int i = nFirst; i < nFirst + nCount; i++)
+        vMints.push_back(std::make_pair(libzerocoin::PublicCoin(Params().Zerocoin_Params(false), CBigNum(i), libzerocoin::ZQ_ONE), uint256(i)));
+    return vMints;
+}
+
+BOOST_AUTO_TEST_CASE(zerocoindb_filters)
+{
+    CZerocoinDB db(1 << 20, true, true);
+    BOOST_CHECK(db.WriteCoinMintBatch(MakeMints(1, 10)));
+    BOOST_CHECK(db.LoadFilters());
+
+    uint256 hashTx;
+    for (int i = 1; i <= 10; i++) {
+        BOOST_CHECK(db.ReadCoinMint(CBigNum(i), hashTx));
+        BOOST_CHECK(hashTx == uint256(i));
+    }
+    BOOST_CHECK(!db.ReadCoinMint(CBigNum(11), hashTx));
+
+    // Mints written after the filter was loaded are found too, including after the
+    // filter outgrew its size and was rebuilt from the database
+    BOOST_CHECK(db.WriteCoinMintBatch(MakeMints(11, ZEROCOIN_FILTER_MIN_ELEMENTS)));
+    BOOST_CHECK(db.WriteCoinMintBatch(MakeMints(ZEROCOIN_FILTER_MIN_ELEMENTS + 11, 10)));
+    for (int i = 1; i < ZEROCOIN_FILTER_MIN_ELEMENTS + 21; i += 997)
+        BOOST_CHECK(db.ReadCoinMint(CBigNum(i), hashTx));
+    for (int i = ZEROCOIN_FILTER_MIN_ELEMENTS + 11; i < ZEROCOIN_FILTER_MIN_ELEMENTS + 21; i++)
+        BOOST_CHECK(db.ReadCoinMint(CBigNum(i), hashTx));
+
+    // Erased mints stay in the filter but are not found
+    BOOST_CHECK(db.EraseCoinMint(CBigNum(5)));
+    BOOST_CHECK(!db.ReadCoinMint(CBigNum(5), hashTx));
+}
+
+BOOST_AUTO_TEST_CASE(zerocoindb_height_index)
+{
+    CZerocoinDB db(1 << 20, true, true);
+    std::vector<std::pair<libzerocoin::PublicCoin, uint256> > vMints = MakeMints(1, 6);
+    std::vector<int> vHeights = {30, 10, 20, 10, 40, 50};
+    BOOST_CHECK(db.WriteCoinMintBatch(vMints, vHeights));
+    // An unrelated spend, which the height index keeps apart from the mints
+    uint256 hashSerial = uint256S("0x55");
+    BOOST_CHECK(db.Write(std::make_pair('s', hashSerial), uint256(99)));
+    BOOST_CHECK(db.Write(std::make_pair('h', CZerocoinHeightKey('s', 15, hashSerial)), uint256(99)));
+
+    std::vector<CZerocoinIndexEntry> vEntries;
+    BOOST_CHECK(db.ReadCoinsInRange('m', 10, 30, vEntries));
+    BOOST_CHECK_EQUAL(vEntries.size(), 4U);
+    for (unsigned int i = 1; i < vEntries.size(); i++)
+        BOOST_CHECK(vEntries[i - 1].nHeight <= vEntries[i].nHeight);
+    BOOST_CHECK_EQUAL(vEntries[0].nHeight, 10);
+    BOOST_CHECK_EQUAL(vEntries[3].nHeight, 30);
+    BOOST_CHECK(vEntries[3].hash == GetPubCoinHash(CBigNum(1)));
+    BOOST_CHECK(vEntries[3].txid == uint256(1));
+
+    vEntries.clear();
+    BOOST_CHECK(db.ReadCoinsInRange('s', 0, 100, vEntries));
+    BOOST_CHECK_EQUAL(vEntries.size(), 1U);
+    BOOST_CHECK(vEntries[0].hash == hashSerial);
+
+    // Erasing with the height removes the index entry as well
+    BOOST_CHECK(db.EraseCoinMint(CBigNum(5), 40));
+    vEntries.clear();
+    BOOST_CHECK(db.ReadCoinsInRange('m', 40, 40, vEntries));
+    BOOST_CHECK(vEntries.empty());
+
+    // Wiping the heights keeps the coins, wiping the mints keeps the spends
+    BOOST_CHECK(!db.WipeCoins("unknown"));
+    BOOST_CHECK(db.WipeCoins("heights"));
+    vEntries.clear();
+    BOOST_CHECK(db.ReadCoinsInRange('m', 0, 100, vEntries));
+    BOOST_CHECK(db.ReadCoinsInRange('s', 0, 100, vEntries));
+    BOOST_CHECK(vEntries.empty());
+    uint256 hashTx;
+    BOOST_CHECK(db.ReadCoinMint(CBigNum(1), hashTx));
+
+    BOOST_CHECK(db.WipeCoins("mints"));
+    BOOST_CHECK(!db.ReadCoinMint(CBigNum(1), hashTx));
+    BOOST_CHECK(db.ReadCoinSpend(hashSerial, hashTx));
+    BOOST_CHECK(hashTx == uint256(99));
+}
+
+BOOST_AUTO_TEST_CASE(zerocoindb_height_index_disconnect)
+{
+    CZerocoinDB db(1 << 20, true, true);
+    std::vector<std::pair<libzerocoin::PublicCoin, uint256> > vMints = MakeMints(1, 3);
+    std::vector<int> vHeights = {40, 45, 50};
+    BOOST_CHECK(db.WriteCoinMintBatch(vMints, vHeights));
+    BOOST_CHECK(db.WriteInt("heightindex", 50));
+
+    // Disconnect block 50 the way DisconnectBlock does: lower the end of the index, then erase
+    BOOST_CHECK(db.TruncateHeightIndex(50));
+    BOOST_CHECK(db.EraseCoinMint(CBigNum(3), 50));
+    int nHeightIndexed;
+    BOOST_CHECK(db.ReadInt("heightindex", nHeightIndexed));
+    BOOST_CHECK_EQUAL(nHeightIndexed, 49);
+
+    // Block 49 has no mints, but its replacement won't be indexed either
+    BOOST_CHECK(db.TruncateHeightIndex(49));
+    BOOST_CHECK(db.ReadInt("heightindex", nHeightIndexed));
+    BOOST_CHECK_EQUAL(nHeightIndexed, 48);
+
+    // What is still covered is complete
+    std::vector<CZerocoinIndexEntry> vEntries;
+    BOOST_CHECK(db.ReadCoinsInRange('m', 0, nHeightIndexed, vEntries));
+    BOOST_CHECK_EQUAL(vEntries.size(), 2U);
+    BOOST_CHECK_EQUAL(vEntries[1].nHeight, 45);
+
+    // Blocks above the end of the index, or without an index, leave it alone
+    BOOST_CHECK(db.TruncateHeightIndex(60));
+    BOOST_CHECK(db.ReadInt("heightindex", nHeightIndexed));
+    BOOST_CHECK_EQUAL(nHeightIndexed, 48);
+    BOOST_CHECK(db.EraseInt("heightindex"));
+    BOOST_CHECK(db.TruncateHeightIndex(10));
+    BOOST_CHECK(!db.ReadInt("heightindex", nHeightIndexed));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
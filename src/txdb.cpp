@@ -12,6 +12,8 @@
 #include "uint256.h"
 #include "accumulators.h"
 
+#include <atomic>
+#include <limits>
 #include <stdint.h>
 
 #include <boost/thread.hpp>
@@ -84,6 +86,14 @@ bool CBlockTreeDB::WriteBlockIndex(const CDiskBlockIndex& blockindex)
     return Write(make_pair('b', blockindex.GetBlockHash()), blockindex);
 }
 
+bool CBlockTreeDB::WriteBlockIndexBatch(const std::vector<CBlockIndex*>& vIndex)
+{
+    CLevelDBBatch batch;
+    for (CBlockIndex* pindex : vIndex)
+        batch.Write(make_pair('b', pindex->GetBlockHash()), CDiskBlockIndex(pindex));
+    return WriteBatch(batch);
+}
+
 bool CBlockTreeDB::WriteBlockFileInfo(int nFile, const CBlockFileInfo& info)
 {
     return Write(make_pair('f', nFile), info);
@@ -185,6 +195,169 @@ bool CBlockTreeDB::WriteTxIndex(const std::vector<std::pair<uint256, CDiskTxPos>
     return WriteBatch(batch);
 }
 
+bool CBlockTreeDB::WriteAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount> >& vect)
+{
+    CLevelDBBatch batch;
+    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it = vect.begin(); it != vect.end(); it++)
+        batch.Write(make_pair('a', it->first), it->second);
+    return WriteBatch(batch);
+}
+
+bool CBlockTreeDB::EraseAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount> >& vect)
+{
+    CLevelDBBatch batch;
+    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it = vect.begin(); it != vect.end(); it++)
+        batch.Erase(make_pair('a', it->first));
+    return WriteBatch(batch);
+}
+
+bool CBlockTreeDB::ReadAddressIndex(const uint160& addressHash, int nType, std::vector<std::pair<CAddressIndexKey, CAmount> >& vect, int nStart, int nEnd)
+{
+    boost::scoped_ptr<leveldb::Iterator> pcursor(NewIterator());
+
+    CDataStream ssKeySet(SER_DISK, CLIENT_VERSION);
+    if (nStart > 0 && nEnd > 0)
+        ssKeySet << make_pair('a', CAddressIndexIteratorHeightKey(nType, addressHash, nStart));
+    else
+        ssKeySet << make_pair('a', CAddressIndexIteratorKey(nType, addressHash));
+    pcursor->Seek(ssKeySet.str());
+
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        try {
+            leveldb::Slice slKey = pcursor->key();
+            CDataStream ssKey(slKey.data(), slKey.data() + slKey.size(), SER_DISK, CLIENT_VERSION);
+            char chType;
+            ssKey >> chType;
+            if (chType != 'a' || slKey.size() != 1 + CAddressIndexKey().GetSerializeSize(SER_DISK, CLIENT_VERSION))
+                break;
+            CAddressIndexKey key;
+            ssKey >> key;
+            if ((int)key.type != nType || key.hashBytes != addressHash)
+                break;
+            if (nEnd > 0 && key.blockHeight > nEnd)
+                break;
+
+            leveldb::Slice slValue = pcursor->value();
+            CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
+            CAmount nValue;
+            ssValue >> nValue;
+            vect.push_back(make_pair(key, nValue));
+            pcursor->Next();
+        } catch (std::exception& e) {
+            return error("%s : Deserialize or I/O error - %s", __func__, e.what());
+        }
+    }
+
+    return true;
+}
+
+bool CBlockTreeDB::UpdateAddressUnspentIndex(const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >& vect)
+{
+    CLevelDBBatch batch;
+    for (std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >::const_iterator it = vect.begin(); it != vect.end(); it++) {
+        if (it->second.IsNull())
+            batch.Erase(make_pair('u', it->first));
+        else
+            batch.Write(make_pair('u', it->first), it->second);
+    }
+    return WriteBatch(batch);
+}
+
+bool CBlockTreeDB::ReadAddressUnspentIndex(const uint160& addressHash, int nType, std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >& vect)
+{
+    boost::scoped_ptr<leveldb::Iterator> pcursor(NewIterator());
+
+    CDataStream ssKeySet(SER_DISK, CLIENT_VERSION);
+    ssKeySet << make_pair('u', CAddressIndexIteratorKey(nType, addressHash));
+    pcursor->Seek(ssKeySet.str());
+
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        try {
+            leveldb::Slice slKey = pcursor->key();
+            CDataStream ssKey(slKey.data(), slKey.data() + slKey.size(), SER_DISK, CLIENT_VERSION);
+            char chType;
+            ssKey >> chType;
+            if (chType != 'u' || slKey.size() != 1 + CAddressUnspentKey().GetSerializeSize(SER_DISK, CLIENT_VERSION))
+                break;
+            CAddressUnspentKey key;
+            ssKey >> key;
+            if ((int)key.type != nType || key.hashBytes != addressHash)
+                break;
+
+            leveldb::Slice slValue = pcursor->value();
+            CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
+            CAddressUnspentValue value;
+            ssValue >> value;
+            vect.push_back(make_pair(key, value));
+            pcursor->Next();
+        } catch (std::exception& e) {
+            return error("%s : Deserialize or I/O error - %s", __func__, e.what());
+        }
+    }
+
+    return true;
+}
+
+bool CBlockTreeDB::UpdateSpentIndex(const std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >& vect)
+{
+    CLevelDBBatch batch;
+    for (std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >::const_iterator it = vect.begin(); it != vect.end(); it++) {
+        if (it->second.IsNull())
+            batch.Erase(make_pair('p', it->first));
+        else
+            batch.Write(make_pair('p', it->first), it->second);
+    }
+    return WriteBatch(batch);
+}
+
+bool CBlockTreeDB::ReadSpentIndex(const CSpentIndexKey& key, CSpentIndexValue& value)
+{
+    return Read(make_pair('p', key), value);
+}
+
+bool CBlockTreeDB::WriteTimestampIndex(const CTimestampIndexKey& key)
+{
+    return Write(make_pair('s', key), '1');
+}
+
+bool CBlockTreeDB::EraseTimestampIndex(const CTimestampIndexKey& key)
+{
+    return Erase(make_pair('s', key));
+}
+
+bool CBlockTreeDB::ReadTimestampIndex(unsigned int nHigh, unsigned int nLow, std::vector<uint256>& vHashes)
+{
+    boost::scoped_ptr<leveldb::Iterator> pcursor(NewIterator());
+
+    CDataStream ssKeySet(SER_DISK, CLIENT_VERSION);
+    ssKeySet << make_pair('s', CTimestampIndexIteratorKey(nLow));
+    pcursor->Seek(ssKeySet.str());
+
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        try {
+            leveldb::Slice slKey = pcursor->key();
+            CDataStream ssKey(slKey.data(), slKey.data() + slKey.size(), SER_DISK, CLIENT_VERSION);
+            char chType;
+            ssKey >> chType;
+            if (chType != 's' || slKey.size() != 1 + CTimestampIndexKey().GetSerializeSize(SER_DISK, CLIENT_VERSION))
+                break;
+            CTimestampIndexKey key;
+            ssKey >> key;
+            if (key.timestamp >= nHigh)
+                break;
+            vHashes.push_back(key.blockHash);
+            pcursor->Next();
+        } catch (std::exception& e) {
+            return error("%s : Deserialize or I/O error - %s", __func__, e.what());
+        }
+    }
+
+    return true;
+}
+
 bool CBlockTreeDB::WriteFlag(const std::string& name, bool fValue)
 {
     return Write(std::make_pair('F', name), fValue ? '1' : '0');
@@ -209,80 +382,155 @@ bool CBlockTreeDB::ReadInt(const std::string& name, int& nValue)
     return Read(std::make_pair('I', name), nValue);
 }
 
+namespace
+{
+/** State shared by the threads loading disjoint key ranges of the block index */
+struct CBlockIndexLoadState {
+    boost::mutex mutex;
+    std::set<uint256> setCheckpoints;
+    std::atomic<bool> fFailed;
+    std::string strError;
+
+    CBlockIndexLoadState() : fFailed(false) {}
+
+    void Fail(const std::string& strErrorIn)
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        if (!fFailed) {
+            fFailed = true;
+            strError = strErrorIn;
+        }
+    }
+};
+} // anon namespace
+
+/**
+ * Load the 'b' entries whose block hash starts with a byte in [nBegin, nEnd). The key is
+ * ('b', hash), so each such range is one contiguous stretch of the database. Decoding,
+ * hashing and the proof of work check run without the lock; only linking the entry into
+ * mapBlockIndex is serialized.
+ */
+static void LoadBlockIndexRange(CBlockTreeDB* pdb, unsigned int nBegin, unsigned int nEnd, CBlockIndexLoadState* pstate)
+{
+    try {
+        boost::scoped_ptr<leveldb::Iterator> pcursor(pdb->NewIterator());
+
+        uint256 hashStart;
+        *hashStart.begin() = nBegin;
+        CDataStream ssKeySet(SER_DISK, CLIENT_VERSION);
+        ssKeySet << make_pair('b', hashStart);
+        pcursor->Seek(ssKeySet.str());
+
+        for (; pcursor->Valid(); pcursor->Next()) {
+            if (pstate->fFailed)
+                return;
+
+            leveldb::Slice slKey = pcursor->key();
+            if (slKey.size() < 2 || slKey[0] != 'b' || (unsigned char)slKey[1] >= nEnd)
+                break; // finished loading this part of the block index
+
+            leveldb::Slice slValue = pcursor->value();
+            CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
+            CDiskBlockIndex diskindex;
+            ssValue >> diskindex;
+
+            uint256 hashBlock = diskindex.GetBlockHash();
+            if (diskindex.nHeight <= Params().LAST_POW_BLOCK()) {
+                if (!CheckProofOfWork(hashBlock, diskindex.nBits))
+                    return pstate->Fail(strprintf("CheckProofOfWork failed: %s", diskindex.ToString()));
+            }
+
+            boost::unique_lock<boost::mutex> lock(pstate->mutex);
+
+            // Construct block index object
+            CBlockIndex* pindexNew = InsertBlockIndex(hashBlock);
+            pindexNew->pprev = InsertBlockIndex(diskindex.hashPrev);
+            pindexNew->pnext = InsertBlockIndex(diskindex.hashNext);
+            pindexNew->nHeight = diskindex.nHeight;
+            pindexNew->nFile = diskindex.nFile;
+            pindexNew->nDataPos = diskindex.nDataPos;
+            pindexNew->nUndoPos = diskindex.nUndoPos;
+            pindexNew->nVersion = diskindex.nVersion;
+            pindexNew->hashMerkleRoot = diskindex.hashMerkleRoot;
+            pindexNew->nTime = diskindex.nTime;
+            pindexNew->nBits = diskindex.nBits;
+            pindexNew->nNonce = diskindex.nNonce;
+            pindexNew->nStatus = diskindex.nStatus;
+            pindexNew->nTx = diskindex.nTx;
+
+            //zerocoin
+            pindexNew->nAccumulatorCheckpoint = diskindex.nAccumulatorCheckpoint;
+            pindexNew->mapZerocoinSupply = diskindex.mapZerocoinSupply;
+            pindexNew->vMintDenominationsInBlock.swap(diskindex.vMintDenominationsInBlock);
+
+            //Proof Of Stake
+            pindexNew->nMint = diskindex.nMint;
+            pindexNew->nMoneySupply = diskindex.nMoneySupply;
+            pindexNew->nFlags = diskindex.nFlags;
+            pindexNew->nStakeModifier = diskindex.nStakeModifier;
+            pindexNew->prevoutStake = diskindex.prevoutStake;
+            pindexNew->nStakeTime = diskindex.nStakeTime;
+            pindexNew->hashProofOfStake = diskindex.hashProofOfStake;
+
+            // ppcoin: build setStakeSeen
+            if (pindexNew->IsProofOfStake())
+                setStakeSeen.insert(make_pair(pindexNew->prevoutStake, pindexNew->nStakeTime));
+
+            //Don't load any checkpoints that exist before v2 zkyd. The accumulator is invalid for v1 and not used.
+            if (pindexNew->nAccumulatorCheckpoint != 0 && pindexNew->nHeight >= Params().Zerocoin_Block_V2_Start())
+                pstate->setCheckpoints.insert(pindexNew->nAccumulatorCheckpoint);
+        }
+    } catch (std::exception& e) {
+        pstate->Fail(strprintf("Deserialize or I/O error - %s", e.what()));
+    }
+}
+
 bool CBlockTreeDB::LoadBlockIndexGuts()
+{
+    int nThreads = std::max(1, std::min((int)boost::thread::hardware_concurrency(), MAX_BLOCK_INDEX_LOAD_THREADS));
+
+    // Load mapBlockIndex, one contiguous range of block hashes per thread
+    CBlockIndexLoadState state;
+    boost::thread_group loadThreads;
+    for (int i = 1; i < nThreads; i++)
+        loadThreads.create_thread(boost::bind(&LoadBlockIndexRange, this, 256 * i / nThreads, 256 * (i + 1) / nThreads, &state));
+    LoadBlockIndexRange(this, 0, 256 / nThreads, &state);
+    loadThreads.join_all();
+
+    if (state.fFailed)
+        return error("%s : %s", __func__, state.strError);
+    boost::this_thread::interruption_point();
+
+    //populate accumulator checksum map in memory
+    for (const uint256& nCheckpoint : state.setCheckpoints)
+        LoadAccumulatorValuesFromDB(nCheckpoint);
+
+    return true;
+}
+
+CZerocoinDB::CZerocoinDB(size_t nCacheSize, bool fMemory, bool fWipe) : CLevelDBWrapper(GetDataDir() / "zerocoin", nCacheSize, fMemory, fWipe, SPARSE_DB_BLOOM_BITS), fFiltersLoaded(false)
+{
+}
+
+bool CZerocoinDB::ReadHashes(char chType, std::vector<uint256>& vHashes)
 {
     boost::scoped_ptr<leveldb::Iterator> pcursor(NewIterator());
 
     CDataStream ssKeySet(SER_DISK, CLIENT_VERSION);
-    ssKeySet << make_pair('b', uint256(0));
+    ssKeySet << chType;
     pcursor->Seek(ssKeySet.str());
 
-    // Load mapBlockIndex
-    uint256 nPreviousCheckpoint;
     while (pcursor->Valid()) {
         boost::this_thread::interruption_point();
         try {
             leveldb::Slice slKey = pcursor->key();
+            if (slKey.size() == 0 || slKey.data()[0] != chType)
+                break;
             CDataStream ssKey(slKey.data(), slKey.data() + slKey.size(), SER_DISK, CLIENT_VERSION);
-            char chType;
-            ssKey >> chType;
-            if (chType == 'b') {
-                leveldb::Slice slValue = pcursor->value();
-                CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
-                CDiskBlockIndex diskindex;
-                ssValue >> diskindex;
-
-                // Construct block index object
-                CBlockIndex* pindexNew = InsertBlockIndex(diskindex.GetBlockHash());
-                pindexNew->pprev = InsertBlockIndex(diskindex.hashPrev);
-                pindexNew->pnext = InsertBlockIndex(diskindex.hashNext);
-                pindexNew->nHeight = diskindex.nHeight;
-                pindexNew->nFile = diskindex.nFile;
-                pindexNew->nDataPos = diskindex.nDataPos;
-                pindexNew->nUndoPos = diskindex.nUndoPos;
-                pindexNew->nVersion = diskindex.nVersion;
-                pindexNew->hashMerkleRoot = diskindex.hashMerkleRoot;
-                pindexNew->nTime = diskindex.nTime;
-                pindexNew->nBits = diskindex.nBits;
-                pindexNew->nNonce = diskindex.nNonce;
-                pindexNew->nStatus = diskindex.nStatus;
-                pindexNew->nTx = diskindex.nTx;
-
-                //zerocoin
-                pindexNew->nAccumulatorCheckpoint = diskindex.nAccumulatorCheckpoint;
-                pindexNew->mapZerocoinSupply = diskindex.mapZerocoinSupply;
-                pindexNew->vMintDenominationsInBlock = diskindex.vMintDenominationsInBlock;
-
-                //Proof Of Stake
-                pindexNew->nMint = diskindex.nMint;
-                pindexNew->nMoneySupply = diskindex.nMoneySupply;
-                pindexNew->nFlags = diskindex.nFlags;
-                pindexNew->nStakeModifier = diskindex.nStakeModifier;
-                pindexNew->prevoutStake = diskindex.prevoutStake;
-                pindexNew->nStakeTime = diskindex.nStakeTime;
-                pindexNew->hashProofOfStake = diskindex.hashProofOfStake;
-
-                if (pindexNew->nHeight <= Params().LAST_POW_BLOCK()) {
-                    if (!CheckProofOfWork(pindexNew->GetBlockHash(), pindexNew->nBits))
-                        return error("LoadBlockIndex() : CheckProofOfWork failed: %s", pindexNew->ToString());
-                }
-                // ppcoin: build setStakeSeen
-                if (pindexNew->IsProofOfStake())
-                    setStakeSeen.insert(make_pair(pindexNew->prevoutStake, pindexNew->nStakeTime));
-
-                //populate accumulator checksum map in memory
-                if(pindexNew->nAccumulatorCheckpoint != 0 && pindexNew->nAccumulatorCheckpoint != nPreviousCheckpoint) {
-                    //Don't load any checkpoints that exist before v2 zkyd. The accumulator is invalid for v1 and not used.
-                    if (pindexNew->nHeight >= Params().Zerocoin_Block_V2_Start())
-                        LoadAccumulatorValuesFromDB(pindexNew->nAccumulatorCheckpoint);
-
-                    nPreviousCheckpoint = pindexNew->nAccumulatorCheckpoint;
-                }
-
-                pcursor->Next();
-            } else {
-                break; // if shutdown requested or finished loading block index
-            }
+            std::pair<char, uint256> key;
+            ssKey >> key;
+            vHashes.push_back(key.second);
+            pcursor->Next();
         } catch (std::exception& e) {
             return error("%s : Deserialize or I/O error - %s", __func__, e.what());
         }
@@ -291,23 +539,114 @@ bool CBlockTreeDB::LoadBlockIndexGuts()
     return true;
 }
 
-CZerocoinDB::CZerocoinDB(size_t nCacheSize, bool fMemory, bool fWipe) : CLevelDBWrapper(GetDataDir() / "zerocoin", nCacheSize, fMemory, fWipe)
+bool CZerocoinDB::RebuildFilter(char chType)
+{
+    CZerocoinFilter& filter = (chType == 's' ? filterSpends : filterMints);
+    {
+        // Writes in flight finish first, so the scan sees them
+        boost::unique_lock<boost::shared_mutex> lockWrites(cs_writes);
+        boost::unique_lock<boost::mutex> lock(cs_filters);
+        if (filter.fRebuilding)
+            return true;
+        filter.fRebuilding = true;
+        filter.vPending.clear();
+    }
+
+    // The scan runs unlocked. Writers add their hashes to the filters before writing them, so a
+    // hash the scan misses was written after it started and is in vPending.
+    std::vector<uint256> vHashes;
+    bool fOk = ReadHashes(chType, vHashes);
+    CHashFilter filterNew;
+    if (fOk) {
+        filterNew = CHashFilter(std::max(ZEROCOIN_FILTER_MIN_ELEMENTS, (unsigned int)vHashes.size() * 2), ZEROCOIN_FILTER_FP_RATE);
+        for (const uint256& hash : vHashes)
+            filterNew.insert(hash);
+    }
+
+    boost::unique_lock<boost::mutex> lock(cs_filters);
+    filter.fRebuilding = false;
+    if (fOk) {
+        for (const uint256& hash : filter.vPending)
+            filterNew.insert(hash);
+        std::swap(filter.filter, filterNew);
+        LogPrint("zero", "%s : %u %s hashes\n", __func__, filter.filter.size(), chType == 's' ? "serial" : "pubcoin");
+    }
+    filter.vPending.clear();
+    return fOk;
+}
+
+bool CZerocoinDB::LoadFilters()
+{
+    {
+        boost::unique_lock<boost::mutex> lock(cs_filters);
+        fFiltersLoaded = false;
+    }
+    if (!RebuildFilter('s') || !RebuildFilter('m'))
+        return error("%s : failed to read the zerocoin database", __func__);
+
+    boost::unique_lock<boost::mutex> lock(cs_filters);
+    fFiltersLoaded = true;
+    LogPrintf("%s : %u serials, %u pubcoins\n", __func__, filterSpends.filter.size(), filterMints.filter.size());
+    return true;
+}
+
+bool CZerocoinDB::MayHave(char chType, const uint256& hash) const
+{
+    boost::unique_lock<boost::mutex> lock(cs_filters);
+    if (!fFiltersLoaded)
+        return true;
+    return (chType == 's' ? filterSpends : filterMints).filter.contains(hash);
+}
+
+void CZerocoinDB::AddToFilter(char chType, const std::vector<uint256>& vHashes)
 {
+    // Called before the hashes are written, so that a reader never misses a written entry
+    boost::unique_lock<boost::mutex> lock(cs_filters);
+    CZerocoinFilter& filter = (chType == 's' ? filterSpends : filterMints);
+    for (const uint256& hash : vHashes)
+        filter.filter.insert(hash);
+    if (filter.fRebuilding)
+        filter.vPending.insert(filter.vPending.end(), vHashes.begin(), vHashes.end());
+}
+
+void CZerocoinDB::TrimFilter(char chType)
+{
+    {
+        boost::unique_lock<boost::mutex> lock(cs_filters);
+        if (!fFiltersLoaded || !(chType == 's' ? filterSpends : filterMints).filter.IsFull())
+            return;
+    }
+
+    // Grown past its size the fp rate climbs quickly, so rebuild it twice as large
+    if (!RebuildFilter(chType)) {
+        boost::unique_lock<boost::mutex> lock(cs_filters);
+        fFiltersLoaded = false;
+    }
 }
 
-bool CZerocoinDB::WriteCoinMintBatch(const std::vector<std::pair<libzerocoin::PublicCoin, uint256> >& mintInfo)
+bool CZerocoinDB::WriteCoinMintBatch(const std::vector<std::pair<libzerocoin::PublicCoin, uint256> >& mintInfo, const std::vector<int>& vHeights)
 {
     CLevelDBBatch batch;
-    size_t count = 0;
-    for (std::vector<std::pair<libzerocoin::PublicCoin, uint256> >::const_iterator it=mintInfo.begin(); it != mintInfo.end(); it++) {
-        PublicCoin pubCoin = it->first;
-        uint256 hash = GetPubCoinHash(pubCoin.getValue());
-        batch.Write(make_pair('m', hash), it->second);
-        ++count;
+    std::vector<uint256> vHashes;
+    vHashes.reserve(mintInfo.size());
+    for (unsigned int i = 0; i < mintInfo.size(); i++) {
+        uint256 hash = GetPubCoinHash(mintInfo[i].first.getValue());
+        batch.Write(make_pair('m', hash), mintInfo[i].second);
+        if (!vHeights.empty())
+            batch.Write(make_pair('h', CZerocoinHeightKey('m', vHeights[i], hash)), mintInfo[i].second);
+        vHashes.push_back(hash);
+    }
+
+    LogPrint("zero", "Writing %u coin mints to db.\n", (unsigned int)vHashes.size());
+    {
+        boost::shared_lock<boost::shared_mutex> lock(cs_writes);
+        AddToFilter('m', vHashes);
+        if (!WriteBatch(batch, true))
+            return false;
     }
 
-    LogPrint("zero", "Writing %u coin mints to db.\n", (unsigned int)count);
-    return WriteBatch(batch, true);
+    TrimFilter('m');
+    return true;
 }
 
 bool CZerocoinDB::ReadCoinMint(const CBigNum& bnPubcoin, uint256& hashTx)
@@ -317,30 +656,76 @@ bool CZerocoinDB::ReadCoinMint(const CBigNum& bnPubcoin, uint256& hashTx)
 
 bool CZerocoinDB::ReadCoinMint(const uint256& hashPubcoin, uint256& hashTx)
 {
+    if (!MayHave('m', hashPubcoin))
+        return false;
     return Read(make_pair('m', hashPubcoin), hashTx);
 }
 
-bool CZerocoinDB::EraseCoinMint(const CBigNum& bnPubcoin)
+bool CZerocoinDB::ReadCoinMints(const std::vector<uint256>& vHashPubcoin, std::map<uint256, uint256>& mapHashTx)
+{
+    // Resolve the whole batch with one iterator instead of a Get() per key
+    std::vector<uint256> vCandidates;
+    std::vector<std::pair<char, uint256> > vKeys;
+    vCandidates.reserve(vHashPubcoin.size());
+    vKeys.reserve(vHashPubcoin.size());
+    for (const uint256& hashPubcoin : vHashPubcoin) {
+        if (!MayHave('m', hashPubcoin))
+            continue;
+        vCandidates.push_back(hashPubcoin);
+        vKeys.emplace_back('m', hashPubcoin);
+    }
+
+    std::vector<uint256> vHashTx;
+    std::vector<bool> vFound;
+    if (!MultiRead(vKeys, vHashTx, vFound))
+        return error("%s : failed to deserialize coin mints", __func__);
+    for (unsigned int i = 0; i < vCandidates.size(); i++) {
+        if (vFound[i])
+            mapHashTx[vCandidates[i]] = vHashTx[i];
+    }
+
+    return true;
+}
+
+bool CZerocoinDB::EraseCoinMint(const CBigNum& bnPubcoin, int nHeight)
 {
     uint256 hash = GetPubCoinHash(bnPubcoin);
-    return Erase(make_pair('m', hash));
+    if (nHeight < 0)
+        return Erase(make_pair('m', hash));
+
+    // The filter keeps the hash; that only costs a database read until it is rebuilt
+    CLevelDBBatch batch;
+    batch.Erase(make_pair('m', hash));
+    batch.Erase(make_pair('h', CZerocoinHeightKey('m', nHeight, hash)));
+    return WriteBatch(batch);
 }
 
-bool CZerocoinDB::WriteCoinSpendBatch(const std::vector<std::pair<libzerocoin::CoinSpend, uint256> >& spendInfo)
+bool CZerocoinDB::WriteCoinSpendBatch(const std::vector<std::pair<libzerocoin::CoinSpend, uint256> >& spendInfo, const std::vector<int>& vHeights)
 {
     CLevelDBBatch batch;
-    size_t count = 0;
-    for (std::vector<std::pair<libzerocoin::CoinSpend, uint256> >::const_iterator it=spendInfo.begin(); it != spendInfo.end(); it++) {
-        CBigNum bnSerial = it->first.getCoinSerialNumber();
+    std::vector<uint256> vHashes;
+    vHashes.reserve(spendInfo.size());
+    for (unsigned int i = 0; i < spendInfo.size(); i++) {
+        CBigNum bnSerial = spendInfo[i].first.getCoinSerialNumber();
         CDataStream ss(SER_GETHASH, 0);
         ss << bnSerial;
         uint256 hash = Hash(ss.begin(), ss.end());
-        batch.Write(make_pair('s', hash), it->second);
-        ++count;
+        batch.Write(make_pair('s', hash), spendInfo[i].second);
+        if (!vHeights.empty())
+            batch.Write(make_pair('h', CZerocoinHeightKey('s', vHeights[i], hash)), spendInfo[i].second);
+        vHashes.push_back(hash);
     }
 
-    LogPrint("zero", "Writing %u coin spends to db.\n", (unsigned int)count);
-    return WriteBatch(batch, true);
+    LogPrint("zero", "Writing %u coin spends to db.\n", (unsigned int)vHashes.size());
+    {
+        boost::shared_lock<boost::shared_mutex> lock(cs_writes);
+        AddToFilter('s', vHashes);
+        if (!WriteBatch(batch, true))
+            return false;
+    }
+
+    TrimFilter('s');
+    return true;
 }
 
 bool CZerocoinDB::ReadCoinSpend(const CBigNum& bnSerial, uint256& txHash)
@@ -349,64 +734,126 @@ bool CZerocoinDB::ReadCoinSpend(const CBigNum& bnSerial, uint256& txHash)
     ss << bnSerial;
     uint256 hash = Hash(ss.begin(), ss.end());
 
-    return Read(make_pair('s', hash), txHash);
+    return ReadCoinSpend(hash, txHash);
 }
 
 bool CZerocoinDB::ReadCoinSpend(const uint256& hashSerial, uint256 &txHash)
 {
+    if (!MayHave('s', hashSerial))
+        return false;
     return Read(make_pair('s', hashSerial), txHash);
 }
 
-bool CZerocoinDB::EraseCoinSpend(const CBigNum& bnSerial)
+bool CZerocoinDB::EraseCoinSpend(const CBigNum& bnSerial, int nHeight)
 {
     CDataStream ss(SER_GETHASH, 0);
     ss << bnSerial;
     uint256 hash = Hash(ss.begin(), ss.end());
+    if (nHeight < 0)
+        return Erase(make_pair('s', hash));
 
-    return Erase(make_pair('s', hash));
+    CLevelDBBatch batch;
+    batch.Erase(make_pair('s', hash));
+    batch.Erase(make_pair('h', CZerocoinHeightKey('s', nHeight, hash)));
+    return WriteBatch(batch);
 }
 
-bool CZerocoinDB::WipeCoins(std::string strType)
+bool CZerocoinDB::TruncateHeightIndex(int nHeight)
 {
-    if (strType != "spends" && strType != "mints")
-        return error("%s: did not recognize type %s", __func__, strType);
+    // Blocks connected in place of this one are not indexed, so the index
+    // stops being complete here even if this block had no zerocoin entries
+    int nHeightIndexed;
+    if (!ReadInt("heightindex", nHeightIndexed) || nHeightIndexed < nHeight)
+        return true;
+    return WriteInt("heightindex", nHeight - 1);
+}
 
+bool CZerocoinDB::ReadCoinsInRange(char chType, int nHeightStart, int nHeightEnd, std::vector<CZerocoinIndexEntry>& vEntries)
+{
     boost::scoped_ptr<leveldb::Iterator> pcursor(NewIterator());
 
-    char type = (strType == "spends" ? 's' : 'm');
     CDataStream ssKeySet(SER_DISK, CLIENT_VERSION);
-    ssKeySet << make_pair(type, uint256(0));
+    ssKeySet << make_pair('h', CZerocoinHeightKey(chType, nHeightStart, uint256(0)));
     pcursor->Seek(ssKeySet.str());
-    // Load mapBlockIndex
-    std::set<uint256> setDelete;
+
     while (pcursor->Valid()) {
         boost::this_thread::interruption_point();
         try {
             leveldb::Slice slKey = pcursor->key();
             CDataStream ssKey(slKey.data(), slKey.data() + slKey.size(), SER_DISK, CLIENT_VERSION);
-            char chType;
-            ssKey >> chType;
-            if (chType == type) {
-                leveldb::Slice slValue = pcursor->value();
-                CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
-                uint256 hash;
-                ssValue >> hash;
-                setDelete.insert(hash);
-                pcursor->Next();
-            } else {
-                break; // if shutdown requested or finished loading block index
-            }
+            char chKey;
+            ssKey >> chKey;
+            if (chKey != 'h')
+                break;
+            CZerocoinHeightKey key;
+            ssKey >> key;
+            if (key.chType != chType || key.nHeight > nHeightEnd)
+                break;
+
+            leveldb::Slice slValue = pcursor->value();
+            CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
+            CZerocoinIndexEntry entry;
+            entry.nHeight = key.nHeight;
+            entry.hash = key.hash;
+            ssValue >> entry.txid;
+            vEntries.push_back(entry);
+            pcursor->Next();
         } catch (std::exception& e) {
             return error("%s : Deserialize or I/O error - %s", __func__, e.what());
         }
     }
 
-    for (auto& hash : setDelete) {
-        if (!Erase(make_pair(type, hash)))
-            LogPrintf("%s: error failed to delete %s\n", __func__, hash.GetHex());
+    return true;
+}
+
+bool CZerocoinDB::WipeCoins(std::string strType)
+{
+    if (strType != "spends" && strType != "mints" && strType != "heights")
+        return error("%s: did not recognize type %s", __func__, strType);
+
+    if (strType == "heights") {
+        std::vector<CZerocoinIndexEntry> vSpends, vMints;
+        if (!ReadCoinsInRange('s', 0, std::numeric_limits<int>::max(), vSpends) || !ReadCoinsInRange('m', 0, std::numeric_limits<int>::max(), vMints))
+            return false;
+
+        CLevelDBBatch batch;
+        for (const CZerocoinIndexEntry& entry : vSpends)
+            batch.Erase(make_pair('h', CZerocoinHeightKey('s', entry.nHeight, entry.hash)));
+        for (const CZerocoinIndexEntry& entry : vMints)
+            batch.Erase(make_pair('h', CZerocoinHeightKey('m', entry.nHeight, entry.hash)));
+        return WriteBatch(batch);
+    }
+
+    char type = (strType == "spends" ? 's' : 'm');
+    {
+        boost::unique_lock<boost::mutex> lock(cs_filters);
+        fFiltersLoaded = false;
     }
 
-    return true;
+    // Collect the keys themselves and erase them in one batch
+    std::vector<uint256> vHashes;
+    if (!ReadHashes(type, vHashes))
+        return false;
+
+    CLevelDBBatch batch;
+    for (const uint256& hash : vHashes)
+        batch.Erase(make_pair(type, hash));
+    return WriteBatch(batch);
+}
+
+bool CZerocoinDB::WriteInt(const std::string& name, int nValue)
+{
+    return Write(std::make_pair('I', name), nValue);
+}
+
+bool CZerocoinDB::ReadInt(const std::string& name, int& nValue)
+{
+    return Read(std::make_pair('I', name), nValue);
+}
+
+bool CZerocoinDB::EraseInt(const std::string& name)
+{
+    return Erase(std::make_pair('I', name));
 }
 
 bool CZerocoinDB::WriteAccumulatorValue(const uint32_t& nChecksum, const CBigNum& bnValue)
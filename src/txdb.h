@@ -8,6 +8,8 @@
 #ifndef BITCOIN_TXDB_H
 #define BITCOIN_TXDB_H
 
+#include "addressindex.h"
+#include "bloom.h"
 #include "leveldbwrapper.h"
 #include "main.h"
 #include "primitives/zerocoin.h"
@@ -17,6 +19,9 @@
 #include <utility>
 #include <vector>
 
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/shared_mutex.hpp>
+
 class CCoins;
 class uint256;
 
@@ -26,6 +31,12 @@ static const int64_t nDefaultDbCache = 100;
 static const int64_t nMaxDbCache = sizeof(void*) > 4 ? 4096 : 1024;
 //! min. -dbcache in (MiB)
 static const int64_t nMinDbCache = 4;
+//! max. number of threads reading the block index at startup
+static const int MAX_BLOCK_INDEX_LOAD_THREADS = 16;
+//! min. number of keys the zerocoin serial and pubcoin filters are sized for
+static const unsigned int ZEROCOIN_FILTER_MIN_ELEMENTS = 100000;
+//! false positive rate of the zerocoin serial and pubcoin filters
+static const double ZEROCOIN_FILTER_FP_RATE = 0.001;
 
 /** CCoinsView backed by the LevelDB coin database (chainstate/) */
 class CCoinsViewDB : public CCoinsView
@@ -55,6 +66,7 @@ private:
 
 public:
     bool WriteBlockIndex(const CDiskBlockIndex& blockindex);
+    bool WriteBlockIndexBatch(const std::vector<CBlockIndex*>& vIndex);
     bool ReadBlockFileInfo(int nFile, CBlockFileInfo& fileinfo);
     bool WriteBlockFileInfo(int nFile, const CBlockFileInfo& fileinfo);
     bool ReadLastBlockFile(int& nFile);
@@ -63,6 +75,20 @@ public:
     bool ReadReindexing(bool& fReindex);
     bool ReadTxIndex(const uint256& txid, CDiskTxPos& pos);
     bool WriteTxIndex(const std::vector<std::pair<uint256, CDiskTxPos> >& list);
+    bool WriteAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount> >& vect);
+    bool EraseAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount> >& vect);
+    /** Read the history of an address, optionally limited to the blocks in [nStart, nEnd] */
+    bool ReadAddressIndex(const uint160& addressHash, int nType, std::vector<std::pair<CAddressIndexKey, CAmount> >& vect, int nStart = 0, int nEnd = 0);
+    /** Write the unspent outputs of a batch, erasing the entries whose value is null */
+    bool UpdateAddressUnspentIndex(const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >& vect);
+    bool ReadAddressUnspentIndex(const uint160& addressHash, int nType, std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >& vect);
+    /** Write the spent outputs of a batch, erasing the entries whose value is null */
+    bool UpdateSpentIndex(const std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >& vect);
+    bool ReadSpentIndex(const CSpentIndexKey& key, CSpentIndexValue& value);
+    bool WriteTimestampIndex(const CTimestampIndexKey& key);
+    bool EraseTimestampIndex(const CTimestampIndexKey& key);
+    /** Read the hashes of the blocks with a timestamp in [nLow, nHigh) */
+    bool ReadTimestampIndex(unsigned int nHigh, unsigned int nLow, std::vector<uint256>& vHashes);
     bool WriteFlag(const std::string& name, bool fValue);
     bool ReadFlag(const std::string& name, bool& fValue);
     bool WriteInt(const std::string& name, int nValue);
@@ -70,6 +96,41 @@ public:
     bool LoadBlockIndexGuts();
 };
 
+/** Key of the zerocoin height index, which orders spends ('s') and mints ('m') by block height */
+struct CZerocoinHeightKey {
+    char chType;
+    int nHeight;
+    uint256 hash;
+
+    CZerocoinHeightKey() : chType(0), nHeight(0) {}
+    CZerocoinHeightKey(char chTypeIn, int nHeightIn, const uint256& hashIn) : chType(chTypeIn), nHeight(nHeightIn), hash(hashIn) {}
+
+    unsigned int GetSerializeSize(int nType, int nVersion) const { return 37; }
+
+    template <typename Stream>
+    void Serialize(Stream& s, int nType, int nVersion) const
+    {
+        ::Serialize(s, chType, nType, nVersion);
+        SerializeKeyBE32(s, nHeight);
+        hash.Serialize(s, nType, nVersion);
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s, int nType, int nVersion)
+    {
+        ::Unserialize(s, chType, nType, nVersion);
+        nHeight = UnserializeKeyBE32(s);
+        hash.Unserialize(s, nType, nVersion);
+    }
+};
+
+/** A serial or pubcoin hash from the height index, with the transaction it appeared in */
+struct CZerocoinIndexEntry {
+    int nHeight;
+    uint256 hash;
+    uint256 txid;
+};
+
 /** Zerocoin database (zerocoin/) */
 class CZerocoinDB : public CLevelDBWrapper
 {
@@ -80,18 +141,56 @@ private:
     CZerocoinDB(const CZerocoinDB&);
     void operator=(const CZerocoinDB&);
 
+    //! A filter over the serial or pubcoin hashes in the database
+    struct CZerocoinFilter {
+        CHashFilter filter;
+        //! Set while the filter is rebuilt from a database scan
+        bool fRebuilding;
+        //! Hashes written during the rebuild, added to the new filter before it goes live
+        std::vector<uint256> vPending;
+
+        CZerocoinFilter() : fRebuilding(false) {}
+    };
+
+    //! Protects the filters, which are consulted once fFiltersLoaded; never held during database access
+    mutable boost::mutex cs_filters;
+    //! Held shared by writers from adding their hashes to a filter until the write is done
+    boost::shared_mutex cs_writes;
+    CZerocoinFilter filterSpends;
+    CZerocoinFilter filterMints;
+    bool fFiltersLoaded;
+
+    bool ReadHashes(char chType, std::vector<uint256>& vHashes);
+    bool RebuildFilter(char chType);
+    bool MayHave(char chType, const uint256& hash) const;
+    void AddToFilter(char chType, const std::vector<uint256>& vHashes);
+    void TrimFilter(char chType);
+
 public:
-    /** Write zKYD mints to the zerocoinDB in a batch */
-    bool WriteCoinMintBatch(const std::vector<std::pair<libzerocoin::PublicCoin, uint256> >& mintInfo);
+    /** Build the filters that let lookups of unknown serials and pubcoins skip LevelDB */
+    bool LoadFilters();
+    /** Write zKYD mints to the zerocoinDB in a batch. vHeights, if not empty, holds the height of each mint for the height index */
+    bool WriteCoinMintBatch(const std::vector<std::pair<libzerocoin::PublicCoin, uint256> >& mintInfo, const std::vector<int>& vHeights = std::vector<int>());
     bool ReadCoinMint(const CBigNum& bnPubcoin, uint256& txHash);
     bool ReadCoinMint(const uint256& hashPubcoin, uint256& hashTx);
-    /** Write zKYD spends to the zerocoinDB in a batch */
-    bool WriteCoinSpendBatch(const std::vector<std::pair<libzerocoin::CoinSpend, uint256> >& spendInfo);
+    /** Look up the mint txids of a batch of pubcoin hashes with a single sorted sweep of the database */
+    bool ReadCoinMints(const std::vector<uint256>& vHashPubcoin, std::map<uint256, uint256>& mapHashTx);
+    /** Write zKYD spends to the zerocoinDB in a batch. vHeights, if not empty, holds the height of each spend for the height index */
+    bool WriteCoinSpendBatch(const std::vector<std::pair<libzerocoin::CoinSpend, uint256> >& spendInfo, const std::vector<int>& vHeights = std::vector<int>());
     bool ReadCoinSpend(const CBigNum& bnSerial, uint256& txHash);
     bool ReadCoinSpend(const uint256& hashSerial, uint256 &txHash);
-    bool EraseCoinMint(const CBigNum& bnPubcoin);
-    bool EraseCoinSpend(const CBigNum& bnSerial);
+    /** Erase a mint or spend, along with its height index entry when nHeight is known */
+    bool EraseCoinMint(const CBigNum& bnPubcoin, int nHeight = -1);
+    bool EraseCoinSpend(const CBigNum& bnSerial, int nHeight = -1);
+    /** Lower the height the index is complete up to below nHeight, before the entries of a disconnected block at nHeight are erased */
+    bool TruncateHeightIndex(int nHeight);
+    /** Read the spends ('s') or mints ('m') of the blocks in [nHeightStart, nHeightEnd] in height order */
+    bool ReadCoinsInRange(char chType, int nHeightStart, int nHeightEnd, std::vector<CZerocoinIndexEntry>& vEntries);
+    /** Erase all "spends", "mints" or "heights" entries */
     bool WipeCoins(std::string strType);
+    bool WriteInt(const std::string& name, int nValue);
+    bool ReadInt(const std::string& name, int& nValue);
+    bool EraseInt(const std::string& name);
     bool WriteAccumulatorValue(const uint32_t& nChecksum, const CBigNum& bnValue);
     bool ReadAccumulatorValue(const uint32_t& nChecksum, CBigNum& bnValue);
     bool EraseAccumulatorValue(const uint32_t& nChecksum);
@@ -12,6 +12,7 @@
 #include "streams.h"
 #include "util.h"
 #include "utilmoneystr.h"
+#include "validationinterface.h"
 #include "version.h"
 
 #include <boost/circular_buffer.hpp>
@@ -418,12 +419,13 @@ bool CTxMemPool::addUnchecked(const uint256& hash, const CTxMemPoolEntry& entry)
         }
         nTransactionsUpdated++;
         totalTxSize += entry.GetTxSize();
+        GetMainSignals().TransactionAddedToMempool(tx);
     }
     return true;
 }
 
 
-void CTxMemPool::remove(const CTransaction& origTx, std::list<CTransaction>& removed, bool fRecursive)
+void CTxMemPool::remove(const CTransaction& origTx, std::list<CTransaction>& removed, bool fRecursive, bool fInBlock)
 {
     // Remove transaction from memory pool
     {
@@ -460,6 +462,8 @@ void CTxMemPool::remove(const CTransaction& origTx, std::list<CTransaction>& rem
                 mapNextTx.erase(txin.prevout);
 
             removed.push_back(tx);
+            if (!fInBlock)
+                GetMainSignals().TransactionRemovedFromMempool(tx);
             totalTxSize -= mapTx[hash].GetTxSize();
             mapTx.erase(hash);
             nTransactionsUpdated++;
@@ -523,7 +527,7 @@ void CTxMemPool::removeForBlock(const std::vector<CTransaction>& vtx, unsigned i
     minerPolicyEstimator->seenBlock(entries, nBlockHeight, minRelayFee);
     BOOST_FOREACH (const CTransaction& tx, vtx) {
         std::list<CTransaction> dummy;
-        remove(tx, dummy, false);
+        remove(tx, dummy, false, true);
         removeConflicts(tx, conflicts);
         ClearPrioritisation(tx.GetHash());
     }
@@ -7,6 +7,17 @@
 
 #include "validationinterface.h"
 
+#include "main.h"
+#include "primitives/block.h"
+#include "util.h"
+
+#include <deque>
+#include <memory>
+#include <set>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
 static CMainSignals g_signals;
 
 CMainSignals& GetMainSignals()
@@ -14,21 +25,346 @@ CMainSignals& GetMainSignals()
     return g_signals;
 }
 
-void RegisterValidationInterface(CValidationInterface* pwalletIn) {
+/**
+ * Delivers the notifications of the main signals that do not return anything to the asynchronous
+ * listeners, one at a time and in the order they were raised. While the queue thread is not
+ * running notifications are delivered on the thread that raised them.
+ */
+class CValidationQueue
+{
+private:
+    typedef boost::function<void(CValidationInterface*)> Notification;
+
+    struct CListener {
+        CValidationInterface* pListener;
+        CValidationListenerStats stats;
+    };
+
+    //! Held while delivering, so a listener is never called after it was unregistered
+    boost::mutex cs_listeners;
+    std::vector<CListener> vListeners;
+    std::vector<boost::signals2::connection> vConnections;
+
+    mutable boost::mutex cs_queue;
+    boost::condition_variable condQueued;
+    boost::condition_variable condDelivered;
+    std::deque<Notification> queue;
+    //! The registered listeners, for Sync() which must not wait for cs_listeners
+    std::set<CValidationInterface*> setListeners;
+    uint64_t nQueued;
+    uint64_t nDelivered;
+    bool fRunning;
+    //! The queue thread, which must not wait for itself when a listener raises a notification
+    boost::thread::id idThread;
+
+    //! Copy of the last block passed along, shared by BlockConnected and the SyncTransaction of each of its transactions
+    boost::mutex cs_block;
+    const CBlock* pblockLast;
+    std::shared_ptr<const CBlock> pblockLastCopy;
+
+    static void CallUpdatedBlockTip(CValidationInterface* p, const CBlockIndex* pindex) { p->UpdatedBlockTip(pindex); }
+    static void CallSyncTransaction(CValidationInterface* p, const CTransaction& tx, const std::shared_ptr<const CBlock>& pblock) { p->SyncTransaction(tx, pblock.get()); }
+    static void CallNotifyTransactionLock(CValidationInterface* p, const CTransaction& tx) { p->NotifyTransactionLock(tx); }
+    static void CallSetBestChain(CValidationInterface* p, const CBlockLocator& locator) { p->SetBestChain(locator); }
+    static void CallBlockChecked(CValidationInterface* p, const std::shared_ptr<const CBlock>& pblock, const CValidationState& state) { p->BlockChecked(*pblock, state); }
+    static void CallBlockConnected(CValidationInterface* p, const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindex) { p->BlockConnected(*pblock, pindex); }
+    static void CallBlockDisconnected(CValidationInterface* p, const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindex) { p->BlockDisconnected(*pblock, pindex); }
+    static void CallTransactionAddedToMempool(CValidationInterface* p, const CTransaction& tx) { p->TransactionAddedToMempool(tx); }
+    static void CallTransactionRemovedFromMempool(CValidationInterface* p, const CTransaction& tx) { p->TransactionRemovedFromMempool(tx); }
+    static void CallMasternodeWinner(CValidationInterface* p, int nBlockHeight, const COutPoint& outpoint, const CScript& payee) { p->MasternodeWinner(nBlockHeight, outpoint, payee); }
+
+    //! Whether the copy is still of *pblock, which may have been changed or reused since, without hashing it
+    static bool IsCopyOf(const CBlock& copy, const CBlock& block)
+    {
+        return copy.nVersion == block.nVersion && copy.hashPrevBlock == block.hashPrevBlock &&
+               copy.hashMerkleRoot == block.hashMerkleRoot && copy.nTime == block.nTime &&
+               copy.nBits == block.nBits && copy.nNonce == block.nNonce &&
+               copy.nAccumulatorCheckpoint == block.nAccumulatorCheckpoint && copy.vtx.size() == block.vtx.size();
+    }
+
+    std::shared_ptr<const CBlock> ShareBlock(const CBlock* pblock)
+    {
+        boost::unique_lock<boost::mutex> lock(cs_block);
+        if (pblock != pblockLast || !pblockLastCopy || !IsCopyOf(*pblockLastCopy, *pblock)) {
+            pblockLastCopy = std::make_shared<const CBlock>(*pblock);
+            pblockLast = pblock;
+        }
+        return pblockLastCopy;
+    }
+
+    void UpdatedBlockTip(const CBlockIndex* pindex)
+    {
+        Enqueue(boost::bind(&CValidationQueue::CallUpdatedBlockTip, _1, pindex));
+    }
+
+    void SyncTransaction(const CTransaction& tx, const CBlock* pblock)
+    {
+        std::shared_ptr<const CBlock> pblockCopy;
+        if (pblock)
+            pblockCopy = ShareBlock(pblock);
+        Enqueue(boost::bind(&CValidationQueue::CallSyncTransaction, _1, tx, pblockCopy));
+    }
+
+    void NotifyTransactionLock(const CTransaction& tx)
+    {
+        Enqueue(boost::bind(&CValidationQueue::CallNotifyTransactionLock, _1, tx));
+    }
+
+    void SetBestChain(const CBlockLocator& locator)
+    {
+        Enqueue(boost::bind(&CValidationQueue::CallSetBestChain, _1, locator));
+    }
+
+    void BlockChecked(const CBlock& block, const CValidationState& state)
+    {
+        // Shared with the BlockConnected and SyncTransaction notifications that follow
+        Enqueue(boost::bind(&CValidationQueue::CallBlockChecked, _1, ShareBlock(&block), state));
+    }
+
+    void BlockConnected(const CBlock& block, const CBlockIndex* pindex)
+    {
+        Enqueue(boost::bind(&CValidationQueue::CallBlockConnected, _1, ShareBlock(&block), pindex));
+    }
+
+    void BlockDisconnected(const CBlock& block, const CBlockIndex* pindex)
+    {
+        Enqueue(boost::bind(&CValidationQueue::CallBlockDisconnected, _1, ShareBlock(&block), pindex));
+    }
+
+    void TransactionAddedToMempool(const CTransaction& tx)
+    {
+        Enqueue(boost::bind(&CValidationQueue::CallTransactionAddedToMempool, _1, tx));
+    }
+
+    void TransactionRemovedFromMempool(const CTransaction& tx)
+    {
+        Enqueue(boost::bind(&CValidationQueue::CallTransactionRemovedFromMempool, _1, tx));
+    }
+
+    void MasternodeWinner(int nBlockHeight, const COutPoint& outpoint, const CScript& payee)
+    {
+        Enqueue(boost::bind(&CValidationQueue::CallMasternodeWinner, _1, nBlockHeight, outpoint, payee));
+    }
+
+    void Enqueue(const Notification& notification)
+    {
+        {
+            boost::unique_lock<boost::mutex> lock(cs_queue);
+            while (fRunning && queue.size() >= MAX_VALIDATION_QUEUE && boost::this_thread::get_id() != idThread)
+                condDelivered.wait(lock);
+            if (fRunning) {
+                queue.push_back(notification);
+                nQueued++;
+                condQueued.notify_one();
+                return;
+            }
+        }
+        Deliver(notification);
+    }
+
+    void Deliver(const Notification& notification)
+    {
+        boost::unique_lock<boost::mutex> lock(cs_listeners);
+        for (std::vector<CListener>::iterator it = vListeners.begin(); it != vListeners.end(); ++it) {
+            int64_t nStart = GetTimeMicros();
+            try {
+                notification(it->pListener);
+            } catch (const std::exception& e) {
+                LogPrintf("%s: %s listener threw: %s\n", __func__, it->stats.strName, e.what());
+            }
+            int64_t nElapsed = GetTimeMicros() - nStart;
+
+            CValidationListenerStats& stats = it->stats;
+            stats.nCalls++;
+            stats.nTotalMicros += nElapsed;
+            stats.nMaxMicros = std::max(stats.nMaxMicros, nElapsed);
+            int nBucket = 0;
+            for (int64_t nBound = 100; nBucket < VALIDATION_LATENCY_BUCKETS - 1 && nElapsed >= nBound; nBound *= 10)
+                nBucket++;
+            stats.vLatency[nBucket]++;
+        }
+    }
+
+public:
+    CValidationQueue() : nQueued(0), nDelivered(0), fRunning(false), pblockLast(NULL) {}
+
+    void AddListener(CValidationInterface* pListener, const std::string& strName)
+    {
+        boost::unique_lock<boost::mutex> lock(cs_listeners);
+        CListener listener;
+        listener.pListener = pListener;
+        listener.stats.strName = strName;
+        vListeners.push_back(listener);
+        {
+            boost::unique_lock<boost::mutex> lockQueue(cs_queue);
+            setListeners.insert(pListener);
+        }
+
+        if (vConnections.empty()) {
+            vConnections.push_back(g_signals.UpdatedBlockTip.connect(boost::bind(&CValidationQueue::UpdatedBlockTip, this, _1)));
+            vConnections.push_back(g_signals.SyncTransaction.connect(boost::bind(&CValidationQueue::SyncTransaction, this, _1, _2)));
+            vConnections.push_back(g_signals.NotifyTransactionLock.connect(boost::bind(&CValidationQueue::NotifyTransactionLock, this, _1)));
+            vConnections.push_back(g_signals.SetBestChain.connect(boost::bind(&CValidationQueue::SetBestChain, this, _1)));
+            vConnections.push_back(g_signals.BlockChecked.connect(boost::bind(&CValidationQueue::BlockChecked, this, _1, _2)));
+            vConnections.push_back(g_signals.BlockConnected.connect(boost::bind(&CValidationQueue::BlockConnected, this, _1, _2)));
+            vConnections.push_back(g_signals.BlockDisconnected.connect(boost::bind(&CValidationQueue::BlockDisconnected, this, _1, _2)));
+            vConnections.push_back(g_signals.TransactionAddedToMempool.connect(boost::bind(&CValidationQueue::TransactionAddedToMempool, this, _1)));
+            vConnections.push_back(g_signals.TransactionRemovedFromMempool.connect(boost::bind(&CValidationQueue::TransactionRemovedFromMempool, this, _1)));
+            vConnections.push_back(g_signals.MasternodeWinner.connect(boost::bind(&CValidationQueue::MasternodeWinner, this, _1, _2, _3)));
+        }
+    }
+
+    void RemoveListener(CValidationInterface* pListener)
+    {
+        boost::unique_lock<boost::mutex> lock(cs_listeners);
+        for (std::vector<CListener>::iterator it = vListeners.begin(); it != vListeners.end();) {
+            if (it->pListener == pListener)
+                it = vListeners.erase(it);
+            else
+                ++it;
+        }
+        {
+            boost::unique_lock<boost::mutex> lockQueue(cs_queue);
+            setListeners.erase(pListener);
+        }
+
+        if (vListeners.empty()) {
+            for (std::vector<boost::signals2::connection>::iterator it = vConnections.begin(); it != vConnections.end(); ++it)
+                it->disconnect();
+            vConnections.clear();
+        }
+    }
+
+    void RemoveAllListeners()
+    {
+        boost::unique_lock<boost::mutex> lock(cs_listeners);
+        vListeners.clear();
+        vConnections.clear();
+        boost::unique_lock<boost::mutex> lockQueue(cs_queue);
+        setListeners.clear();
+    }
+
+    void Thread()
+    {
+        RenameThread("kyd-validation");
+        {
+            boost::unique_lock<boost::mutex> lock(cs_queue);
+            idThread = boost::this_thread::get_id();
+        }
+
+        try {
+            while (true) {
+                Notification notification;
+                {
+                    boost::unique_lock<boost::mutex> lock(cs_queue);
+                    while (queue.empty())
+                        condQueued.wait(lock);
+                    notification = queue.front();
+                    queue.pop_front();
+                    // Make room for a producer waiting on a full queue right away, not after delivering
+                    if (queue.size() == MAX_VALIDATION_QUEUE - 1)
+                        condDelivered.notify_all();
+                }
+
+                Deliver(notification);
+
+                {
+                    boost::unique_lock<boost::mutex> lock(cs_queue);
+                    nDelivered++;
+                    condDelivered.notify_all();
+                }
+            }
+        } catch (...) {
+            // Interrupted: nobody delivers the queue any more, so deliver what is left and wake Sync()
+            Stop();
+            throw;
+        }
+    }
+
+    void Start(boost::thread_group& threadGroup)
+    {
+        {
+            boost::unique_lock<boost::mutex> lock(cs_queue);
+            if (fRunning)
+                return;
+            fRunning = true;
+        }
+        threadGroup.create_thread(boost::bind(&CValidationQueue::Thread, this));
+    }
+
+    void Stop()
+    {
+        std::deque<Notification> queueLeft;
+        {
+            boost::unique_lock<boost::mutex> lock(cs_queue);
+            fRunning = false;
+            queueLeft.swap(queue);
+        }
+
+        for (std::deque<Notification>::iterator it = queueLeft.begin(); it != queueLeft.end(); ++it)
+            Deliver(*it);
+
+        boost::unique_lock<boost::mutex> lock(cs_queue);
+        nDelivered = nQueued;
+        condDelivered.notify_all();
+    }
+
+    void Sync(CValidationInterface* pListener)
+    {
+        boost::unique_lock<boost::mutex> lock(cs_queue);
+        if (!setListeners.count(pListener))
+            return;
+        uint64_t nTarget = nQueued;
+        while (fRunning && nDelivered < nTarget)
+            condDelivered.wait(lock);
+    }
+
+    void GetStats(size_t& nQueuedRet, std::vector<CValidationListenerStats>& vStatsRet)
+    {
+        {
+            boost::unique_lock<boost::mutex> lock(cs_queue);
+            nQueuedRet = queue.size();
+        }
+
+        boost::unique_lock<boost::mutex> lock(cs_listeners);
+        vStatsRet.clear();
+        for (std::vector<CListener>::const_iterator it = vListeners.begin(); it != vListeners.end(); ++it)
+            vStatsRet.push_back(it->stats);
+    }
+};
+
+static CValidationQueue validationQueue;
+
+void RegisterValidationInterface(CValidationInterface* pwalletIn, bool fAsync, const std::string& strName) {
 // XX42 g_signals.EraseTransaction.connect(boost::bind(&CValidationInterface::EraseFromWallet, pwalletIn, _1));
-    g_signals.UpdatedBlockTip.connect(boost::bind(&CValidationInterface::UpdatedBlockTip, pwalletIn, _1));
-    g_signals.SyncTransaction.connect(boost::bind(&CValidationInterface::SyncTransaction, pwalletIn, _1, _2));
-    g_signals.NotifyTransactionLock.connect(boost::bind(&CValidationInterface::NotifyTransactionLock, pwalletIn, _1));
+    if (fAsync) {
+        validationQueue.AddListener(pwalletIn, strName);
+    } else {
+        g_signals.UpdatedBlockTip.connect(boost::bind(&CValidationInterface::UpdatedBlockTip, pwalletIn, _1));
+        g_signals.SyncTransaction.connect(boost::bind(&CValidationInterface::SyncTransaction, pwalletIn, _1, _2));
+        g_signals.NotifyTransactionLock.connect(boost::bind(&CValidationInterface::NotifyTransactionLock, pwalletIn, _1));
+        g_signals.SetBestChain.connect(boost::bind(&CValidationInterface::SetBestChain, pwalletIn, _1));
+        g_signals.BlockChecked.connect(boost::bind(&CValidationInterface::BlockChecked, pwalletIn, _1, _2));
+        g_signals.BlockConnected.connect(boost::bind(&CValidationInterface::BlockConnected, pwalletIn, _1, _2));
+        g_signals.BlockDisconnected.connect(boost::bind(&CValidationInterface::BlockDisconnected, pwalletIn, _1, _2));
+        g_signals.TransactionAddedToMempool.connect(boost::bind(&CValidationInterface::TransactionAddedToMempool, pwalletIn, _1));
+        g_signals.TransactionRemovedFromMempool.connect(boost::bind(&CValidationInterface::TransactionRemovedFromMempool, pwalletIn, _1));
+        g_signals.MasternodeWinner.connect(boost::bind(&CValidationInterface::MasternodeWinner, pwalletIn, _1, _2, _3));
+    }
     g_signals.UpdatedTransaction.connect(boost::bind(&CValidationInterface::UpdatedTransaction, pwalletIn, _1));
-    g_signals.SetBestChain.connect(boost::bind(&CValidationInterface::SetBestChain, pwalletIn, _1));
     g_signals.Inventory.connect(boost::bind(&CValidationInterface::Inventory, pwalletIn, _1));
     g_signals.Broadcast.connect(boost::bind(&CValidationInterface::ResendWalletTransactions, pwalletIn));
-    g_signals.BlockChecked.connect(boost::bind(&CValidationInterface::BlockChecked, pwalletIn, _1, _2));
 // XX42    g_signals.ScriptForMining.connect(boost::bind(&CValidationInterface::GetScriptForMining, pwalletIn, _1));
     g_signals.BlockFound.connect(boost::bind(&CValidationInterface::ResetRequestCount, pwalletIn, _1));
 }
 
 void UnregisterValidationInterface(CValidationInterface* pwalletIn) {
+    validationQueue.RemoveListener(pwalletIn);
+    g_signals.MasternodeWinner.disconnect(boost::bind(&CValidationInterface::MasternodeWinner, pwalletIn, _1, _2, _3));
+    g_signals.TransactionRemovedFromMempool.disconnect(boost::bind(&CValidationInterface::TransactionRemovedFromMempool, pwalletIn, _1));
+    g_signals.TransactionAddedToMempool.disconnect(boost::bind(&CValidationInterface::TransactionAddedToMempool, pwalletIn, _1));
+    g_signals.BlockDisconnected.disconnect(boost::bind(&CValidationInterface::BlockDisconnected, pwalletIn, _1, _2));
+    g_signals.BlockConnected.disconnect(boost::bind(&CValidationInterface::BlockConnected, pwalletIn, _1, _2));
     g_signals.BlockFound.disconnect(boost::bind(&CValidationInterface::ResetRequestCount, pwalletIn, _1));
 // XX42    g_signals.ScriptForMining.disconnect(boost::bind(&CValidationInterface::GetScriptForMining, pwalletIn, _1));
     g_signals.BlockChecked.disconnect(boost::bind(&CValidationInterface::BlockChecked, pwalletIn, _1, _2));
@@ -43,6 +379,12 @@ void UnregisterValidationInterface(CValidationInterface* pwalletIn) {
 }
 
 void UnregisterAllValidationInterfaces() {
+    validationQueue.RemoveAllListeners();
+    g_signals.MasternodeWinner.disconnect_all_slots();
+    g_signals.TransactionRemovedFromMempool.disconnect_all_slots();
+    g_signals.TransactionAddedToMempool.disconnect_all_slots();
+    g_signals.BlockDisconnected.disconnect_all_slots();
+    g_signals.BlockConnected.disconnect_all_slots();
     g_signals.BlockFound.disconnect_all_slots();
 // XX42    g_signals.ScriptForMining.disconnect_all_slots();
     g_signals.BlockChecked.disconnect_all_slots();
@@ -59,3 +401,23 @@ void UnregisterAllValidationInterfaces() {
 void SyncWithWallets(const CTransaction &tx, const CBlock *pblock = NULL) {
     g_signals.SyncTransaction(tx, pblock);
 }
+
+void StartValidationQueue(boost::thread_group& threadGroup)
+{
+    validationQueue.Start(threadGroup);
+}
+
+void StopValidationQueue()
+{
+    validationQueue.Stop();
+}
+
+void SyncWithValidationQueue(CValidationInterface* pListener)
+{
+    validationQueue.Sync(pListener);
+}
+
+void GetValidationQueueStats(size_t& nQueuedRet, std::vector<CValidationListenerStats>& vStatsRet)
+{
+    validationQueue.GetStats(nQueuedRet, vStatsRet);
+}
@@ -8,22 +8,55 @@
 #ifndef BITCOIN_VALIDATIONINTERFACE_H
 #define BITCOIN_VALIDATIONINTERFACE_H
 
+#include <stdint.h>
+#include <string>
+#include <vector>
+
 #include <boost/signals2/signal.hpp>
 #include <boost/shared_ptr.hpp>
 
+namespace boost
+{
+class thread_group;
+} // namespace boost
+
 class CBlock;
 struct CBlockLocator;
 class CBlockIndex;
+class COutPoint;
 class CReserveScript;
+class CScript;
 class CTransaction;
 class CValidationInterface;
+class CValidationQueue;
 class CValidationState;
 class uint256;
 
+//! Notifications waiting for the validation queue thread before the thread raising them waits for it to catch up
+static const size_t MAX_VALIDATION_QUEUE = 10000;
+//! Number of buckets of the callback latency histogram, bucket n counts callbacks that took less than 100us * 10^n
+static const int VALIDATION_LATENCY_BUCKETS = 6;
+
+/** Delivery statistics of a listener registered as asynchronous */
+struct CValidationListenerStats {
+    std::string strName;
+    uint64_t nCalls;
+    int64_t nTotalMicros;
+    int64_t nMaxMicros;
+    std::vector<uint64_t> vLatency;
+
+    CValidationListenerStats() : nCalls(0), nTotalMicros(0), nMaxMicros(0), vLatency(VALIDATION_LATENCY_BUCKETS, 0) {}
+};
+
 // These functions dispatch to one or all registered wallets
 
-/** Register a wallet to receive updates from core */
-void RegisterValidationInterface(CValidationInterface* pwalletIn);
+/**
+ * Register a wallet to receive updates from core. An asynchronous listener gets the notifications
+ * that do not return anything in order from the validation queue thread, after cs_main has been
+ * released, instead of from inside validation. It must not take cs_main: validation waits with
+ * cs_main held while the queue is full.
+ */
+void RegisterValidationInterface(CValidationInterface* pwalletIn, bool fAsync = false, const std::string& strName = "");
 /** Unregister a wallet from core */
 void UnregisterValidationInterface(CValidationInterface* pwalletIn);
 /** Unregister all wallets from core */
@@ -31,6 +64,19 @@ void UnregisterAllValidationInterfaces();
 /** Push an updated transaction to all registered wallets */
 void SyncWithWallets(const CTransaction& tx, const CBlock* pblock);
 
+/** Start the thread delivering notifications to asynchronous listeners */
+void StartValidationQueue(boost::thread_group& threadGroup);
+/** Deliver what is still queued on the calling thread; later notifications are delivered synchronously */
+void StopValidationQueue();
+/**
+ * Wait until every notification queued before the call has been delivered, for callers that
+ * need pListener to be up to date. Returns at once if pListener is not asynchronous. Must not
+ * be called with cs_main held.
+ */
+void SyncWithValidationQueue(CValidationInterface* pListener);
+/** Number of queued notifications and the delivery statistics of the asynchronous listeners */
+void GetValidationQueueStats(size_t& nQueuedRet, std::vector<CValidationListenerStats>& vStatsRet);
+
 class CValidationInterface {
 protected:
 // XX42    virtual void EraseFromWallet(const uint256& hash){};
@@ -43,9 +89,15 @@ protected:
 // XX42    virtual void ResendWalletTransactions(int64_t nBestBlockTime) {}
     virtual void ResendWalletTransactions() {}
     virtual void BlockChecked(const CBlock&, const CValidationState&) {}
+    virtual void BlockConnected(const CBlock &block, const CBlockIndex *pindex) {}
+    virtual void BlockDisconnected(const CBlock &block, const CBlockIndex *pindex) {}
+    virtual void TransactionAddedToMempool(const CTransaction &tx) {}
+    virtual void TransactionRemovedFromMempool(const CTransaction &tx) {}
+    virtual void MasternodeWinner(int nBlockHeight, const COutPoint &outpointMasternode, const CScript &payee) {}
 // XX42    virtual void GetScriptForMining(boost::shared_ptr<CReserveScript>&) {};
     virtual void ResetRequestCount(const uint256 &hash) {};
-    friend void ::RegisterValidationInterface(CValidationInterface*);
+    friend class ::CValidationQueue;
+    friend void ::RegisterValidationInterface(CValidationInterface*, bool, const std::string&);
     friend void ::UnregisterValidationInterface(CValidationInterface*);
     friend void ::UnregisterAllValidationInterfaces();
 };
@@ -69,6 +121,16 @@ struct CMainSignals {
     boost::signals2::signal<void ()> Broadcast;
     /** Notifies listeners of a block validation result */
     boost::signals2::signal<void (const CBlock&, const CValidationState&)> BlockChecked;
+    /** Notifies listeners of a block connected to the active chain */
+    boost::signals2::signal<void (const CBlock&, const CBlockIndex*)> BlockConnected;
+    /** Notifies listeners of a block disconnected from the active chain */
+    boost::signals2::signal<void (const CBlock&, const CBlockIndex*)> BlockDisconnected;
+    /** Notifies listeners of a transaction entering the memory pool */
+    boost::signals2::signal<void (const CTransaction&)> TransactionAddedToMempool;
+    /** Notifies listeners of a transaction leaving the memory pool for any reason but being included in a block */
+    boost::signals2::signal<void (const CTransaction&)> TransactionRemovedFromMempool;
+    /** Notifies listeners of a new masternode payment winner vote */
+    boost::signals2::signal<void (int, const COutPoint&, const CScript&)> MasternodeWinner;
     /** Notifies listeners that a key for mining is required (coinbase) */
 // XX42    boost::signals2::signal<void (boost::shared_ptr<CReserveScript>&)> ScriptForMining;
     /** Notifies listeners that a block has been successfully mined */
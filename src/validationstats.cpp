@@ -0,0 +1,109 @@
+// Copyright (c) 2018-2019 The KYD developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "validationstats.h"
+
+#include "utiltime.h"
+
+#include <algorithm>
+
+CValidationStats validationStats;
+
+const char* GetValidationStageName(int nStage)
+{
+    switch (nStage) {
+    case VALIDATION_STAGE_READ_DISK: return "read_disk";
+    case VALIDATION_STAGE_CHECK_BLOCK: return "check_block";
+    case VALIDATION_STAGE_CHECK_STAKE: return "check_stake";
+    case VALIDATION_STAGE_ZEROCOIN: return "zerocoin";
+    case VALIDATION_STAGE_SCRIPTS: return "scripts";
+    case VALIDATION_STAGE_ACCUMULATOR: return "accumulator_checkpoint";
+    case VALIDATION_STAGE_SUPPLY: return "supply";
+    case VALIDATION_STAGE_CONNECT: return "connect_block";
+    case VALIDATION_STAGE_INDEX: return "undo_and_index";
+    case VALIDATION_STAGE_FLUSH: return "flush";
+    case VALIDATION_STAGE_SIGNALS: return "signals";
+    case VALIDATION_STAGE_TOTAL: return "total";
+    default: return "unknown";
+    }
+}
+
+int64_t ValidationStagePercentile(const std::vector<int64_t>& vSorted, int nPercent)
+{
+    if (vSorted.empty())
+        return 0;
+    // The smallest value that at least nPercent percent of the values are at or below
+    size_t nRank = (vSorted.size() * nPercent + 99) / 100;
+    return vSorted[std::min(vSorted.size(), std::max(nRank, (size_t)1)) - 1];
+}
+
+CBlockValidationTimes::CBlockValidationTimes() : nHeight(-1), nTx(0), nTimeConnected(0)
+{
+    for (int i = 0; i < VALIDATION_STAGE_COUNT; i++)
+        vMicros[i] = 0;
+}
+
+CValidationStats::CValidationStats() : fCurrent(false), nNext(0)
+{
+}
+
+void CValidationStats::AddPending(const uint256& hashBlock, BlockValidationStage stage, int64_t nMicros)
+{
+    LOCK(cs);
+    std::map<uint256, CBlockValidationTimes>::iterator it = mapPending.find(hashBlock);
+    if (it == mapPending.end()) {
+        // Blocks that never get connected must not pile up; which one goes does not matter
+        if (mapPending.size() >= VALIDATION_STATS_PENDING)
+            mapPending.erase(mapPending.begin());
+        it = mapPending.insert(std::make_pair(hashBlock, CBlockValidationTimes())).first;
+    }
+    it->second.vMicros[stage] += nMicros;
+}
+
+void CValidationStats::BeginBlock(const uint256& hashBlock, int nHeight, unsigned int nTx)
+{
+    LOCK(cs);
+    current = CBlockValidationTimes();
+    std::map<uint256, CBlockValidationTimes>::iterator it = mapPending.find(hashBlock);
+    if (it != mapPending.end()) {
+        current = it->second;
+        mapPending.erase(it);
+    }
+    current.hashBlock = hashBlock;
+    current.nHeight = nHeight;
+    current.nTx = nTx;
+    fCurrent = true;
+}
+
+void CValidationStats::Add(BlockValidationStage stage, int64_t nMicros)
+{
+    LOCK(cs);
+    if (fCurrent)
+        current.vMicros[stage] += nMicros;
+}
+
+void CValidationStats::CommitBlock()
+{
+    LOCK(cs);
+    if (!fCurrent)
+        return;
+    fCurrent = false;
+    current.nTimeConnected = GetTime();
+
+    if (vBlocks.size() < VALIDATION_STATS_BLOCKS) {
+        vBlocks.push_back(current);
+    } else {
+        vBlocks[nNext] = current;
+    }
+    nNext = (nNext + 1) % VALIDATION_STATS_BLOCKS;
+}
+
+void CValidationStats::GetRecent(size_t nCount, std::vector<CBlockValidationTimes>& vRecent) const
+{
+    LOCK(cs);
+    vRecent.clear();
+    nCount = std::min(nCount, vBlocks.size());
+    for (size_t i = 1; i <= nCount; i++)
+        vRecent.push_back(vBlocks[(nNext + VALIDATION_STATS_BLOCKS - i) % VALIDATION_STATS_BLOCKS]);
+}
@@ -0,0 +1,82 @@
+// Copyright (c) 2018-2019 The KYD developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef KYD_VALIDATIONSTATS_H
+#define KYD_VALIDATIONSTATS_H
+
+#include "sync.h"
+#include "uint256.h"
+
+#include <map>
+#include <stdint.h>
+#include <vector>
+
+//! Number of connected blocks whose timings are kept
+static const size_t VALIDATION_STATS_BLOCKS = 1000;
+//! Blocks checked but not connected yet whose early timings are kept
+static const size_t VALIDATION_STATS_PENDING = 100;
+
+/** The parts of connecting a block to the tip that are timed */
+enum BlockValidationStage {
+    VALIDATION_STAGE_READ_DISK,    //!< Reading the block from disk in ConnectTip
+    VALIDATION_STAGE_CHECK_BLOCK,  //!< CheckBlock, when the block arrived or in ConnectBlock
+    VALIDATION_STAGE_CHECK_STAKE,  //!< CheckProofOfStake in AcceptBlock
+    VALIDATION_STAGE_ZEROCOIN,     //!< Contextual checks of zerocoin spends and mints
+    VALIDATION_STAGE_SCRIPTS,      //!< CheckInputs plus waiting for the script check threads
+    VALIDATION_STAGE_ACCUMULATOR,  //!< ValidateAccumulatorCheckpoint
+    VALIDATION_STAGE_SUPPLY,       //!< Money and zKYD supply accounting
+    VALIDATION_STAGE_CONNECT,      //!< The whole of ConnectBlock
+    VALIDATION_STAGE_INDEX,        //!< Writing undo data and the optional indexes
+    VALIDATION_STAGE_FLUSH,        //!< Flushing the block's coins into pcoinsTip and the chainstate to disk
+    VALIDATION_STAGE_SIGNALS,      //!< BlockChecked, BlockConnected and wallet notifications
+    VALIDATION_STAGE_TOTAL,        //!< The whole of ConnectTip
+    VALIDATION_STAGE_COUNT
+};
+
+const char* GetValidationStageName(int nStage);
+/** The nPercent'th percentile of the sorted vSorted by nearest rank, 0 if it is empty */
+int64_t ValidationStagePercentile(const std::vector<int64_t>& vSorted, int nPercent);
+
+/** Microseconds spent in every stage while connecting one block */
+struct CBlockValidationTimes {
+    uint256 hashBlock;
+    int nHeight;
+    unsigned int nTx;
+    int64_t nTimeConnected;
+    int64_t vMicros[VALIDATION_STAGE_COUNT];
+
+    CBlockValidationTimes();
+};
+
+/**
+ * Timings of the most recently connected blocks. ConnectTip opens a record with BeginBlock, the
+ * code it calls adds to it with Add, and CommitBlock stores it once the block is on the tip.
+ * Stages that run before ConnectTip, possibly in another thread, are recorded by hash with
+ * AddPending and merged into the record when that block gets connected.
+ */
+class CValidationStats
+{
+private:
+    mutable CCriticalSection cs;
+    std::map<uint256, CBlockValidationTimes> mapPending;
+    CBlockValidationTimes current;
+    bool fCurrent;
+    std::vector<CBlockValidationTimes> vBlocks;
+    size_t nNext;
+
+public:
+    CValidationStats();
+
+    void AddPending(const uint256& hashBlock, BlockValidationStage stage, int64_t nMicros);
+    void BeginBlock(const uint256& hashBlock, int nHeight, unsigned int nTx);
+    void Add(BlockValidationStage stage, int64_t nMicros);
+    void CommitBlock();
+
+    /** The last nCount connected blocks, newest first */
+    void GetRecent(size_t nCount, std::vector<CBlockValidationTimes>& vRecent) const;
+};
+
+extern CValidationStats validationStats;
+
+#endif // KYD_VALIDATIONSTATS_H
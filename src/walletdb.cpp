@@ -18,6 +18,7 @@
 #include "wallet.h"
 #include <primitives/deterministicmint.h>
 
+#include <boost/bind.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/foreach.hpp>
 #include <boost/scoped_ptr.hpp>
@@ -473,13 +474,188 @@ public:
     }
 };
 
-bool ReadKeyValue(CWallet* pwallet, CDataStream& ssKey, CDataStream& ssValue, CWalletScanState& wss, string& strType, string& strErr)
+/**
+ * A single wallet.dat record as read by the cursor pass of LoadWallet.
+ * Transactions and keys make up the bulk of a wallet and of the cost of
+ * loading it, so they are decoded and verified by worker threads first and
+ * only applied to the wallet, in cursor order, afterwards.
+ *
+ * The Decode*Record functions run on those workers. They only write to their
+ * own record and must not touch the wallet, the chain or any other shared
+ * mutable state. What they call relies on state that is fixed before the
+ * wallet is loaded: the chain params, the secp256k1 signing context set up by
+ * ECC_Start and the OpenSSL locking set up at startup for GetRandBytes.
+ */
+class CWalletLoadRecord
+{
+public:
+    std::string strType;
+    CDataStream ssKey;
+    CDataStream ssValue;
+
+    // Set by the decode pass
+    bool fDecoded;
+    bool fValid;
+    std::string strErr;
+
+    // "tx" records
+    uint256 hash;
+    CWalletTx wtx;
+    bool fUpgraded;
+
+    // "key", "wkey" and "ckey" records
+    CPubKey vchPubKey;
+    CKey key;
+    std::vector<unsigned char> vchCryptedSecret;
+
+    CWalletLoadRecord(const std::string& strTypeIn = "") : strType(strTypeIn), ssKey(SER_DISK, CLIENT_VERSION), ssValue(SER_DISK, CLIENT_VERSION)
+    {
+        fDecoded = false;
+        fValid = false;
+        fUpgraded = false;
+    }
+};
+
+/** Deserialize and check a "tx" record. Does not touch the wallet and is safe to run on a worker thread. */
+static bool DecodeTxRecord(CDataStream& ssKey, CDataStream& ssValue, CWalletLoadRecord& rec)
+{
+    ssKey >> rec.hash;
+    ssValue >> rec.wtx;
+    CValidationState state;
+    // false because there is no reason to go through the zerocoin checks for our own wallet.
+    // This is also what makes it safe on a worker: without them CheckTransaction only reads
+    // the chain params, the zerocoin spend checks would read chainActive and the zerocoin params.
+    if (!(CheckTransaction(rec.wtx, false, false, state) && (rec.wtx.GetHash() == rec.hash) && state.IsValid()))
+        return false;
+
+    // Undo serialize changes in 31600
+    CWalletTx& wtx = rec.wtx;
+    if (31404 <= wtx.fTimeReceivedIsTxTime && wtx.fTimeReceivedIsTxTime <= 31703) {
+        if (!ssValue.empty()) {
+            char fTmp;
+            char fUnused;
+            ssValue >> fTmp >> fUnused >> wtx.strFromAccount;
+            rec.strErr = strprintf("LoadWallet() upgrading tx ver=%d %d '%s' %s",
+                wtx.fTimeReceivedIsTxTime, fTmp, wtx.strFromAccount, rec.hash.ToString());
+            wtx.fTimeReceivedIsTxTime = fTmp;
+        } else {
+            rec.strErr = strprintf("LoadWallet() repairing tx ver=%d %s", wtx.fTimeReceivedIsTxTime, rec.hash.ToString());
+            wtx.fTimeReceivedIsTxTime = 0;
+        }
+        rec.fUpgraded = true;
+    }
+    return true;
+}
+
+static void LoadTxRecord(CWallet* pwallet, const CWalletLoadRecord& rec, CWalletScanState& wss)
+{
+    if (rec.fUpgraded)
+        wss.vWalletUpgrade.push_back(rec.hash);
+
+    if (rec.wtx.nOrderPos == -1)
+        wss.fAnyUnordered = true;
+
+    pwallet->AddToWallet(rec.wtx, true);
+}
+
+/** Deserialize and verify a "key" or "wkey" record. Safe to run on a worker thread. */
+static bool DecodeKeyRecord(CDataStream& ssKey, CDataStream& ssValue, CWalletLoadRecord& rec)
+{
+    ssKey >> rec.vchPubKey;
+    if (!rec.vchPubKey.IsValid()) {
+        rec.strErr = "Error reading wallet database: CPubKey corrupt";
+        return false;
+    }
+    CPrivKey pkey;
+    uint256 hash = 0;
+
+    if (rec.strType == "key") {
+        ssValue >> pkey;
+    } else {
+        CWalletKey wkey;
+        ssValue >> wkey;
+        pkey = wkey.vchPrivKey;
+    }
+
+    // Old wallets store keys as "key" [pubkey] => [privkey]
+    // ... which was slow for wallets with lots of keys, because the public key is re-derived from the private key
+    // using EC operations as a checksum.
+    // Newer wallets store keys as "key"[pubkey] => [privkey][hash(pubkey,privkey)], which is much faster while
+    // remaining backwards-compatible.
+    try {
+        ssValue >> hash;
+    } catch (...) {
+    }
+
+    bool fSkipCheck = false;
+
+    if (hash != 0) {
+        // hash pubkey/privkey to accelerate wallet load
+        std::vector<unsigned char> vchKey;
+        vchKey.reserve(rec.vchPubKey.size() + pkey.size());
+        vchKey.insert(vchKey.end(), rec.vchPubKey.begin(), rec.vchPubKey.end());
+        vchKey.insert(vchKey.end(), pkey.begin(), pkey.end());
+
+        if (Hash(vchKey.begin(), vchKey.end()) != hash) {
+            rec.strErr = "Error reading wallet database: CPubKey/CPrivKey corrupt";
+            return false;
+        }
+
+        fSkipCheck = true;
+    }
+
+    if (!rec.key.Load(pkey, rec.vchPubKey, fSkipCheck)) {
+        rec.strErr = "Error reading wallet database: CPrivKey corrupt";
+        return false;
+    }
+    return true;
+}
+
+static bool LoadKeyRecord(CWallet* pwallet, const CWalletLoadRecord& rec, CWalletScanState& wss, string& strErr)
+{
+    if (rec.strType == "key")
+        wss.nKeys++;
+
+    if (!pwallet->LoadKey(rec.key, rec.vchPubKey)) {
+        strErr = "Error reading wallet database: LoadKey failed";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Deserialize a "ckey" record. Safe to run on a worker thread. The secret can only be checked
+ * against the public key once the wallet is unlocked, CCryptoKeyStore::Unlock does that.
+ */
+static bool DecodeCryptedKeyRecord(CDataStream& ssKey, CDataStream& ssValue, CWalletLoadRecord& rec)
+{
+    ssKey >> rec.vchPubKey;
+    if (!rec.vchPubKey.IsValid()) {
+        rec.strErr = "Error reading wallet database: CPubKey corrupt";
+        return false;
+    }
+    ssValue >> rec.vchCryptedSecret;
+    return true;
+}
+
+static bool LoadCryptedKeyRecord(CWallet* pwallet, const CWalletLoadRecord& rec, CWalletScanState& wss, string& strErr)
+{
+    wss.nCKeys++;
+
+    if (!pwallet->LoadCryptedKey(rec.vchPubKey, rec.vchCryptedSecret)) {
+        strErr = "Error reading wallet database: LoadCryptedKey failed";
+        return false;
+    }
+    wss.fIsEncrypted = true;
+    return true;
+}
+
+static bool ReadTypedKeyValue(CWallet* pwallet, CDataStream& ssKey, CDataStream& ssValue, CWalletScanState& wss, const string& strType, string& strErr)
 {
     try {
         // Unserialize
         // Taking advantage of the fact that pair serialization
         // is just the two items serialized one after the other
-        ssKey >> strType;
         if (strType == "name") {
             string strAddress;
             ssKey >> strAddress;
@@ -489,35 +665,11 @@ bool ReadKeyValue(CWallet* pwallet, CDataStream& ssKey, CDataStream& ssValue, CW
             ssKey >> strAddress;
             ssValue >> pwallet->mapAddressBook[CBitcoinAddress(strAddress).Get()].purpose;
         } else if (strType == "tx") {
-            uint256 hash;
-            ssKey >> hash;
-            CWalletTx wtx;
-            ssValue >> wtx;
-            CValidationState state;
-            // false because there is no reason to go through the zerocoin checks for our own wallet
-            if (!(CheckTransaction(wtx, false, false, state) && (wtx.GetHash() == hash) && state.IsValid()))
+            CWalletLoadRecord rec(strType);
+            if (!DecodeTxRecord(ssKey, ssValue, rec))
                 return false;
-
-            // Undo serialize changes in 31600
-            if (31404 <= wtx.fTimeReceivedIsTxTime && wtx.fTimeReceivedIsTxTime <= 31703) {
-                if (!ssValue.empty()) {
-                    char fTmp;
-                    char fUnused;
-                    ssValue >> fTmp >> fUnused >> wtx.strFromAccount;
-                    strErr = strprintf("LoadWallet() upgrading tx ver=%d %d '%s' %s",
-                        wtx.fTimeReceivedIsTxTime, fTmp, wtx.strFromAccount, hash.ToString());
-                    wtx.fTimeReceivedIsTxTime = fTmp;
-                } else {
-                    strErr = strprintf("LoadWallet() repairing tx ver=%d %s", wtx.fTimeReceivedIsTxTime, hash.ToString());
-                    wtx.fTimeReceivedIsTxTime = 0;
-                }
-                wss.vWalletUpgrade.push_back(hash);
-            }
-
-            if (wtx.nOrderPos == -1)
-                wss.fAnyUnordered = true;
-
-            pwallet->AddToWallet(wtx, true);
+            strErr = rec.strErr;
+            LoadTxRecord(pwallet, rec, wss);
         } else if (strType == "acentry") {
             string strAccount;
             ssKey >> strAccount;
@@ -555,60 +707,13 @@ bool ReadKeyValue(CWallet* pwallet, CDataStream& ssKey, CDataStream& ssValue, CW
             // so set the wallet birthday to the beginning of time.
             pwallet->nTimeFirstKey = 1;
         } else if (strType == "key" || strType == "wkey") {
-            CPubKey vchPubKey;
-            ssKey >> vchPubKey;
-            if (!vchPubKey.IsValid()) {
-                strErr = "Error reading wallet database: CPubKey corrupt";
-                return false;
-            }
-            CKey key;
-            CPrivKey pkey;
-            uint256 hash = 0;
-
-            if (strType == "key") {
-                wss.nKeys++;
-                ssValue >> pkey;
-            } else {
-                CWalletKey wkey;
-                ssValue >> wkey;
-                pkey = wkey.vchPrivKey;
-            }
-
-            // Old wallets store keys as "key" [pubkey] => [privkey]
-            // ... which was slow for wallets with lots of keys, because the public key is re-derived from the private key
-            // using EC operations as a checksum.
-            // Newer wallets store keys as "key"[pubkey] => [privkey][hash(pubkey,privkey)], which is much faster while
-            // remaining backwards-compatible.
-            try {
-                ssValue >> hash;
-            } catch (...) {
-            }
-
-            bool fSkipCheck = false;
-
-            if (hash != 0) {
-                // hash pubkey/privkey to accelerate wallet load
-                std::vector<unsigned char> vchKey;
-                vchKey.reserve(vchPubKey.size() + pkey.size());
-                vchKey.insert(vchKey.end(), vchPubKey.begin(), vchPubKey.end());
-                vchKey.insert(vchKey.end(), pkey.begin(), pkey.end());
-
-                if (Hash(vchKey.begin(), vchKey.end()) != hash) {
-                    strErr = "Error reading wallet database: CPubKey/CPrivKey corrupt";
-                    return false;
-                }
-
-                fSkipCheck = true;
-            }
-
-            if (!key.Load(pkey, vchPubKey, fSkipCheck)) {
-                strErr = "Error reading wallet database: CPrivKey corrupt";
+            CWalletLoadRecord rec(strType);
+            if (!DecodeKeyRecord(ssKey, ssValue, rec)) {
+                strErr = rec.strErr;
                 return false;
             }
-            if (!pwallet->LoadKey(key, vchPubKey)) {
-                strErr = "Error reading wallet database: LoadKey failed";
+            if (!LoadKeyRecord(pwallet, rec, wss, strErr))
                 return false;
-            }
         } else if (strType == "mkey") {
             unsigned int nID;
             ssKey >> nID;
@@ -622,17 +727,13 @@ bool ReadKeyValue(CWallet* pwallet, CDataStream& ssKey, CDataStream& ssValue, CW
             if (pwallet->nMasterKeyMaxID < nID)
                 pwallet->nMasterKeyMaxID = nID;
         } else if (strType == "ckey") {
-            CPubKey vchPubKey;
-            ssKey >> vchPubKey;
-            vector<unsigned char> vchPrivKey;
-            ssValue >> vchPrivKey;
-            wss.nCKeys++;
-
-            if (!pwallet->LoadCryptedKey(vchPubKey, vchPrivKey)) {
-                strErr = "Error reading wallet database: LoadCryptedKey failed";
+            CWalletLoadRecord rec(strType);
+            if (!DecodeCryptedKeyRecord(ssKey, ssValue, rec)) {
+                strErr = rec.strErr;
                 return false;
             }
-            wss.fIsEncrypted = true;
+            if (!LoadCryptedKeyRecord(pwallet, rec, wss, strErr))
+                return false;
         } else if (strType == "keymeta") {
             CPubKey vchPubKey;
             ssKey >> vchPubKey;
@@ -721,6 +822,41 @@ bool ReadKeyValue(CWallet* pwallet, CDataStream& ssKey, CDataStream& ssValue, CW
     return true;
 }
 
+bool ReadKeyValue(CWallet* pwallet, CDataStream& ssKey, CDataStream& ssValue, CWalletScanState& wss, string& strType, string& strErr)
+{
+    try {
+        ssKey >> strType;
+    } catch (...) {
+        return false;
+    }
+    return ReadTypedKeyValue(pwallet, ssKey, ssValue, wss, strType, strErr);
+}
+
+/** Decode the expensive record types ahead of LoadWallet applying them; everything else is left for the serial pass. */
+static void DecodeWalletRecord(CWalletLoadRecord& rec)
+{
+    try {
+        if (rec.strType == "tx") {
+            rec.fDecoded = true;
+            rec.fValid = DecodeTxRecord(rec.ssKey, rec.ssValue, rec);
+        } else if (rec.strType == "key" || rec.strType == "wkey") {
+            rec.fDecoded = true;
+            rec.fValid = DecodeKeyRecord(rec.ssKey, rec.ssValue, rec);
+        } else if (rec.strType == "ckey") {
+            rec.fDecoded = true;
+            rec.fValid = DecodeCryptedKeyRecord(rec.ssKey, rec.ssValue, rec);
+        }
+    } catch (...) {
+        rec.fValid = false;
+    }
+}
+
+static void DecodeWalletRecords(std::vector<CWalletLoadRecord>* pvRecords, size_t nStart, size_t nStride)
+{
+    for (size_t i = nStart; i < pvRecords->size(); i += nStride)
+        DecodeWalletRecord((*pvRecords)[i]);
+}
+
 static bool IsKeyType(string strType)
 {
     return (strType == "key" || strType == "wkey" ||
@@ -750,35 +886,88 @@ DBErrors CWalletDB::LoadWallet(CWallet* pwallet)
             return DB_CORRUPT;
         }
 
-        while (true) {
-            // Read next record
-            CDataStream ssKey(SER_DISK, CLIENT_VERSION);
-            CDataStream ssValue(SER_DISK, CLIENT_VERSION);
-            int ret = ReadAtCursor(pcursor, ssKey, ssValue);
-            if (ret == DB_NOTFOUND)
-                break;
-            else if (ret != 0) {
-                LogPrintf("Error reading next record from wallet database\n");
-                return DB_CORRUPT;
+        int nThreads = GetArg("-walletloadthreads", DEFAULT_WALLET_LOAD_THREADS);
+        if (nThreads <= 0)
+            nThreads += boost::thread::hardware_concurrency();
+        nThreads = std::max(1, std::min(nThreads, MAX_WALLET_LOAD_THREADS));
+
+        // Records are read in batches: a fast cursor pass collects the raw
+        // key/value pairs, transactions and keys are then decoded and verified
+        // in parallel, and finally every record is applied in cursor order.
+        std::vector<CWalletLoadRecord> vRecords;
+        bool fDone = false;
+        while (!fDone) {
+            vRecords.clear();
+            vRecords.reserve(WALLET_LOAD_BATCH_SIZE);
+            while (vRecords.size() < WALLET_LOAD_BATCH_SIZE) {
+                // Read next record
+                vRecords.push_back(CWalletLoadRecord());
+                CWalletLoadRecord& rec = vRecords.back();
+                int ret = ReadAtCursor(pcursor, rec.ssKey, rec.ssValue);
+                if (ret == DB_NOTFOUND) {
+                    vRecords.pop_back();
+                    fDone = true;
+                    break;
+                } else if (ret != 0) {
+                    pcursor->close();
+                    LogPrintf("Error reading next record from wallet database\n");
+                    return DB_CORRUPT;
+                }
+
+                try {
+                    rec.ssKey >> rec.strType;
+                } catch (...) {
+                    rec.strType.clear();
+                    rec.fDecoded = true;
+                }
             }
 
-            // Try to be tolerant of single corrupt records:
-            string strType, strErr;
-            if (!ReadKeyValue(pwallet, ssKey, ssValue, wss, strType, strErr)) {
-                // losing keys is considered a catastrophic error, anything else
-                // we assume the user can live with:
-                if (IsKeyType(strType))
-                    result = DB_CORRUPT;
-                else {
-                    // Leave other errors alone, if we try to fix them we might make things worse.
-                    fNoncriticalErrors = true; // ... but do warn the user there is something wrong.
-                    if (strType == "tx")
-                        // Rescan if there is a bad transaction record:
-                        SoftSetBoolArg("-rescan", true);
+            if (nThreads > 1 && vRecords.size() > 1) {
+                boost::thread_group decodeThreads;
+                for (int i = 1; i < nThreads; i++)
+                    decodeThreads.create_thread(boost::bind(&DecodeWalletRecords, &vRecords, i, nThreads));
+                DecodeWalletRecords(&vRecords, 0, nThreads);
+                decodeThreads.join_all();
+            } else {
+                DecodeWalletRecords(&vRecords, 0, 1);
+            }
+            boost::this_thread::interruption_point();
+
+            BOOST_FOREACH (CWalletLoadRecord& rec, vRecords) {
+                // Try to be tolerant of single corrupt records:
+                string strErr;
+                bool fOk;
+                if (!rec.fDecoded) {
+                    fOk = ReadTypedKeyValue(pwallet, rec.ssKey, rec.ssValue, wss, rec.strType, strErr);
+                } else if (!rec.fValid) {
+                    strErr = rec.strErr;
+                    fOk = false;
+                } else if (rec.strType == "tx") {
+                    strErr = rec.strErr;
+                    LoadTxRecord(pwallet, rec, wss);
+                    fOk = true;
+                } else if (rec.strType == "ckey") {
+                    fOk = LoadCryptedKeyRecord(pwallet, rec, wss, strErr);
+                } else {
+                    fOk = LoadKeyRecord(pwallet, rec, wss, strErr);
+                }
+
+                if (!fOk) {
+                    // losing keys is considered a catastrophic error, anything else
+                    // we assume the user can live with:
+                    if (IsKeyType(rec.strType))
+                        result = DB_CORRUPT;
+                    else {
+                        // Leave other errors alone, if we try to fix them we might make things worse.
+                        fNoncriticalErrors = true; // ... but do warn the user there is something wrong.
+                        if (rec.strType == "tx")
+                            // Rescan if there is a bad transaction record:
+                            SoftSetBoolArg("-rescan", true);
+                    }
                 }
+                if (!strErr.empty())
+                    LogPrintf("%s\n", strErr);
             }
-            if (!strErr.empty())
-                LogPrintf("%s\n", strErr);
         }
         pcursor->close();
     } catch (boost::thread_interrupted) {
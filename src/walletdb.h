@@ -38,6 +38,13 @@ class CZerocoinSpend;
 class uint160;
 class uint256;
 
+/** -walletloadthreads default (0 = one thread per core) */
+static const int DEFAULT_WALLET_LOAD_THREADS = 0;
+/** Maximum number of threads decoding wallet records at startup */
+static const int MAX_WALLET_LOAD_THREADS = 16;
+/** Number of wallet.dat records read by the cursor before they are decoded */
+static const unsigned int WALLET_LOAD_BATCH_SIZE = 10000;
+
 /** Error statuses for the wallet database */
 enum DBErrors {
     DB_LOAD_OK,
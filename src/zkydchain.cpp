@@ -256,15 +256,26 @@ bool IsSerialInBlockchain(const uint256& hashSerial, int& nHeightTx, uint256& tx
 
 std::string ReindexZerocoinDB()
 {
-    if (!zerocoinDB->WipeCoins("spends") || !zerocoinDB->WipeCoins("mints")) {
-        return _("Failed to wipe zerocoinDB");
+    // An interrupted reindex resumes after the last block it flushed instead of starting over
+    int nHeightStart = Params().Zerocoin_StartHeight();
+    int nHeightDone;
+    if (zerocoinDB->ReadInt("reindexheight", nHeightDone) && nHeightDone >= nHeightStart && nHeightDone <= chainActive.Height()) {
+        LogPrintf("%s : resuming after block %d\n", __func__, nHeightDone);
+        nHeightStart = nHeightDone + 1;
+    } else {
+        if (!zerocoinDB->WipeCoins("spends") || !zerocoinDB->WipeCoins("mints") || !zerocoinDB->WipeCoins("heights") ||
+            !zerocoinDB->EraseInt("heightindex") || !zerocoinDB->WriteInt("reindexheight", nHeightStart - 1)) {
+            return _("Failed to wipe zerocoinDB");
+        }
     }
 
     uiInterface.ShowProgress(_("Reindexing zerocoin database..."), 0);
 
-    CBlockIndex* pindex = chainActive[Params().Zerocoin_StartHeight()];
+    CBlockIndex* pindex = chainActive[nHeightStart];
     std::vector<std::pair<libzerocoin::CoinSpend, uint256> > vSpendInfo;
     std::vector<std::pair<libzerocoin::PublicCoin, uint256> > vMintInfo;
+    std::vector<int> vSpendHeights;
+    std::vector<int> vMintHeights;
     while (pindex) {
         uiInterface.ShowProgress(_("Reindexing zerocoin database..."), std::max(1, std::min(99, (int)((double)(pindex->nHeight - Params().Zerocoin_StartHeight()) / (double)(chainActive.Height() - Params().Zerocoin_StartHeight()) * 100))));
 
@@ -277,45 +288,46 @@ std::string ReindexZerocoinDB()
         }
 
         for (const CTransaction& tx : block.vtx) {
-            for (unsigned int i = 0; i < tx.vin.size(); i++) {
-                if (tx.IsCoinBase())
-                    break;
+            if (tx.IsCoinBase() || !tx.ContainsZerocoins())
+                continue;
 
-                if (tx.ContainsZerocoins()) {
-                    uint256 txid = tx.GetHash();
-                    //Record Serials
-                    if (tx.IsZerocoinSpend()) {
-                        for (auto& in : tx.vin) {
-                            if (!in.scriptSig.IsZerocoinSpend())
-                                continue;
-
-                            libzerocoin::CoinSpend spend = TxInToZerocoinSpend(in);
-                            vSpendInfo.push_back(make_pair(spend, txid));
-                        }
-                    }
-
-                    //Record mints
-                    if (tx.IsZerocoinMint()) {
-                        for (auto& out : tx.vout) {
-                            if (!out.IsZerocoinMint())
-                                continue;
-
-                            CValidationState state;
-                            libzerocoin::PublicCoin coin(Params().Zerocoin_Params(pindex->nHeight < Params().Zerocoin_Block_V2_Start()));
-                            TxOutToPublicCoin(out, coin, state);
-                            vMintInfo.push_back(make_pair(coin, txid));
-                        }
-                    }
+            uint256 txid = tx.GetHash();
+            //Record Serials
+            if (tx.IsZerocoinSpend()) {
+                for (auto& in : tx.vin) {
+                    if (!in.scriptSig.IsZerocoinSpend())
+                        continue;
+
+                    libzerocoin::CoinSpend spend = TxInToZerocoinSpend(in);
+                    vSpendInfo.push_back(make_pair(spend, txid));
+                    vSpendHeights.push_back(pindex->nHeight);
+                }
+            }
+
+            //Record mints
+            if (tx.IsZerocoinMint()) {
+                for (auto& out : tx.vout) {
+                    if (!out.IsZerocoinMint())
+                        continue;
+
+                    CValidationState state;
+                    libzerocoin::PublicCoin coin(Params().Zerocoin_Params(pindex->nHeight < Params().Zerocoin_Block_V2_Start()));
+                    TxOutToPublicCoin(out, coin, state);
+                    vMintInfo.push_back(make_pair(coin, txid));
+                    vMintHeights.push_back(pindex->nHeight);
                 }
             }
         }
 
-        // Flush the zerocoinDB to disk every 100 blocks
+        // Flush the zerocoinDB to disk every 100 blocks and remember how far we got
         if (pindex->nHeight % 100 == 0) {
-            if ((!vSpendInfo.empty() && !zerocoinDB->WriteCoinSpendBatch(vSpendInfo)) || (!vMintInfo.empty() && !zerocoinDB->WriteCoinMintBatch(vMintInfo)))
+            if ((!vSpendInfo.empty() && !zerocoinDB->WriteCoinSpendBatch(vSpendInfo, vSpendHeights)) || (!vMintInfo.empty() && !zerocoinDB->WriteCoinMintBatch(vMintInfo, vMintHeights)) ||
+                !zerocoinDB->WriteInt("reindexheight", pindex->nHeight))
                 return _("Error writing zerocoinDB to disk");
             vSpendInfo.clear();
             vMintInfo.clear();
+            vSpendHeights.clear();
+            vMintHeights.clear();
         }
 
         pindex = chainActive.Next(pindex);
@@ -323,7 +335,11 @@ std::string ReindexZerocoinDB()
     uiInterface.ShowProgress("", 100);
 
     // Final flush to disk in case any remaining information exists
-    if ((!vSpendInfo.empty() && !zerocoinDB->WriteCoinSpendBatch(vSpendInfo)) || (!vMintInfo.empty() && !zerocoinDB->WriteCoinMintBatch(vMintInfo)))
+    if ((!vSpendInfo.empty() && !zerocoinDB->WriteCoinSpendBatch(vSpendInfo, vSpendHeights)) || (!vMintInfo.empty() && !zerocoinDB->WriteCoinMintBatch(vMintInfo, vMintHeights)))
+        return _("Error writing zerocoinDB to disk");
+
+    // The height index now covers the whole chain
+    if (!zerocoinDB->WriteInt("heightindex", chainActive.Height()) || !zerocoinDB->EraseInt("reindexheight"))
         return _("Error writing zerocoinDB to disk");
 
     uiInterface.ShowProgress("", 100);
@@ -12,21 +12,24 @@
 #include "walletdb.h"
 #include "zkydwallet.h"
 #include "accumulators.h"
+#include "zkydchain.h"
 
 using namespace std;
 
 CzKYDTracker::CzKYDTracker(std::string strWalletFile)
 {
     this->strWalletFile = strWalletFile;
-    mapSerialHashes.clear();
+    Clear();
     mapPendingSpends.clear();
+    mapPendingSpendTxids.clear();
     fInitialized = false;
 }
 
 CzKYDTracker::~CzKYDTracker()
 {
-    mapSerialHashes.clear();
+    Clear();
     mapPendingSpends.clear();
+    mapPendingSpendTxids.clear();
 }
 
 void CzKYDTracker::Init()
@@ -38,10 +41,104 @@ void CzKYDTracker::Init()
     }
 }
 
+void CzKYDTracker::IndexMeta(const CMintMeta& meta, bool fAdd)
+{
+    if (fAdd) {
+        mapPubcoinHashes[meta.hashPubcoin] = meta.hashSerial;
+        mapStakeHashes[meta.hashStake] = meta.hashSerial;
+        setMintTxids.insert(meta.txid);
+    } else {
+        auto itPubcoin = mapPubcoinHashes.find(meta.hashPubcoin);
+        if (itPubcoin != mapPubcoinHashes.end() && itPubcoin->second == meta.hashSerial)
+            mapPubcoinHashes.erase(itPubcoin);
+        auto itStake = mapStakeHashes.find(meta.hashStake);
+        if (itStake != mapStakeHashes.end() && itStake->second == meta.hashSerial)
+            mapStakeHashes.erase(itStake);
+        auto itTxid = setMintTxids.find(meta.txid);
+        if (itTxid != setMintTxids.end())
+            setMintTxids.erase(itTxid);
+    }
+
+    if (meta.isUsed || meta.isArchived)
+        return;
+
+    CAmount nValue = libzerocoin::ZerocoinDenominationToAmount(meta.denom);
+    if (!fAdd)
+        nValue = -nValue;
+
+    if (fAdd)
+        setUnspent.insert(meta.hashSerial);
+    else
+        setUnspent.erase(meta.hashSerial);
+
+    nUnspentBalance += nValue;
+    if (meta.nHeight == 0) {
+        nPendingBalance += nValue;
+    } else {
+        CAmount& nHeightValue = mapUnspentByHeight[meta.nHeight];
+        nHeightValue += nValue;
+        if (nHeightValue == 0)
+            mapUnspentByHeight.erase(meta.nHeight);
+    }
+}
+
+//Replace the meta object of a mint and keep the indexes in step
+void CzKYDTracker::SetMeta(const CMintMeta& meta)
+{
+    auto it = mapSerialHashes.find(meta.hashSerial);
+    if (it != mapSerialHashes.end())
+        IndexMeta(it->second, false);
+    mapSerialHashes[meta.hashSerial] = meta;
+    IndexMeta(meta, true);
+}
+
+//Add a mint read from the database, queueing it for a status refresh if it is new or has changed
+void CzKYDTracker::AddMeta(const CMintMeta& meta)
+{
+    auto it = mapSerialHashes.find(meta.hashSerial);
+    bool fChanged = it == mapSerialHashes.end() || it->second.txid != meta.txid || it->second.nHeight != meta.nHeight ||
+                    it->second.isUsed != meta.isUsed || it->second.isArchived != meta.isArchived;
+    SetMeta(meta);
+    if (fChanged)
+        setDirtySerials.insert(meta.hashSerial);
+}
+
+void CzKYDTracker::MarkDirty(const uint256& hashSerial)
+{
+    if (mapSerialHashes.count(hashSerial))
+        setDirtySerials.insert(hashSerial);
+}
+
+void CzKYDTracker::AddPending(const uint256& hashSerial, const uint256& txid)
+{
+    if (mapPendingSpends.insert(make_pair(hashSerial, txid)).second)
+        mapPendingSpendTxids.insert(make_pair(txid, hashSerial));
+}
+
+void CzKYDTracker::ErasePending(const uint256& hashSerial)
+{
+    auto it = mapPendingSpends.find(hashSerial);
+    if (it == mapPendingSpends.end())
+        return;
+
+    auto range = mapPendingSpendTxids.equal_range(it->second);
+    for (auto itTxid = range.first; itTxid != range.second; ++itTxid) {
+        if (itTxid->second == hashSerial) {
+            mapPendingSpendTxids.erase(itTxid);
+            break;
+        }
+    }
+    mapPendingSpends.erase(it);
+}
+
 bool CzKYDTracker::Archive(CMintMeta& meta)
 {
-    if (mapSerialHashes.count(meta.hashSerial))
-        mapSerialHashes.at(meta.hashSerial).isArchived = true;
+    if (mapSerialHashes.count(meta.hashSerial)) {
+        CMintMeta metaArchived = mapSerialHashes.at(meta.hashSerial);
+        metaArchived.isArchived = true;
+        SetMeta(metaArchived);
+        setDirtySerials.erase(meta.hashSerial);
+    }
 
     CWalletDB walletdb(strWalletFile);
     CZerocoinMint mint;
@@ -90,25 +187,21 @@ CMintMeta CzKYDTracker::Get(const uint256 &hashSerial)
 
 CMintMeta CzKYDTracker::GetMetaFromPubcoin(const uint256& hashPubcoin)
 {
-    for (auto it : mapSerialHashes) {
-        CMintMeta meta = it.second;
-        if (meta.hashPubcoin == hashPubcoin)
-            return meta;
-    }
+    auto it = mapPubcoinHashes.find(hashPubcoin);
+    if (it == mapPubcoinHashes.end())
+        return CMintMeta();
 
-    return CMintMeta();
+    return mapSerialHashes.at(it->second);
 }
 
 bool CzKYDTracker::GetMetaFromStakeHash(const uint256& hashStake, CMintMeta& meta) const
 {
-    for (auto& it : mapSerialHashes) {
-        if (it.second.hashStake == hashStake) {
-            meta = it.second;
-            return true;
-        }
-    }
+    auto it = mapStakeHashes.find(hashStake);
+    if (it == mapStakeHashes.end())
+        return false;
 
-    return false;
+    meta = mapSerialHashes.at(it->second);
+    return true;
 }
 
 std::vector<uint256> CzKYDTracker::GetSerialHashes()
@@ -127,30 +220,21 @@ std::vector<uint256> CzKYDTracker::GetSerialHashes()
 
 CAmount CzKYDTracker::GetBalance(bool fConfirmedOnly, bool fUnconfirmedOnly) const
 {
-    CAmount nTotal = 0;
-    //! zerocoin specific fields
-    std::map<libzerocoin::CoinDenomination, unsigned int> myZerocoinSupply;
-    for (auto& denom : libzerocoin::zerocoinDenomList) {
-        myZerocoinSupply.insert(make_pair(denom, 0));
-    }
+    // Mints in a block at or above this height do not have enough confirmations yet
+    int nConfirmedHeight = chainActive.Height() - Params().Zerocoin_MintRequiredConfirmations();
+    CAmount nRecent = 0;
+    for (auto it = mapUnspentByHeight.lower_bound(nConfirmedHeight); it != mapUnspentByHeight.end(); ++it)
+        nRecent += it->second;
 
-    {
-        //LOCK(cs_pivtracker);
-        // Get Unused coins
-        for (auto& it : mapSerialHashes) {
-            CMintMeta meta = it.second;
-            if (meta.isUsed || meta.isArchived)
-                continue;
-            bool fConfirmed = ((meta.nHeight < chainActive.Height() - Params().Zerocoin_MintRequiredConfirmations()) && !(meta.nHeight == 0));
-            if (fConfirmedOnly && !fConfirmed)
-                continue;
-            if (fUnconfirmedOnly && fConfirmed)
-                continue;
-
-            nTotal += libzerocoin::ZerocoinDenominationToAmount(meta.denom);
-            myZerocoinSupply.at(meta.denom)++;
-        }
-    }
+    CAmount nTotal = 0;
+    if (fConfirmedOnly && fUnconfirmedOnly)
+        nTotal = 0;
+    else if (fConfirmedOnly)
+        nTotal = nUnspentBalance - nPendingBalance - nRecent;
+    else if (fUnconfirmedOnly)
+        nTotal = nPendingBalance + nRecent;
+    else
+        nTotal = nUnspentBalance;
 
     if (nTotal < 0 ) nTotal = 0; // Sanity never hurts
 
@@ -165,10 +249,9 @@ CAmount CzKYDTracker::GetUnconfirmedBalance() const
 std::vector<CMintMeta> CzKYDTracker::GetMints(bool fConfirmedOnly) const
 {
     vector<CMintMeta> vMints;
-    for (auto& it : mapSerialHashes) {
-        CMintMeta mint = it.second;
-        if (mint.isArchived || mint.isUsed)
-            continue;
+    vMints.reserve(setUnspent.size());
+    for (const uint256& hashSerial : setUnspent) {
+        const CMintMeta& mint = mapSerialHashes.at(hashSerial);
         bool fConfirmed = (mint.nHeight < chainActive.Height() - Params().Zerocoin_MintRequiredConfirmations());
         if (fConfirmedOnly && !fConfirmed)
             continue;
@@ -180,12 +263,7 @@ std::vector<CMintMeta> CzKYDTracker::GetMints(bool fConfirmedOnly) const
 //Does a mint in the tracker have this txid
 bool CzKYDTracker::HasMintTx(const uint256& txid)
 {
-    for (auto it : mapSerialHashes) {
-        if (it.second.txid == txid)
-            return true;
-    }
-
-    return false;
+    return setMintTxids.count(txid) > 0;
 }
 
 bool CzKYDTracker::HasPubcoin(const CBigNum &bnValue) const
@@ -197,12 +275,7 @@ bool CzKYDTracker::HasPubcoin(const CBigNum &bnValue) const
 
 bool CzKYDTracker::HasPubcoinHash(const uint256& hashPubcoin) const
 {
-    for (auto it : mapSerialHashes) {
-        CMintMeta meta = it.second;
-        if (meta.hashPubcoin == hashPubcoin)
-            return true;
-    }
-    return false;
+    return mapPubcoinHashes.count(hashPubcoin) > 0;
 }
 
 bool CzKYDTracker::HasSerial(const CBigNum& bnSerial) const
@@ -229,7 +302,8 @@ bool CzKYDTracker::UpdateZerocoinMint(const CZerocoinMint& mint)
     meta.isUsed = mint.IsUsed();
     meta.denom = mint.GetDenomination();
     meta.nHeight = mint.GetHeight();
-    mapSerialHashes.at(hashSerial) = meta;
+    SetMeta(meta);
+    MarkDirty(hashSerial);
 
     //Write to db
     return CWalletDB(strWalletFile).WriteZerocoinMint(mint);
@@ -273,7 +347,8 @@ bool CzKYDTracker::UpdateState(const CMintMeta& meta)
             return error("%s: failed to write mint to database", __func__);
     }
 
-    mapSerialHashes[meta.hashSerial] = meta;
+    SetMeta(meta);
+    MarkDirty(meta.hashSerial);
 
     return true;
 }
@@ -297,7 +372,7 @@ void CzKYDTracker::Add(const CDeterministicMint& dMint, bool isNew, bool isArchi
     meta.isSeedCorrect = zKYDWallet->CheckSeed(dMint);
     if (! iszKYDWalletInitialized)
         delete zKYDWallet;
-    mapSerialHashes[meta.hashSerial] = meta;
+    AddMeta(meta);
 
     if (isNew)
         CWalletDB(strWalletFile).WriteDeterministicMint(dMint);
@@ -318,7 +393,7 @@ void CzKYDTracker::Add(const CZerocoinMint& mint, bool isNew, bool isArchived)
     meta.isArchived = isArchived;
     meta.isDeterministic = false;
     meta.isSeedCorrect = true;
-    mapSerialHashes[meta.hashSerial] = meta;
+    AddMeta(meta);
 
     if (isNew)
         CWalletDB(strWalletFile).WriteZerocoinMint(mint);
@@ -330,7 +405,7 @@ void CzKYDTracker::SetPubcoinUsed(const uint256& hashPubcoin, const uint256& txi
         return;
     CMintMeta meta = GetMetaFromPubcoin(hashPubcoin);
     meta.isUsed = true;
-    mapPendingSpends.insert(make_pair(meta.hashSerial, txid));
+    AddPending(meta.hashSerial, txid);
     UpdateState(meta);
 }
 
@@ -341,24 +416,60 @@ void CzKYDTracker::SetPubcoinNotUsed(const uint256& hashPubcoin)
     CMintMeta meta = GetMetaFromPubcoin(hashPubcoin);
     meta.isUsed = false;
 
-    if (mapPendingSpends.count(meta.hashSerial))
-        mapPendingSpends.erase(meta.hashSerial);
+    ErasePending(meta.hashSerial);
 
     UpdateState(meta);
 }
 
+//Forget the pending spends of every mint spent by txid, which is not going to make it into a block
 void CzKYDTracker::RemovePending(const uint256& txid)
 {
-    uint256 hashSerial;
-    for (auto it : mapPendingSpends) {
-        if (it.second == txid) {
-            hashSerial = it.first;
-            break;
+    auto range = mapPendingSpendTxids.equal_range(txid);
+    for (auto it = range.first; it != range.second; ++it) {
+        mapPendingSpends.erase(it->second);
+        MarkDirty(it->second);
+    }
+    mapPendingSpendTxids.erase(range.first, range.second);
+}
+
+//Queue any of our mints that are minted or spent by this transaction for a status refresh. Called
+//when the transaction enters the mempool and when its block is connected or disconnected.
+void CzKYDTracker::NotifyTransaction(const CTransaction& tx)
+{
+    if (!tx.ContainsZerocoins() || mapSerialHashes.empty())
+        return;
+
+    uint256 txid = tx.GetHash();
+    auto range = mapPendingSpendTxids.equal_range(txid);
+    for (auto it = range.first; it != range.second; ++it)
+        MarkDirty(it->second);
+
+    if (tx.IsZerocoinMint()) {
+        for (const CTxOut& out : tx.vout) {
+            if (!out.IsZerocoinMint())
+                continue;
+            libzerocoin::PublicCoin pubcoin(Params().Zerocoin_Params(false));
+            CValidationState state;
+            if (!TxOutToPublicCoin(out, pubcoin, state))
+                continue;
+            auto it = mapPubcoinHashes.find(GetPubCoinHash(pubcoin.getValue()));
+            if (it != mapPubcoinHashes.end())
+                MarkDirty(it->second);
         }
     }
 
-    if (hashSerial > 0)
-        mapPendingSpends.erase(hashSerial);
+    if (tx.IsZerocoinSpend()) {
+        for (const CTxIn& in : tx.vin) {
+            if (!in.scriptSig.IsZerocoinSpend())
+                continue;
+            try {
+                libzerocoin::CoinSpend spend = TxInToZerocoinSpend(in);
+                MarkDirty(GetSerialHash(spend.getCoinSerialNumber()));
+            } catch (const std::exception& e) {
+                LogPrint("zero", "%s: failed to deserialize spend in tx %s: %s\n", __func__, txid.GetHex(), e.what());
+            }
+        }
+    }
 }
 
 bool CzKYDTracker::UpdateStatusInternal(const std::set<uint256>& setMempool, CMintMeta& mint)
@@ -458,29 +569,68 @@ std::set<CMintMeta> CzKYDTracker::ListMints(bool fUnusedOnly, bool fMatureOnly,
 
     std::vector<CMintMeta> vOverWrite;
     std::set<CMintMeta> setMints;
-    std::set<uint256> setMempool;
-    {
-        LOCK(mempool.cs);
-        mempool.getTransactions(setMempool);
-    }
 
-    std::map<libzerocoin::CoinDenomination, int> mapMaturity = GetMintMaturityHeight();
-    for (auto& it : mapSerialHashes) {
-        CMintMeta mint = it.second;
+    // Only mints touched by a transaction, block or database change since the last refresh
+    // need their status checked against the mempool and the zerocoin database
+    if (fUpdateStatus && !setDirtySerials.empty()) {
+        std::set<uint256> setMempool;
+        {
+            LOCK(mempool.cs);
+            mempool.getTransactions(setMempool);
+        }
 
-        //This is only intended for unarchived coins
-        if (mint.isArchived)
-            continue;
+        bool fKeepDirty = IsInitialBlockDownload();
+        std::set<uint256> setDirty;
+        setDirty.swap(setDirtySerials);
+        for (const uint256& hashSerial : setDirty) {
+            if (!mapSerialHashes.count(hashSerial))
+                continue;
+            CMintMeta mint = mapSerialHashes.at(hashSerial);
+            if (mint.isArchived)
+                continue;
 
-        // Update the metadata of the mints if requested
-        if (fUpdateStatus && UpdateStatusInternal(setMempool, mint)) {
+            bool fUpdated = UpdateStatusInternal(setMempool, mint);
             if (mint.isArchived)
                 continue;
 
             // Mint was updated, queue for overwrite
-            vOverWrite.emplace_back(mint);
+            if (fUpdated)
+                vOverWrite.emplace_back(mint);
+
+            // Mints that are not settled in the chain yet are checked again on the next refresh
+            if (fKeepDirty || !mint.nHeight || mint.txid == 0 || mapPendingSpends.count(hashSerial))
+                setDirtySerials.insert(hashSerial);
         }
 
+        //overwrite any updates
+        for (CMintMeta& meta : vOverWrite) {
+            bool fWasDirty = setDirtySerials.count(meta.hashSerial) > 0;
+            UpdateState(meta);
+            if (!fWasDirty)
+                setDirtySerials.erase(meta.hashSerial);
+        }
+    }
+
+    // Unused mints come from the index, listing all of them walks every mint but returns most of them too
+    std::vector<const CMintMeta*> vCandidates;
+    if (fUnusedOnly) {
+        vCandidates.reserve(setUnspent.size());
+        for (const uint256& hashSerial : setUnspent)
+            vCandidates.push_back(&mapSerialHashes.at(hashSerial));
+    } else {
+        vCandidates.reserve(mapSerialHashes.size());
+        for (auto& it : mapSerialHashes)
+            vCandidates.push_back(&it.second);
+    }
+
+    std::map<libzerocoin::CoinDenomination, int> mapMaturity = GetMintMaturityHeight();
+    for (const CMintMeta* pmint : vCandidates) {
+        const CMintMeta& mint = *pmint;
+
+        //This is only intended for unarchived coins
+        if (mint.isArchived)
+            continue;
+
         if (fUnusedOnly && mint.isUsed)
             continue;
 
@@ -498,14 +648,18 @@ std::set<CMintMeta> CzKYDTracker::ListMints(bool fUnusedOnly, bool fMatureOnly,
         setMints.insert(mint);
     }
 
-    //overwrite any updates
-    for (CMintMeta& meta : vOverWrite)
-        UpdateState(meta);
-
     return setMints;
 }
 
 void CzKYDTracker::Clear()
 {
     mapSerialHashes.clear();
+    mapPubcoinHashes.clear();
+    mapStakeHashes.clear();
+    setMintTxids.clear();
+    setUnspent.clear();
+    mapUnspentByHeight.clear();
+    nUnspentBalance = 0;
+    nPendingBalance = 0;
+    setDirtySerials.clear();
 }
@@ -8,8 +8,10 @@
 
 #include "primitives/zerocoin.h"
 #include <list>
+#include <set>
 
 class CDeterministicMint;
+class CTransaction;
 class CzKYDWallet;
 
 class CzKYDTracker
@@ -19,6 +21,26 @@ private:
     std::string strWalletFile;
     std::map<uint256, CMintMeta> mapSerialHashes;
     std::map<uint256, uint256> mapPendingSpends; //serialhash, txid of spend
+    std::multimap<uint256, uint256> mapPendingSpendTxids; //txid of spend, serialhash
+
+    // Indexes over mapSerialHashes, maintained by SetMeta()
+    std::map<uint256, uint256> mapPubcoinHashes; //pubcoinhash, serialhash
+    std::map<uint256, uint256> mapStakeHashes; //stakehash, serialhash
+    std::multiset<uint256> setMintTxids;
+    std::set<uint256> setUnspent; //serialhashes of mints that are neither used nor archived
+    std::map<int, CAmount> mapUnspentByHeight; //value of unspent mints per block height
+    CAmount nUnspentBalance;
+    CAmount nPendingBalance; //value of unspent mints that are not in a block yet
+
+    // Mints whose status has to be refreshed against the chain and mempool by ListMints()
+    std::set<uint256> setDirtySerials;
+
+    void IndexMeta(const CMintMeta& meta, bool fAdd);
+    void SetMeta(const CMintMeta& meta);
+    void AddMeta(const CMintMeta& meta);
+    void MarkDirty(const uint256& hashSerial);
+    void AddPending(const uint256& hashSerial, const uint256& txid);
+    void ErasePending(const uint256& hashSerial);
     bool UpdateStatusInternal(const std::set<uint256>& setMempool, CMintMeta& mint);
 public:
     CzKYDTracker(std::string strWalletFile);
@@ -41,6 +63,7 @@ public:
     std::vector<CMintMeta> GetMints(bool fConfirmedOnly) const;
     CAmount GetUnconfirmedBalance() const;
     std::set<CMintMeta> ListMints(bool fUnusedOnly, bool fMatureOnly, bool fUpdateStatus, bool fWrongSeed = false);
+    void NotifyTransaction(const CTransaction& tx);
     void RemovePending(const uint256& txid);
     void SetPubcoinUsed(const uint256& hashPubcoin, const uint256& txid);
     void SetPubcoinNotUsed(const uint256& hashPubcoin);
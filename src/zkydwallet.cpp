@@ -187,6 +187,8 @@ void CzKYDWallet::SyncWithChain(bool fGenerateMintPool)
     CWalletDB walletdb(strWalletFile);
 
     set<uint256> setAddedTx;
+    // Transactions already fetched for mints of this wallet, shared by all passes
+    map<uint256, pair<CTransaction, uint256> > mapTxCache;
     while (found) {
         found = false;
         if (fGenerateMintPool)
@@ -195,8 +197,8 @@ void CzKYDWallet::SyncWithChain(bool fGenerateMintPool)
 
         std::set<uint256> setChecked;
         list<pair<uint256,uint32_t> > listMints = mintPool.List();
+        vector<pair<uint256, uint32_t> > vUnknown;
         for (pair<uint256, uint32_t> pMint : listMints) {
-            LOCK(cs_main);
             if (setChecked.count(pMint.first))
                 return;
             setChecked.insert(pMint.first);
@@ -208,14 +210,35 @@ void CzKYDWallet::SyncWithChain(bool fGenerateMintPool)
                 mintPool.Remove(pMint.first);
                 continue;
             }
+            vUnknown.emplace_back(pMint);
+        }
+
+        // Resolve the whole window against the zerocoin database at once
+        vector<uint256> vHashPubcoin;
+        vHashPubcoin.reserve(vUnknown.size());
+        for (const pair<uint256, uint32_t>& pMint : vUnknown)
+            vHashPubcoin.emplace_back(pMint.first);
+        map<uint256, uint256> mapMintTx;
+        if (!zerocoinDB->ReadCoinMints(vHashPubcoin, mapMintTx)) {
+            LogPrintf("%s : failed to read mints from zerocoinDB\n", __func__);
+            return;
+        }
 
-            uint256 txHash;
-            CZerocoinMint mint;
-            if (zerocoinDB->ReadCoinMint(pMint.first, txHash)) {
-                //this mint has already occurred on the chain, increment counter's state to reflect this
-                LogPrintf("%s : Found wallet coin mint=%s count=%d tx=%s\n", __func__, pMint.first.GetHex(), pMint.second, txHash.GetHex());
-                found = true;
+        for (const pair<uint256, uint32_t>& pMint : vUnknown) {
+            auto itMint = mapMintTx.find(pMint.first);
+            if (itMint == mapMintTx.end())
+                continue;
 
+            if (ShutdownRequested())
+                return;
+
+            //this mint has already occurred on the chain, increment counter's state to reflect this
+            const uint256& txHash = itMint->second;
+            LogPrintf("%s : Found wallet coin mint=%s count=%d tx=%s\n", __func__, pMint.first.GetHex(), pMint.second, txHash.GetHex());
+            found = true;
+
+            auto itTx = mapTxCache.find(txHash);
+            if (itTx == mapTxCache.end()) {
                 uint256 hashBlock;
                 CTransaction tx;
                 if (!GetTransaction(txHash, tx, hashBlock, true)) {
@@ -224,59 +247,63 @@ void CzKYDWallet::SyncWithChain(bool fGenerateMintPool)
                     nLastCountUsed = std::max(pMint.second, nLastCountUsed);
                     continue;
                 }
+                itTx = mapTxCache.insert(make_pair(txHash, make_pair(tx, hashBlock))).first;
+            }
+            const CTransaction& tx = itTx->second.first;
+            const uint256& hashBlock = itTx->second.second;
+
+            //Find the denomination
+            CoinDenomination denomination = CoinDenomination::ZQ_ERROR;
+            bool fFoundMint = false;
+            CBigNum bnValue = 0;
+            for (const CTxOut& out : tx.vout) {
+                if (!out.scriptPubKey.IsZerocoinMint())
+                    continue;
 
-                //Find the denomination
-                CoinDenomination denomination = CoinDenomination::ZQ_ERROR;
-                bool fFoundMint = false;
-                CBigNum bnValue = 0;
-                for (const CTxOut& out : tx.vout) {
-                    if (!out.scriptPubKey.IsZerocoinMint())
-                        continue;
-
-                    PublicCoin pubcoin(Params().Zerocoin_Params(false));
-                    CValidationState state;
-                    if (!TxOutToPublicCoin(out, pubcoin, state)) {
-                        LogPrintf("%s : failed to get mint from txout for %s!\n", __func__, pMint.first.GetHex());
-                        continue;
-                    }
-
-                    // See if this is the mint that we are looking for
-                    uint256 hashPubcoin = GetPubCoinHash(pubcoin.getValue());
-                    if (pMint.first == hashPubcoin) {
-                        denomination = pubcoin.getDenomination();
-                        bnValue = pubcoin.getValue();
-                        fFoundMint = true;
-                        break;
-                    }
+                PublicCoin pubcoin(Params().Zerocoin_Params(false));
+                CValidationState state;
+                if (!TxOutToPublicCoin(out, pubcoin, state)) {
+                    LogPrintf("%s : failed to get mint from txout for %s!\n", __func__, pMint.first.GetHex());
+                    continue;
                 }
 
-                if (!fFoundMint || denomination == ZQ_ERROR) {
-                    LogPrintf("%s : failed to get mint %s from tx %s!\n", __func__, pMint.first.GetHex(), tx.GetHash().GetHex());
-                    found = false;
+                // See if this is the mint that we are looking for
+                uint256 hashPubcoin = GetPubCoinHash(pubcoin.getValue());
+                if (pMint.first == hashPubcoin) {
+                    denomination = pubcoin.getDenomination();
+                    bnValue = pubcoin.getValue();
+                    fFoundMint = true;
                     break;
                 }
+            }
 
-                CBlockIndex* pindex = nullptr;
-                if (mapBlockIndex.count(hashBlock))
-                    pindex = mapBlockIndex.at(hashBlock);
-
-                if (!setAddedTx.count(txHash)) {
-                    CBlock block;
-                    CWalletTx wtx(pwalletMain, tx);
-                    if (pindex && ReadBlockFromDisk(block, pindex))
-                        wtx.SetMerkleBranch(block);
-
-                    //Fill out wtx so that a transaction record can be created
-                    wtx.nTimeReceived = pindex->GetBlockTime();
-                    pwalletMain->AddToWallet(wtx);
-                    setAddedTx.insert(txHash);
-                }
+            if (!fFoundMint || denomination == ZQ_ERROR) {
+                LogPrintf("%s : failed to get mint %s from tx %s!\n", __func__, pMint.first.GetHex(), tx.GetHash().GetHex());
+                found = false;
+                break;
+            }
 
-                SetMintSeen(bnValue, pindex->nHeight, txHash, denomination);
-                nLastCountUsed = std::max(pMint.second, nLastCountUsed);
-                nCountLastUsed = std::max(nLastCountUsed, nCountLastUsed);
-                LogPrint("zero", "%s: updated count to %d\n", __func__, nCountLastUsed);
+            LOCK(cs_main);
+            CBlockIndex* pindex = nullptr;
+            if (mapBlockIndex.count(hashBlock))
+                pindex = mapBlockIndex.at(hashBlock);
+
+            if (!setAddedTx.count(txHash)) {
+                CBlock block;
+                CWalletTx wtx(pwalletMain, tx);
+                if (pindex && ReadBlockFromDisk(block, pindex))
+                    wtx.SetMerkleBranch(block);
+
+                //Fill out wtx so that a transaction record can be created
+                wtx.nTimeReceived = pindex->GetBlockTime();
+                pwalletMain->AddToWallet(wtx);
+                setAddedTx.insert(txHash);
             }
+
+            SetMintSeen(bnValue, pindex->nHeight, txHash, denomination);
+            nLastCountUsed = std::max(pMint.second, nLastCountUsed);
+            nCountLastUsed = std::max(nLastCountUsed, nCountLastUsed);
+            LogPrint("zero", "%s: updated count to %d\n", __func__, nCountLastUsed);
         }
     }
 }
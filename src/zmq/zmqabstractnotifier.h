@@ -8,6 +8,8 @@
 #include "zmqconfig.h"
 
 class CBlockIndex;
+class COutPoint;
+class CScript;
 class CZMQAbstractNotifier;
 
 typedef CZMQAbstractNotifier* (*CZMQNotifierFactory)();
@@ -35,6 +37,11 @@ public:
     virtual bool NotifyBlock(const CBlockIndex *pindex);
     virtual bool NotifyTransaction(const CTransaction &transaction);
     virtual bool NotifyTransactionLock(const CTransaction &transaction);
+    virtual bool NotifyBlockConnected(const CBlock &block, const CBlockIndex *pindex);
+    virtual bool NotifyBlockDisconnected(const CBlock &block, const CBlockIndex *pindex);
+    virtual bool NotifyTransactionAcceptance(const CTransaction &transaction);
+    virtual bool NotifyTransactionRemoval(const CTransaction &transaction);
+    virtual bool NotifyMasternodeWinner(int nBlockHeight, const COutPoint &outpointMasternode, const CScript &payee);
 
 protected:
     void *psocket;
@@ -10,6 +10,9 @@
 #include "streams.h"
 #include "util.h"
 
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+
 void zmqError(const char *str)
 {
     LogPrint("zmq", "zmq: Error: %s, errno=%s\n", str, zmq_strerror(errno));
@@ -38,9 +41,13 @@ CZMQNotificationInterface* CZMQNotificationInterface::CreateWithArguments(const
     factories["pubhashblock"] = CZMQAbstractNotifier::Create<CZMQPublishHashBlockNotifier>;
     factories["pubhashtx"] = CZMQAbstractNotifier::Create<CZMQPublishHashTransactionNotifier>;
     factories["pubhashtxlock"] = CZMQAbstractNotifier::Create<CZMQPublishHashTransactionLockNotifier>;
+    factories["pubmnwinner"] = CZMQAbstractNotifier::Create<CZMQPublishMasternodeWinnerNotifier>;
     factories["pubrawblock"] = CZMQAbstractNotifier::Create<CZMQPublishRawBlockNotifier>;
     factories["pubrawtx"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionNotifier>;
     factories["pubrawtxlock"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionLockNotifier>;
+    factories["pubsequence"] = CZMQAbstractNotifier::Create<CZMQPublishSequenceNotifier>;
+    factories["pubzerocoinmint"] = CZMQAbstractNotifier::Create<CZMQPublishZerocoinMintNotifier>;
+    factories["pubzerocoinspend"] = CZMQAbstractNotifier::Create<CZMQPublishZerocoinSpendNotifier>;
 
     for (std::map<std::string, CZMQNotifierFactory>::const_iterator i=factories.begin(); i!=factories.end(); ++i)
     {
@@ -105,6 +112,8 @@ bool CZMQNotificationInterface::Initialize()
         return false;
     }
 
+    StartZMQPublisher();
+
     return true;
 }
 
@@ -114,6 +123,9 @@ void CZMQNotificationInterface::Shutdown()
     LogPrint("zmq", "zmq: Shutdown notification interface\n");
     if (pcontext)
     {
+        // send what is still queued before the sockets go away
+        StopZMQPublisher();
+
         for (std::list<CZMQAbstractNotifier*>::iterator i=notifiers.begin(); i!=notifiers.end(); ++i)
         {
             CZMQAbstractNotifier *notifier = *i;
@@ -126,12 +138,13 @@ void CZMQNotificationInterface::Shutdown()
     }
 }
 
-void CZMQNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindex)
+template <typename Function>
+void CZMQNotificationInterface::TryForEachAndRemoveFailed(const Function& func)
 {
     for (std::list<CZMQAbstractNotifier*>::iterator i = notifiers.begin(); i!=notifiers.end(); )
     {
         CZMQAbstractNotifier *notifier = *i;
-        if (notifier->NotifyBlock(pindex))
+        if (func(notifier))
         {
             i++;
         }
@@ -143,36 +156,42 @@ void CZMQNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindex)
     }
 }
 
+void CZMQNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindex)
+{
+    TryForEachAndRemoveFailed(boost::bind(&CZMQAbstractNotifier::NotifyBlock, _1, pindex));
+}
+
 void CZMQNotificationInterface::SyncTransaction(const CTransaction &tx, const CBlock *pblock)
 {
-    for (std::list<CZMQAbstractNotifier*>::iterator i = notifiers.begin(); i!=notifiers.end(); )
-    {
-        CZMQAbstractNotifier *notifier = *i;
-        if (notifier->NotifyTransaction(tx))
-        {
-            i++;
-        }
-        else
-        {
-            notifier->Shutdown();
-            i = notifiers.erase(i);
-        }
-    }
+    TryForEachAndRemoveFailed(boost::bind(&CZMQAbstractNotifier::NotifyTransaction, _1, boost::cref(tx)));
 }
 
 void CZMQNotificationInterface::NotifyTransactionLock(const CTransaction &tx)
 {
-    for (std::list<CZMQAbstractNotifier*>::iterator i = notifiers.begin(); i!=notifiers.end(); )
-    {
-        CZMQAbstractNotifier *notifier = *i;
-        if (notifier->NotifyTransactionLock(tx))
-        {
-            i++;
-        }
-        else
-        {
-            notifier->Shutdown();
-            i = notifiers.erase(i);
-        }
-    }
+    TryForEachAndRemoveFailed(boost::bind(&CZMQAbstractNotifier::NotifyTransactionLock, _1, boost::cref(tx)));
+}
+
+void CZMQNotificationInterface::BlockConnected(const CBlock &block, const CBlockIndex *pindex)
+{
+    TryForEachAndRemoveFailed(boost::bind(&CZMQAbstractNotifier::NotifyBlockConnected, _1, boost::cref(block), pindex));
+}
+
+void CZMQNotificationInterface::BlockDisconnected(const CBlock &block, const CBlockIndex *pindex)
+{
+    TryForEachAndRemoveFailed(boost::bind(&CZMQAbstractNotifier::NotifyBlockDisconnected, _1, boost::cref(block), pindex));
+}
+
+void CZMQNotificationInterface::TransactionAddedToMempool(const CTransaction &tx)
+{
+    TryForEachAndRemoveFailed(boost::bind(&CZMQAbstractNotifier::NotifyTransactionAcceptance, _1, boost::cref(tx)));
+}
+
+void CZMQNotificationInterface::TransactionRemovedFromMempool(const CTransaction &tx)
+{
+    TryForEachAndRemoveFailed(boost::bind(&CZMQAbstractNotifier::NotifyTransactionRemoval, _1, boost::cref(tx)));
+}
+
+void CZMQNotificationInterface::MasternodeWinner(int nBlockHeight, const COutPoint &outpointMasternode, const CScript &payee)
+{
+    TryForEachAndRemoveFailed(boost::bind(&CZMQAbstractNotifier::NotifyMasternodeWinner, _1, nBlockHeight, boost::cref(outpointMasternode), boost::cref(payee)));
 }
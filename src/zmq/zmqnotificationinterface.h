@@ -6,6 +6,7 @@
 #define BITCOIN_ZMQ_ZMQNOTIFICATIONINTERFACE_H
 
 #include "validationinterface.h"
+#include <list>
 #include <string>
 #include <map>
 
@@ -27,10 +28,19 @@ protected:
     void SyncTransaction(const CTransaction &tx, const CBlock *pblock);
     void UpdatedBlockTip(const CBlockIndex *pindex);
     void NotifyTransactionLock(const CTransaction &tx);
+    void BlockConnected(const CBlock &block, const CBlockIndex *pindex);
+    void BlockDisconnected(const CBlock &block, const CBlockIndex *pindex);
+    void TransactionAddedToMempool(const CTransaction &tx);
+    void TransactionRemovedFromMempool(const CTransaction &tx);
+    void MasternodeWinner(int nBlockHeight, const COutPoint &outpointMasternode, const CScript &payee);
 
 private:
     CZMQNotificationInterface();
 
+    // Call func on every notifier, shutting down and dropping those for which it fails
+    template <typename Function>
+    void TryForEachAndRemoveFailed(const Function& func);
+
     void *pcontext;
     std::list<CZMQAbstractNotifier*> notifiers;
 };
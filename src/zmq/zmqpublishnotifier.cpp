@@ -6,7 +6,13 @@
 #include "zmqpublishnotifier.h"
 #include "main.h"
 #include "util.h"
+#include "zkydchain.h"
 #include "crypto/common.h"
+#include "primitives/zerocoin.h"
+
+#include <deque>
+
+#include <boost/thread.hpp>
 
 static std::multimap<std::string, CZMQAbstractPublishNotifier*> mapPublishNotifiers;
 
@@ -16,6 +22,10 @@ static const char *MSG_HASHTXLOCK = "hashtxlock";
 static const char *MSG_RAWBLOCK   = "rawblock";
 static const char *MSG_RAWTX      = "rawtx";
 static const char *MSG_RAWTXLOCK = "rawtxlock";
+static const char *MSG_SEQUENCE   = "sequence";
+static const char *MSG_ZEROCOINMINT  = "zerocoinmint";
+static const char *MSG_ZEROCOINSPEND = "zerocoinspend";
+static const char *MSG_MNWINNER   = "mnwinner";
 
 // Internal function to send multipart message
 static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
@@ -57,6 +67,155 @@ static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
     return 0;
 }
 
+/** A message waiting for the publisher thread */
+struct CZMQQueuedMessage
+{
+    void *psocket;
+    const char *command;
+    ZMQPayload payload;
+    uint32_t nSequence;
+};
+
+/**
+ * Sends the queued messages of all publish notifiers in the order they were queued. The
+ * notifiers only serialize, so a slow socket never holds up the thread delivering validation
+ * notifications. When the queue is full the notifiers wait, so no message is ever dropped.
+ */
+class CZMQPublisher
+{
+private:
+    boost::mutex cs;
+    boost::condition_variable condQueued;
+    boost::condition_variable condSent;
+    std::deque<CZMQQueuedMessage> queue;
+    boost::thread thread;
+    bool fRunning;
+    bool fStop;
+
+    void Thread()
+    {
+        RenameThread("kyd-zmqpub");
+
+        while (true) {
+            std::deque<CZMQQueuedMessage> batch;
+            {
+                boost::unique_lock<boost::mutex> lock(cs);
+                while (queue.empty() && !fStop)
+                    condQueued.wait(lock);
+                if (queue.empty())
+                    return;
+                batch.swap(queue);
+                condSent.notify_all();
+            }
+
+            for (std::deque<CZMQQueuedMessage>::const_iterator it = batch.begin(); it != batch.end(); ++it) {
+                /* send three parts, command & data & a LE 4byte sequence number */
+                unsigned char msgseq[sizeof(uint32_t)];
+                WriteLE32(&msgseq[0], it->nSequence);
+                // a null data pointer ends the part list, so empty payloads point at a dummy byte
+                static const unsigned char chEmpty = 0;
+                const std::vector<unsigned char>& data = *it->payload;
+                zmq_send_multipart(it->psocket, it->command, strlen(it->command), data.empty() ? &chEmpty : &data[0], data.size(), msgseq, (size_t)sizeof(uint32_t), (void*)0);
+            }
+        }
+    }
+
+public:
+    CZMQPublisher() : fRunning(false), fStop(false) {}
+
+    void Start()
+    {
+        boost::unique_lock<boost::mutex> lock(cs);
+        if (fRunning)
+            return;
+        fRunning = true;
+        fStop = false;
+        thread = boost::thread(boost::bind(&CZMQPublisher::Thread, this));
+    }
+
+    void Stop()
+    {
+        {
+            boost::unique_lock<boost::mutex> lock(cs);
+            if (!fRunning)
+                return;
+            fStop = true;
+            condQueued.notify_all();
+        }
+        thread.join();
+
+        boost::unique_lock<boost::mutex> lock(cs);
+        fRunning = false;
+        condSent.notify_all();
+    }
+
+    bool Push(void *psocket, const char *command, const ZMQPayload& payload, uint32_t nSequence)
+    {
+        boost::unique_lock<boost::mutex> lock(cs);
+        while (fRunning && !fStop && queue.size() >= MAX_ZMQ_PUBLISH_QUEUE)
+            condSent.wait(lock);
+        if (!fRunning || fStop)
+            return false;
+
+        CZMQQueuedMessage msg;
+        msg.psocket = psocket;
+        msg.command = command;
+        msg.payload = payload;
+        msg.nSequence = nSequence;
+        queue.push_back(msg);
+        condQueued.notify_one();
+        return true;
+    }
+};
+
+static CZMQPublisher zmqPublisher;
+
+void StartZMQPublisher()
+{
+    zmqPublisher.Start();
+}
+
+void StopZMQPublisher()
+{
+    zmqPublisher.Stop();
+}
+
+static ZMQPayload MakePayload(const CDataStream& ss)
+{
+    return std::make_shared<const std::vector<unsigned char> >(ss.begin(), ss.end());
+}
+
+/** Serialized form of the last transaction published raw, shared by rawtx and rawtxlock */
+static ZMQPayload GetTransactionPayload(const CTransaction &transaction)
+{
+    static boost::mutex cs_last;
+    static uint256 hashLast;
+    static ZMQPayload payloadLast;
+
+    boost::unique_lock<boost::mutex> lock(cs_last);
+    if (!payloadLast || hashLast != transaction.GetHash()) {
+        CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+        ss << transaction;
+        payloadLast = MakePayload(ss);
+        hashLast = transaction.GetHash();
+    }
+    return payloadLast;
+}
+
+/** Append hash in the byte order used by the hash* topics */
+static void AppendReversedHash(std::vector<unsigned char>& data, const uint256 &hash)
+{
+    for (unsigned int i = 0; i < 32; i++)
+        data.push_back(hash.begin()[31 - i]);
+}
+
+static void AppendLE32(std::vector<unsigned char>& data, uint32_t n)
+{
+    unsigned char buf[4];
+    WriteLE32(buf, n);
+    data.insert(data.end(), buf, buf + 4);
+}
+
 bool CZMQAbstractPublishNotifier::Initialize(void *pcontext)
 {
     assert(!psocket);
@@ -127,17 +286,19 @@ void CZMQAbstractPublishNotifier::Shutdown()
 }
 
 bool CZMQAbstractPublishNotifier::SendMessage(const char *command, const void* data, size_t size)
+{
+    const unsigned char *pdata = static_cast<const unsigned char*>(data);
+    return SendMessage(command, std::make_shared<const std::vector<unsigned char> >(pdata, pdata + size));
+}
+
+bool CZMQAbstractPublishNotifier::SendMessage(const char *command, const ZMQPayload& payload)
 {
     assert(psocket);
 
-    /* send three parts, command & data & a LE 4byte sequence number */
-    unsigned char msgseq[sizeof(uint32_t)];
-    WriteLE32(&msgseq[0], nSequence);
-    int rc = zmq_send_multipart(psocket, command, strlen(command), data, size, msgseq, (size_t)sizeof(uint32_t), (void*)0);
-    if (rc == -1)
+    if (!zmqPublisher.Push(psocket, command, payload, nSequence))
         return false;
 
-    /* increment memory only sequence number after sending */
+    /* increment memory only sequence number after queueing, the publisher sends in queue order */
     nSequence++;
 
     return true;
@@ -173,42 +334,132 @@ bool CZMQPublishHashTransactionLockNotifier::NotifyTransactionLock(const CTransa
     return SendMessage(MSG_HASHTXLOCK, data, 32);
 }
 
-bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
+bool CZMQPublishRawBlockNotifier::NotifyBlockConnected(const CBlock &block, const CBlockIndex *pindex)
 {
     LogPrint("zmq", "zmq: Publish rawblock %s\n", pindex->GetBlockHash().GetHex());
 
-// XX42    const Consensus::Params& consensusParams = Params().GetConsensus();
+    // Every connected block is published from the copy validation already holds, nothing is read back from disk
     CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-    {
-        LOCK(cs_main);
-        CBlock block;
-// XX42        if(!ReadBlockFromDisk(block, pindex, consensusParams))
-        if(!ReadBlockFromDisk(block, pindex))
-        {
-            zmqError("Can't read block from disk");
-            return false;
-        }
-
-        ss << block;
-    }
-
-    return SendMessage(MSG_RAWBLOCK, &(*ss.begin()), ss.size());
+    ss << block;
+    return SendMessage(MSG_RAWBLOCK, MakePayload(ss));
 }
 
 bool CZMQPublishRawTransactionNotifier::NotifyTransaction(const CTransaction &transaction)
 {
     uint256 hash = transaction.GetHash();
     LogPrint("zmq", "zmq: Publish rawtx %s\n", hash.GetHex());
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-    ss << transaction;
-    return SendMessage(MSG_RAWTX, &(*ss.begin()), ss.size());
+    return SendMessage(MSG_RAWTX, GetTransactionPayload(transaction));
 }
 
 bool CZMQPublishRawTransactionLockNotifier::NotifyTransactionLock(const CTransaction &transaction)
 {
     uint256 hash = transaction.GetHash();
     LogPrint("zmq", "zmq: Publish rawtxlock %s\n", hash.GetHex());
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-    ss << transaction;
-    return SendMessage(MSG_RAWTXLOCK, &(*ss.begin()), ss.size());
+    return SendMessage(MSG_RAWTXLOCK, GetTransactionPayload(transaction));
+}
+
+bool CZMQPublishSequenceNotifier::SendSequenceMessage(const uint256 &hash, char label, bool fMempool)
+{
+    LogPrint("zmq", "zmq: Publish sequence %c %s\n", label, hash.GetHex());
+    std::vector<unsigned char> data;
+    data.reserve(32 + 1 + sizeof(uint64_t));
+    AppendReversedHash(data, hash);
+    data.push_back(label);
+    if (fMempool) {
+        unsigned char buf[sizeof(uint64_t)];
+        WriteLE64(buf, ++nMempoolSequence);
+        data.insert(data.end(), buf, buf + sizeof(buf));
+    }
+    return SendMessage(MSG_SEQUENCE, std::make_shared<const std::vector<unsigned char> >(data));
+}
+
+bool CZMQPublishSequenceNotifier::NotifyBlockConnected(const CBlock &block, const CBlockIndex *pindex)
+{
+    return SendSequenceMessage(pindex->GetBlockHash(), 'C', false);
+}
+
+bool CZMQPublishSequenceNotifier::NotifyBlockDisconnected(const CBlock &block, const CBlockIndex *pindex)
+{
+    return SendSequenceMessage(pindex->GetBlockHash(), 'D', false);
+}
+
+bool CZMQPublishSequenceNotifier::NotifyTransactionAcceptance(const CTransaction &transaction)
+{
+    return SendSequenceMessage(transaction.GetHash(), 'A', true);
+}
+
+bool CZMQPublishSequenceNotifier::NotifyTransactionRemoval(const CTransaction &transaction)
+{
+    return SendSequenceMessage(transaction.GetHash(), 'R', true);
+}
+
+bool CZMQPublishZerocoinMintNotifier::NotifyBlockConnected(const CBlock &block, const CBlockIndex *pindex)
+{
+    for (const CTransaction& tx : block.vtx) {
+        if (!tx.IsZerocoinMint())
+            continue;
+
+        for (unsigned int i = 0; i < tx.vout.size(); i++) {
+            if (!tx.vout[i].IsZerocoinMint())
+                continue;
+
+            libzerocoin::PublicCoin pubCoin(Params().Zerocoin_Params(false));
+            CValidationState state;
+            if (!TxOutToPublicCoin(tx.vout[i], pubCoin, state))
+                continue;
+
+            std::vector<unsigned char> data;
+            AppendReversedHash(data, tx.GetHash());
+            AppendLE32(data, i);
+            AppendLE32(data, (uint32_t)pubCoin.getDenomination());
+            AppendReversedHash(data, GetPubCoinHash(pubCoin.getValue()));
+            if (!SendMessage(MSG_ZEROCOINMINT, std::make_shared<const std::vector<unsigned char> >(data)))
+                return false;
+        }
+    }
+    return true;
+}
+
+bool CZMQPublishZerocoinSpendNotifier::NotifyBlockConnected(const CBlock &block, const CBlockIndex *pindex)
+{
+    for (const CTransaction& tx : block.vtx) {
+        if (!tx.IsZerocoinSpend())
+            continue;
+
+        for (unsigned int i = 0; i < tx.vin.size(); i++) {
+            if (!tx.vin[i].scriptSig.IsZerocoinSpend())
+                continue;
+
+            uint256 hashSerial;
+            uint32_t nDenomination;
+            try {
+                libzerocoin::CoinSpend spend = TxInToZerocoinSpend(tx.vin[i]);
+                hashSerial = GetSerialHash(spend.getCoinSerialNumber());
+                nDenomination = (uint32_t)spend.getDenomination();
+            } catch (const std::exception& e) {
+                LogPrint("zmq", "zmq: Unable to parse zerocoin spend %s:%u: %s\n", tx.GetHash().GetHex(), i, e.what());
+                continue;
+            }
+
+            std::vector<unsigned char> data;
+            AppendReversedHash(data, tx.GetHash());
+            AppendLE32(data, i);
+            AppendLE32(data, nDenomination);
+            AppendReversedHash(data, hashSerial);
+            if (!SendMessage(MSG_ZEROCOINSPEND, std::make_shared<const std::vector<unsigned char> >(data)))
+                return false;
+        }
+    }
+    return true;
+}
+
+bool CZMQPublishMasternodeWinnerNotifier::NotifyMasternodeWinner(int nBlockHeight, const COutPoint &outpointMasternode, const CScript &payee)
+{
+    LogPrint("zmq", "zmq: Publish mnwinner %d %s\n", nBlockHeight, outpointMasternode.ToStringShort());
+    std::vector<unsigned char> data;
+    AppendLE32(data, nBlockHeight);
+    AppendReversedHash(data, outpointMasternode.hash);
+    AppendLE32(data, outpointMasternode.n);
+    data.insert(data.end(), payee.begin(), payee.end());
+    return SendMessage(MSG_MNWINNER, std::make_shared<const std::vector<unsigned char> >(data));
 }
@@ -7,22 +7,39 @@
 
 #include "zmqabstractnotifier.h"
 
+#include <memory>
+#include <vector>
+
 class CBlockIndex;
 
+//! Messages waiting for the publisher thread before notifiers wait for it to catch up
+static const size_t MAX_ZMQ_PUBLISH_QUEUE = 10000;
+
+typedef std::shared_ptr<const std::vector<unsigned char> > ZMQPayload;
+
+/**
+ * Start and stop the thread that sends the messages of all publish notifiers. Notifiers only
+ * serialize and queue, stopping sends everything still queued.
+ */
+void StartZMQPublisher();
+void StopZMQPublisher();
+
 class CZMQAbstractPublishNotifier : public CZMQAbstractNotifier
 {
 private:
     uint32_t nSequence; // upcounting per message sequence number
 
 public:
+    CZMQAbstractPublishNotifier() : nSequence(0) { }
 
-    /* send zmq multipart message
+    /* queue zmq multipart message for the publisher thread
        parts:
           * command
           * data
           * message sequence number
     */
     bool SendMessage(const char *command, const void* data, size_t size);
+    bool SendMessage(const char *command, const ZMQPayload& payload);
 
     bool Initialize(void *pcontext);
     void Shutdown();
@@ -49,7 +66,7 @@ public:
 class CZMQPublishRawBlockNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyBlock(const CBlockIndex *pindex);
+    bool NotifyBlockConnected(const CBlock &block, const CBlockIndex *pindex);
 };
 
 class CZMQPublishRawTransactionNotifier : public CZMQAbstractPublishNotifier
@@ -64,4 +81,46 @@ public:
     bool NotifyTransactionLock(const CTransaction &transaction);
 };
 
+/**
+ * Publishes 32 byte hash, 1 byte label and for mempool events an 8 byte little endian mempool
+ * sequence number: C (block connected), D (block disconnected), A (added to the mempool) and R
+ * (removed from the mempool for any reason but inclusion in a block).
+ */
+class CZMQPublishSequenceNotifier : public CZMQAbstractPublishNotifier
+{
+private:
+    uint64_t nMempoolSequence;
+
+    bool SendSequenceMessage(const uint256 &hash, char label, bool fMempool);
+
+public:
+    CZMQPublishSequenceNotifier() : nMempoolSequence(0) { }
+
+    bool NotifyBlockConnected(const CBlock &block, const CBlockIndex *pindex);
+    bool NotifyBlockDisconnected(const CBlock &block, const CBlockIndex *pindex);
+    bool NotifyTransactionAcceptance(const CTransaction &transaction);
+    bool NotifyTransactionRemoval(const CTransaction &transaction);
+};
+
+/** Publishes txid, 4 byte output index, 4 byte denomination and pubcoin hash of each mint in a connected block */
+class CZMQPublishZerocoinMintNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyBlockConnected(const CBlock &block, const CBlockIndex *pindex);
+};
+
+/** Publishes txid, 4 byte input index, 4 byte denomination and serial hash of each spend in a connected block */
+class CZMQPublishZerocoinSpendNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyBlockConnected(const CBlock &block, const CBlockIndex *pindex);
+};
+
+/** Publishes 4 byte block height, masternode outpoint (hash, 4 byte index) and payee script of each accepted winner vote */
+class CZMQPublishMasternodeWinnerNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyMasternodeWinner(int nBlockHeight, const COutPoint &outpointMasternode, const CScript &payee);
+};
+
 #endif // BITCOIN_ZMQ_ZMQPUBLISHNOTIFIER_H